@@ -20,6 +20,8 @@
 
 #include <new>
 
+#include "ElementImp.h"
+
 namespace org { namespace w3c { namespace dom { namespace bootstrap {
 
 // Attr
@@ -53,6 +55,8 @@ std::u16string AttrImp::getValue()
 void AttrImp::setValue(const std::u16string& value)
 {
     this->value = value;
+    if (auto element = getOwnerElement())
+        element->updateAttrValue(this, value);
 }
 
 AttrImp::AttrImp(Nullable<std::u16string> namespaceURI, Nullable<std::u16string> prefix, const std::u16string& localName, const std::u16string& value) :
@@ -25,17 +25,34 @@
 
 namespace org { namespace w3c { namespace dom { namespace bootstrap {
 
+class ElementImp;
+typedef std::shared_ptr<ElementImp> ElementPtr;
+
 class AttrImp : public ObjectMixin<AttrImp>
 {
+    friend class ElementImp;
+
 private:
     Nullable<std::u16string> namespaceURI;
     Nullable<std::u16string> prefix;
     std::u16string localName;
     std::u16string value;
+    std::weak_ptr<ElementImp> ownerElement;
 
 public:
     AttrImp(Nullable<std::u16string> namespaceURI, Nullable<std::u16string> prefix, const std::u16string& localName, const std::u16string& value);
 
+    ElementPtr getOwnerElement() const {
+        return ownerElement.lock();
+    }
+    void setOwnerElement(const ElementPtr& element) {
+        ownerElement = element;
+    }
+
+    bool matches(const std::u16string& namespaceURI, const std::u16string& localName) const {
+        return this->localName == localName && static_cast<std::u16string>(this->namespaceURI) == namespaceURI;
+    }
+
     // Attr
     virtual Nullable<std::u16string> getNamespaceURI();
     virtual Nullable<std::u16string> getPrefix();
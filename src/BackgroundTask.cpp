@@ -25,6 +25,7 @@
 
 #include "DOMImplementationImp.h"
 #include "DocumentImp.h"
+#include "FrameScheduler.h"
 #include "css/ViewCSSImp.h"
 #include "html/HTMLParser.h"
 
@@ -37,7 +38,10 @@ WindowProxy::BackgroundTask::BackgroundTask(WindowProxy* window) :
     state(Init),
     flags(0),
     view(0),
-    xfered(false)
+    xfered(false),
+    interrupted(false),
+    styleTime(0.0),
+    layoutTime(0.0)
 {
 }
 
@@ -60,6 +64,8 @@ void WindowProxy::BackgroundTask::operator()()
         return;
 
     unsigned command;
+    bool deferred = false;  // the reflow is deferred at most once per layout
+    bool cascaded = false;  // the selectors have been matched since the last layout
     while (!((command = sleep()) & Abort)) {
         try {
             if (!window->getWindowPtr()) {
@@ -87,10 +93,21 @@ void WindowProxy::BackgroundTask::operator()()
             if (!view || (command & Cascade)) {
                 state = Cascading;
                 recordTime("%*sselector matching begin", window->windowDepth * 2, "");
+                bool rematch = view && (command & Rematch);
                 if (!view)
                     view = new(std::nothrow) ViewCSSImp(window->getWindowPtr());
                 if (view) {
-                    view->constructComputedStyles();
+                    double start = FrameScheduler::now();
+                    view->constructComputedStyles(rematch);
+                    cascaded = true;
+                    addTime(styleTime, start);
+                    if (getLogLevel()) {
+                        size_t unshared;
+                        size_t used = view->getComputedStyleMemoryUsage(unshared);
+                        recordTime("%*s%u computed styles in %u KB (%u KB unshared)", window->windowDepth * 2, "",
+                                   static_cast<unsigned>(view->getComputedStyleCount()),
+                                   static_cast<unsigned>(used / 1024), static_cast<unsigned>(unshared / 1024));
+                    }
                     state = Cascaded;
                 } else
                     state = Init;
@@ -103,12 +120,40 @@ void WindowProxy::BackgroundTask::operator()()
             //
             if (command & Layout) {
                 state = Layouting;
+                bool resized = view->getWidth() != window->width || view->getHeight() != window->height;
                 view->setSize(window->width, window->height);   // TODO: sync with mainloop
                 recordTime("%*sstyle recalculation begin", window->windowDepth * 2, "");
+                double start = FrameScheduler::now();
                 view->calculateComputedStyles();
+                addTime(styleTime, start);
                 recordTime("%*sstyle recalculation end", window->windowDepth * 2, "");
+
+                // The styles are consistent here; if input events are
+                // waiting, go back to the Cascaded state and let the main
+                // thread dispatch them before it asks for the layout again.
+                if (interrupted && !deferred) {
+                    deferred = true;
+                    recordTime("%*sreflow deferred for input", window->windowDepth * 2, "");
+                    state = Cascaded;
+                    continue;
+                }
+
+                // If the restyle has changed only the painted values, e.g., by
+                // a :hover color, the restyled blocks have been flagged with
+                // NEED_REPAINT, and neither the reflow nor a full repaint is
+                // necessary.
+                if (!cascaded && !resized && view->getTree() && !(view->gatherFlags() & ~Box::NEED_REPAINT)) {
+                    recordTime("%*sreflow skipped", window->windowDepth * 2, "");
+                    deferred = false;
+                    state = Done;
+                    continue;
+                }
+                cascaded = false;
+
                 recordTime("%*sreflow begin", window->windowDepth * 2, "");
+                start = FrameScheduler::now();
                 view->layOut();
+                addTime(layoutTime, start);
                 recordTime("%*sreflow end", window->windowDepth * 2, "");
 
                 // Even though every view flag should have been cleared now,
@@ -126,6 +171,7 @@ void WindowProxy::BackgroundTask::operator()()
                 view->setFlags(Box::NEED_REPAINT);
             }
 
+            deferred = false;
             state = Done;
         } catch (const std::exception& e) {
             std::cerr << "WindowProxy::BackgroundTask: " << e.what() << "\n";
@@ -136,14 +182,36 @@ void WindowProxy::BackgroundTask::operator()()
 }
 
 
+void WindowProxy::BackgroundTask::addTime(double& time, double start)
+{
+    double end = FrameScheduler::now();
+    std::lock_guard<std::mutex> lock(mutex);
+    time += end - start;
+}
+
+void WindowProxy::BackgroundTask::takeTimes(double& style, double& layout)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    style = styleTime;
+    layout = layoutTime;
+    styleTime = layoutTime = 0.0;
+}
+
 unsigned WindowProxy::BackgroundTask::sleep()
 {
     std::unique_lock<std::mutex> lock(mutex);
+    interrupted = false;
     cond.notify_all();
     while (!flags)
         cond.wait(lock);
     unsigned result = flags;
     flags = 0;
+    // Leave Done before the lock is released so that getView() does not
+    // hand out the view that is about to be updated.
+    if (result & (Cascade | Restart))
+        state = Cascading;
+    else if (result & Layout)
+        state = Layouting;
     return result;
 }
 
@@ -172,7 +240,8 @@ void WindowProxy::BackgroundTask::restart(unsigned flags)
 
 ViewCSSImp* WindowProxy::BackgroundTask::getView()
 {
-    if (state == Done || state == Init) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if ((state == Done || state == Init) && !flags) {
         if (!xfered && view) {
             xfered = true;
             return view;
@@ -181,13 +250,27 @@ ViewCSSImp* WindowProxy::BackgroundTask::getView()
     return 0;
 }
 
+ViewCSSImp* WindowProxy::BackgroundTask::getSuspendedView()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (state == Cascaded && !flags)
+        return view;
+    return 0;
+}
+
+bool WindowProxy::BackgroundTask::isWaiting()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return !isPending() && (state == Done || state == Cascaded);
+}
+
 bool WindowProxy::BackgroundTask::wait()
 {
     std::unique_lock<std::mutex> lock(mutex);
     int original = state;
-    if (!isRestarting() && original == Done)
+    if (!isPending() && original == Done)
         return true;
-    while ((isRestarting() || state == original) && !(flags & Abort))
+    while ((isPending() || state == original) && !(flags & Abort))
         cond.wait(lock);
     return !(flags & Abort);
 }
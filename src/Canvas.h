@@ -17,6 +17,7 @@
 #ifndef ES_CANVAS_H
 #define ES_CANVAS_H
 
+#include <cstddef>
 #include <memory>
 
 class Canvas
@@ -32,15 +33,28 @@ public:
     void shutdown();
 
     void beginRender(unsigned backgroundColor);
+    // Repaints only the given area; the rest of the canvas is kept.
+    void beginRender(unsigned backgroundColor, int left, int top, int w, int h);
     void endRender();
 
     void beginTranslucent();
+    // Begins an offscreen layer that only covers the given area.
+    void beginTranslucent(int left, int top, int w, int h);
     void endTranslucent(float alpha);
 
+    // The number of the layers used in the last rendering, and the memory
+    // kept for them.
+    unsigned getLayerCount() const;
+    size_t getLayerMemory() const;
+
     int getWidth() const;
     int getHeight() const;
 
+    static int getMaxSize();
+
     void render(int width, int height);
+    // Composites the width x height area of the canvas starting at (left, top).
+    void render(int width, int height, int left, int top);
     void alphaBlend(int width, int height, float alpha);
 
     Impl* getPimple() const {
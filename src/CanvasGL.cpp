@@ -17,6 +17,7 @@
 #include "CanvasGL.h"
 #include <boost/concept_check.hpp>
 
+#include <algorithm>
 #include <assert.h>
 
 GLuint Canvas::Impl::currentFrameBuffer = 0;
@@ -82,50 +83,65 @@ void Canvas::Impl::shutdown()
         glDeleteTextures(1, &texture);
         texture = 0;
     }
-    while (!translucents.empty()) {
-        GLuint tex = translucents.back();
-        glDeleteTextures(1, &tex);
-        translucents.pop_back();
-    }
+    translucents.clear();
+    for (auto i = layerPool.begin(); i != layerPool.end(); ++i)
+        deleteLayer(*i);
+    layerPool.clear();
     frameBuffer = 0;
     renderBuffer = 0;
     width = height = 0;
 }
 
-void Canvas::Impl::beginRender(unsigned backgroundColor)
+void Canvas::Impl::beginRender(unsigned backgroundColor, int left, int top, int w, int h)
 {
-    GLint v[4];
-    glGetIntegerv(GL_VIEWPORT, v);
-    GLint viewportHeight = v[3];
-
     savedFrameBuffer = currentFrameBuffer;
-    currentFrameBuffer = frameBuffer;
-    if (GLEW_ARB_framebuffer_object)
-        glBindFramebuffer(GL_FRAMEBUFFER, currentFrameBuffer);
-    else
-        glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, currentFrameBuffer);
 
     GLfloat m[16];
     glGetFloatv(GL_MODELVIEW_MATRIX, m);
     x = m[12];
     y = m[13];
 
+    // The canvas can be larger than the window when it is used as a scroll
+    // layer, so map the whole canvas rather than the window viewport.
+    glGetIntegerv(GL_VIEWPORT, savedViewport);
     glMatrixMode(GL_PROJECTION);
     glPushMatrix();
-    glTranslatef(-x, viewportHeight - (y + height), 0.0f);
-
     glMatrixMode(GL_MODELVIEW);
     glPushMatrix();
+    setTarget(frameBuffer, 0, 0, width, height);
+
+    // Note a child window can be rendered while the parent canvas is scissored.
+    savedScissorTest = glIsEnabled(GL_SCISSOR_TEST);
+    glGetIntegerv(GL_SCISSOR_BOX, savedScissorBox);
+    if (left <= 0 && top <= 0 && width <= left + w && height <= top + h)
+        glDisable(GL_SCISSOR_TEST);
+    else {
+        glEnable(GL_SCISSOR_TEST);
+        glScissor(left, height - (top + h), w, h);  // in window coordinates
+    }
 
     glClearColor(((backgroundColor >> 16) & 255) / 255.0f,
                  ((backgroundColor >> 8) & 255) / 255.0f,
                  (backgroundColor & 255) / 255.0f,
                  ((backgroundColor >> 24) & 255) / 255.0f);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+
+    ++renderCount;
+    layerCount = 0;
 }
 
 void Canvas::Impl::endRender()
 {
+    assert(translucents.empty());
+    trimLayers();
+
+    if (savedScissorTest) {
+        glEnable(GL_SCISSOR_TEST);
+        glScissor(savedScissorBox[0], savedScissorBox[1], savedScissorBox[2], savedScissorBox[3]);
+    } else
+        glDisable(GL_SCISSOR_TEST);
+
+    glViewport(savedViewport[0], savedViewport[1], savedViewport[2], savedViewport[3]);
     glMatrixMode(GL_PROJECTION);
     glPopMatrix();
 
@@ -139,23 +155,202 @@ void Canvas::Impl::endRender()
         glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, currentFrameBuffer);
 }
 
-void Canvas::Impl::beginTranslucent()
+// Renders into target, which covers the w x h area at (left, top) of the
+// canvas. Note the rows of target are stored bottom up.
+void Canvas::Impl::setTarget(GLuint target, int left, int top, int w, int h)
 {
-    GLuint tex;
-    glGenTextures(1, &tex);
-    glBindTexture(GL_TEXTURE_2D, tex);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, 0);
-    translucents.push_back(tex);
-
-    glFlush();
+    currentFrameBuffer = target;
     if (GLEW_ARB_framebuffer_object)
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, tex, 0);
+        glBindFramebuffer(GL_FRAMEBUFFER, currentFrameBuffer);
     else
-        glFramebufferTexture2DEXT(GL_FRAMEBUFFER_EXT, GL_COLOR_ATTACHMENT0_EXT, GL_TEXTURE_2D, tex, 0);
+        glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, currentFrameBuffer);
+    glViewport(0, 0, w, h);
+    glMatrixMode(GL_PROJECTION);
+    glLoadIdentity();
+    glOrtho(0, w, h, 0, -1000.0, 1.0);
+    glTranslatef(-x - left, -y - top, 0.0f);
+    glMatrixMode(GL_MODELVIEW);
+}
+
+void Canvas::Impl::setParentTarget()
+{
+    if (translucents.empty())
+        setTarget(frameBuffer, 0, 0, width, height);
+    else {
+        const Translucent& parent = translucents.back();
+        setTarget(layerPool[parent.layer].frameBuffer, parent.left, parent.top, parent.width, parent.height);
+    }
+}
+
+namespace {
+
+int roundUpLayerSize(int size, int minSize, int limit)
+{
+    int s = minSize;
+    while (s < size)
+        s *= 2;
+    return std::max(std::min(s, limit), 1);
+}
+
+}
+
+// Gets the smallest free layer that can hold a w x h area.
+size_t Canvas::Impl::acquireLayer(int w, int h)
+{
+    size_t found = layerPool.size();
+    for (size_t i = 0; i < layerPool.size(); ++i) {
+        const Layer& layer = layerPool[i];
+        if (layer.inUse || layer.width < w || layer.height < h)
+            continue;
+        if (found == layerPool.size() || layer.width * layer.height < layerPool[found].width * layerPool[found].height)
+            found = i;
+    }
+    if (found == layerPool.size()) {
+        Layer layer;
+        layer.width = roundUpLayerSize(w, MinLayerSize, width);
+        layer.height = roundUpLayerSize(h, MinLayerSize, height);
+
+        glGenTextures(1, &layer.texture);
+        glBindTexture(GL_TEXTURE_2D, layer.texture);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, layer.width, layer.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, 0);
+
+        if (GLEW_ARB_framebuffer_object) {
+            glGenRenderbuffers(1, &layer.renderBuffer);
+            glBindRenderbuffer(GL_RENDERBUFFER, layer.renderBuffer);
+            glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_STENCIL, layer.width, layer.height);
+
+            glGenFramebuffers(1, &layer.frameBuffer);
+            glBindFramebuffer(GL_FRAMEBUFFER, layer.frameBuffer);
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, layer.texture, 0);
+            glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, layer.renderBuffer);
+            glBindFramebuffer(GL_FRAMEBUFFER, currentFrameBuffer);
+        } else {
+            glGenRenderbuffersEXT(1, &layer.renderBuffer);
+            glBindRenderbufferEXT(GL_RENDERBUFFER_EXT, layer.renderBuffer);
+            glRenderbufferStorageEXT(GL_RENDERBUFFER_EXT, GL_DEPTH_STENCIL_EXT, layer.width, layer.height);
+
+            glGenFramebuffersEXT(1, &layer.frameBuffer);
+            glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, layer.frameBuffer);
+            glFramebufferTexture2DEXT(GL_FRAMEBUFFER_EXT, GL_COLOR_ATTACHMENT0_EXT, GL_TEXTURE_2D, layer.texture, 0);
+            glFramebufferRenderbufferEXT(GL_FRAMEBUFFER_EXT, GL_DEPTH_ATTACHMENT_EXT, GL_RENDERBUFFER_EXT, layer.renderBuffer);
+            glFramebufferRenderbufferEXT(GL_FRAMEBUFFER_EXT, GL_STENCIL_ATTACHMENT_EXT, GL_RENDERBUFFER_EXT, layer.renderBuffer);
+            glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, currentFrameBuffer);
+        }
+        layerPool.push_back(layer);
+    }
+    layerPool[found].inUse = true;
+    layerPool[found].lastUsed = renderCount;
+    return found;
+}
+
+void Canvas::Impl::deleteLayer(const Layer& layer)
+{
+    if (GLEW_ARB_framebuffer_object) {
+        glDeleteFramebuffers(1, &layer.frameBuffer);
+        glDeleteRenderbuffers(1, &layer.renderBuffer);
+    } else {
+        glDeleteFramebuffersEXT(1, &layer.frameBuffer);
+        glDeleteRenderbuffersEXT(1, &layer.renderBuffer);
+    }
+    glDeleteTextures(1, &layer.texture);
+}
+
+// Releases the layers that have not been used in the last MaxLayerAge
+// renderings, and then the least recently used ones while the pool is
+// larger than MaxLayerMemory.
+void Canvas::Impl::trimLayers()
+{
+    for (auto i = layerPool.begin(); i != layerPool.end();) {
+        if (MaxLayerAge < renderCount - i->lastUsed) {
+            deleteLayer(*i);
+            i = layerPool.erase(i);
+        } else
+            ++i;
+    }
+    while (MaxLayerMemory < getLayerMemory()) {
+        auto oldest = std::min_element(layerPool.begin(), layerPool.end(), [](const Layer& a, const Layer& b) {
+            return a.lastUsed < b.lastUsed;
+        });
+        deleteLayer(*oldest);
+        layerPool.erase(oldest);
+    }
+}
+
+size_t Canvas::Impl::getLayerMemory() const
+{
+    size_t size = 0;
+    for (auto i = layerPool.begin(); i != layerPool.end(); ++i)
+        size += i->width * i->height * 8;   // RGBA and depth-stencil
+    return size;
+}
+
+void Canvas::Impl::beginTranslucent(int left, int top, int w, int h)
+{
+    int parentLeft = 0;
+    int parentTop = 0;
+    int parentWidth = width;
+    int parentHeight = height;
+    if (!translucents.empty()) {
+        const Translucent& parent = translucents.back();
+        parentLeft = parent.left;
+        parentTop = parent.top;
+        parentWidth = parent.width;
+        parentHeight = parent.height;
+    }
+
+    // The layer covers only the given area within the current target and
+    // its scissor box, which is in the window coordinates of the target.
+    Translucent layer;
+    layer.scissorTest = glIsEnabled(GL_SCISSOR_TEST);
+    glGetIntegerv(GL_SCISSOR_BOX, layer.scissorBox);
+    int l = std::max(left, parentLeft);
+    int t = std::max(top, parentTop);
+    int r = std::min(left + w, parentLeft + parentWidth);
+    int b = std::min(top + h, parentTop + parentHeight);
+    if (layer.scissorTest) {
+        l = std::max(l, parentLeft + layer.scissorBox[0]);
+        r = std::min(r, parentLeft + layer.scissorBox[0] + layer.scissorBox[2]);
+        t = std::max(t, parentTop + parentHeight - (layer.scissorBox[1] + layer.scissorBox[3]));
+        b = std::min(b, parentTop + parentHeight - layer.scissorBox[1]);
+    }
+    layer.left = l;
+    layer.top = t;
+    layer.width = std::max(r - l, 0);
+    layer.height = std::max(b - t, 0);
+    layer.layer = acquireLayer(layer.width, layer.height);
+    GLuint target = layerPool[layer.layer].frameBuffer;
+
+    glFlush();
+    glDisable(GL_SCISSOR_TEST);
+    if (0 < layer.width && 0 < layer.height) {
+        // Copy the clips in effect.
+        int srcLeft = l - parentLeft;
+        int srcBottom = parentTop + parentHeight - b;
+        if (GLEW_ARB_framebuffer_object) {
+            glBindFramebuffer(GL_READ_FRAMEBUFFER, currentFrameBuffer);
+            glBindFramebuffer(GL_DRAW_FRAMEBUFFER, target);
+            glBlitFramebuffer(srcLeft, srcBottom, srcLeft + layer.width, srcBottom + layer.height,
+                              0, 0, layer.width, layer.height,
+                              GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT, GL_NEAREST);
+        } else {
+            glBindFramebufferEXT(GL_READ_FRAMEBUFFER_EXT, currentFrameBuffer);
+            glBindFramebufferEXT(GL_DRAW_FRAMEBUFFER_EXT, target);
+            glBlitFramebufferEXT(srcLeft, srcBottom, srcLeft + layer.width, srcBottom + layer.height,
+                                 0, 0, layer.width, layer.height,
+                                 GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT, GL_NEAREST);
+        }
+    }
+
+    translucents.push_back(layer);
+    ++layerCount;
+
+    setTarget(target, layer.left, layer.top, layer.width, layer.height);
+    glEnable(GL_SCISSOR_TEST);
+    glScissor(0, 0, layer.width, layer.height);
     glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
     glClear(GL_COLOR_BUFFER_BIT);
     glClearColor(1.0, 1.0, 1.0, 1.0);
@@ -166,25 +361,28 @@ void Canvas::Impl::endTranslucent(float alpha)
     glFlush();
 
     assert(!translucents.empty());
-    GLuint tex = translucents.back();
+    Translucent layer = translucents.back();
     translucents.pop_back();
-
-    GLuint next = translucents.empty() ? texture : translucents.back();
-    if (GLEW_ARB_framebuffer_object)
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, next, 0);
-    else
-        glFramebufferTexture2DEXT(GL_FRAMEBUFFER_EXT, GL_COLOR_ATTACHMENT0_EXT, GL_TEXTURE_2D, next, 0);
-
-    glPushMatrix();
-    glLoadIdentity();
-    glTranslatef(x, y, 0.0f);
-    alphaBlend(width, height, alpha, tex);
-    glPopMatrix();
-
-    glDeleteTextures(1, &tex);
+    Layer& entry = layerPool[layer.layer];
+    entry.inUse = false;
+
+    setParentTarget();
+    if (layer.scissorTest) {
+        glEnable(GL_SCISSOR_TEST);
+        glScissor(layer.scissorBox[0], layer.scissorBox[1], layer.scissorBox[2], layer.scissorBox[3]);
+    } else
+        glDisable(GL_SCISSOR_TEST);
+
+    if (0 < layer.width && 0 < layer.height) {
+        glPushMatrix();
+        glLoadIdentity();
+        glTranslatef(x + layer.left, y + layer.top, 0.0f);
+        alphaBlend(layer.width, layer.height, alpha, entry.texture, entry.width, entry.height);
+        glPopMatrix();
+    }
 }
 
-void Canvas::Impl::render(int w, int h)
+void Canvas::Impl::render(int w, int h, int left, int top)
 {
     if (texture == 0)
         return;
@@ -197,21 +395,23 @@ void Canvas::Impl::render(int w, int h)
     glEnable(GL_TEXTURE_2D);
     glBindTexture(GL_TEXTURE_2D, texture);
     glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_REPLACE);
+    // Note the rows of the texture are stored bottom up.
+    int bottom = height - top;
     glBegin(GL_QUADS);
-        glTexCoord2f(0, h);
+        glTexCoord2f(left, bottom);
         glVertex2f(0, 0);
-        glTexCoord2f(w, h);
+        glTexCoord2f(left + w, bottom);
         glVertex2f(w, 0);
-        glTexCoord2f(w, 0);
+        glTexCoord2f(left + w, bottom - h);
         glVertex2f(w, h);
-        glTexCoord2f(0, 0);
+        glTexCoord2f(left, bottom - h);
         glVertex2f(0, h);
     glEnd();
     glDisable(GL_TEXTURE_2D);
     glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
 }
 
-void Canvas::Impl::alphaBlend(int w, int h, float alpha, GLuint tex)
+void Canvas::Impl::alphaBlend(int w, int h, float alpha, GLuint tex, int texWidth, int texHeight)
 {
     if (tex == 0)
         return;
@@ -220,7 +420,7 @@ void Canvas::Impl::alphaBlend(int w, int h, float alpha, GLuint tex)
 
     glMatrixMode(GL_TEXTURE);
     glLoadIdentity();
-    glScalef(1.0f / width, 1.0f / height, 0.0f);
+    glScalef(1.0f / texWidth, 1.0f / texHeight, 0.0f);
     glMatrixMode(GL_MODELVIEW);
 
     glEnable(GL_TEXTURE_2D);
@@ -262,7 +462,12 @@ void Canvas::shutdown()
 
 void Canvas::beginRender(unsigned backgroundColor)
 {
-    pimpl->beginRender(backgroundColor);
+    pimpl->beginRender(backgroundColor, 0, 0, pimpl->getWidth(), pimpl->getHeight());
+}
+
+void Canvas::beginRender(unsigned backgroundColor, int left, int top, int w, int h)
+{
+    pimpl->beginRender(backgroundColor, left, top, w, h);
 }
 
 void Canvas::endRender()
@@ -272,7 +477,22 @@ void Canvas::endRender()
 
 void Canvas::beginTranslucent()
 {
-    pimpl->beginTranslucent();
+    pimpl->beginTranslucent(0, 0, pimpl->getWidth(), pimpl->getHeight());
+}
+
+void Canvas::beginTranslucent(int left, int top, int w, int h)
+{
+    pimpl->beginTranslucent(left, top, w, h);
+}
+
+unsigned Canvas::getLayerCount() const
+{
+    return pimpl->getLayerCount();
+}
+
+size_t Canvas::getLayerMemory() const
+{
+    return pimpl->getLayerMemory();
 }
 
 void Canvas::endTranslucent(float alpha)
@@ -290,9 +510,21 @@ int Canvas::getHeight() const
     return pimpl->getHeight();
 }
 
+int Canvas::getMaxSize()
+{
+    GLint size = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &size);
+    return size;
+}
+
 void Canvas::render(int width, int height)
 {
-    return pimpl->render(width, height);
+    return pimpl->render(width, height, 0, pimpl->getHeight() - height);
+}
+
+void Canvas::render(int width, int height, int left, int top)
+{
+    return pimpl->render(width, height, left, top);
 }
 
 void Canvas::alphaBlend(int width, int height, float alpha)
@@ -23,6 +23,7 @@
 #include <GL/freeglut.h>
 
 #include <deque>
+#include <vector>
 
 class Canvas::Impl
 {
@@ -33,11 +34,41 @@ class Canvas::Impl
     GLuint frameBuffer;
     GLuint renderBuffer;
     GLuint texture;
-    std::deque<GLuint> translucents;    // alpha blend textures
+    // An offscreen layer for an opacity group. A layer has its own stencil
+    // buffer, into which the clips in effect are copied when it is begun.
+    struct Layer {
+        GLuint texture;     // alpha blend texture
+        GLuint renderBuffer;
+        GLuint frameBuffer;
+        int width;          // of the texture, which is rounded up
+        int height;
+        unsigned lastUsed;  // renderCount when the layer was last used
+        bool inUse;
+    };
+    struct Translucent {
+        size_t layer;       // index into layerPool
+        int left;           // the area covered in canvas coordinates
+        int top;
+        int width;
+        int height;
+        GLboolean scissorTest;
+        GLint scissorBox[4];
+    };
+    static const int MinLayerSize = 64;
+    static const unsigned MaxLayerAge = 60;                 // in renderings
+    static const size_t MaxLayerMemory = 32 * 1024 * 1024;  // in bytes
+    std::deque<Translucent> translucents;
+    std::vector<Layer> layerPool;
+    unsigned renderCount;
+    unsigned layerCount;    // in the last rendering
 
     GLuint savedFrameBuffer;
+    GLint savedViewport[4];
     static GLuint currentFrameBuffer;
 
+    GLboolean savedScissorTest;
+    GLint savedScissorBox[4];
+
 public:
     Impl() :
         x(0.0f),
@@ -46,7 +77,10 @@ public:
         height(0),
         frameBuffer(0),
         renderBuffer(0),
-        texture(0)
+        texture(0),
+        renderCount(0),
+        layerCount(0),
+        savedScissorTest(GL_FALSE)
     {}
 
     ~Impl() {
@@ -57,10 +91,10 @@ public:
     void setup(int width, int height);
     void shutdown();
 
-    void beginRender(unsigned backgroundColor);
+    void beginRender(unsigned backgroundColor, int left, int top, int w, int h);
     void endRender();
 
-    void beginTranslucent();
+    void beginTranslucent(int left, int top, int w, int h);
     void endTranslucent(float alpha);
 
     int getWidth() const {
@@ -78,9 +112,23 @@ public:
     GLuint getTexture() const {
         return texture;
     }
+    unsigned getLayerCount() const {
+        return layerCount;
+    }
+    size_t getLayerMemory() const;
+
+    void render(int width, int height, int left, int top);
+    void alphaBlend(int width, int height, float alpha, GLuint tex) {
+        alphaBlend(width, height, alpha, tex, this->width, this->height);
+    }
 
-    void render(int width, int height);
-    void alphaBlend(int width, int height, float alpha, GLuint tex);
+private:
+    void alphaBlend(int w, int h, float alpha, GLuint tex, int texWidth, int texHeight);
+    void setTarget(GLuint target, int left, int top, int w, int h);
+    void setParentTarget();
+    size_t acquireLayer(int w, int h);
+    void deleteLayer(const Layer& layer);
+    void trimLayers();
 };
 
 #endif  // ES_CANVAS_GL_H
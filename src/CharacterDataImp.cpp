@@ -17,16 +17,20 @@
 #include "CharacterDataImp.h"
 #include "DocumentImp.h"
 #include "MutationEventImp.h"
+#include "MutationObserverImp.h"
 #include "RangeImp.h"
 
 namespace org { namespace w3c { namespace dom { namespace bootstrap {
 
 void CharacterDataImp::dispatchMutationEvent(const std::u16string& prev)
 {
-    events::MutationEvent event = std::make_shared<MutationEventImp>();
-    event.initMutationEvent(u"DOMCharacterDataModified",
-                            true, false, getParentNode(), prev, data, u"", 0);
-    dispatchEvent(event);
+    if (hasMutationListeners(CharacterDataModifiedListener)) {
+        events::MutationEvent event = std::make_shared<MutationEventImp>();
+        event.initMutationEvent(u"DOMCharacterDataModified",
+                                true, false, getParentNode(), prev, data, u"", 0);
+        dispatchEvent(event);
+    }
+    MutationObserverImp::queueCharacterData(std::static_pointer_cast<NodeImp>(self()), prev);
 }
 
 
@@ -26,6 +26,8 @@ namespace org { namespace w3c { namespace dom { namespace bootstrap {
 
 class CharacterDataImp : public ObjectMixin<CharacterDataImp, NodeImp>
 {
+    friend class DOMSerializer;
+
     std::u16string data;
 
     void dispatchMutationEvent(const std::u16string& prev);
@@ -0,0 +1,455 @@
+/*
+ * Copyright 2015 Esrille Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "DOMSerializer.h"
+
+#include "CharacterDataImp.h"
+#include "DocumentTypeImp.h"
+#include "ElementImp.h"
+#include "ProcessingInstructionImp.h"
+
+namespace org { namespace w3c { namespace dom { namespace bootstrap {
+
+namespace {
+
+const char16_t* const htmlNamespace = u"http://www.w3.org/1999/xhtml";
+const char16_t* const xmlNamespace = u"http://www.w3.org/XML/1998/namespace";
+const char16_t* const xmlnsNamespace = u"http://www.w3.org/2000/xmlns/";
+
+bool isOneOf(const std::u16string& name, const char16_t* const* names)
+{
+    for (; *names; ++names) {
+        if (name == *names)
+            return true;
+    }
+    return false;
+}
+
+const char16_t* const voidElements[] = {
+    u"area", u"base", u"basefont", u"bgsound", u"br", u"col", u"embed", u"frame",
+    u"hr", u"img", u"input", u"keygen", u"link", u"meta", u"param", u"source",
+    u"track", u"wbr", 0
+};
+
+// The elements whose Text children are serialized without escaping
+const char16_t* const rawTextElements[] = {
+    u"style", u"script", u"xmp", u"iframe", u"noembed", u"noframes", u"plaintext",
+    u"noscript", 0
+};
+
+// The elements that drop a leading newline when parsed
+const char16_t* const newlineElements[] = {
+    u"pre", u"textarea", u"listing", 0
+};
+
+}
+
+DOMSerializer::DOMSerializer(std::u16string& out, bool html) :
+    out(out),
+    html(html),
+    generatedPrefixCount(0)
+{
+}
+
+template <typename F>
+void DOMSerializer::forEachDescendant(NodeImp* root, F f)
+{
+    std::vector<NodeImp*> ancestors;
+    NodeImp* node = root->firstChild.get();
+    while (node) {
+        f(node);
+        if (node->firstChild) {
+            ancestors.push_back(node);
+            node = node->firstChild.get();
+            continue;
+        }
+        while (!node->nextSibling && !ancestors.empty()) {
+            node = ancestors.back();
+            ancestors.pop_back();
+        }
+        node = node->nextSibling.get();
+    }
+}
+
+size_t DOMSerializer::estimateLength(NodeImp* root)
+{
+    size_t length = 0;
+    auto measure = [&length](NodeImp* node) {
+        switch (node->getNodeType()) {
+        case Node::ELEMENT_NODE: {
+            ElementImp* element = static_cast<ElementImp*>(node);
+            length += 2 * (element->prefix.length() + element->localName.length()) + 5;
+            for (size_t i = 0; i < element->attributes.size(); ++i)
+                length += element->attributes[i].name.length() + element->attributes[i].value.length() + 4;
+            break;
+        }
+        case Node::TEXT_NODE:
+        case Node::COMMENT_NODE:
+        case Node::PROCESSING_INSTRUCTION_NODE:
+            length += static_cast<CharacterDataImp*>(node)->data.length() + 7;
+            break;
+        default:
+            break;
+        }
+    };
+    measure(root);
+    forEachDescendant(root, measure);
+    return length;
+}
+
+void DOMSerializer::appendEscaped(const std::u16string& text, bool attributeMode)
+{
+    // Copy the runs of characters that need no escaping in bulk.
+    const char16_t* p = text.data();
+    const char16_t* end = p + text.length();
+    const char16_t* run = p;
+    for (; p < end; ++p) {
+        const char16_t* entity;
+        switch (*p) {
+        case u'&':
+            entity = u"&amp;";
+            break;
+        case 0xA0:
+            if (!html)
+                continue;
+            entity = u"&nbsp;";
+            break;
+        case u'"':
+            if (!attributeMode)
+                continue;
+            entity = u"&quot;";
+            break;
+        case u'<':
+            if (html && attributeMode)
+                continue;
+            entity = u"&lt;";
+            break;
+        case u'>':
+            if (html && attributeMode)
+                continue;
+            entity = u"&gt;";
+            break;
+        default:
+            continue;
+        }
+        out.append(run, p - run);
+        out += entity;
+        run = p + 1;
+    }
+    out.append(run, end - run);
+}
+
+void DOMSerializer::appendAttributes(ElementImp* element)
+{
+    for (size_t i = 0; i < element->attributes.size(); ++i) {
+        const ElementImp::AttrEntry& entry = element->attributes[i];
+        out += u' ';
+        out += entry.name;
+        out += u"=\"";
+        appendEscaped(entry.value, true);
+        out += u'"';
+    }
+}
+
+// Returns the namespace bound to prefix, or nullptr if prefix is not bound.
+// If inElement is true, only the declarations of the current element are
+// looked up.
+const std::u16string* DOMSerializer::lookupNamespace(const std::u16string& prefix, bool inElement) const
+{
+    size_t bottom = (inElement && !scopes.empty()) ? scopes.back() : 0;
+    for (size_t i = prefixes.size(); bottom < i; --i) {
+        if (prefixes[i - 1].first == prefix)
+            return &prefixes[i - 1].second;
+    }
+    return nullptr;
+}
+
+void DOMSerializer::declareNamespace(const std::u16string& prefix, const std::u16string& namespaceURI)
+{
+    // An element cannot declare the same prefix twice.
+    if (lookupNamespace(prefix, true))
+        return;
+    out += u" xmlns";
+    if (!prefix.empty()) {
+        out += u':';
+        out += prefix;
+    }
+    out += u"=\"";
+    appendEscaped(namespaceURI, true);
+    out += u'"';
+    prefixes.emplace_back(prefix, namespaceURI);
+}
+
+// Opens the namespace scope of element with the declarations that element
+// has as its own attributes; appendXMLAttributes() writes them out.
+void DOMSerializer::openScope(ElementImp* element)
+{
+    scopes.push_back(prefixes.size());
+    for (size_t i = 0; i < element->attributes.size(); ++i) {
+        const std::u16string& name = element->attributes[i].name;
+        if (name == u"xmlns")
+            prefixes.emplace_back(u"", element->attributes[i].value);
+        else if (name.compare(0, 6, u"xmlns:") == 0)
+            prefixes.emplace_back(name.substr(6), element->attributes[i].value);
+    }
+}
+
+// Writes the attributes of element, declaring the namespace prefixes they use
+// if those are not in scope.
+void DOMSerializer::appendXMLAttributes(ElementImp* element)
+{
+    for (size_t i = 0; i < element->attributes.size(); ++i) {
+        const ElementImp::AttrEntry& entry = element->attributes[i];
+        std::u16string namespaceURI;
+        if (entry.attr)
+            namespaceURI = static_cast<std::u16string>(entry.attr->getNamespaceURI());
+        if (namespaceURI.empty() || namespaceURI == xmlNamespace || namespaceURI == xmlnsNamespace) {
+            out += u' ';
+            out += entry.name;
+        } else {
+            std::u16string prefix = static_cast<std::u16string>(entry.attr->getPrefix());
+            const std::u16string* bound = prefix.empty() ? nullptr : lookupNamespace(prefix);
+            if (!bound || *bound != namespaceURI) {
+                if (prefix.empty() || lookupNamespace(prefix, true)) {
+                    // Make up a prefix that is not in use.
+                    do {
+                        unsigned n = ++generatedPrefixCount;
+                        prefix = u"ns";
+                        size_t pos = prefix.length();
+                        do {
+                            prefix.insert(pos, 1, static_cast<char16_t>(u'0' + n % 10));
+                            n /= 10;
+                        } while (n);
+                    } while (lookupNamespace(prefix));
+                }
+                declareNamespace(prefix, namespaceURI);
+            }
+            out += u' ';
+            out += prefix;
+            out += u':';
+            out += entry.attr->getLocalName();
+        }
+        out += u"=\"";
+        appendEscaped(entry.value, true);
+        out += u'"';
+    }
+}
+
+bool DOMSerializer::open(NodeImp* node, NodeImp* parent)
+{
+    switch (node->getNodeType()) {
+    case Node::ELEMENT_NODE: {
+        ElementImp* element = static_cast<ElementImp*>(node);
+        out += u'<';
+        if (!element->prefix.empty()) {
+            out += element->prefix;
+            out += u':';
+        }
+        out += element->localName;
+        if (html) {
+            appendAttributes(element);
+            out += u'>';
+            if (element->namespaceURI != htmlNamespace)
+                return true;
+            if (isOneOf(element->localName, voidElements))
+                return false;
+            if (isOneOf(element->localName, newlineElements)) {
+                NodeImp* child = element->firstChild.get();
+                if (child && child->getNodeType() == Node::TEXT_NODE) {
+                    const std::u16string& data = static_cast<CharacterDataImp*>(child)->data;
+                    if (!data.empty() && data[0] == u'\n')
+                        out += u'\n';
+                }
+            }
+            return true;
+        }
+        openScope(element);
+        if (element->prefix != u"xml") {
+            const std::u16string* bound = lookupNamespace(element->prefix);
+            if (bound ? *bound != element->namespaceURI : (!element->prefix.empty() || !element->namespaceURI.empty()))
+                declareNamespace(element->prefix, element->namespaceURI);
+        }
+        appendXMLAttributes(element);
+        if (!element->firstChild) {
+            out += u"/>";
+            prefixes.resize(scopes.back());
+            scopes.pop_back();
+            return false;
+        }
+        out += u'>';
+        return true;
+    }
+    case Node::TEXT_NODE: {
+        const std::u16string& data = static_cast<CharacterDataImp*>(node)->data;
+        bool raw = false;
+        if (html && parent && parent->getNodeType() == Node::ELEMENT_NODE) {
+            ElementImp* element = static_cast<ElementImp*>(parent);
+            raw = element->namespaceURI == htmlNamespace && isOneOf(element->localName, rawTextElements);
+        }
+        if (raw)
+            out += data;
+        else
+            appendEscaped(data, false);
+        return false;
+    }
+    case Node::COMMENT_NODE:
+        out += u"<!--";
+        out += static_cast<CharacterDataImp*>(node)->data;
+        out += u"-->";
+        return false;
+    case Node::PROCESSING_INSTRUCTION_NODE: {
+        ProcessingInstructionImp* pi = static_cast<ProcessingInstructionImp*>(node);
+        out += u"<?";
+        out += pi->getTarget();
+        out += u' ';
+        out += static_cast<CharacterDataImp*>(node)->data;
+        out += html ? u">" : u"?>";
+        return false;
+    }
+    case Node::DOCUMENT_TYPE_NODE: {
+        DocumentTypeImp* doctype = static_cast<DocumentTypeImp*>(node);
+        out += u"<!DOCTYPE ";
+        out += doctype->getName();
+        if (!html) {
+            std::u16string publicId(doctype->getPublicId());
+            std::u16string systemId(doctype->getSystemId());
+            if (!publicId.empty()) {
+                out += u" PUBLIC \"";
+                out += publicId;
+                out += u'"';
+            } else if (!systemId.empty())
+                out += u" SYSTEM";
+            if (!systemId.empty()) {
+                out += u" \"";
+                out += systemId;
+                out += u'"';
+            }
+        }
+        out += u'>';
+        return false;
+    }
+    case Node::DOCUMENT_NODE:
+    case Node::DOCUMENT_FRAGMENT_NODE:
+        return true;
+    default:
+        return false;
+    }
+}
+
+void DOMSerializer::close(NodeImp* node)
+{
+    if (node->getNodeType() != Node::ELEMENT_NODE)
+        return;
+    ElementImp* element = static_cast<ElementImp*>(node);
+    out += u"</";
+    if (!element->prefix.empty()) {
+        out += element->prefix;
+        out += u':';
+    }
+    out += element->localName;
+    out += u'>';
+    if (!html) {
+        prefixes.resize(scopes.back());
+        scopes.pop_back();
+    }
+}
+
+void DOMSerializer::walk(NodeImp* root, bool includeRoot)
+{
+    // stack keeps the open nodes; the bottom base entries are never closed.
+    std::vector<NodeImp*> stack;
+    if (!includeRoot)
+        stack.push_back(root);
+    size_t base = stack.size();
+    NodeImp* node = includeRoot ? root : root->firstChild.get();
+    while (node) {
+        if (open(node, stack.empty() ? nullptr : stack.back())) {
+            if (NodeImp* child = node->firstChild.get()) {
+                stack.push_back(node);
+                node = child;
+                continue;
+            }
+            close(node);
+        }
+        for (;;) {
+            if (node == root) {
+                node = nullptr;
+                break;
+            }
+            if (NodeImp* next = node->nextSibling.get()) {
+                node = next;
+                break;
+            }
+            if (stack.size() <= base) {
+                node = nullptr;
+                break;
+            }
+            node = stack.back();
+            stack.pop_back();
+            close(node);
+        }
+    }
+}
+
+std::u16string DOMSerializer::getTextContent(NodeImp* node)
+{
+    size_t length = 0;
+    forEachDescendant(node, [&length](NodeImp* n) {
+        if (n->getNodeType() == Node::TEXT_NODE)
+            length += static_cast<CharacterDataImp*>(n)->data.length();
+    });
+    std::u16string content;
+    content.reserve(length);
+    forEachDescendant(node, [&content](NodeImp* n) {
+        if (n->getNodeType() == Node::TEXT_NODE)
+            content += static_cast<CharacterDataImp*>(n)->data;
+    });
+    return content;
+}
+
+std::u16string DOMSerializer::serializeHTML(NodeImp* node, bool includeNode)
+{
+    std::u16string out;
+    out.reserve(estimateLength(node));
+    DOMSerializer serializer(out, true);
+    serializer.walk(node, includeNode);
+    return out;
+}
+
+std::u16string DOMSerializer::serializeXML(NodeImp* node, bool includeNode)
+{
+    std::u16string out;
+    out.reserve(estimateLength(node));
+    DOMSerializer serializer(out, false);
+    if (!includeNode && node->getNodeType() == Node::ELEMENT_NODE) {
+        // Serialize the children in the namespace scope of node.
+        std::vector<ElementImp*> ancestors;
+        for (NodePtr i = std::static_pointer_cast<NodeImp>(node->self()); i; i = i->getParent()) {
+            if (i->getNodeType() == Node::ELEMENT_NODE)
+                ancestors.push_back(static_cast<ElementImp*>(i.get()));
+        }
+        for (auto i = ancestors.rbegin(); i != ancestors.rend(); ++i) {
+            ElementImp* element = *i;
+            serializer.openScope(element);
+            serializer.prefixes.emplace_back(element->prefix, element->namespaceURI);
+        }
+        serializer.scopes.clear();
+    }
+    serializer.walk(node, includeNode);
+    return out;
+}
+
+}}}}  // org::w3c::dom::bootstrap
@@ -0,0 +1,81 @@
+/*
+ * Copyright 2015 Esrille Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ORG_W3C_DOM_BOOTSTRAP_DOMSERIALIZER_H_INCLUDED
+#define ORG_W3C_DOM_BOOTSTRAP_DOMSERIALIZER_H_INCLUDED
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace org { namespace w3c { namespace dom { namespace bootstrap {
+
+class ElementImp;
+class NodeImp;
+
+// DOMSerializer serializes a subtree into a single output string. The tree is
+// walked iteratively rather than recursively, and the output buffer is
+// reserved up front from an estimate of the serialized length so that
+// serializing a large tree does not repeatedly reallocate and copy.
+class DOMSerializer
+{
+    std::u16string& out;
+    bool html;
+
+    // For XML, the namespace prefixes in scope as (prefix, namespace) pairs,
+    // where the empty prefix stands for the default namespace, and the size
+    // of prefixes at each open element.
+    std::vector<std::pair<std::u16string, std::u16string>> prefixes;
+    std::vector<size_t> scopes;
+    unsigned generatedPrefixCount;
+
+    DOMSerializer(std::u16string& out, bool html);
+
+    void appendEscaped(const std::u16string& text, bool attributeMode);
+    void appendAttributes(ElementImp* element);
+    const std::u16string* lookupNamespace(const std::u16string& prefix, bool inElement = false) const;
+    void declareNamespace(const std::u16string& prefix, const std::u16string& namespaceURI);
+    void openScope(ElementImp* element);
+    void appendXMLAttributes(ElementImp* element);
+    bool open(NodeImp* node, NodeImp* parent);
+    void close(NodeImp* node);
+    void walk(NodeImp* root, bool includeRoot);
+
+    template <typename F>
+    static void forEachDescendant(NodeImp* root, F f);
+    static size_t estimateLength(NodeImp* root);
+
+public:
+    // Returns the concatenation of the data of all the Text descendants of node.
+    static std::u16string getTextContent(NodeImp* node);
+
+    // Serializes node by the HTML fragment serialization algorithm. If
+    // includeNode is false, only the children of node are serialized as
+    // for innerHTML.
+    static std::u16string serializeHTML(NodeImp* node, bool includeNode);
+
+    // Serializes node as XML. If includeNode is false, only the children of
+    // node are serialized.
+    static std::u16string serializeXML(NodeImp* node, bool includeNode = true);
+};
+
+}}}}  // org::w3c::dom::bootstrap
+
+#endif  // ORG_W3C_DOM_BOOTSTRAP_DOMSERIALIZER_H_INCLUDED
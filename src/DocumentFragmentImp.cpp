@@ -16,6 +16,7 @@
 
 #include "DocumentFragmentImp.h"
 
+#include "DOMSerializer.h"
 #include "DocumentImp.h"
 #include "NodeListImp.h"
 
@@ -37,22 +38,7 @@ unsigned short DocumentFragmentImp::getNodeType()
 
 Nullable<std::u16string> DocumentFragmentImp::getTextContent()
 {
-    std::u16string content;
-    for (Node child = getFirstChild(); child; child = child.getNextSibling()) {
-        switch (child.getNodeType()) {
-        case Node::ELEMENT_NODE:
-        case Node::TEXT_NODE:
-        case Node::DOCUMENT_FRAGMENT_NODE: {
-            Nullable<std::u16string> text = child.getTextContent();
-            if (text.hasValue())
-                content += text.value();
-            break;
-        }
-        default:
-            break;
-        }
-    }
-    return content;
+    return DOMSerializer::getTextContent(this);
 }
 
 void DocumentFragmentImp::setTextContent(const Nullable<std::u16string>& textContent)
@@ -32,6 +32,7 @@
 #include "DocumentTypeImp.h"
 #include "ElementImp.h"
 #include "EventImp.h"
+#include "MutationObserverImp.h"
 #include "NodeListImp.h"
 #include "ObjectArrayImp.h"
 #include "RangeImp.h"
@@ -113,6 +114,7 @@ namespace org { namespace w3c { namespace dom { namespace bootstrap {
 
 DocumentImp::DocumentImp(const std::u16string& url) :
     ObjectMixin(nullptr),
+    arena(std::make_shared<NodeArena>()),
     url(url),
     mode(NoQuirksMode),
     readyState(u"loading"),
@@ -121,6 +123,9 @@ DocumentImp::DocumentImp(const std::u16string& url) :
     contentLoaded(false),
     insertionPoint(0),
     lastModified(0),
+    mutationDeliveryPending(false),
+    treeVersion(0),
+    attributeVersion(0),
     defaultView(0),
     error(0)
 {
@@ -302,6 +307,47 @@ void DocumentImp::appendRange(const RangePtr& range)
     rangeList.push_back(range);
 }
 
+void DocumentImp::addMutationObserver(const MutationObserverPtr& observer)
+{
+    pruneMutationObservers();
+    if (std::find(mutationObservers.begin(), mutationObservers.end(), observer) == mutationObservers.end())
+        mutationObservers.push_back(observer);
+}
+
+void DocumentImp::removeMutationObserver(const MutationObserverPtr& observer)
+{
+    mutationObservers.remove(observer);
+}
+
+// Drops the observers whose observed nodes are all gone, so that an observer
+// that is never disconnected does not live as long as the document.
+void DocumentImp::pruneMutationObservers()
+{
+    mutationObservers.remove_if([](const MutationObserverPtr& observer) { return !observer->hasRegistrations(); });
+}
+
+void DocumentImp::scheduleMutationDelivery()
+{
+    // Note the records queued in a document without a browsing context are
+    // kept until takeRecords() is called.
+    if (mutationDeliveryPending || !defaultView)
+        return;
+    mutationDeliveryPending = true;
+    Task task(self(), boost::bind(&DocumentImp::deliverMutationRecords, this));
+    defaultView->putTask(task);
+}
+
+void DocumentImp::deliverMutationRecords()
+{
+    mutationDeliveryPending = false;
+    std::list<MutationObserverPtr> observers(mutationObservers);
+    enter();
+    for (auto i = observers.begin(); i != observers.end(); ++i)
+        (*i)->deliver();
+    exit();
+    pruneMutationObservers();
+}
+
 void DocumentImp::eraseRange(const RangePtr& range)
 {
     for (auto i = rangeList.begin(); i != rangeList.end(); ++i) {
@@ -366,7 +412,7 @@ Element DocumentImp::getDocumentElement()
 
 html::HTMLCollection DocumentImp::getElementsByTagName(const std::u16string& localName)
 {
-    return ElementImp::getElementsByTagName(std::dynamic_pointer_cast<ElementImp>(getDocumentElement().self()), localName);
+    return ElementImp::getElementsByTagName(std::static_pointer_cast<NodeImp>(self()), localName);
 }
 
 html::HTMLCollection DocumentImp::getElementsByTagNameNS(const Nullable<std::u16string>& _namespace, const std::u16string& localName)
@@ -377,7 +423,7 @@ html::HTMLCollection DocumentImp::getElementsByTagNameNS(const Nullable<std::u16
 
 html::HTMLCollection DocumentImp::getElementsByClassName(const std::u16string& classNames)
 {
-    return ElementImp::getElementsByClassName(std::dynamic_pointer_cast<ElementImp>(getDocumentElement().self()), classNames);
+    return ElementImp::getElementsByClassName(std::static_pointer_cast<NodeImp>(self()), classNames);
 }
 
 Element DocumentImp::getElementById(const std::u16string& elementId)
@@ -400,80 +446,80 @@ Element DocumentImp::createElement(const std::u16string& localName)
 
     // Checked in the order of descriptions in the HTML specification
     if (name == u"html")
-        return std::make_shared<HTMLHtmlElementImp>(this);
+        return createNode<HTMLHtmlElementImp>();
     if (name == u"head")
-        return std::make_shared<HTMLHeadElementImp>(this);
+        return createNode<HTMLHeadElementImp>();
     if (name == u"title")
-        return std::make_shared<HTMLTitleElementImp>(this);
+        return createNode<HTMLTitleElementImp>();
     if (name == u"base")
-        return std::make_shared<HTMLBaseElementImp>(this);
+        return createNode<HTMLBaseElementImp>();
     if (name == u"link")
-        return std::make_shared<HTMLLinkElementImp>(this);
+        return createNode<HTMLLinkElementImp>();
     if (name == u"meta")
-        return std::make_shared<HTMLMetaElementImp>(this);
+        return createNode<HTMLMetaElementImp>();
     if (name == u"style")
-        return std::make_shared<HTMLStyleElementImp>(this);
+        return createNode<HTMLStyleElementImp>();
     if (name == u"script")
-        return std::make_shared<HTMLScriptElementImp>(this);
+        return createNode<HTMLScriptElementImp>();
     if (name == u"noscript")
-        return std::make_shared<HTMLElementImp>(this, name);
+        return createNode<HTMLElementImp>(name);
     if (name == u"body")
-        return std::make_shared<HTMLBodyElementImp>(this);
+        return createNode<HTMLBodyElementImp>();
     if (name == u"section" ||
         name == u"nav" ||
         name == u"article" ||
         name == u"aside")
-        return std::make_shared<HTMLElementImp>(this, name);
+        return createNode<HTMLElementImp>(name);
     if (name == u"h1" ||
         name == u"h2" ||
         name == u"h3" ||
         name == u"h4" ||
         name == u"h5" ||
         name == u"h6")
-        return std::make_shared<HTMLHeadingElementImp>(this, name);
+        return createNode<HTMLHeadingElementImp>(name);
     if (name == u"hgroup" ||
         name == u"header" ||
         name == u"footer" ||
         name == u"address")
-        return std::make_shared<HTMLElementImp>(this, name);
+        return createNode<HTMLElementImp>(name);
     if (name == u"p")
-        return std::make_shared<HTMLParagraphElementImp>(this);
+        return createNode<HTMLParagraphElementImp>();
     if (name == u"hr")
-        return std::make_shared<HTMLHRElementImp>(this);
+        return createNode<HTMLHRElementImp>();
     if (name == u"pre")
-        return std::make_shared<HTMLPreElementImp>(this);
+        return createNode<HTMLPreElementImp>();
     if (name == u"blockquote")
-        return std::make_shared<HTMLQuoteElementImp>(this, name);
+        return createNode<HTMLQuoteElementImp>(name);
     if (name == u"ol")
-        return std::make_shared<HTMLOListElementImp>(this);
+        return createNode<HTMLOListElementImp>();
     if (name == u"ul")
-        return std::make_shared<HTMLUListElementImp>(this);
+        return createNode<HTMLUListElementImp>();
     if (name == u"li")
-        return std::make_shared<HTMLLIElementImp>(this);
+        return createNode<HTMLLIElementImp>();
     if (name == u"dl")
-        return std::make_shared<HTMLDListElementImp>(this);
+        return createNode<HTMLDListElementImp>();
     if (name == u"dt" ||
         name == u"dd" ||
         name == u"figure" ||
         name == u"figcaption")
-        return std::make_shared<HTMLElementImp>(this, name);
+        return createNode<HTMLElementImp>(name);
     if (name == u"div")
-        return std::make_shared<HTMLDivElementImp>(this);
+        return createNode<HTMLDivElementImp>();
     if (name == u"a")
-        return std::make_shared<HTMLAnchorElementImp>(this);
+        return createNode<HTMLAnchorElementImp>();
     if (name == u"em" ||
         name == u"strong" ||
         name == u"small" ||
         name == u"s" ||
         name == u"cite")
-        return std::make_shared<HTMLElementImp>(this, name);
+        return createNode<HTMLElementImp>(name);
     if (name == u"q")
-        return std::make_shared<HTMLQuoteElementImp>(this, name);
+        return createNode<HTMLQuoteElementImp>(name);
     if (name == u"dfn" ||
         name == u"abbr")
-        return std::make_shared<HTMLElementImp>(this, name);
+        return createNode<HTMLElementImp>(name);
     if (name == u"time")
-        return std::make_shared<HTMLTimeElementImp>(this);
+        return createNode<HTMLTimeElementImp>();
     if (name == u"code" ||
         name == u"var" ||
         name == u"samp" ||
@@ -489,117 +535,117 @@ Element DocumentImp::createElement(const std::u16string& localName)
         name == u"rp" ||
         name == u"bdi" ||
         name == u"bdo")
-        return std::make_shared<HTMLElementImp>(this, name);
+        return createNode<HTMLElementImp>(name);
     if (name == u"span")
-        return std::make_shared<HTMLSpanElementImp>(this);
+        return createNode<HTMLSpanElementImp>();
     if (name == u"br")
-        return std::make_shared<HTMLBRElementImp>(this);
+        return createNode<HTMLBRElementImp>();
     if (name == u"wbr")
-        return std::make_shared<HTMLElementImp>(this, name);
+        return createNode<HTMLElementImp>(name);
     if (name == u"ins" ||
         name == u"del")
-        return std::make_shared<HTMLModElementImp>(this, name);
+        return createNode<HTMLModElementImp>(name);
     if (name == u"img")
-        return std::make_shared<HTMLImageElementImp>(this);
+        return createNode<HTMLImageElementImp>();
     if (name == u"iframe") {
         auto context = getDefaultWindow();
         assert(context);
-        auto iframe = std::make_shared<HTMLIFrameElementImp>(this);
+        auto iframe = createNode<HTMLIFrameElementImp>();
         iframe->open(u"about:blank", context->isDeskTop() ? WindowProxy::TopLevel : 0);
         return iframe;
     }
     if (name == u"embed")
-        return std::make_shared<HTMLEmbedElementImp>(this);
+        return createNode<HTMLEmbedElementImp>();
     if (name == u"object")
-        return std::make_shared<HTMLObjectElementImp>(this);
+        return createNode<HTMLObjectElementImp>();
     if (name == u"param")
-        return std::make_shared<HTMLParamElementImp>(this);
+        return createNode<HTMLParamElementImp>();
     if (name == u"video")
-        return std::make_shared<HTMLVideoElementImp>(this);
+        return createNode<HTMLVideoElementImp>();
     if (name == u"audio")
-        return std::make_shared<HTMLAudioElementImp>(this);
+        return createNode<HTMLAudioElementImp>();
     if (name == u"source")
-        return std::make_shared<HTMLSourceElementImp>(this);
+        return createNode<HTMLSourceElementImp>();
     if (name == u"canvas")
-        return std::make_shared<HTMLCanvasElementImp>(this);
+        return createNode<HTMLCanvasElementImp>();
     if (name == u"map")
-        return std::make_shared<HTMLMapElementImp>(this);
+        return createNode<HTMLMapElementImp>();
     if (name == u"area")
-        return std::make_shared<HTMLAreaElementImp>(this);
+        return createNode<HTMLAreaElementImp>();
     if (name == u"table")
-        return std::make_shared<HTMLTableElementImp>(this);
+        return createNode<HTMLTableElementImp>();
     if (name == u"caption")
-        return std::make_shared<HTMLTableCaptionElementImp>(this);
+        return createNode<HTMLTableCaptionElementImp>();
     if (name == u"colgroup" ||
         name == u"col")
-        return std::make_shared<HTMLTableColElementImp>(this, name);
+        return createNode<HTMLTableColElementImp>(name);
     if (name == u"tbody" ||
         name == u"thead" ||
         name == u"tfoot")
-        return std::make_shared<HTMLTableSectionElementImp>(this, name);
+        return createNode<HTMLTableSectionElementImp>(name);
     if (name == u"tr")
-        return std::make_shared<HTMLTableRowElementImp>(this);
+        return createNode<HTMLTableRowElementImp>();
     if (name == u"td")
-        return std::make_shared<HTMLTableDataCellElementImp>(this);
+        return createNode<HTMLTableDataCellElementImp>();
     if (name == u"th")
-        return std::make_shared<HTMLTableHeaderCellElementImp>(this);
+        return createNode<HTMLTableHeaderCellElementImp>();
     if (name == u"form")
-        return std::make_shared<HTMLFormElementImp>(this);
+        return createNode<HTMLFormElementImp>();
     if (name == u"fieldset")
-        return std::make_shared<HTMLFieldSetElementImp>(this);
+        return createNode<HTMLFieldSetElementImp>();
     if (name == u"legend")
-        return std::make_shared<HTMLLegendElementImp>(this);
+        return createNode<HTMLLegendElementImp>();
     if (name == u"label")
-        return std::make_shared<HTMLLabelElementImp>(this);
+        return createNode<HTMLLabelElementImp>();
     if (name == u"input")
-        return std::make_shared<HTMLInputElementImp>(this);
+        return createNode<HTMLInputElementImp>();
     if (name == u"button")
-        return std::make_shared<HTMLButtonElementImp>(this);
+        return createNode<HTMLButtonElementImp>();
     if (name == u"select")
-        return std::make_shared<HTMLSelectElementImp>(this);
+        return createNode<HTMLSelectElementImp>();
     if (name == u"datalist")
-        return std::make_shared<HTMLDataListElementImp>(this);
+        return createNode<HTMLDataListElementImp>();
     if (name == u"optgroup")
-        return std::make_shared<HTMLOptGroupElementImp>(this);
+        return createNode<HTMLOptGroupElementImp>();
     if (name == u"option")
-        return std::make_shared<HTMLOptionElementImp>(this);
+        return createNode<HTMLOptionElementImp>();
     if (name == u"textarea")
-        return std::make_shared<HTMLTextAreaElementImp>(this);
+        return createNode<HTMLTextAreaElementImp>();
     if (name == u"keygen")
-        return std::make_shared<HTMLKeygenElementImp>(this);
+        return createNode<HTMLKeygenElementImp>();
     if (name == u"output")
-        return std::make_shared<HTMLOutputElementImp>(this);
+        return createNode<HTMLOutputElementImp>();
     if (name == u"progress")
-        return std::make_shared<HTMLProgressElementImp>(this);
+        return createNode<HTMLProgressElementImp>();
     if (name == u"meter")
-        return std::make_shared<HTMLMeterElementImp>(this);
+        return createNode<HTMLMeterElementImp>();
     if (name == u"details")
-        return std::make_shared<HTMLDetailsElementImp>(this);
+        return createNode<HTMLDetailsElementImp>();
     if (name == u"summary")
-        return std::make_shared<HTMLElementImp>(this, name);
+        return createNode<HTMLElementImp>(name);
     if (name == u"command")
-        return std::make_shared<HTMLCommandElementImp>(this);
+        return createNode<HTMLCommandElementImp>();
     if (name == u"menu")
-        return std::make_shared<HTMLMenuElementImp>(this);
+        return createNode<HTMLMenuElementImp>();
 
     if (name == u"binding")
-        return std::make_shared<HTMLBindingElementImp>(this);
+        return createNode<HTMLBindingElementImp>();
     if (name == u"template")
-        return std::make_shared<HTMLTemplateElementImp>(this);
+        return createNode<HTMLTemplateElementImp>();
     if (name == u"implementation")
-        return std::make_shared<HTMLScriptElementImp>(this, name);
+        return createNode<HTMLScriptElementImp>(name);
 
     // Deprecated elements
     if (name == u"applet")
-        return std::make_shared<HTMLAppletElementImp>(this);
+        return createNode<HTMLAppletElementImp>();
     if (name == u"center")   // shorthand for DIV align=center
-        return std::make_shared<HTMLDivElementImp>(this, name);
+        return createNode<HTMLDivElementImp>(name);
     if (name == u"font")
-        return std::make_shared<HTMLFontElementImp>(this);
+        return createNode<HTMLFontElementImp>();
     if (name == u"marquee")
-        return std::make_shared<HTMLMarqueeElementImp>(this);
+        return createNode<HTMLMarqueeElementImp>();
 
-    return std::make_shared<HTMLUnknownElementImp>(this, name);
+    return createNode<HTMLUnknownElementImp>(name);
 }
 
 Element DocumentImp::createElementNS(const Nullable<std::u16string>& namespaceURI, const std::u16string& qualifiedName)
@@ -623,7 +669,7 @@ Element DocumentImp::createElementNS(const Nullable<std::u16string>& namespaceUR
     if (namespaceURI == u"http://www.w3.org/1999/xhtml" && prefix.empty())  // TODO: Check prefix
         return createElement(localName);
 
-    return std::make_shared<ElementImp>(this, localName, namespaceURI, prefix);
+    return createNode<ElementImp>(localName, namespaceURI, prefix);
 }
 
 DocumentFragment DocumentImp::createDocumentFragment()
@@ -634,12 +680,12 @@ DocumentFragment DocumentImp::createDocumentFragment()
 
 Text DocumentImp::createTextNode(const std::u16string& data)
 {
-    return std::make_shared<TextImp>(this, data);
+    return createNode<TextImp>(data);
 }
 
 Comment DocumentImp::createComment(const std::u16string& data)
 {
-    return std::make_shared<CommentImp>(this, data);
+    return createNode<CommentImp>(data);
 }
 
 ProcessingInstruction DocumentImp::createProcessingInstruction(const std::u16string& target, const std::u16string& data)
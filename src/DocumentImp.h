@@ -53,6 +53,7 @@
 #include <deque>
 #include <list>
 
+#include "NodeArena.h"
 #include "NodeImp.h"
 #include "EventListenerImp.h"
 #include "html/HTMLScriptElementImp.h"
@@ -68,8 +69,12 @@ typedef std::shared_ptr<RangeImp> RangePtr;
 class WindowProxy;
 typedef std::shared_ptr<WindowProxy> WindowProxyPtr;
 
+class MutationObserverImp;
+typedef std::shared_ptr<MutationObserverImp> MutationObserverPtr;
+
 class DocumentImp : public ObjectMixin<DocumentImp, NodeImp>
 {
+    NodeArenaPtr arena;
     std::u16string url;
     std::u16string contentType;
     DocumentType doctype;
@@ -90,6 +95,12 @@ class DocumentImp : public ObjectMixin<DocumentImp, NodeImp>
     std::list<html::HTMLScriptElement> orderedScripts;
 
     std::list<std::weak_ptr<RangeImp>> rangeList;
+    std::list<MutationObserverPtr> mutationObservers;
+    bool mutationDeliveryPending;
+
+    // DOM version counters used to invalidate the live collections
+    unsigned treeVersion;
+    unsigned attributeVersion;
 
     WindowProxyPtr defaultView;
     std::weak_ptr<ElementImp> activeElement;
@@ -114,6 +125,17 @@ public:
          LimitedQuirksMode
     };
 
+    // Allocates a node owned by this document from the document's node arena.
+    // The first argument of the node constructor, i.e., the owner document,
+    // is supplied by createNode() itself.
+    template<class T, class... As>
+    std::shared_ptr<T> createNode(As&&... as) {
+        return std::allocate_shared<T>(NodeAllocator<T>(arena), this, std::forward<As>(as)...);
+    }
+    const NodeArenaPtr& getNodeArena() const {
+        return arena;
+    }
+
     WindowProxyPtr getDefaultWindow() const {
         return defaultView;
     }
@@ -250,6 +272,37 @@ public:
         }
     }
 
+    // The observers of the nodes owned by this document
+    bool hasMutationObservers() const {
+        return !mutationObservers.empty();
+    }
+    const std::list<MutationObserverPtr>& getMutationObservers() const {
+        return mutationObservers;
+    }
+    void addMutationObserver(const MutationObserverPtr& observer);
+    void removeMutationObserver(const MutationObserverPtr& observer);
+    void pruneMutationObservers();
+    // Posts a task to the window to deliver the queued mutation records,
+    // unless one has been posted already.
+    void scheduleMutationDelivery();
+    void deliverMutationRecords();
+
+    // treeVersion is incremented whenever a node owned by this document is
+    // inserted or removed, and attributeVersion whenever an attribute value
+    // is changed.
+    unsigned getTreeVersion() const {
+        return treeVersion;
+    }
+    void incrementTreeVersion() {
+        ++treeVersion;
+    }
+    unsigned getAttributeVersion() const {
+        return attributeVersion;
+    }
+    void incrementAttributeVersion() {
+        ++attributeVersion;
+    }
+
     // Node - override
     virtual unsigned short getNodeType();
     virtual Node appendChild(Node newChild);
@@ -22,15 +22,18 @@
 #include <vector>
 #include <boost/algorithm/string.hpp>
 
+#include <org/w3c/dom/ObjectArray.h>
+
 #include "utf.h"
 #include "Test.util.h"
 
 #include "AttrImp.h"
 #include "DocumentImp.h"
+#include "DOMSerializer.h"
 #include "DOMTokenListImp.h"
 #include "MutationEventImp.h"
+#include "MutationObserverImp.h"
 #include "NodeListImp.h"
-#include "ObjectArrayImp.h"
 #include "XMLDocumentImp.h"
 #include "WindowProxy.h"
 #include "css/CSSSerialize.h"
@@ -40,18 +43,148 @@
 
 namespace org { namespace w3c { namespace dom { namespace bootstrap {
 
-void ElementImp::setAttributes(const std::deque<Attr>& attributes)
+namespace {
+
+AttrPtr createAttr(const DocumentPtr& document, const Nullable<std::u16string>& namespaceURI, const Nullable<std::u16string>& prefix, const std::u16string& localName, const std::u16string& value)
+{
+    if (document)
+        return std::allocate_shared<AttrImp>(NodeAllocator<AttrImp>(document->getNodeArena()), namespaceURI, prefix, localName, value);
+    return std::make_shared<AttrImp>(namespaceURI, prefix, localName, value);
+}
+
+// Returns true if name matches the lower case attribute name stored, comparing
+// in an ASCII case-insensitive manner without making a lowered copy of name.
+bool matchesLowerCase(const std::u16string& stored, const std::u16string& name)
+{
+    size_t length = stored.length();
+    if (length != name.length())
+        return false;
+    for (size_t i = 0; i < length; ++i) {
+        if (stored[i] != toLower(name[i]))
+            return false;
+    }
+    return true;
+}
+
+}
+
+// Attr[] for Element.attributes; Attr objects are created on demand.
+class AttrArray : public Imp
+{
+    ElementPtr element;
+public:
+    virtual unsigned int getLength() {
+        return element->getAttributeCount();
+    }
+    virtual void setLength(unsigned int length) {
+    }
+    virtual Attr getElement(unsigned int index) {
+        return element->getAttributeNode(index);
+    }
+    virtual void setElement(unsigned int index, Attr value) {
+    }
+    // Object
+    virtual Any message_(uint32_t selector, const char* id, int argc, Any* argv) {
+        return ObjectArray<Attr>::dispatch(this, selector, id, argc, argv);
+    }
+    AttrArray(const ElementPtr& element) :
+        element(element)
+    {}
+};
+
+int ElementImp::findAttribute(const std::u16string& name) const
 {
-    for (auto i = attributes.begin(); i != attributes.end(); ++i) {
-        Attr attr = *i;
-        setAttributeNS(attr.getNamespaceURI(), attr.getName(), attr.getValue());
+    // TODO: If the context node is in the HTML namespace and its ownerDocument is an HTML document
+    for (size_t i = 0; i < attributes.size(); ++i) {
+        if (matchesLowerCase(attributes[i].name, name))
+            return i;
+    }
+    return -1;
+}
+
+int ElementImp::findAttributeNS(const std::u16string& namespaceURI, const std::u16string& localName) const
+{
+    for (size_t i = 0; i < attributes.size(); ++i) {
+        const AttrEntry& entry = attributes[i];
+        if (entry.attr) {
+            if (entry.attr->matches(namespaceURI, localName))
+                return i;
+        } else if (namespaceURI.empty() && entry.name == localName)
+            return i;
+    }
+    return -1;
+}
+
+AttrPtr ElementImp::getAttributeNode(unsigned int index)
+{
+    if (attributes.size() <= index)
+        return nullptr;
+    AttrEntry& entry = attributes[index];
+    if (!entry.attr) {
+        entry.attr = createAttr(getOwnerDocumentImp(), Nullable<std::u16string>(), Nullable<std::u16string>(), entry.name, entry.value);
+        entry.attr->setOwnerElement(std::static_pointer_cast<ElementImp>(self()));
     }
+    return entry.attr;
+}
+
+AttrPtr ElementImp::getAttributeNode(const std::u16string& name)
+{
+    int index = findAttribute(name);
+    if (index < 0)
+        return nullptr;
+    return getAttributeNode(index);
+}
+
+void ElementImp::updateAttrValue(AttrImp* attr, const std::u16string& value)
+{
+    for (size_t i = 0; i < attributes.size(); ++i) {
+        if (attributes[i].attr.get() == attr) {
+            attributes[i].value = value;
+            if (DocumentPtr document = getOwnerDocumentImp())
+                document->incrementAttributeVersion();
+            return;
+        }
+    }
+}
+
+// attrName and prevValue are taken by value since a DOMAttrModified listener
+// can add or remove attributes, and the entry at index is not accessed after
+// the event has been dispatched.
+void ElementImp::dispatchAttrModified(size_t index, std::u16string attrName, std::u16string prevValue, const std::u16string& newValue, unsigned short attrChange)
+{
+    if (DocumentPtr document = getOwnerDocumentImp())
+        document->incrementAttributeVersion();
+    AttrPtr attr = attributes[index].attr;
+    Nullable<std::u16string> namespaceURI;
+    if (attr)
+        namespaceURI = attr->getNamespaceURI();
+    // Queue the record before any listener can change the attributes again.
+    MutationObserverImp::queueAttributes(std::static_pointer_cast<ElementImp>(self()), attrName, namespaceURI, prevValue);
+    if (hasMutationListeners(AttrModifiedListener)) {
+        auto event = std::make_shared<MutationEventImp>();
+        event->initMutationEvent(u"DOMAttrModified", true, false, attr, prevValue, newValue, attrName, attrChange);
+        if (!attr)
+            event->setRelatedAttr(std::static_pointer_cast<ElementImp>(self()), attributes[index].name);
+        dispatchEvent(event);
+    }
+}
+
+void ElementImp::setAttributes(const std::deque<Attribute>& attributes)
+{
+    for (auto i = attributes.begin(); i != attributes.end(); ++i)
+        setAttributeNS(Nullable<std::u16string>(), i->getName(), i->getValue());
 }
 
 void ElementImp::cloneAttributes(const ElementImp* org)
 {
     assert(org);
-    setAttributes(org->attributes);
+    for (size_t i = 0; i < org->attributes.size(); ++i) {
+        const AttrEntry& entry = org->attributes[i];
+        if (entry.attr)
+            setAttributeNS(entry.attr->getNamespaceURI(), entry.attr->getName(), entry.value);
+        else
+            setAttributeNS(Nullable<std::u16string>(), entry.name, entry.value);
+    }
 }
 
 ElementPtr ElementImp::getNextElement(const ElementPtr& root)
@@ -81,22 +214,7 @@ unsigned short ElementImp::getNodeType()
 
 Nullable<std::u16string> ElementImp::getTextContent()
 {
-    std::u16string content;
-    for (Node child = getFirstChild(); child; child = child.getNextSibling()) {
-        switch (child.getNodeType()) {
-        case Node::ELEMENT_NODE:
-        case Node::TEXT_NODE:
-        case Node::DOCUMENT_FRAGMENT_NODE: {
-            Nullable<std::u16string> text = child.getTextContent();
-            if (text.hasValue())
-                content += text.value();
-            break;
-        }
-        default:
-            break;
-        }
-    }
-    return content;
+    return DOMSerializer::getTextContent(this);
 }
 
 void ElementImp::setTextContent(const Nullable<std::u16string>& textContent)
@@ -127,19 +245,11 @@ bool ElementImp::isEqualNode(Node arg)
         return false;
     if (attributes.size() != element->attributes.size())
         return false;
-    for (auto i = attributes.begin(); i != attributes.end(); ++i) {
-        bool found = false;
-        for (auto j = element->attributes.begin(); j != element->attributes.end(); ++j) {
-            if (i->getLocalName() == j->getLocalName()) {
-                if (i->getNamespaceURI() != j->getNamespaceURI())
-                    break;
-                if (i->getValue() != j->getValue())
-                    break;
-                found = true;
-                break;
-            }
-        }
-        if (!found)
+    for (size_t i = 0; i < attributes.size(); ++i) {
+        const AttrEntry& entry = attributes[i];
+        int j = entry.attr ? element->findAttributeNS(entry.attr->getNamespaceURI(), entry.attr->getLocalName()) :
+                             element->findAttributeNS(u"", entry.name);
+        if (j < 0 || entry.value != element->attributes[j].value)
             return false;
     }
     return NodeImp::isEqualNode(arg);
@@ -193,60 +303,48 @@ DOMTokenList ElementImp::getClassList()
 
 dom::ObjectArray<Attr> ElementImp:: getAttributes()
 {
-    return std::make_shared<ObjectArrayImp<ElementImp, Attr, &ElementImp::attributes>>(std::static_pointer_cast<ElementImp>(self()));
+    return std::make_shared<AttrArray>(std::static_pointer_cast<ElementImp>(self()));
 }
 
 Nullable<std::u16string> ElementImp::getAttribute(const std::u16string& name)
 {
-    // TODO: If the context node is in the HTML namespace and its ownerDocument is an HTML document
-    std::u16string n(name);
-        toLower(n);
-    for (auto i = attributes.begin(); i != attributes.end(); ++i) {
-        Attr attr = *i;
-        if (attr.getName() == n)
-            return attr.getValue();
-    }
-    return Nullable<std::u16string>();
+    int index = findAttribute(name);
+    if (index < 0)
+        return Nullable<std::u16string>();
+    return attributes[index].value;
 }
 
 Nullable<std::u16string> ElementImp::getAttributeNS(const Nullable<std::u16string>& namespaceURI, const std::u16string& localName)
 {
-    for (auto i = attributes.begin(); i != attributes.end(); ++i) {
-        Attr attr = *i;
-        if (static_cast<std::u16string>(attr.getNamespaceURI()) == static_cast<std::u16string>(namespaceURI) && attr.getLocalName() == localName)
-            return attr.getValue();
-    }
-    return Nullable<std::u16string>();
+    int index = findAttributeNS(namespaceURI, localName);
+    if (index < 0)
+        return Nullable<std::u16string>();
+    return attributes[index].value;
 }
 
 void ElementImp::setAttribute(const std::u16string& name, const std::u16string& value)
 {
     // TODO: If qualifiedName does not match the Name production in XML, raise an INVALID_CHARACTER_ERR exception and terminate these steps.
-    // TODO: If the context node is in the HTML namespace and its ownerDocument is an HTML document
-    std::u16string n(name);
-        toLower(n);
     // TODO: If qualifiedName starts with "xmlns", raise a NAMESPACE_ERR and terminate these steps.
-    for (auto i = attributes.begin(); i != attributes.end(); ++i) {
-        Attr attr = *i;
-        if (attr.getName() == n) {
-            std::u16string prevValue = attr.getValue();
-            if (prevValue != value) {
-                attr.setValue(value);
-                events::MutationEvent event = std::make_shared<MutationEventImp>();
-                event.initMutationEvent(u"DOMAttrModified",
-                                        true, false, attr, prevValue, value, n, events::MutationEvent::MODIFICATION);
-                this->dispatchEvent(event);
-            }
-            return;
+    int index = findAttribute(name);
+    if (0 <= index) {
+        AttrEntry& entry = attributes[index];
+        if (entry.value != value) {
+            std::u16string prevValue(std::move(entry.value));
+            entry.value = value;
+            if (entry.attr)
+                entry.attr->value = value;
+            dispatchAttrModified(index, entry.name, prevValue, value, events::MutationEvent::MODIFICATION);
         }
+        return;
     }
-    if (Attr attr = std::make_shared<AttrImp>(Nullable<std::u16string>(), Nullable<std::u16string>(), n, value)) {
-        attributes.push_back(attr);
-        events::MutationEvent event = std::make_shared<MutationEventImp>();
-        event.initMutationEvent(u"DOMAttrModified",
-                                true, false, attr, u"", value, n, events::MutationEvent::ADDITION);
-        this->dispatchEvent(event);
-    }
+    AttrEntry entry;
+    entry.name = name;
+    toLower(entry.name);
+    entry.value = value;
+    attributes.push_back(std::move(entry));
+    index = attributes.size() - 1;
+    dispatchAttrModified(index, attributes[index].name, u"", value, events::MutationEvent::ADDITION);
 }
 
 void ElementImp::setAttributeNS(const Nullable<std::u16string>& namespaceURI, const std::u16string& name, const std::u16string& value)
@@ -272,85 +370,77 @@ void ElementImp::setAttributeNS(const Nullable<std::u16string>& namespaceURI, co
     if ((name == u"xmlns" || prefix.hasValue() && prefix.value() == u"xmlns") && namespaceURI != u"http://www.w3.org/2000/xmlns")
         throw DOMException{DOMException::NAMESPACE_ERR};
  */
-    for (auto i = attributes.begin(); i != attributes.end(); ++i) {
-        Attr attr = *i;
-        if (static_cast<std::u16string>(attr.getNamespaceURI()) == static_cast<std::u16string>(namespaceURI) && attr.getLocalName() == localName) {
-            std::u16string prevValue = attr.getValue();
-            if (prevValue != value) {
-                attr.setValue(value);
-                // TODO: set prefix, too.
-
-                events::MutationEvent event = std::make_shared<MutationEventImp>();
-                event.initMutationEvent(u"DOMAttrModified",
-                                        true, false, attr, prevValue, value, localName, events::MutationEvent::MODIFICATION);
-                dispatchEvent(event);
-            }
-            return;
+    int index = findAttributeNS(namespaceURI, localName);
+    if (0 <= index) {
+        AttrEntry& entry = attributes[index];
+        if (entry.value != value) {
+            std::u16string prevValue(std::move(entry.value));
+            entry.value = value;
+            if (entry.attr)
+                entry.attr->value = value;
+            // TODO: set prefix, too.
+            dispatchAttrModified(index, localName, prevValue, value, events::MutationEvent::MODIFICATION);
         }
+        return;
     }
-    if (Attr attr = std::make_shared<AttrImp>(namespaceURI, prefix, localName, value)) {
-        attributes.push_back(attr);
-        events::MutationEvent event = std::make_shared<MutationEventImp>();
-        event.initMutationEvent(u"DOMAttrModified",
-                                true, false, attr, u"", value, localName, events::MutationEvent::ADDITION);
-        dispatchEvent(event);
+    AttrEntry entry;
+    entry.name = name;
+    entry.value = value;
+    if (prefix.hasValue() || !static_cast<std::u16string>(namespaceURI).empty()) {
+        entry.attr = createAttr(getOwnerDocumentImp(), namespaceURI, prefix, localName, value);
+        entry.attr->setOwnerElement(std::static_pointer_cast<ElementImp>(self()));
     }
+    attributes.push_back(std::move(entry));
+    dispatchAttrModified(attributes.size() - 1, localName, u"", value, events::MutationEvent::ADDITION);
 }
 
 void ElementImp::removeAttribute(const std::u16string& name)
 {
-    // TODO: If the context node is in the HTML namespace and its ownerDocument is an HTML document
-    std::u16string n(name);
-        toLower(n);
-    for (auto i = attributes.begin(); i != attributes.end();) {
-        Attr attr = *i;
-        if (attr.getName() == n) {
-            events::MutationEvent event = std::make_shared<MutationEventImp>();
-            event.initMutationEvent(u"DOMAttrModified",
-                                    true, false, attr, attr.getValue(), u"", n, events::MutationEvent::REMOVAL);
-            this->dispatchEvent(event);
-            i = attributes.erase(i);
-        } else
-            ++i;
-    }
+    int index = findAttribute(name);
+    if (index < 0)
+        return;
+    std::u16string n(attributes[index].name);
+    // A DOMAttrModified listener can no longer find the removed Attr through
+    // this element, so it is created here only for the listeners.
+    AttrPtr attr = hasMutationListeners(AttrModifiedListener) ? getAttributeNode(index) : attributes[index].attr;
+    dispatchAttrModified(index, n, attributes[index].value, u"", events::MutationEvent::REMOVAL);
+    eraseAttribute(attr, attr ? -1 : findAttribute(n));
 }
 
 void ElementImp::removeAttributeNS(const Nullable<std::u16string>& namespaceURI, const std::u16string& localName)
 {
-    for (auto i = attributes.begin(); i != attributes.end();) {
-        Attr attr = *i;
-        if (static_cast<std::u16string>(attr.getNamespaceURI()) == static_cast<std::u16string>(namespaceURI) && attr.getLocalName() == localName) {
-            events::MutationEvent event = std::make_shared<MutationEventImp>();
-            event.initMutationEvent(u"DOMAttrModified",
-                                    true, false, attr, attr.getValue(), u"", localName, events::MutationEvent::REMOVAL);
-            this->dispatchEvent(event);
-            i = attributes.erase(i);
-        } else
-            ++i;
-    }
+    int index = findAttributeNS(namespaceURI, localName);
+    if (index < 0)
+        return;
+    AttrPtr attr = hasMutationListeners(AttrModifiedListener) ? getAttributeNode(index) : attributes[index].attr;
+    dispatchAttrModified(index, localName, attributes[index].value, u"", events::MutationEvent::REMOVAL);
+    eraseAttribute(attr, attr ? -1 : findAttributeNS(namespaceURI, localName));
+}
+
+// Erases the entry of attr, or the one at index if attr is null. Note a
+// DOMAttrModified listener may have moved the entry.
+void ElementImp::eraseAttribute(const AttrPtr& attr, int index)
+{
+    if (attr) {
+        for (size_t i = 0; i < attributes.size(); ++i) {
+            if (attributes[i].attr == attr) {
+                attributes.erase(attributes.begin() + i);
+                break;
+            }
+        }
+        attr->setOwnerElement(nullptr);
+    } else if (0 <= index)
+        attributes.erase(attributes.begin() + index);
 }
 
 bool ElementImp::hasAttribute(const std::u16string& name)
 {
-    // TODO: If the context node is in the HTML namespace and its ownerDocument is an HTML document
-    std::u16string n(name);
-        toLower(n);
-    for (auto i = attributes.begin(); i != attributes.end(); ++i) {
-        Attr attr = *i;
-        if (attr.getName() == n)
-            return true;
-    }
-    return false;
+    return 0 <= findAttribute(name);
 }
 
 bool ElementImp::hasAttributeNS(const Nullable<std::u16string>& namespaceURI, const std::u16string& localName)
 {
-    for (auto i = attributes.begin(); i != attributes.end(); ++i) {
-        Attr attr = *i;
-        if (static_cast<std::u16string>(attr.getNamespaceURI()) == static_cast<std::u16string>(namespaceURI) && attr.getLocalName() == localName)
-            return true;
-    }
-    return false;
+    return 0 <= findAttributeNS(namespaceURI, localName);
 }
 
 html::HTMLCollection ElementImp::getChildren()
@@ -359,21 +449,65 @@ html::HTMLCollection ElementImp::getChildren()
     return nullptr;
 }
 
-HTMLCollectionPtr ElementImp::getElementsByTagName(const ElementPtr& element, const std::u16string& localName)
+namespace {
+
+class ElementsByTagNameImp : public LiveHTMLCollectionImp
 {
-    HTMLCollectionPtr list = std::make_shared<HTMLCollectionImp>();
-    if (!list)
-        return nullptr;
+    bool all;
 
-    if (localName == u"*") {
-        for (ElementPtr e = element; e; e = e->getNextElement())
-            list->addItem(e);
-    } else {
+protected:
+    virtual bool match(ElementImp* element) {
         // TODO: Support non HTML document
-        for (ElementPtr e = element; e; e = e->getNextElement()) {
-            if (e->getLocalName() == localName)
-                list->addItem(e);
+        return all || element->getLocalName() == getKey();
+    }
+
+public:
+    ElementsByTagNameImp(const NodePtr& root, const std::u16string& localName) :
+        LiveHTMLCollectionImp(root, ElementsByTagName, localName),
+        all(localName == u"*")
+    {
+    }
+};
+
+class ElementsByClassNameImp : public LiveHTMLCollectionImp
+{
+    std::vector<std::u16string> classes;
+
+protected:
+    // The class names of the elements can change without mutating the tree.
+    virtual unsigned getVersion(DocumentImp* document) {
+        return document->getTreeVersion() + document->getAttributeVersion();
+    }
+    virtual bool match(ElementImp* element) {
+        if (classes.empty())
+            return false;
+        std::u16string c = element->getClassName();
+        std::vector<std::u16string> v;
+        boost::algorithm::split(v, c, isSpace);
+        for (auto i = classes.begin(); i != classes.end(); ++i) {
+            if (std::find(v.begin(), v.end(), *i) == v.end())
+                return false;
         }
+        return true;
+    }
+
+public:
+    ElementsByClassNameImp(const NodePtr& root, const std::u16string& classNames) :
+        LiveHTMLCollectionImp(root, ElementsByClassName, classNames)
+    {
+        boost::algorithm::split(classes, classNames, isSpace, boost::algorithm::token_compress_on);
+        classes.erase(std::remove(classes.begin(), classes.end(), u""), classes.end());
+    }
+};
+
+}
+
+HTMLCollectionPtr ElementImp::getElementsByTagName(const NodePtr& root, const std::u16string& localName)
+{
+    auto list = root->findLiveCollection(LiveHTMLCollectionImp::ElementsByTagName, localName);
+    if (!list) {
+        list = std::make_shared<ElementsByTagNameImp>(root, localName);
+        root->addLiveCollection(list);
     }
     return list;
 }
@@ -389,27 +523,12 @@ html::HTMLCollection ElementImp::getElementsByTagNameNS(const Nullable<std::u16s
     return nullptr;
 }
 
-HTMLCollectionPtr ElementImp::getElementsByClassName(const ElementPtr& element, const std::u16string& classNames)
+HTMLCollectionPtr ElementImp::getElementsByClassName(const NodePtr& root, const std::u16string& classNames)
 {
-    HTMLCollectionPtr list = std::make_shared<HTMLCollectionImp>();
-    if (!list)
-        return nullptr;
-
-    std::vector<std::u16string> classes;
-    boost::algorithm::split(classes, classNames, isSpace);
-    for (ElementPtr e = element; e; e = e->getNextElement()) {
-        std::u16string c = e->getClassName();
-        std::vector<std::u16string> v;
-        boost::algorithm::split(v, c, isSpace);
-        bool notFound = false;
-        for (auto i = classes.begin(); i != classes.end(); ++i) {
-            if (std::find(v.begin(), v.end(), *i) == v.end()) {
-                notFound = true;
-                break;
-            }
-        }
-        if (!notFound)
-            list->addItem(e);
+    auto list = root->findLiveCollection(LiveHTMLCollectionImp::ElementsByClassName, classNames);
+    if (!list) {
+        list = std::make_shared<ElementsByClassNameImp>(root, classNames);
+        root->addLiveCollection(list);
     }
     return list;
 }
@@ -550,36 +669,27 @@ int ElementImp::getClientHeight()
 
 std::u16string ElementImp::getInnerHTML()
 {
-    // TODO: implement me!
-    return u"";
+    if (dynamic_cast<XMLDocumentImp*>(getOwnerDocumentImp().get()))
+        return DOMSerializer::serializeXML(this, false);
+    return DOMSerializer::serializeHTML(this, false);
 }
 
 void ElementImp::setInnerHTML(const std::u16string& innerHTML)
 {
-    DocumentPtr document(std::make_shared<DocumentImp>());
+    DocumentPtr document = getOwnerDocumentImp();
     if (!document)
         return;
-    HTMLParser::parseFragment(document, innerHTML, std::static_pointer_cast<ElementImp>(self()));
-    Element root = document->getDocumentElement();
+    Element root = HTMLParser::parseFragment(document, innerHTML, std::static_pointer_cast<ElementImp>(self()));
     if (!root)
         return;
-
-    // TODO: Set suppress observers flag
-    for (auto i = getFirstChild(); i; i = i.getNextSibling())
-        removeChild(i);
-    while (root.hasChildNodes()) {
-        // Replace all
-        auto i = root.getFirstChild();
-        getOwnerDocumentImp()->adoptNode(i);
-        appendChild(i);
-    }
-    // TODO: Unset suppress observers flag and queue events
+    replaceAll(std::static_pointer_cast<NodeImp>(root.self()));
 }
 
 std::u16string ElementImp::getOuterHTML()
 {
-    // TODO: implement me!
-    return u"";
+    if (dynamic_cast<XMLDocumentImp*>(getOwnerDocumentImp().get()))
+        return DOMSerializer::serializeXML(this);
+    return DOMSerializer::serializeHTML(this, true);
 }
 
 void ElementImp::setOuterHTML(const std::u16string& outerHTML)
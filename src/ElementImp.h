@@ -36,9 +36,13 @@
 #include <org/w3c/dom/xbl2/XBLImplementationList.h>
 
 #include <deque>
+#include <vector>
 
+#include "AttrImp.h"
 #include "NodeImp.h"
 
+class Attribute;
+
 namespace org { namespace w3c { namespace dom { namespace bootstrap {
 
 class CSSSelectorsGroup;
@@ -55,12 +59,30 @@ typedef std::shared_ptr<ElementImp> ElementPtr;
 class ElementImp : public ObjectMixin<ElementImp, NodeImp>
 {
     friend class AttrArray;
+    friend class AttrImp;
+    friend class DOMSerializer;
     friend class ViewCSSImp;
 
+    // An attribute is kept as a plain name/value pair, and its Attr object
+    // is created only when script asks for it. Namespaced attributes always
+    // have their Attr objects, which keep the namespace URI and the prefix.
+    struct AttrEntry
+    {
+        std::u16string name;    // qualified name
+        std::u16string value;
+        AttrPtr attr;
+    };
+
     std::u16string namespaceURI;
     std::u16string prefix;
     std::u16string localName;
-    std::deque<Attr> attributes;
+    std::vector<AttrEntry> attributes;   // kept out of line; most elements have none
+
+    int findAttribute(const std::u16string& name) const;
+    int findAttributeNS(const std::u16string& namespaceURI, const std::u16string& localName) const;
+    void updateAttrValue(AttrImp* attr, const std::u16string& value);
+    void eraseAttribute(const AttrPtr& attr, int index);
+    void dispatchAttrModified(size_t index, std::u16string attrName, std::u16string prevValue, const std::u16string& newValue, unsigned short attrChange);
 
     Element querySelector(CSSSelectorsGroup* selectorsGroup, ViewCSSImp* view);
     void querySelectorAll(NodeListPtr nodeList, CSSSelectorsGroup* selectorsGroup, ViewCSSImp* view);
@@ -72,7 +94,12 @@ public:
     ElementImp(DocumentImp* ownerDocument, const std::u16string& localName, const std::u16string& namespaceURI, const std::u16string& prefix = u"");
     ElementImp(const ElementImp& org);
 
-    void setAttributes(const std::deque<Attr>& attributes);
+    void setAttributes(const std::deque<Attribute>& attributes);  // for HTMLParser
+    unsigned int getAttributeCount() const {
+        return attributes.size();
+    }
+    AttrPtr getAttributeNode(unsigned int index);
+    AttrPtr getAttributeNode(const std::u16string& name);
     ElementPtr getNextElement(const ElementPtr& root = nullptr);
 
     // notify() is called when conditions that are not handled by DOM events
@@ -166,8 +193,9 @@ public:
         return Element::getMetaData();
     }
 
-    static HTMLCollectionPtr getElementsByTagName(const ElementPtr& element, const std::u16string& localName);
-    static HTMLCollectionPtr getElementsByClassName(const ElementPtr& element, const std::u16string& classNames);
+    // Returns the live collection of the descendant elements of root
+    static HTMLCollectionPtr getElementsByTagName(const NodePtr& root, const std::u16string& localName);
+    static HTMLCollectionPtr getElementsByClassName(const NodePtr& root, const std::u16string& classNames);
 };
 
 }}}}  // org::w3c::dom::bootstrap
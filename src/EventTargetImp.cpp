@@ -28,6 +28,21 @@
 
 namespace org { namespace w3c { namespace dom { namespace bootstrap {
 
+unsigned EventTargetImp::getListenerBit(const std::u16string& type)
+{
+    if (type.compare(0, 3, u"DOM") != 0)
+        return 0;
+    if (type == u"DOMAttrModified")
+        return AttrModifiedListener;
+    if (type == u"DOMCharacterDataModified")
+        return CharacterDataModifiedListener;
+    if (type == u"DOMNodeInserted")
+        return NodeInsertedListener;
+    if (type == u"DOMNodeRemoved")
+        return NodeRemovedListener;
+    return 0;
+}
+
 void EventTargetImp::invoke(const EventPtr& event)
 {
     auto found = map.find(event->getType());
@@ -87,6 +102,7 @@ void EventTargetImp::addEventListener(const std::u16string&  type, events::Event
     if (useCapture)
         flags |= UseCapture;
     Listener item{ listener, flags };
+    listenerBits |= getListenerBit(type);
 
     auto found = map.find(type);
     if (found == map.end()) {
@@ -120,6 +136,8 @@ void EventTargetImp::removeEventListener(const std::u16string&  type, events::Ev
     for (auto i = listeners.begin(); i != listeners.end(); ++i) {
         if (*i == item) {
             listeners.erase(i);
+            if (listeners.empty())
+                listenerBits &= ~getListenerBit(type);
             return;
         }
     }
@@ -231,12 +249,14 @@ bool EventTargetImp::dispatchEvent(events::Event evt)
 }
 
 EventTargetImp::EventTargetImp() :
-    ObjectMixin()
+    ObjectMixin(),
+    listenerBits(0)
 {
 }
 
 EventTargetImp::EventTargetImp(const EventTargetImp& other) :
-    ObjectMixin(other)
+    ObjectMixin(other),
+    listenerBits(0)
 {
     // TODO: Check what needs to be copied.
 }
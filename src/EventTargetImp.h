@@ -46,6 +46,16 @@ public:
         UseEventHandler = 0x04
     };
 
+    // Listener bits for the mutation event types, which are dispatched
+    // synchronously and very frequently.
+    enum {
+        AttrModifiedListener = 0x01,
+        CharacterDataModifiedListener = 0x02,
+        NodeInsertedListener = 0x04,
+        NodeRemovedListener = 0x08
+    };
+    static unsigned getListenerBit(const std::u16string& type);
+
 private:
     struct Listener
     {
@@ -72,6 +82,7 @@ private:
     };
 
     std::map<std::u16string, std::list<Listener>> map;
+    unsigned listenerBits;
 
 public:
     EventTargetImp();
@@ -79,6 +90,12 @@ public:
 
     virtual void invoke(const EventPtr& event);
 
+    // Returns true if this target has any listener for the mutation event
+    // type(s) given in bits.
+    bool hasListener(unsigned bits) const {
+        return listenerBits & bits;
+    }
+
     EventListenerPtr getEventHandlerListener(const std::u16string& type);
 
     Object getEventHandler(const std::u16string& type);
@@ -25,34 +25,35 @@ using namespace org::w3c::dom::bootstrap;
 int main()
 {
     CSSStyleDeclarationImp style;
-    style.fontFamily.setGeneric(CSSFontFamilyValueImp::Serif);
-    style.fontStyle.setValue(CSSFontStyleValueImp::Normal);
-    style.fontWeight.setValue(400);
+    CSSFontValues& font = style.fontValues.mutate();
+    font.fontFamily.setGeneric(CSSFontFamilyValueImp::Serif);
+    font.fontStyle.setValue(CSSFontStyleValueImp::Normal);
+    font.fontWeight.setValue(400);
 
     FontFileInfo* info;
 
     info = FontFileInfo::chooseFont(&style);
     std::cout << info->filename << '\n';
 
-    style.fontWeight.setValue(900);
+    font.fontWeight.setValue(900);
     info = FontFileInfo::chooseFont(&style);
     std::cout << info->filename << '\n';
 
-    style.fontStyle.setValue(CSSFontStyleValueImp::Italic);
+    font.fontStyle.setValue(CSSFontStyleValueImp::Italic);
     info = FontFileInfo::chooseFont(&style);
     std::cout << info->filename << '\n';
 
-    style.fontWeight.setValue(100);
+    font.fontWeight.setValue(100);
     info = FontFileInfo::chooseFont(&style);
     std::cout << info->filename << '\n';
 
-    style.fontFamily.addFamily(u"LiberationSans");
+    font.fontFamily.addFamily(u"LiberationSans");
     info = FontFileInfo::chooseFont(&style);
     std::cout << info->filename << '\n';
 
-    style.fontFamily.reset();
-    style.fontFamily.addFamily(u"Lucida Console");
-    style.fontFamily.setGeneric(CSSFontFamilyValueImp::Monospace);
+    font.fontFamily.reset();
+    font.fontFamily.addFamily(u"Lucida Console");
+    font.fontFamily.setGeneric(CSSFontFamilyValueImp::Monospace);
     info = FontFileInfo::chooseFont(&style);
     std::cout << info->filename << '\n';
 }
\ No newline at end of file
@@ -18,6 +18,11 @@
 #include "font/FontManagerBackEndGL.h"
 #include "font/FontDatabase.h"
 
+#include <string.h>
+
+#include <chrono>
+#include <iostream>
+
 FontManagerBackEndGL backend;
 
 unsigned int point = 48;
@@ -165,8 +170,51 @@ void display()
     glutSwapBuffers();
 }
 
+// Measures the text measurement speed of the base fonts over a range of font
+// sizes, e.g., FontManager.test -benchmark
+void benchmark()
+{
+    static const struct {
+        const char16_t* family;
+        const char16_t* text;
+    } samples[] = {
+        { u"Liberation Sans", u"The quick brown fox jumps over the lazy dog. 0123456789 (+-*/=)" },
+        { u"IPAGothic", u"いろはにほへと ちりぬるを わかよたれそ つねならむ うゐのおくやま けふこえて あさきゆめみし ゑひもせす 春眠不覚暁処処聞啼鳥夜来風雨声花落知多少" },
+    };
+    const unsigned MinPoint = 6;
+    const unsigned MaxPoint = 72;
+    const unsigned Iterations = 1000;
+
+    FontManager* manager = backend.getFontManager();
+    for (auto i = samples; i < &samples[sizeof samples / sizeof samples[0]]; ++i) {
+        FontFace* face = manager->getFontFace(i->family);
+        if (!face) {
+            std::cout << utfconv(i->family) << ": not found\n";
+            continue;
+        }
+        auto begin = std::chrono::high_resolution_clock::now();
+        float width = 0.0f;
+        for (unsigned point = MinPoint; point <= MaxPoint; ++point) {
+            FontTexture* font = face->getFontTexture(point, false, false);
+            if (!font)
+                continue;
+            for (unsigned j = 0; j < Iterations; ++j)
+                width += font->measureText(i->text, point);
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        std::cout << face->getFamilyName() << ": " <<
+            std::chrono::duration_cast<std::chrono::microseconds>(end - begin).count() << " us (" << width << ")\n";
+    }
+}
+
 int main(int argc, char* argv[])
 {
+    if (2 <= argc && strcmp(argv[1], "-benchmark") == 0) {
+        FontDatabase::loadBaseFonts(backend.getFontManager());
+        benchmark();
+        return 0;
+    }
+
     glutInit(&argc, argv);
     glutInitDisplayMode(GLUT_RGB | GLUT_DOUBLE | GLUT_DEPTH);
     glutInitWindowSize(1024, 1024);
@@ -0,0 +1,91 @@
+/*
+ * Copyright 2015 Esrille Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "FrameScheduler.h"
+
+#include <chrono>
+#include <cmath>
+
+#include "Test.util.h"
+
+namespace org { namespace w3c { namespace dom { namespace bootstrap {
+
+FrameScheduler::FrameScheduler() :
+    interval(1000.0 / FrameRate),
+    origin(now()),
+    frameTime(origin),
+    frameCount(0),
+    inFrame(false),
+    busy(false)
+{
+    for (int i = 0; i < PhaseCount; ++i)
+        phaseTimes[i] = 0.0;
+}
+
+FrameScheduler& FrameScheduler::getInstance()
+{
+    static FrameScheduler scheduler;
+    return scheduler;
+}
+
+double FrameScheduler::now()
+{
+    auto duration = std::chrono::steady_clock::now().time_since_epoch();
+    return std::chrono::duration_cast<std::chrono::duration<double, std::milli>>(duration).count();
+}
+
+void FrameScheduler::beginFrame()
+{
+    frameTime = now();
+    ++frameCount;
+    inFrame = true;
+    busy = false;
+    for (int i = 0; i < PhaseCount; ++i)
+        phaseTimes[i] = 0.0;
+}
+
+void FrameScheduler::endFrame()
+{
+    if (!inFrame)
+        return;
+    inFrame = false;
+    if (!busy)
+        return;
+    double total = now() - frameTime;
+    recordTime("frame %u: input %.2f, timers %.2f, animation %.2f, style %.2f, layout %.2f, paint %.2f, total %.2f ms%s",
+               frameCount, phaseTimes[Input], phaseTimes[Timers], phaseTimes[Animation],
+               phaseTimes[Style], phaseTimes[Layout], phaseTimes[Paint], total,
+               (interval < total) ? " (over budget)" : "");
+}
+
+void FrameScheduler::addPhaseTime(Phase phase, double time)
+{
+    phaseTimes[phase] += time;
+    busy = true;
+}
+
+int FrameScheduler::getDelay(double time) const
+{
+    double t = now();
+    if (time < t)
+        time = t;
+    // Align to the frame grid so that the frames do not drift against the
+    // display refresh that glutSwapBuffers() waits for.
+    double frame = origin + ceil((time - origin) / interval) * interval;
+    return static_cast<int>(ceil(frame - t));
+}
+
+}}}}  // org::w3c::dom::bootstrap
@@ -0,0 +1,101 @@
+/*
+ * Copyright 2015 Esrille Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ES_FRAMESCHEDULER_H
+#define ES_FRAMESCHEDULER_H
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+namespace org { namespace w3c { namespace dom { namespace bootstrap {
+
+// FrameScheduler paces the main loop. Frames start on a fixed grid of
+// FrameRate per second, and in each frame WindowProxy::poll() dispatches the
+// input events, runs the timers that are due and the animation frame
+// callbacks, and then starts the style and layout work and paints at most
+// once. When no window has anything to do, the front end schedules no frame
+// at all until an input event arrives.
+class FrameScheduler
+{
+public:
+    static const unsigned FrameRate = 60;
+
+    enum Phase {
+        Input,
+        Timers,
+        Animation,
+        Style,      // on the background thread
+        Layout,     // on the background thread
+        Paint,
+        PhaseCount
+    };
+
+    // Measures the time spent in phase until the end of the scope.
+    class Scope
+    {
+        Phase phase;
+        double start;
+    public:
+        Scope(Phase phase) :
+            phase(phase),
+            start(now())
+        {}
+        ~Scope() {
+            getInstance().addPhaseTime(phase, now() - start);
+        }
+    };
+
+private:
+    double interval;    // in milliseconds
+    double origin;      // the start time of the first frame
+    double frameTime;   // the start time of the current frame
+    unsigned frameCount;
+    bool inFrame;
+    bool busy;          // set if any phase time has been recorded in the frame
+    double phaseTimes[PhaseCount];
+
+    FrameScheduler();
+
+public:
+    static FrameScheduler& getInstance();
+
+    // Returns the current time in milliseconds.
+    static double now();
+
+    double getInterval() const {
+        return interval;
+    }
+    // Returns the start time of the current frame; the animation frame
+    // callbacks are given it relative to the time origin of the window.
+    double getFrameTime() const {
+        return frameTime;
+    }
+
+    void beginFrame();
+    // Reports the phase times of the frame if any work has been done in it.
+    void endFrame();
+
+    void addPhaseTime(Phase phase, double time);
+
+    // Returns the delay in milliseconds until the first frame that starts
+    // at or after time.
+    int getDelay(double time) const;
+};
+
+}}}}  // org::w3c::dom::bootstrap
+
+#endif  // ES_FRAMESCHEDULER_H
@@ -21,11 +21,13 @@
 #include <org/w3c/dom/DocumentType.h>
 #include <org/w3c/dom/Text.h>
 
+#include <chrono>
 #include <fstream>
 #include <iostream>
 #include <sstream>
 
 #include <assert.h>
+#include <sys/resource.h>
 
 #include "utf.h"
 
@@ -33,6 +35,7 @@
 #include "css/CSSSerialize.h"
 #include "DOMImplementationImp.h"
 #include "DocumentImp.h"
+#include "ElementImp.h"
 
 #include "Test.util.h"
 
@@ -51,6 +54,52 @@ void test(std::ostream& result, const char* data)
     dumpTree(result, document);
 }
 
+// Parses the specified HTML file and reports the parse time, the number of
+// node allocations made from the document's node arena, and the peak RSS.
+int benchmark(const char* path)
+{
+    std::ifstream stream(path);
+    if (!stream) {
+        std::cerr << "error: cannot open " << path << ".\n";
+        return EXIT_FAILURE;
+    }
+    auto start = std::chrono::high_resolution_clock::now();
+    HTMLInputStream htmlInputStream(stream, "utf-8");
+    HTMLTokenizer tokenizer(&htmlInputStream);
+    Document document = bootstrap::getDOMImplementation()->createDocument(u"", u"", nullptr);
+    auto imp = std::static_pointer_cast<bootstrap::DocumentImp>(document.self());
+    HTMLParser parser(imp, &tokenizer);
+    parser.mainLoop();
+    auto elapsed = std::chrono::high_resolution_clock::now() - start;
+
+    const bootstrap::NodeArenaPtr& arena = imp->getNodeArena();
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    std::cout << "parse time: " << std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count() << " ms\n" <<
+                 "node allocations: " << arena->getAllocationCount() << '\n' <<
+                 "arena slabs: " << arena->getSlabCount() << '\n' <<
+                 "arena peak: " << arena->getPeakBytes() / 1024 << " KB\n" <<
+                 "peak RSS: " << usage.ru_maxrss << " KB\n";
+
+    // Measure getAttribute() as used by selector matching.
+    const int Rounds = 100;
+    unsigned long long calls = 0;
+    start = std::chrono::high_resolution_clock::now();
+    for (int round = 0; round < Rounds; ++round) {
+        auto root = std::dynamic_pointer_cast<bootstrap::ElementImp>(imp->getDocumentElement().self());
+        for (auto e = root; e; e = e->getNextElement()) {
+            e->getAttribute(u"id");
+            e->getAttribute(u"class");
+            e->getAttribute(u"HREF");
+            calls += 3;
+        }
+    }
+    elapsed = std::chrono::high_resolution_clock::now() - start;
+    auto us = std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+    std::cout << "getAttribute: " << (us ? calls * 1000000 / us : 0) << " calls/s\n";
+    return EXIT_SUCCESS;
+}
+
 const char* load(std::ifstream& stream, char* data)
 {
     static char type[256];
@@ -81,8 +130,14 @@ int main(int argc, char* argv[])
 {
     if (argc < 2) {
         std::cout << "usage: " << argv[0] << " [test.dat]...\n";
+        std::cout << "       " << argv[0] << " --benchmark file.html\n";
         exit(EXIT_FAILURE);
     }
+    if (strcmp(argv[1], "--benchmark") == 0) {
+        if (argc < 3)
+            exit(EXIT_FAILURE);
+        return benchmark(argv[2]);
+    }
     int rc = EXIT_SUCCESS;
     for (int i = 1; i < argc; ++i) {
         std::ifstream stream(argv[i]);
@@ -16,12 +16,14 @@
 
 #include "http/HTTPConnection.h"
 
+#include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 
+#include <chrono>
 #include <iostream>
+#include <vector>
 #include <boost/version.hpp>
-#include <boost/iostreams/stream.hpp>
-#include <boost/iostreams/device/file_descriptor.hpp>
 
 #include "Test.util.h"
 #include "utf.h"
@@ -51,23 +53,73 @@ int test(std::u16string urlString)
 
     std::cerr << request->getResponseMessage().toString() << "----\n";
     std::cerr << request->getResponseMessage().getContentCharset() << "----\n";
-    boost::iostreams::stream<boost::iostreams::file_descriptor_source> stream(request->getContentDescriptor(), boost::iostreams::close_handle);
-    while (stream) {
-        char c = stream.get();
-        if (stream.good())
+    std::unique_ptr<std::istream> stream(request->openContent());
+    while (*stream) {
+        char c = stream->get();
+        if (stream->good())
             std::cout << c;
     }
     return 0;
 }
 
+// Fetches count distinct small resources like a page with many subresources
+// does, and reports the time taken. Run this against a server on the
+// loopback interface.
+int benchmark(std::u16string urlString, int count)
+{
+    auto start = std::chrono::steady_clock::now();
+    std::vector<HttpRequestPtr> requests;
+    for (int i = 0; i < count; ++i) {
+        URL url(urlString + u"?" + utfconv(std::to_string(i)));
+        if (url.isEmpty())
+            return 1;
+        HttpRequestPtr request(std::make_shared<HttpRequest>());
+        request->open(u"get", url);
+        request->send();
+        requests.push_back(request);
+    }
+    int errors = 0;
+    size_t octets = 0;
+    for (auto i = requests.begin(); i != requests.end(); ++i) {
+        HttpRequestPtr request = *i;
+        while (request->getReadyState() != HttpRequest::DONE) {
+            HttpConnectionManager::getIOService().run_one();
+            HttpConnectionManager::getInstance().poll();
+        }
+        if (request->getError()) {
+            ++errors;
+            continue;
+        }
+        std::unique_ptr<std::istream> stream(request->openContent());
+        char buffer[4096];
+        while (stream->read(buffer, sizeof buffer) || stream->gcount())
+            octets += stream->gcount();
+    }
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+    std::cout << count << " requests, " << errors << " errors, " << octets << " bytes in " << elapsed.count() / 1000.0 << " ms\n";
+    return errors ? 1 : 0;
+}
+
 int main(int argc, char* argv[])
 {
     initLogLevel(&argc, argv, 3);
 
+    // -encoded keeps gzip and deflate coded responses encoded in the cache.
+    if (2 <= argc && strcmp(argv[1], "-encoded") == 0) {
+        HttpCacheManager::setStoreEncoded(true);
+        --argc;
+        ++argv;
+    }
+
+    // -benchmark count url fetches count small resources from url; use it
+    // with --v=0 so that logging does not dominate the time.
+    if (4 <= argc && strcmp(argv[1], "-benchmark") == 0)
+        return benchmark(utfconv(argv[3]), atoi(argv[2]));
+
     int result = 0;
     if (2 <= argc) {
         for (int i = 1; i < argc; ++i)
-            result += test(utfconv(argv[1]));
+            result += test(utfconv(argv[i]));
     } else {
         result += test(u"http://www.esrille.com/index.html");
         sleep(3);
@@ -0,0 +1,115 @@
+/*
+ * Copyright 2015 Esrille Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "http/HTTPResolver.h"
+
+#include <stdlib.h>
+
+#include <iostream>
+
+#include <boost/bind.hpp>
+
+using namespace org::w3c::dom::bootstrap;
+
+namespace {
+
+int lookupCount;
+
+// A stub standing in for DNS: "localhost" resolves to 127.0.0.1 and any
+// other name fails.
+void stubLookup(boost::asio::io_service& ioService, const std::string& hostname, const std::string& port, const HttpResolver::Handler& handler)
+{
+    ++lookupCount;
+    HttpResolver::Endpoints endpoints;
+    boost::system::error_code error;
+    if (hostname == "localhost")
+        endpoints.push_back(boost::asio::ip::tcp::endpoint(boost::asio::ip::address_v4::loopback(), atoi(port.c_str())));
+    else
+        error = boost::asio::error::host_not_found;
+    ioService.post(boost::bind(handler, error, endpoints));
+}
+
+int resultCount;
+int errorCount;
+
+void handleResolve(const boost::system::error_code& err, const HttpResolver::Endpoints& endpoints)
+{
+    ++resultCount;
+    if (err || endpoints.empty())
+        ++errorCount;
+}
+
+int check(const char* name, unsigned long long value, unsigned long long expected)
+{
+    if (value == expected)
+        return 0;
+    std::cout << name << ": " << value << " (expected " << expected << ")\n";
+    return 1;
+}
+
+}  // namespace
+
+int main()
+{
+    int result = 0;
+    boost::asio::io_service ioService;
+    HttpResolver resolver(ioService);
+    resolver.setLookup(boost::bind(stubLookup, boost::ref(ioService), _1, _2, _3));
+
+    // Concurrent requests for the same host share one lookup.
+    for (int i = 0; i < 6; ++i)
+        resolver.resolve("localhost", "80", handleResolve);
+    ioService.run();
+    ioService.reset();
+    result += check("lookups", lookupCount, 1);
+    result += check("coalesced", resolver.getCoalescedCount(), 5);
+    result += check("results", resultCount, 6);
+
+    // The result is kept for the TTL.
+    resolver.resolve("localhost", "80", handleResolve);
+    resolver.resolve("localhost", "8080", handleResolve);
+    ioService.run();
+    ioService.reset();
+    result += check("lookups", lookupCount, 2);
+    result += check("hits", resolver.getHitCount(), 1);
+
+    // Failures are kept, too.
+    resolver.resolve("unknown.invalid", "80", handleResolve);
+    ioService.run();
+    ioService.reset();
+    resolver.resolve("unknown.invalid", "80", handleResolve);
+    ioService.run();
+    ioService.reset();
+    result += check("lookups", lookupCount, 3);
+    result += check("negative hits", resolver.getNegativeHitCount(), 1);
+    result += check("errors", errorCount, 2);
+
+    // Invalidated and expired results are looked up again.
+    resolver.setTTL(0, 0);
+    resolver.invalidate("localhost", "80");
+    resolver.resolve("localhost", "80", handleResolve);
+    ioService.run();
+    ioService.reset();
+    result += check("lookups", lookupCount, 4);
+    resolver.resolve("localhost", "80", handleResolve);
+    ioService.run();
+    ioService.reset();
+    result += check("lookups", lookupCount, 5);
+
+    resolver.dump();
+    std::cout << "hit rate: " << resolver.getHitRate() << '\n';
+    return result;
+}
@@ -16,6 +16,8 @@
 
 #include "MutationEventImp.h"
 
+#include "ElementImp.h"
+
 namespace org
 {
 namespace w3c
@@ -25,9 +27,19 @@ namespace dom
 namespace bootstrap
 {
 
+Object MutationEventImp::getRelatedNode()
+{
+    if (!relatedNode && attrOwner) {
+        relatedNode = attrOwner->getAttributeNode(attrOwnerName);
+        attrOwner.reset();
+    }
+    return relatedNode;
+}
+
 void MutationEventImp::initMutationEvent(const std::u16string& typeArg, bool canBubbleArg, bool cancelableArg, Object relatedNodeArg, const std::u16string& prevValueArg, const std::u16string& newValueArg, const std::u16string& attrNameArg, unsigned short attrChangeArg)
 {
     relatedNode = relatedNodeArg;
+    attrOwner.reset();
     prevValue = prevValueArg;
     newValue = newValueArg;
     attrName = attrNameArg;
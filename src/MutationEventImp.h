@@ -35,9 +35,13 @@ namespace dom
 {
 namespace bootstrap
 {
+class ElementImp;
+
 class MutationEventImp : public ObjectMixin<MutationEventImp, EventImp>
 {
     Object         relatedNode;
+    std::shared_ptr<ElementImp> attrOwner;  // to create relatedNode on demand
+    std::u16string attrOwnerName;
     std::u16string prevValue;
     std::u16string newValue;
     std::u16string attrName;
@@ -48,10 +52,15 @@ public:
     {
     }
 
-    // MutationEvent
-    Object getRelatedNode() {
-        return relatedNode;
+    // Sets the element whose attribute named name is the related node. The
+    // Attr object is created only if script asks for it.
+    void setRelatedAttr(const std::shared_ptr<ElementImp>& element, const std::u16string& name) {
+        attrOwner = element;
+        attrOwnerName = name;
     }
+
+    // MutationEvent
+    Object getRelatedNode();
     std::u16string getPrevValue() {
         return prevValue;
     }
@@ -1,10 +1,28 @@
-// Generated by esidl 0.3.0.
-// This file is expected to be modified for the Web IDL interface
-// implementation.  Permission to use, copy, modify and distribute
-// this file in any software license is hereby granted.
+/*
+ * Copyright 2010-2015 Esrille Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
 
 #include "MutationObserverImp.h"
 
+#include <algorithm>
+
+#include "DocumentImp.h"
+#include "ElementImp.h"
+#include "ObjectArrayImp.h"
+#include "html/HTMLTemplateElementImp.h"
+
 namespace org
 {
 namespace w3c
@@ -14,23 +32,275 @@ namespace dom
 namespace bootstrap
 {
 
+namespace {
+
+// Returns the parent of node, where the host of a shadow tree is regarded as
+// the parent of the shadow tree. Note a shadow tree is always the root of its
+// own tree.
+NodePtr getComposedParent(const NodePtr& node)
+{
+    if (NodePtr parent = node->getParent())
+        return parent;
+    if (auto shadowTree = std::dynamic_pointer_cast<HTMLTemplateElementImp>(node))
+        return std::dynamic_pointer_cast<NodeImp>(shadowTree->getHost().self());
+    return nullptr;
+}
+
+bool isComposedAncestorOf(NodeImp* ancestor, NodeImp* node)
+{
+    for (NodePtr i = node->getParent(); i; i = getComposedParent(i)) {
+        if (i.get() == ancestor)
+            return true;
+    }
+    return false;
+}
+
+DocumentPtr getDocumentOf(const NodePtr& node)
+{
+    if (node->getNodeType() == Node::DOCUMENT_NODE)
+        return std::static_pointer_cast<DocumentImp>(node);
+    return node->getOwnerDocumentImp();
+}
+
+}
+
+MutationObserverImp::MutationObserverImp(events::MutationCallback callback) :
+    callback(callback)
+{
+}
+
+MutationObserverImp::MutationObserverImp(Handler handler) :
+    handler(handler)
+{
+}
+
+unsigned MutationObserverImp::getOptions(NodeImp* target, const std::u16string* attrName)
+{
+    unsigned options = 0;
+    for (auto i = registrations.begin(); i != registrations.end(); ++i) {
+        NodePtr node = i->target.lock();
+        if (!node)
+            continue;
+        if (node.get() != target && (!(i->options & Subtree) || !isComposedAncestorOf(node.get(), target)))
+            continue;
+        unsigned o = i->options;
+        if (attrName && !i->attributeFilter.empty() &&
+            std::find(i->attributeFilter.begin(), i->attributeFilter.end(), *attrName) == i->attributeFilter.end())
+            o &= ~(Attributes | AttributeOldValue);
+        options |= o;
+    }
+    return options;
+}
+
+template<class F>
+void MutationObserverImp::forEachObserver(const NodePtr& target, const std::u16string* attrName, F f)
+{
+    DocumentPtr document = getDocumentOf(target);
+    if (document && document->hasMutationObservers()) {
+        const std::list<MutationObserverPtr>& observers = document->getMutationObservers();
+        for (auto i = observers.begin(); i != observers.end(); ++i) {
+            if (unsigned options = (*i)->getOptions(target.get(), attrName))
+                f(i->get(), options, document);
+        }
+    }
+
+    // The observers of the document of a shadow host also see the mutations
+    // inside its shadow tree.
+    NodePtr root = target;
+    while (NodePtr parent = root->getParent())
+        root = parent;
+    if (root->getNodeType() == Node::DOCUMENT_NODE)
+        return;
+    for (NodePtr host = getComposedParent(root); host; host = getComposedParent(root)) {
+        DocumentPtr hostDocument = host->getOwnerDocumentImp();
+        if (hostDocument && hostDocument != document && hostDocument->hasMutationObservers()) {
+            const std::list<MutationObserverPtr>& observers = hostDocument->getMutationObservers();
+            for (auto i = observers.begin(); i != observers.end(); ++i) {
+                if (unsigned options = (*i)->getOptions(target.get(), attrName))
+                    f(i->get(), options, hostDocument);
+            }
+            return;
+        }
+        for (root = host; NodePtr parent = root->getParent(); root = parent)
+            ;
+    }
+}
+
+void MutationObserverImp::enqueue(const DocumentPtr& document, const MutationRecordPtr& record)
+{
+    records.push_back(record);
+    document->scheduleMutationDelivery();
+}
+
+void MutationObserverImp::queueChildList(const NodePtr& parent, const NodePtr& added, const NodePtr& removed, const NodePtr& prev, const NodePtr& next)
+{
+    forEachObserver(parent, 0, [&](MutationObserverImp* observer, unsigned options, const DocumentPtr& document) {
+        if (!(options & ChildList))
+            return;
+        if (!observer->records.empty()) {
+            auto last = std::static_pointer_cast<MutationRecordImp>(observer->records.back().self());
+            if (last->coalesce(parent, added, removed, prev, next))
+                return;
+        }
+        auto record = std::make_shared<MutationRecordImp>(ChildList, parent);
+        if (added)
+            record->addAddedNode(added);
+        if (removed)
+            record->addRemovedNode(removed);
+        record->setSiblings(prev, next);
+        observer->enqueue(document, record);
+    });
+}
+
+void MutationObserverImp::queueChildList(const NodePtr& parent, const std::deque<NodePtr>& added, const std::deque<NodePtr>& removed)
+{
+    forEachObserver(parent, 0, [&](MutationObserverImp* observer, unsigned options, const DocumentPtr& document) {
+        if (!(options & ChildList))
+            return;
+        auto record = std::make_shared<MutationRecordImp>(ChildList, parent);
+        for (auto i = added.begin(); i != added.end(); ++i)
+            record->addAddedNode(*i);
+        for (auto i = removed.begin(); i != removed.end(); ++i)
+            record->addRemovedNode(*i);
+        observer->enqueue(document, record);
+    });
+}
+
+void MutationObserverImp::queueAttributes(const ElementPtr& element, const std::u16string& name, const Nullable<std::u16string>& namespaceURI, const std::u16string& oldValue)
+{
+    NodePtr target(element);
+    forEachObserver(target, &name, [&](MutationObserverImp* observer, unsigned options, const DocumentPtr& document) {
+        if (!(options & Attributes))
+            return;
+        auto record = std::make_shared<MutationRecordImp>(Attributes, target);
+        record->setAttribute(name, namespaceURI);
+        if (options & AttributeOldValue)
+            record->setOldValue(oldValue);
+        observer->enqueue(document, record);
+    });
+}
+
+void MutationObserverImp::queueCharacterData(const NodePtr& node, const std::u16string& oldValue)
+{
+    forEachObserver(node, 0, [&](MutationObserverImp* observer, unsigned options, const DocumentPtr& document) {
+        if (!(options & CharacterData))
+            return;
+        auto record = std::make_shared<MutationRecordImp>(CharacterData, node);
+        if (options & CharacterDataOldValue)
+            record->setOldValue(oldValue);
+        observer->enqueue(document, record);
+    });
+}
+
+void MutationObserverImp::observe(const NodePtr& target, unsigned options, const std::deque<std::u16string>& attributeFilter)
+{
+    for (auto i = registrations.begin(); i != registrations.end(); ++i) {
+        if (i->target.lock() == target) {
+            i->options = options;
+            i->attributeFilter = attributeFilter;
+            return;
+        }
+    }
+    registrations.push_back(Registration{ target, options, attributeFilter });
+    if (DocumentPtr document = getDocumentOf(target))
+        document->addMutationObserver(std::static_pointer_cast<MutationObserverImp>(self()));
+}
+
+bool MutationObserverImp::hasRegistrations()
+{
+    registrations.remove_if([](const Registration& r) { return r.target.expired(); });
+    return !registrations.empty();
+}
+
+void MutationObserverImp::deliver()
+{
+    if (records.empty())
+        return;
+    if (handler) {
+        std::deque<events::MutationRecord> taken;
+        taken.swap(records);
+        handler(taken);
+    } else if (callback)
+        callback(takeRecords(), events::MutationObserver(self()));
+}
+
 void MutationObserverImp::observe(Node target, events::MutationObserverInit options)
 {
-    // TODO: implement me!
+    unsigned flags = 0;
+    if (options.getChildList())
+        flags |= ChildList;
+    if (options.getAttributes())
+        flags |= Attributes;
+    if (options.getCharacterData())
+        flags |= CharacterData;
+    if (options.getSubtree())
+        flags |= Subtree;
+    if (options.getAttributeOldValue())
+        flags |= AttributeOldValue | Attributes;
+    if (options.getCharacterDataOldValue())
+        flags |= CharacterDataOldValue | CharacterData;
+    std::deque<std::u16string> attributeFilter;
+    if (Sequence<std::u16string> filter = options.getAttributeFilter()) {
+        for (unsigned int i = 0; i < filter.getLength(); ++i)
+            attributeFilter.push_back(filter.getElement(i));
+        flags |= Attributes;
+    }
+    if (!(flags & (ChildList | Attributes | CharacterData)))
+        throw DOMException{DOMException::SYNTAX_ERR};
+    if (auto node = std::dynamic_pointer_cast<NodeImp>(target.self()))
+        observe(node, flags, attributeFilter);
 }
 
 void MutationObserverImp::disconnect()
 {
-    // TODO: implement me!
+    auto observer = std::static_pointer_cast<MutationObserverImp>(self());
+    for (auto i = registrations.begin(); i != registrations.end(); ++i) {
+        if (NodePtr target = i->target.lock()) {
+            if (DocumentPtr document = getDocumentOf(target))
+                document->removeMutationObserver(observer);
+        }
+    }
+    registrations.clear();
+    records.clear();
 }
 
 Sequence<events::MutationRecord> MutationObserverImp::takeRecords()
 {
-    // TODO: implement me!
-    return Sequence<events::MutationRecord>();
+    auto batch = std::make_shared<MutationRecordBatch>();
+    batch->records.swap(records);
+    return std::make_shared<ObjectArrayImp<MutationRecordBatch, events::MutationRecord, &MutationRecordBatch::records>>(batch);
 }
 
+}  // org::w3c::dom::bootstrap
+
+namespace events {
+
+namespace {
+
+class Constructor : public Object
+{
+public:
+    // Object
+    virtual Any message_(uint32_t selector, const char* id, int argc, Any* argv) {
+        if (argc != 1)
+            return nullptr;
+        return std::make_shared<bootstrap::MutationObserverImp>(interface_cast<MutationCallback>(argv[0].toObject()));
+    }
+    Constructor() :
+        Object(this) {
+    }
+};
+
+}  // namespace
+
+Object MutationObserver::getConstructor()
+{
+    static Constructor constructor;
+    return constructor.self();
 }
+
+}
+
 }
 }
 }
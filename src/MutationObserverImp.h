@@ -1,7 +1,18 @@
-// Generated by esidl 0.3.0.
-// This file is expected to be modified for the Web IDL interface
-// implementation.  Permission to use, copy, modify and distribute
-// this file in any software license is hereby granted.
+/*
+ * Copyright 2010-2015 Esrille Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
 
 #ifndef ORG_W3C_DOM_BOOTSTRAP_MUTATIONOBSERVERIMP_H_INCLUDED
 #define ORG_W3C_DOM_BOOTSTRAP_MUTATIONOBSERVERIMP_H_INCLUDED
@@ -12,12 +23,18 @@
 
 #include <org/w3c/dom/events/MutationObserver.h>
 
-#include <org/w3c/dom/events/MutationObserver.h>
 #include <org/w3c/dom/events/MutationCallback.h>
 #include <org/w3c/dom/events/MutationObserverInit.h>
 #include <org/w3c/dom/events/MutationRecord.h>
 #include <org/w3c/dom/Node.h>
 
+#include <deque>
+#include <list>
+#include <boost/function.hpp>
+
+#include "NodeImp.h"
+#include "MutationRecordImp.h"
+
 namespace org
 {
 namespace w3c
@@ -26,9 +43,66 @@ namespace dom
 {
 namespace bootstrap
 {
+class ElementImp;
+
+// MutationObserverImp queues the records of the mutations it is interested
+// in, coalescing consecutive childList mutations of the same parent into a
+// single record, and delivers them at once when the owner document of the
+// observed node reaches its next task checkpoint. Besides script observers,
+// an observer can be created with a C++ handler for the internal consumers
+// like ViewCSSImp.
 class MutationObserverImp : public ObjectMixin<MutationObserverImp>
 {
 public:
+    // The MutationObserverInit options, and the record types as well.
+    enum {
+        ChildList = 0x01,
+        Attributes = 0x02,
+        CharacterData = 0x04,
+        Subtree = 0x08,
+        AttributeOldValue = 0x10,
+        CharacterDataOldValue = 0x20
+    };
+
+    typedef boost::function<void (const std::deque<events::MutationRecord>& records)> Handler;
+
+private:
+    struct Registration
+    {
+        std::weak_ptr<NodeImp> target;
+        unsigned options;
+        std::deque<std::u16string> attributeFilter;
+    };
+
+    events::MutationCallback callback;
+    Handler handler;
+    std::list<Registration> registrations;
+    std::deque<events::MutationRecord> records;
+
+    unsigned getOptions(NodeImp* target, const std::u16string* attrName);
+    template<class F>
+    static void forEachObserver(const NodePtr& target, const std::u16string* attrName, F f);
+    void enqueue(const DocumentPtr& document, const MutationRecordPtr& record);
+
+public:
+    MutationObserverImp(events::MutationCallback callback);
+    MutationObserverImp(Handler handler);
+
+    void observe(const NodePtr& target, unsigned options, const std::deque<std::u16string>& attributeFilter = std::deque<std::u16string>());
+
+    // Returns true if any of the observed nodes is still alive.
+    bool hasRegistrations();
+
+    // Invokes the callback or the handler with the queued records, if any.
+    void deliver();
+
+    // Queues a record of each type to the observers of the owner document of
+    // the target. These are no-ops unless the document has an observer.
+    static void queueChildList(const NodePtr& parent, const NodePtr& added, const NodePtr& removed, const NodePtr& prev, const NodePtr& next);
+    static void queueChildList(const NodePtr& parent, const std::deque<NodePtr>& added, const std::deque<NodePtr>& removed);
+    static void queueAttributes(const std::shared_ptr<ElementImp>& element, const std::u16string& name, const Nullable<std::u16string>& namespaceURI, const std::u16string& oldValue);
+    static void queueCharacterData(const NodePtr& node, const std::u16string& oldValue);
+
     // MutationObserver
     void observe(Node target, events::MutationObserverInit options);
     void disconnect();
@@ -44,6 +118,8 @@ public:
     }
 };
 
+typedef std::shared_ptr<MutationObserverImp> MutationObserverPtr;
+
 }
 }
 }
@@ -1,10 +1,23 @@
-// Generated by esidl 0.3.0.
-// This file is expected to be modified for the Web IDL interface
-// implementation.  Permission to use, copy, modify and distribute
-// this file in any software license is hereby granted.
+/*
+ * Copyright 2010-2015 Esrille Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
 
 #include "MutationRecordImp.h"
 
+#include "MutationObserverImp.h"
+
 namespace org
 {
 namespace w3c
@@ -14,58 +27,99 @@ namespace dom
 namespace bootstrap
 {
 
+void MutationRecordImp::addAddedNode(const NodePtr& node)
+{
+    if (!addedNodes)
+        addedNodes = std::make_shared<NodeListImp>();
+    addedNodes->addItem(node);
+}
+
+void MutationRecordImp::addRemovedNode(const NodePtr& node)
+{
+    if (!removedNodes)
+        removedNodes = std::make_shared<NodeListImp>();
+    removedNodes->addItem(node);
+}
+
+bool MutationRecordImp::coalesce(const NodePtr& parent, const NodePtr& added, const NodePtr& removed, const NodePtr& prev, const NodePtr& next)
+{
+    if (type != MutationObserverImp::ChildList || target != parent)
+        return false;
+    if (added) {
+        if (removedNodes || !addedNodes || nextSibling != next)
+            return false;
+        Node last = addedNodes->item(addedNodes->getLength() - 1);
+        if (last.self().get() != prev.get())
+            return false;
+        addedNodes->addItem(added);
+        return true;
+    }
+    if (removed) {
+        if (addedNodes || !removedNodes || previousSibling != prev || nextSibling != removed)
+            return false;
+        removedNodes->addItem(removed);
+        nextSibling = next;
+        return true;
+    }
+    return false;
+}
+
 std::u16string MutationRecordImp::getType()
 {
-    // TODO: implement me!
-    return u"";
+    switch (type) {
+    case MutationObserverImp::ChildList:
+        return u"childList";
+    case MutationObserverImp::Attributes:
+        return u"attributes";
+    case MutationObserverImp::CharacterData:
+        return u"characterData";
+    default:
+        return u"";
+    }
 }
 
 Node MutationRecordImp::getTarget()
 {
-    // TODO: implement me!
-    return nullptr;
+    return target;
 }
 
 NodeList MutationRecordImp::getAddedNodes()
 {
-    // TODO: implement me!
-    return nullptr;
+    if (!addedNodes)
+        addedNodes = std::make_shared<NodeListImp>();
+    return addedNodes;
 }
 
 NodeList MutationRecordImp::getRemovedNodes()
 {
-    // TODO: implement me!
-    return nullptr;
+    if (!removedNodes)
+        removedNodes = std::make_shared<NodeListImp>();
+    return removedNodes;
 }
 
 Node MutationRecordImp::getPreviousSibling()
 {
-    // TODO: implement me!
-    return nullptr;
+    return previousSibling;
 }
 
 Node MutationRecordImp::getNextSibling()
 {
-    // TODO: implement me!
-    return nullptr;
+    return nextSibling;
 }
 
 Nullable<std::u16string> MutationRecordImp::getAttributeName()
 {
-    // TODO: implement me!
-    return u"";
+    return attributeName;
 }
 
 Nullable<std::u16string> MutationRecordImp::getAttributeNamespace()
 {
-    // TODO: implement me!
-    return u"";
+    return attributeNamespace;
 }
 
 Nullable<std::u16string> MutationRecordImp::getOldValue()
 {
-    // TODO: implement me!
-    return u"";
+    return oldValue;
 }
 
 }
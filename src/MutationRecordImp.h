@@ -1,7 +1,18 @@
-// Generated by esidl 0.3.0.
-// This file is expected to be modified for the Web IDL interface
-// implementation.  Permission to use, copy, modify and distribute
-// this file in any software license is hereby granted.
+/*
+ * Copyright 2010-2015 Esrille Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
 
 #ifndef ORG_W3C_DOM_BOOTSTRAP_MUTATIONRECORDIMP_H_INCLUDED
 #define ORG_W3C_DOM_BOOTSTRAP_MUTATIONRECORDIMP_H_INCLUDED
@@ -15,6 +26,11 @@
 #include <org/w3c/dom/Node.h>
 #include <org/w3c/dom/NodeList.h>
 
+#include <deque>
+
+#include "NodeImp.h"
+#include "NodeListImp.h"
+
 namespace org
 {
 namespace w3c
@@ -25,7 +41,64 @@ namespace bootstrap
 {
 class MutationRecordImp : public ObjectMixin<MutationRecordImp>
 {
+    unsigned type;  // MutationObserverImp::ChildList, Attributes, or CharacterData
+    NodePtr target;
+    NodeListPtr addedNodes;
+    NodeListPtr removedNodes;
+    NodePtr previousSibling;
+    NodePtr nextSibling;
+    Nullable<std::u16string> attributeName;
+    Nullable<std::u16string> attributeNamespace;
+    Nullable<std::u16string> oldValue;
+
 public:
+    MutationRecordImp(unsigned type, const NodePtr& target) :
+        type(type),
+        target(target)
+    {
+    }
+
+    unsigned getTypeBit() const {
+        return type;
+    }
+    const NodePtr& getTargetPtr() const {
+        return target;
+    }
+    const NodePtr& getPreviousSiblingPtr() const {
+        return previousSibling;
+    }
+    const NodePtr& getNextSiblingPtr() const {
+        return nextSibling;
+    }
+    const NodeListPtr& getAddedNodeList() const {
+        return addedNodes;
+    }
+    const NodeListPtr& getRemovedNodeList() const {
+        return removedNodes;
+    }
+    const Nullable<std::u16string>& getAttributeNameValue() const {
+        return attributeName;
+    }
+
+    void addAddedNode(const NodePtr& node);
+    void addRemovedNode(const NodePtr& node);
+    void setSiblings(const NodePtr& prev, const NodePtr& next) {
+        previousSibling = prev;
+        nextSibling = next;
+    }
+    void setAttribute(const Nullable<std::u16string>& name, const Nullable<std::u16string>& namespaceURI) {
+        attributeName = name;
+        attributeNamespace = namespaceURI;
+    }
+    void setOldValue(const Nullable<std::u16string>& value) {
+        oldValue = value;
+    }
+
+    // Tries to merge a childList mutation into this record. Returns true if
+    // node has been inserted right after the last added node, or removed
+    // right after the last removed node, of this record.
+    bool coalesce(const NodePtr& parent, const NodePtr& added, const NodePtr& removed, const NodePtr& prev, const NodePtr& next);
+
     // MutationRecord
     std::u16string getType();
     Node getTarget();
@@ -47,6 +120,15 @@ public:
     }
 };
 
+typedef std::shared_ptr<MutationRecordImp> MutationRecordPtr;
+
+// A batch of records taken from an observer at once, which is presented to
+// script as sequence<MutationRecord>.
+struct MutationRecordBatch
+{
+    std::deque<events::MutationRecord> records;
+};
+
 }
 }
 }
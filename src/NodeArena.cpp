@@ -0,0 +1,90 @@
+/*
+ * Copyright 2015 Esrille Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "NodeArena.h"
+
+#include <new>
+
+namespace org { namespace w3c { namespace dom { namespace bootstrap {
+
+NodeArena::NodeArena() :
+    current(0),
+    remaining(0),
+    allocationCount(0),
+    liveBytes(0),
+    peakBytes(0)
+{
+    for (size_t i = 0; i < SizeClassCount; ++i)
+        freeLists[i] = 0;
+}
+
+NodeArena::~NodeArena()
+{
+    for (auto i = slabs.begin(); i != slabs.end(); ++i)
+        ::operator delete(*i);
+}
+
+void* NodeArena::allocate(size_t size)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    ++allocationCount;
+    if (MaxObjectSize < size) {
+        liveBytes += size;
+        if (peakBytes < liveBytes)
+            peakBytes = liveBytes;
+        return ::operator new(size);
+    }
+
+    size_t sizeClass = getSizeClass(size);
+    size = (sizeClass + 1) * Alignment;
+    liveBytes += size;
+    if (peakBytes < liveBytes)
+        peakBytes = liveBytes;
+    if (FreeBlock* block = freeLists[sizeClass]) {
+        freeLists[sizeClass] = block->next;
+        return block;
+    }
+    if (remaining < size) {
+        // Note the tail of the previous slab is simply abandoned; it is at
+        // most MaxObjectSize bytes.
+        current = static_cast<char*>(::operator new(SlabSize));
+        slabs.push_back(current);
+        remaining = SlabSize;
+    }
+    void* p = current;
+    current += size;
+    remaining -= size;
+    return p;
+}
+
+void NodeArena::deallocate(void* p, size_t size)
+{
+    if (!p)
+        return;
+    std::lock_guard<std::mutex> lock(mutex);
+    if (MaxObjectSize < size) {
+        liveBytes -= size;
+        ::operator delete(p);
+        return;
+    }
+    size_t sizeClass = getSizeClass(size);
+    liveBytes -= (sizeClass + 1) * Alignment;
+    FreeBlock* block = static_cast<FreeBlock*>(p);
+    block->next = freeLists[sizeClass];
+    freeLists[sizeClass] = block;
+}
+
+}}}}  // org::w3c::dom::bootstrap
@@ -0,0 +1,128 @@
+/*
+ * Copyright 2015 Esrille Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ORG_W3C_DOM_BOOTSTRAP_NODEARENA_H_INCLUDED
+#define ORG_W3C_DOM_BOOTSTRAP_NODEARENA_H_INCLUDED
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace org { namespace w3c { namespace dom { namespace bootstrap {
+
+// NodeArena is a per-document slab allocator for node objects; each view also
+// keeps one for its boxes. Objects are
+// carved out of large slabs by size class, and released objects are kept in
+// per size class free lists for reuse. The slabs themselves are freed in bulk
+// when the arena is destroyed, i.e., when the document and every node that
+// has been allocated from it are gone.
+class NodeArena
+{
+    static const size_t Alignment = 16;
+    static const size_t MaxObjectSize = 2048;   // larger objects go to ::operator new
+    static const size_t SlabSize = 64 * 1024;
+    static const size_t SizeClassCount = MaxObjectSize / Alignment;
+
+    struct FreeBlock
+    {
+        FreeBlock* next;
+    };
+
+    std::mutex mutex;
+    std::vector<char*> slabs;
+    char* current;
+    size_t remaining;
+    FreeBlock* freeLists[SizeClassCount];
+
+    // statistics
+    size_t allocationCount;
+    size_t liveBytes;
+    size_t peakBytes;
+
+    static size_t getSizeClass(size_t size) {
+        return (size + Alignment - 1) / Alignment - 1;
+    }
+
+public:
+    NodeArena();
+    ~NodeArena();
+
+    void* allocate(size_t size);
+    void deallocate(void* p, size_t size);
+
+    size_t getAllocationCount() const {
+        return allocationCount;
+    }
+    size_t getSlabCount() const {
+        return slabs.size();
+    }
+    size_t getPeakBytes() const {
+        return peakBytes;
+    }
+};
+
+typedef std::shared_ptr<NodeArena> NodeArenaPtr;
+
+// NodeAllocator is used with std::allocate_shared() so that a node and its
+// shared_ptr control block are placed in the arena together. Each control
+// block keeps a copy of the allocator, so the arena outlives every node
+// allocated from it even if script still holds a node after its document
+// has been discarded.
+template <typename T>
+class NodeAllocator
+{
+    template <typename U> friend class NodeAllocator;
+
+    NodeArenaPtr arena;
+
+public:
+    typedef T value_type;
+
+    NodeAllocator(const NodeArenaPtr& arena) :
+        arena(arena)
+    {
+    }
+    template <typename U>
+    NodeAllocator(const NodeAllocator<U>& other) :
+        arena(other.arena)
+    {
+    }
+
+    T* allocate(size_t n) {
+        return static_cast<T*>(arena->allocate(n * sizeof(T)));
+    }
+    void deallocate(T* p, size_t n) {
+        arena->deallocate(p, n * sizeof(T));
+    }
+
+    template <typename U>
+    bool operator==(const NodeAllocator<U>& other) const {
+        return arena == other.arena;
+    }
+    template <typename U>
+    bool operator!=(const NodeAllocator<U>& other) const {
+        return arena != other.arena;
+    }
+};
+
+}}}}  // org::w3c::dom::bootstrap
+
+#endif  // ORG_W3C_DOM_BOOTSTRAP_NODEARENA_H_INCLUDED
@@ -17,10 +17,15 @@
 #include "NodeImp.h"
 #include "DocumentImp.h"
 #include "MutationEventImp.h"
+#include "MutationObserverImp.h"
 #include "ElementImp.h"
 #include "NodeListImp.h"
 #include "RangeImp.h"
 #include "TextImp.h"
+#include "WindowImp.h"
+#include "WindowProxy.h"
+#include "html/HTMLCollectionImp.h"
+#include "html/HTMLTemplateElementImp.h"
 
 namespace org { namespace w3c { namespace dom { namespace bootstrap {
 
@@ -42,6 +47,7 @@ NodePtr NodeImp::removeChild(NodePtr item)
         prev->nextSibling = next;
     item->parentNode = item->previousSibling = item->nextSibling = 0;
     --childCount;
+    updateTreeVersion();
     return item;
 }
 
@@ -56,6 +62,7 @@ NodePtr NodeImp::insertBefore(NodePtr item, NodePtr after)
         item->previousSibling->nextSibling = item;
     item->setParent(std::static_pointer_cast<NodeImp>(self()));
     ++childCount;
+    updateTreeVersion();
     return item;
 }
 
@@ -71,9 +78,47 @@ NodePtr NodeImp::appendChild(NodePtr item)
     lastChild = item;
     item->setParent(std::static_pointer_cast<NodeImp>(self()));
     ++childCount;
+    updateTreeVersion();
     return item;
 }
 
+void NodeImp::updateTreeVersion()
+{
+    // Note the dynamic type is already NodeImp while ~NodeImp() is removing
+    // the children, so dynamic_cast cannot reach a document being destroyed.
+    if (DocumentPtr document = getOwnerDocumentImp())
+        document->incrementTreeVersion();
+    else if (DocumentImp* document = dynamic_cast<DocumentImp*>(this))
+        document->incrementTreeVersion();
+}
+
+DocumentPtr NodeImp::getTrackingDocument()
+{
+    if (DocumentPtr document = getOwnerDocumentImp())
+        return document;
+    if (dynamic_cast<DocumentImp*>(this))
+        return std::static_pointer_cast<DocumentImp>(self());
+    return nullptr;
+}
+
+std::shared_ptr<LiveHTMLCollectionImp> NodeImp::findLiveCollection(unsigned kind, const std::u16string& key)
+{
+    for (auto i = liveCollections.begin(); i != liveCollections.end();) {
+        if (auto collection = i->lock()) {
+            if (collection->isFor(kind, key))
+                return collection;
+            ++i;
+        } else
+            i = liveCollections.erase(i);
+    }
+    return nullptr;
+}
+
+void NodeImp::addLiveCollection(const std::shared_ptr<LiveHTMLCollectionImp>& collection)
+{
+    liveCollections.push_back(collection);
+}
+
 void NodeImp::setOwnerDocument(const DocumentPtr& document)
 {
     if (getOwnerDocumentImp() != document) {
@@ -237,6 +282,43 @@ struct InsertFunctor
 
 }
 
+bool NodeImp::hasMutationListeners(unsigned bit)
+{
+    if (hasListener(bit))
+        return true;
+    if (DocumentPtr document = getOwnerDocumentImp()) {
+        if (WindowProxyPtr view = document->getDefaultWindow()) {
+            if (auto window = view->getWindowPtr()) {
+                if (window->hasListener(bit))
+                    return true;
+            }
+        }
+    }
+
+    // Follow the same path as EventTargetImp::dispatchEvent() does.
+    for (NodePtr ancestor = getParent(); ancestor; ancestor = ancestor->getParent()) {
+        if (auto shadowTree = std::dynamic_pointer_cast<HTMLTemplateElementImp>(ancestor)) {
+            if (auto host = std::dynamic_pointer_cast<NodeImp>(shadowTree->getHost().self())) {
+                DocumentPtr boundDocument = host->getOwnerDocumentImp();
+                return boundDocument && boundDocument->hasListener(bit);
+            }
+        }
+        if (ancestor->hasListener(bit))
+            return true;
+    }
+    return false;
+}
+
+void NodeImp::notifyNodeInserted(const NodePtr& node)
+{
+    if (node->hasMutationListeners(NodeInsertedListener)) {
+        auto event = std::make_shared<MutationEventImp>();
+        event->initMutationEvent(u"DOMNodeInserted", true, false, self(), u"", u"", u"", 0);
+        node->dispatchEvent(event);
+    }
+    MutationObserverImp::queueChildList(std::static_pointer_cast<NodeImp>(self()), node, nullptr, node->previousSibling, node->nextSibling);
+}
+
 // Insert a node before child.
 void NodeImp::insert(const NodePtr& node, const NodePtr& child, bool suppressObservers)
 {
@@ -258,22 +340,16 @@ void NodeImp::insert(const NodePtr& node, const NodePtr& child, bool suppressObs
                 insertBefore(n.self(), child);
             else
                 appendChild(n.self());
-            if (!suppressObservers) {
-                auto event = std::make_shared<MutationEventImp>();
-                event->initMutationEvent(u"DOMNodeInserted", true, false, self(), u"", u"", u"", 0);
-                node->dispatchEvent(event);
-            }
+            if (!suppressObservers)
+                notifyNodeInserted(std::static_pointer_cast<NodeImp>(n.self()));
         }
     } else {
         if (child)
             insertBefore(node, child);
         else
             appendChild(node);
-        if (!suppressObservers) {
-            auto event = std::make_shared<MutationEventImp>();
-            event->initMutationEvent(u"DOMNodeInserted", true, false, self(), u"", u"", u"", 0);
-            node->dispatchEvent(event);
-        }
+        if (!suppressObservers)
+            notifyNodeInserted(node);
     }
 }
 
@@ -416,13 +492,59 @@ void NodeImp::remove(const NodePtr& child, bool suppressObservers)
         document->forEachRange(RemoveFunctor(parent, child, index));
 
     if (!suppressObservers) {
-        auto event = std::make_shared<MutationEventImp>();
-        event->initMutationEvent(u"DOMNodeRemoved", true, false, std::static_pointer_cast<NodeImp>(self()), u"", u"", u"", 0);
-        child->dispatchEvent(event);
+        if (child->hasMutationListeners(NodeRemovedListener)) {
+            auto event = std::make_shared<MutationEventImp>();
+            event->initMutationEvent(u"DOMNodeRemoved", true, false, parent, u"", u"", u"", 0);
+            child->dispatchEvent(event);
+        }
+        MutationObserverImp::queueChildList(parent, nullptr, child, child->previousSibling, child->nextSibling);
     }
     removeChild(child);
 }
 
+// Replaces all the children of this node with the children of container as a
+// single mutation. cf. https://dom.spec.whatwg.org/#concept-node-replace-all
+void NodeImp::replaceAll(const NodePtr& container)
+{
+    NodePtr parent(std::static_pointer_cast<NodeImp>(self()));
+    DocumentPtr document = getOwnerDocumentImp();
+
+    std::deque<NodePtr> removed;
+    bool removedListened = hasMutationListeners(NodeRemovedListener);
+    while (NodePtr child = firstChild) {
+        if (document)
+            document->forEachRange(RemoveFunctor(parent, child, 0));
+        if (removedListened || child->hasListener(NodeRemovedListener)) {
+            auto event = std::make_shared<MutationEventImp>();
+            event->initMutationEvent(u"DOMNodeRemoved", true, false, parent, u"", u"", u"", 0);
+            child->dispatchEvent(event);
+            if (child != firstChild)
+                continue;
+        }
+        removeChild(child);
+        removed.push_back(child);
+    }
+
+    std::deque<NodePtr> added;
+    if (container) {
+        while (NodePtr child = container->firstChild) {
+            container->removeChild(child);
+            appendChild(child);
+            added.push_back(child);
+        }
+    }
+    if (!added.empty() && hasMutationListeners(NodeInsertedListener)) {
+        for (auto i = added.begin(); i != added.end(); ++i) {
+            auto event = std::make_shared<MutationEventImp>();
+            event->initMutationEvent(u"DOMNodeInserted", true, false, parent, u"", u"", u"", 0);
+            (*i)->dispatchEvent(event);
+        }
+    }
+
+    if (!added.empty() || !removed.empty())
+        MutationObserverImp::queueChildList(parent, added, removed);
+}
+
 // Node
 unsigned short NodeImp::getNodeType()
 {
@@ -466,10 +588,10 @@ bool NodeImp::hasChildNodes()
 
 NodeList NodeImp::getChildNodes()
 {
-    NodeListPtr nodeList = std::make_shared<NodeListImp>();
-    if (nodeList) {
-        for (NodePtr node = firstChild; node; node = node->nextSibling)
-            nodeList->addItem(node);
+    NodeListPtr nodeList = childNodeList.lock();
+    if (!nodeList) {
+        nodeList = std::make_shared<ChildNodeListImp>(std::static_pointer_cast<NodeImp>(self()));
+        childNodeList = nodeList;
     }
     return nodeList;
 }
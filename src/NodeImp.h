@@ -37,7 +37,9 @@
 namespace org { namespace w3c { namespace dom { namespace bootstrap {
 
 class DocumentImp;
+class LiveHTMLCollectionImp;
 class NodeImp;
+class NodeListImp;
 
 typedef std::shared_ptr<NodeImp> NodePtr;
 typedef std::shared_ptr<DocumentImp> DocumentPtr;
@@ -45,6 +47,7 @@ typedef std::shared_ptr<DocumentImp> DocumentPtr;
 class NodeImp : public ObjectMixin<NodeImp, EventTargetImp>
 {
     friend class NodeListImp;
+    friend class DOMSerializer;
     friend class ElementImp;
     friend class EventTargetImp;
     friend class HTMLElementImp;  // for focus
@@ -57,9 +60,15 @@ class NodeImp : public ObjectMixin<NodeImp, EventTargetImp>
     NodePtr nextSibling;
     unsigned int childCount = 0;
 
+    // Live collections rooted at this node
+    std::weak_ptr<NodeListImp> childNodeList;
+    std::list<std::weak_ptr<LiveHTMLCollectionImp>> liveCollections;
+
     NodePtr removeChild(NodePtr item);
     NodePtr appendChild(NodePtr item);
     NodePtr insertBefore(NodePtr item, NodePtr after);
+    void updateTreeVersion();
+    void notifyNodeInserted(const NodePtr& node);
 
 protected:
     std::u16string nodeName;
@@ -121,6 +130,15 @@ public:
     }
     void setOwnerDocument(const DocumentPtr& document);
 
+    // Returns the document whose DOM version counters track this node, i.e.,
+    // the owner document, or this node itself if it is a document.
+    DocumentPtr getTrackingDocument();
+
+    // Returns the live collection of the given kind and key rooted at this
+    // node if it is still in use.
+    std::shared_ptr<LiveHTMLCollectionImp> findLiveCollection(unsigned kind, const std::u16string& key);
+    void addLiveCollection(const std::shared_ptr<LiveHTMLCollectionImp>& collection);
+
     unsigned int getChildCount() const {
         return childCount;
     }
@@ -140,9 +158,15 @@ public:
     NodePtr replace(const NodePtr& child, const NodePtr& node);
     NodePtr preRemove(const NodePtr& child);
     void remove(const NodePtr& child, bool suppressObservers = false);
+    void replaceAll(const NodePtr& container);
 
     void cloneChildren(NodeImp* org);
 
+    // Checks whether a mutation event of the type given by listener bit
+    // would reach any listener if it were dispatched to this node, without
+    // building the event path.
+    bool hasMutationListeners(unsigned bit);
+
     // Node
     virtual unsigned short getNodeType();
     virtual std::u16string getNodeName();
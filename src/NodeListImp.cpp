@@ -16,6 +16,65 @@
 
 #include "NodeListImp.h"
 
+#include "DocumentImp.h"
+#include "NodeImp.h"
+
 namespace org { namespace w3c { namespace dom { namespace bootstrap {
 
+ChildNodeListImp::ChildNodeListImp(const std::shared_ptr<NodeImp>& parent) :
+    parent(parent),
+    document(0),
+    version(0),
+    cursorIndex(0)
+{
+}
+
+Node ChildNodeListImp::item(unsigned int index)
+{
+    unsigned int length = parent->getChildCount();
+    if (length <= index)
+        return nullptr;
+
+    DocumentPtr owner = parent->getTrackingDocument();
+    if (!owner || owner.get() != document || owner->getTreeVersion() != version) {
+        cursor.reset();
+        document = owner.get();
+        version = owner ? owner->getTreeVersion() : 0;
+    }
+
+    // Start from whichever of the cursor, the first child, and the last child
+    // is the nearest to index.
+    NodePtr node;
+    unsigned int i;
+    if (index < length - 1 - index) {
+        node = parent->getFirstChildPtr();
+        i = 0;
+    } else {
+        node = parent->getLastChildPtr();
+        i = length - 1;
+    }
+    if (cursor) {
+        unsigned int distance = (index < cursorIndex) ? cursorIndex - index : index - cursorIndex;
+        if (distance < ((i < index) ? index - i : i - index)) {
+            node = cursor;
+            i = cursorIndex;
+        }
+    }
+    for (; i < index; ++i)
+        node = node->getNextSiblingPtr();
+    for (; index < i; --i)
+        node = node->getPreviousSiblingPtr();
+
+    if (owner) {
+        cursor = node;
+        cursorIndex = index;
+    }
+    return node;
+}
+
+unsigned int ChildNodeListImp::getLength()
+{
+    return parent->getChildCount();
+}
+
 }}}}  // org::w3c::dom::bootstrap
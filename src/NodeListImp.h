@@ -61,6 +61,29 @@ public:
 
 typedef std::shared_ptr<NodeListImp> NodeListPtr;
 
+class DocumentImp;
+class NodeImp;
+
+// ChildNodeListImp is the live list returned by Node.childNodes. It keeps the
+// last visited child as a cursor so that a sequential scan over the list
+// costs O(1) per item. The cursor is discarded once the tree version of the
+// owner document has changed.
+class ChildNodeListImp : public NodeListImp
+{
+    std::shared_ptr<NodeImp> parent;
+    const DocumentImp* document;
+    unsigned version;
+    std::shared_ptr<NodeImp> cursor;
+    unsigned int cursorIndex;
+
+public:
+    ChildNodeListImp(const std::shared_ptr<NodeImp>& parent);
+
+    // NodeList
+    virtual Node item(unsigned int index);
+    virtual unsigned int getLength();
+};
+
 
 }}}}  // org::w3c::dom::bootstrap
 
@@ -585,6 +585,11 @@ public:
     double toNumber() const;
     std::u16string toString() const;
 
+    // Returns the string held without making a copy; valid only if isString().
+    const std::u16string& getString() const {
+        return string;
+    }
+
     std::shared_ptr<Imp> toObject() const {
         return isObject() ? pimpl : nullptr;
     }
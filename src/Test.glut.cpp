@@ -17,10 +17,12 @@
 #include <GL/glew.h>
 #include <GL/freeglut.h>
 
+#include <cmath>
 #include <thread>
 #include <mutex>
 #include <vector>
 
+#include "FrameScheduler.h"
 #include "WindowProxy.h"
 #include "Test.util.h"
 #include "http/HTTPConnection.h"
@@ -30,6 +32,8 @@ using namespace org::w3c::dom;
 
 html::Window window;
 
+void timer(int value);
+
 namespace
 {
 
@@ -40,6 +44,10 @@ const unsigned MainThread = 0x01;
 __thread unsigned threadFlags;
 std::vector<GLuint> texturesToDelete;
 
+// The pending frame timer; the stale ones are ignored.
+int frameGeneration;
+double frameDue = HUGE_VAL;
+
 void deleteTextures() {
     std::lock_guard<std::mutex> lock(mutex);
     if (!texturesToDelete.empty()) {
@@ -48,6 +56,18 @@ void deleteTextures() {
     }
 }
 
+// Arms the frame timer for the first frame at or after time unless an
+// earlier frame is already scheduled.
+void scheduleFrame(double time)
+{
+    int delay = FrameScheduler::getInstance().getDelay(time);
+    double due = FrameScheduler::now() + delay;
+    if (frameDue <= due)
+        return;
+    frameDue = due;
+    glutTimerFunc(delay, timer, ++frameGeneration);
+}
+
 }
 
 void deleteTexture(unsigned texture) {
@@ -71,6 +91,7 @@ void reshape(int w, int h)
 
     if (auto imp = std::static_pointer_cast<WindowProxy>(window.self()))
         imp->setSize(w, h);
+    scheduleFrame(0.0);
 }
 
 void display()
@@ -96,6 +117,7 @@ void display()
     deleteTextures();
 
     glutSwapBuffers();  // This would block until the sync happens
+    FrameScheduler::getInstance().endFrame();
 }
 
 unsigned getCharKeyCode(int key)
@@ -125,12 +147,14 @@ void keyboard(unsigned char key, int x, int y)
 {
     if (auto imp = std::static_pointer_cast<WindowProxy>(window.self()))
         imp->keydown(isprint(key) ? key : 0, getCharKeyCode(key), glutGetModifiers());
+    scheduleFrame(0.0);
 }
 
 void keyboardUp(unsigned char key, int x, int y)
 {
     if (auto imp = std::static_pointer_cast<WindowProxy>(window.self()))
         imp->keyup(isprint(key) ? key : 0, getCharKeyCode(key), glutGetModifiers());
+    scheduleFrame(0.0);
 }
 
 unsigned getSpecialKeyCode(int key)
@@ -191,6 +215,7 @@ void special(int key, int x, int y)
     if (keycode) {
         if (auto imp = std::static_pointer_cast<WindowProxy>(window.self()))
             imp->keydown(0, keycode, glutGetModifiers());
+        scheduleFrame(0.0);
     }
 }
 
@@ -200,6 +225,7 @@ void specialUp(int key, int x, int y)
     if (keycode) {
         if (auto imp = std::static_pointer_cast<WindowProxy>(window.self()))
             imp->keyup(0, keycode, glutGetModifiers());
+        scheduleFrame(0.0);
     }
 }
 
@@ -207,12 +233,14 @@ void mouse(int button, int state, int x, int y)
 {
     if (auto imp = std::static_pointer_cast<WindowProxy>(window.self()))
         imp->mouse(button, state, x, y, glutGetModifiers());
+    scheduleFrame(0.0);
 }
 
 void mouseMove(int x, int y)
 {
     if (auto imp = std::static_pointer_cast<WindowProxy>(window.self()))
         imp->mouseMove(x, y, glutGetModifiers());
+    scheduleFrame(0.0);
 }
 
 void entry(int state)
@@ -223,17 +251,35 @@ void entry(int state)
             // TODO: Keep modifiers status.
             imp->mouseMove(-1, -1, 0 /* glutGetModifiers() */);
         }
+        scheduleFrame(0.0);
     }
 }
 
 void timer(int value)
 {
-    HttpConnectionManager::getInstance().poll();    // TODO: This line should not be necessary.
+    if (value != frameGeneration)
+        return;
+    frameDue = HUGE_VAL;
+
+    FrameScheduler& scheduler = FrameScheduler::getInstance();
+    scheduler.beginFrame();
+    HttpConnectionManager& manager = HttpConnectionManager::getInstance();
+    manager.poll();    // TODO: This line should not be necessary.
+    double next = HUGE_VAL;
     if (auto imp = std::static_pointer_cast<WindowProxy>(window.self())) {
         if (imp->poll())
-            glutPostRedisplay();
-    }
-    glutTimerFunc(50, timer, 0);
+            glutPostRedisplay();    // display() ends the frame.
+        else
+            scheduler.endFrame();
+        next = imp->getWakeUpTime();
+    } else
+        scheduler.endFrame();
+    // Keep polling while the network is busy; otherwise sleep until the next
+    // timer or an input event.
+    if (!manager.isIdle())
+        next = 0.0;
+    if (next < HUGE_VAL)
+        scheduleFrame(next);
     // TODO: do GC here or maybe in the idle proc
 }
 
@@ -281,7 +327,7 @@ void init(int* argc, char* argv[], int width, int height)
     glutMotionFunc(mouseMove);
     glutPassiveMotionFunc(mouseMove);
     glutEntryFunc(entry);
-    glutTimerFunc(50, timer, 0);
+    scheduleFrame(0.0);
     glutSetOption(GLUT_ACTION_ON_WINDOW_CLOSE, GLUT_ACTION_CONTINUE_EXECUTION);
 
     glClearStencil(0x00);
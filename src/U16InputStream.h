@@ -72,6 +72,57 @@ public:
     }
 };
 
+// U16StringInputStream reads directly from the buffer of a UTF-16 string,
+// which must outlive the stream. CR and CR LF are normalized to LF.
+class U16StringInputStream : public U16InputStream
+{
+    const char16_t* nextChar;
+    const char16_t* end;
+    char16_t lastChar;
+    bool eof;
+
+public:
+    U16StringInputStream(const std::u16string& text) :
+        nextChar(text.data()),
+        end(text.data() + text.length()),
+        lastChar(0),
+        eof(false)
+    {}
+    virtual explicit operator bool( ) const {
+        return !eof;
+    }
+    virtual bool operator! () const {
+        return eof;
+    }
+    virtual int peek() {
+        if (lastChar == '\r' && nextChar < end && *nextChar == '\n') {
+            lastChar = '\n';
+            ++nextChar;
+        }
+        if (end <= nextChar) {
+            eof = true;
+            return -1;
+        }
+        switch (int c = *nextChar) {
+        case '\r':
+            return '\n';
+        case '\0':
+            return u'\xfffd';
+        default:
+            return c;
+        }
+    }
+    virtual U16StringInputStream& get(char16_t& c) {
+        int ch = peek();
+        if (!eof) {
+            lastChar = *nextChar;
+            ++nextChar;
+            c = static_cast<char16_t>(ch);
+        }
+        return *this;
+    }
+};
+
 class U16ConverterInputStream : public U16InputStream
 {
 public:
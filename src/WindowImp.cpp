@@ -109,6 +109,7 @@ HttpRequestPtr WindowImp::preload(const std::u16string& base, const std::u16stri
     if (request) {
         cache.push_back(request);
         request->open(u"GET", urlString);
+        request->setPriority(HttpRequest::IMAGE_PRIORITY);
         request->setHandler(boost::bind(&WindowImp::notify, this, request));
         if (document)
             document->incrementLoadEventDelayCount(urlString);
@@ -16,6 +16,8 @@
 
 #include "WindowProxy.h"
 
+#include <algorithm>
+#include <cmath>
 #include <new>
 #include <iostream>
 #include <boost/version.hpp>
@@ -26,6 +28,7 @@
 #include "BeforeUnloadEventImp.h"
 #include "DOMImplementationImp.h"
 #include "DocumentImp.h"
+#include "FrameScheduler.h"
 #include "HashChangeEventImp.h"
 #include "KeyboardEventImp.h"
 #include "MouseEventImp.h"
@@ -42,9 +45,9 @@
 
 namespace org { namespace w3c { namespace dom { namespace bootstrap {
 
-WindowProxy::Parser::Parser(const DocumentPtr& document, int fd, const std::string& optionalEncoding) :
-    stream(fd, boost::iostreams::close_handle),
-    htmlInputStream(stream, optionalEncoding),
+WindowProxy::Parser::Parser(const DocumentPtr& document, std::unique_ptr<std::istream> stream, const std::string& optionalEncoding) :
+    stream(std::move(stream)),
+    htmlInputStream(*this->stream, optionalEncoding),
     tokenizer(&htmlInputStream),
     parser(document, &tokenizer)
 {
@@ -59,12 +62,17 @@ WindowProxy::WindowProxy(unsigned short flags) :
     view(0),
     viewFlags(0),
     flags(flags),
+    lastHandle(0),
+    timeOrigin(FrameScheduler::now()),
     detail(0),
     buttons(0),
     scrollWidth(0),
     scrollHeight(0),
     width(816),     // US letter size, 96 DPI
     height(1056),
+    layerOffsetX(0),
+    layerOffsetY(0),
+    scrollBars(false),
     redisplay(false),
     zoomable(true),
     zoom(1.0f),
@@ -155,6 +163,12 @@ void WindowProxy::updateView(ViewCSSImp* next)
         delete view;
     }
     view = next;
+    hitTestSnapshot.clear();
+    double styleTime;
+    double layoutTime;
+    backgroundTask.takeTimes(styleTime, layoutTime);
+    FrameScheduler::getInstance().addPhaseTime(FrameScheduler::Style, styleTime);
+    FrameScheduler::getInstance().addPhaseTime(FrameScheduler::Layout, layoutTime);
     setViewFlags(flags);
     view->setZoom(zoom);
     detail = 0;
@@ -176,12 +190,24 @@ void WindowProxy::updateView(ViewCSSImp* next)
     window->flushMediaQueryLists(view);
 }
 
+void WindowProxy::releaseView()
+{
+    // Keep what is on the screen hit-testable while the background task
+    // updates the box tree; this must be done before waking up the task.
+    view->snapshotHitTargets(hitTestSnapshot);
+    view = 0;
+}
+
 void WindowProxy::setWindowPtr(const WindowPtr& window)
 {
     this->window = window;
     delete view;
     view = 0;
     viewFlags = 0;
+    hitTestSnapshot.clear();
+    timers.clear();
+    animationFrameCallbacks.clear();
+    timeOrigin = FrameScheduler::now();
     if (window)
         backgroundTask.restart(BackgroundTask::Cascade);
     detail = 0;
@@ -222,26 +248,38 @@ bool WindowProxy::poll()
         }
     }
 
-    while (backgroundTask.getState() == BackgroundTask::Done && !eventQueue.empty()) {
-        const EventTask task = eventQueue.front();
-        switch (task.type) {
-        case EventTask::MouseDown:
-        case EventTask::MouseUp:
-            mouse(task);
-            break;
-        case EventTask::MouseMove:
-            mouseMove(task);
-            break;
-        case EventTask::KeyDown:
-            keydown(task);
-            break;
-        case EventTask::KeyUp:
-            keyup(task);
-            break;
-        default:
-            break;
+    // Events are dispatched also while the background task is suspended
+    // between the cascade and the layout; the mouse events are then targeted
+    // by hitTestSnapshot.
+    if (backgroundTask.isWaiting() && !eventQueue.empty()) {
+        FrameScheduler::Scope scope(FrameScheduler::Input);
+        unsigned dispatched = 0;
+        unsigned latency = 0;
+        unsigned now = getTick();
+        while (backgroundTask.isWaiting() && !eventQueue.empty()) {
+            const EventTask task = eventQueue.front();
+            latency = std::max(latency, now - task.timeStamp);
+            ++dispatched;
+            switch (task.type) {
+            case EventTask::MouseDown:
+            case EventTask::MouseUp:
+                mouse(task);
+                break;
+            case EventTask::MouseMove:
+                mouseMove(task);
+                break;
+            case EventTask::KeyDown:
+                keydown(task);
+                break;
+            case EventTask::KeyUp:
+                keyup(task);
+                break;
+            default:
+                break;
+            }
+            eventQueue.pop_front();
         }
-        eventQueue.pop_front();
+        recordTime("%*sdispatched %u events, latency %u ms%s", windowDepth * 2, "", dispatched, latency * 10, view ? "" : " (during layout)");
     }
 
     for (auto i = childWindows.begin(); i != childWindows.end(); ++i) {
@@ -251,8 +289,15 @@ bool WindowProxy::poll()
             if (view) {
                 if (document && document->isBindingDocumentWindow(child))
                     view->setFlags(Box::NEED_SELECTOR_REMATCHING);
-                else
-                    view->setFlags(Box::NEED_REPAINT);
+                else {
+                    BoxPtr box;
+                    if (auto frame = std::dynamic_pointer_cast<HTMLElementImp>(child->getFrameElementImp()))
+                        box = frame->getBox();
+                    if (box)
+                        box->setFlags(Box::NEED_REPAINT);
+                    else
+                        view->setFlags(Box::NEED_REPAINT);
+                }
             }
         }
     }
@@ -280,7 +325,7 @@ bool WindowProxy::poll()
                 else
                     document->setError(request->getError());
                 document->enter();
-                parser.reset(new(std::nothrow) Parser(document, request->getContentDescriptor(), request->getResponseMessage().getContentCharset()));
+                parser.reset(new(std::nothrow) Parser(document, request->openContent(), request->getResponseMessage().getContentCharset()));
                 document->exit();
                 if (!parser)
                     break;  // TODO: error handling
@@ -364,22 +409,28 @@ bool WindowProxy::poll()
                 }
                 if (document->getReadyState() == u"complete") {
                 }
+                // Run the timers and then the animation frame callbacks so
+                // that the changes they make are styled and laid out once.
+                runTimers();
+                runAnimationFrameCallbacks();
                 if (view) {
                     if (unsigned short gathered = viewFlags | view->gatherFlags()) {
                         viewFlags &= ~gathered;
                         if (gathered & Box::NEED_SELECTOR_REMATCHING) {
                             recordTime("%*strigger selector rematching", windowDepth * 2, "");
-                            backgroundTask.restart(BackgroundTask::Cascade);
-                            view = 0;
+                            releaseView();
+                            backgroundTask.wakeUp(BackgroundTask::Cascade | BackgroundTask::Rematch);
                         } else if (gathered & Box::NEED_SELECTOR_MATCHING) {
                             recordTime("%*strigger restyling", windowDepth * 2, "");
+                            releaseView();
                             backgroundTask.wakeUp(BackgroundTask::Cascade);
-                            view = 0;
                         } else if (gathered & (Box::NEED_STYLE_RECALCULATION | Box::NEED_EXPANSION | Box::NEED_CHILD_REFLOW | Box::NEED_REFLOW)) {
                             recordTime("%*strigger reflow", windowDepth * 2, "");
+                            releaseView();
                             backgroundTask.wakeUp(BackgroundTask::Layout);
-                            view = 0;
                         } else if (gathered & Box::NEED_REPAINT) {
+                            if (next)
+                                recordTime("%*slayout stable", windowDepth * 2, "");
                             redisplay = true;
                             if (flags & Loading) {
                                 flags &= ~Loading;
@@ -401,7 +452,7 @@ bool WindowProxy::poll()
     bool result = redisplay;
     redisplay = false;
     if (!result && view && view->hasExpired(getTick())) {
-        view->setFlags(Box::NEED_REPAINT);
+        view->damageAnimatedImages();
         result = true;
     }
     if (result)
@@ -409,27 +460,81 @@ bool WindowProxy::poll()
     return result;
 }
 
+bool WindowProxy::isLayerStale()
+{
+    float x = window->getScrollX();
+    float y = window->getScrollY();
+    if (view->isScrollDependent())
+        return x != view->getLayerLeft() || y != view->getLayerTop();
+    return x < view->getLayerLeft() || y < view->getLayerTop() ||
+           view->getLayerLeft() + view->getLayerWidth() < x + width / view->getZoom() ||
+           view->getLayerTop() + view->getLayerHeight() < y + height / view->getZoom();
+}
+
+void WindowProxy::updateLayer()
+{
+    // Paint as much of the document as fits in MaxLayerSize around the
+    // viewport so that scrolling within it only recomposites the canvas.
+    // Only the viewport is composited this way; scrolling an element
+    // repaints the damaged area of this layer.
+    float zoom = view->getZoom();
+    int w = width;
+    int h = height;
+    float x = window->getScrollX();
+    float y = window->getScrollY();
+    if (!view->isScrollDependent()) {
+        int maxSize = std::min(MaxLayerSize, Canvas::getMaxSize());
+        w = std::max(w, std::min(static_cast<int>(ceilf(scrollWidth * zoom)), maxSize));
+        h = std::max(h, std::min(static_cast<int>(ceilf(scrollHeight * zoom)), maxSize));
+        x = std::max(0.0f, std::min(x - (w - static_cast<int>(width)) / (2.0f * zoom), scrollWidth - w / zoom));
+        y = std::max(0.0f, std::min(y - (h - static_cast<int>(height)) / (2.0f * zoom), scrollHeight - h / zoom));
+    }
+    if (canvas.getWidth() != w || canvas.getHeight() != h) {
+        canvas.shutdown();
+        canvas.setup(w, h);
+    }
+    view->setLayer(x, y, w / zoom, h / zoom);
+}
+
 void WindowProxy::render(ViewCSSImp* parentView)
 {
+    double start = FrameScheduler::now();
     if (view) {
         std::string readyState = window->getDocument() ? utfconv(window->getDocument()->getReadyState()) : "";
         recordTime("%*srepaint begin: %s (%s)", windowDepth * 2, "", readyState.c_str(), view ? "render" : "canvas");
+        if (isLayerStale())
+            view->setFlags(Box::NEED_REPAINT);
         if (view->gatherFlags() & Box::NEED_REPAINT) {
+            view->gatherDamage(canvas.getWidth(), canvas.getHeight());
             view->clearFlags(Box::NEED_REPAINT);
-            // TODO: if the size of the canvas has not been changed, reuse the same canvas.
-            canvas.shutdown();
-            canvas.setup(width, height);
+            if (view->hasFullDamage())
+                updateLayer();
 
             unsigned backgroundColor = view->getBackgroundColor();
             if (backgroundColor == 0 && !getParent())
                 backgroundColor = 0xffffffff;
-            canvas.beginRender(backgroundColor);
+            int left = 0;
+            int top = 0;
+            int w = canvas.getWidth();
+            int h = canvas.getHeight();
+            if (view->hasFullDamage())
+                canvas.beginRender(backgroundColor);
+            else {
+                view->getDamage(left, top, w, h);
+                canvas.beginRender(backgroundColor, left, top, w, h);
+            }
 
             view->render(parentView ? parentView->getClipCount() : 0);
             scrollWidth = view->getScrollWidth();
             scrollHeight = view->getScrollHeight();
+            scrollBars = view->getTree() && view->canScroll();
             canvas.endRender();
+            recordTime("%*spainted %u boxes, %d pixels (%d,%d %dx%d), %u layers in %u KB", windowDepth * 2, "",
+                       view->getPaintedBoxes(), w * h, left, top, w, h,
+                       canvas.getLayerCount(), static_cast<unsigned>(canvas.getLayerMemory() / 1024));
         }
+        layerOffsetX = static_cast<int>(roundf((window->getScrollX() - view->getLayerLeft()) * view->getZoom()));
+        layerOffsetY = static_cast<int>(roundf((window->getScrollY() - view->getLayerTop()) * view->getZoom()));
         if (2 <= getLogLevel() && backgroundTask.isIdle() && !view->gatherFlags()) {
             unsigned depth = 1;
             for (WindowProxyPtr w = getParentProxy(); w; w = w->getParentProxy())
@@ -444,12 +549,128 @@ void WindowProxy::render(ViewCSSImp* parentView)
         }
         recordTime("%*srepaint end", windowDepth * 2, "");
     }
-    canvas.render(width, height);
+    canvas.render(width, height, layerOffsetX, layerOffsetY);
+    if (scrollBars && window)
+        ViewCSSImp::renderScrollBars(width, height, window->getScrollX(), window->getScrollY(), scrollWidth, scrollHeight);
+    if (!parentView)  // a child window is painted as a part of its parent
+        FrameScheduler::getInstance().addPhaseTime(FrameScheduler::Paint, FrameScheduler::now() - start);
+}
+
+int WindowProxy::addTimer(Object handler, const std::u16string& script, int timeout, Variadic<Any> arguments, bool repeat)
+{
+    Timer timer;
+    timer.handle = ++lastHandle;
+    timer.repeat = repeat;
+    timer.interval = std::max(0, timeout);
+    timer.due = FrameScheduler::now() + timer.interval;
+    timer.handler = handler;
+    timer.script = script;
+    for (size_t i = 0; i < arguments.size(); ++i)
+        timer.arguments.push_back(arguments[i]);
+    timers.push_back(timer);
+    return timer.handle;
+}
+
+void WindowProxy::removeTimer(int handle)
+{
+    for (auto i = timers.begin(); i != timers.end(); ++i) {
+        if (i->handle == handle) {
+            timers.erase(i);
+            break;
+        }
+    }
+}
+
+void WindowProxy::runTimers()
+{
+    // Every timer that has become due by the start of the frame runs in this
+    // frame, in the order of the due times, so that the timers close to each
+    // other share a single style, layout and paint. A timer runs at most once
+    // per frame; an interval timer that has fallen behind is not caught up.
+    double time = FrameScheduler::getInstance().getFrameTime();
+    std::vector<std::pair<double, int>> due;
+    for (auto i = timers.begin(); i != timers.end(); ++i) {
+        if (i->due <= time)
+            due.emplace_back(i->due, i->handle);
+    }
+    if (due.empty())
+        return;
+    std::sort(due.begin(), due.end());
+
+    FrameScheduler::Scope scope(FrameScheduler::Timers);
+    ECMAScriptContext* context = window->getContext();
+    enter();
+    for (auto j = due.begin(); j != due.end(); ++j) {
+        auto i = timers.begin();
+        while (i != timers.end() && i->handle != j->second)
+            ++i;
+        if (i == timers.end())
+            continue;   // cleared by a preceding timer
+        Timer timer(*i);
+        if (timer.repeat)
+            i->due = std::max(i->due + i->interval, time);
+        else
+            timers.erase(i);
+        if (timer.handler)
+            context->callFunction(self(), timer.handler, timer.arguments.size(), timer.arguments.empty() ? 0 : &timer.arguments[0]);
+        else
+            context->evaluate(timer.script);
+    }
+    exit();
+}
+
+void WindowProxy::runAnimationFrameCallbacks()
+{
+    if (animationFrameCallbacks.empty())
+        return;
+
+    // The callbacks requested by these callbacks run in the next frame.
+    std::list<std::pair<int, Object>> callbacks;
+    callbacks.swap(animationFrameCallbacks);
+
+    FrameScheduler::Scope scope(FrameScheduler::Animation);
+    ECMAScriptContext* context = window->getContext();
+    Any time(std::max(0.0, FrameScheduler::getInstance().getFrameTime() - timeOrigin));
+    enter();
+    for (auto i = callbacks.begin(); i != callbacks.end(); ++i)
+        context->callFunction(self(), i->second, 1, &time);
+    exit();
+}
+
+double WindowProxy::getWakeUpTime()
+{
+    if (request->getReadyState() != HttpRequest::DONE)
+        return 0.0;
+    if (!window)
+        return HUGE_VAL;
+    if (parser || (flags & Loading) ||
+        !eventQueue.empty() || redisplay || viewFlags || !animationFrameCallbacks.empty() ||
+        !backgroundTask.isIdle() || !window->getTaskQueue().empty() ||
+        (view && view->gatherFlags()))
+        return 0.0;
+    double time = HUGE_VAL;
+    for (auto i = timers.begin(); i != timers.end(); ++i)
+        time = std::min(time, i->due);
+    if (view && view->getDelay()) {
+        // The animated images count in 1/100 sec.
+        int ticks = static_cast<int>(view->getLast() + view->getDelay()) - static_cast<int>(getTick());
+        time = std::min(time, FrameScheduler::now() + 10.0 * std::max(0, ticks));
+    }
+    for (auto i = childWindows.begin(); i != childWindows.end(); ++i)
+        time = std::min(time, (*i)->getWakeUpTime());
+    return time;
+}
+
+void WindowProxy::queueEvent(const EventTask& task)
+{
+    eventQueue.push_back(task);
+    eventQueue.back().timeStamp = getTick();
+    backgroundTask.interrupt();
 }
 
 void WindowProxy::mouse(int button, int up, int x, int y, int modifiers)
 {
-    eventQueue.emplace_back(up ? EventTask::MouseUp : EventTask::MouseDown, modifiers, x, y, button);
+    queueEvent(EventTask(up ? EventTask::MouseUp : EventTask::MouseDown, modifiers, x, y, button));
 }
 
 void WindowProxy::mouseMove(int x, int y, int modifiers)
@@ -463,17 +684,35 @@ void WindowProxy::mouseMove(int x, int y, int modifiers)
             return;
         }
     }
-    eventQueue.emplace_back(EventTask::MouseMove, modifiers, x, y);
+    queueEvent(EventTask(EventTask::MouseMove, modifiers, x, y));
 }
 
 void WindowProxy::keydown(unsigned charCode, unsigned keyCode, int modifiers)
 {
-    eventQueue.emplace_back(EventTask::KeyDown, modifiers, charCode, keyCode);
+    queueEvent(EventTask(EventTask::KeyDown, modifiers, charCode, keyCode));
 }
 
 void WindowProxy::keyup(unsigned charCode, unsigned keyCode, int modifiers)
 {
-    eventQueue.emplace_back(EventTask::KeyUp, modifiers, charCode, keyCode);
+    queueEvent(EventTask(EventTask::KeyUp, modifiers, charCode, keyCode));
+}
+
+bool WindowProxy::hitTest(int x, int y, HitTestSnapshot::Entry& hit)
+{
+    if (view) {
+        BoxPtr box = view->boxFromPoint(x, y);
+        if (!box)
+            return false;
+        hit = HitTestSnapshot::Entry(box.get());
+        return true;
+    }
+    if (!window)
+        return false;
+    const HitTestSnapshot::Entry* entry = hitTestSnapshot.find(x + window->getScrollX(), y + window->getScrollY());
+    if (!entry)
+        return false;
+    hit = *entry;
+    return true;
 }
 
 void WindowProxy::mouse(const EventTask& task)
@@ -484,7 +723,7 @@ void WindowProxy::mouse(const EventTask& task)
     int y = task.y;
     int modifiers = task.modifiers;
 
-    if (!view)
+    if (!view && hitTestSnapshot.empty())
         return;
 
     recordTime("%*smouse (%d, %d)", windowDepth * 2, "", x, y);
@@ -499,16 +738,13 @@ void WindowProxy::mouse(const EventTask& task)
     else
         buttons |= (1u << shift);
 
-    BoxPtr box = view->boxFromPoint(x, y);
-    if (!box)
+    HitTestSnapshot::Entry hit;
+    if (!hitTest(x, y, hit))
         return;
-    if (WindowProxyPtr childWindow = box->getChildWindow()) {
-        childWindow->mouse(button, up,
-                           x - box->getX() - box->getBlankLeft(), y - box->getY() - box->getBlankTop(),
-                           modifiers);
-    }
+    if (hit.childWindow)
+        hit.childWindow->mouse(button, up, x - hit.childX, y - hit.childY, modifiers);
 
-    Element target = Box::getContainingElement(box->getTargetNode());
+    Element target = Box::getContainingElement(hit.node);
 
     // mousedown, mousemove
     if (auto event = std::make_shared<MouseEventImp>()) {
@@ -525,8 +761,8 @@ void WindowProxy::mouse(const EventTask& task)
 
     if (!up || detail == 0)
         return;
-    BoxPtr clickBox = view->boxFromPoint(x, y);
-    if (box != clickBox)
+    HitTestSnapshot::Entry clickHit;
+    if (!hitTest(x, y, clickHit) || hit.box != clickHit.box)
         return;
 
     // click
@@ -545,14 +781,17 @@ void WindowProxy::mouseMove(const EventTask& task)
     int y = task.y;
     int modifiers = task.modifiers;
 
-    if (!view)
+    if (!view && hitTestSnapshot.empty())
         return;
-    BoxPtr box = view->boxFromPoint(x, y);
-    if (!box)
+    HitTestSnapshot::Entry hit;
+    if (!hitTest(x, y, hit))
         return;
 
-    Element target = Box::getContainingElement(box->getTargetNode());
-    Element prev = view->setHovered(target);
+    Element target = Box::getContainingElement(hit.node);
+    // While the background task is suspended, :hover is updated in the view
+    // it is about to lay out.
+    ViewCSSImp* hoverView = view ? view : backgroundTask.getSuspendedView();
+    Element prev = (hoverView && hoverView->getTree()) ? hoverView->setHovered(target) : target;
 
     if (prev != target) {
         if (html::Window c = interface_cast<html::HTMLIFrameElement>(prev).getContentWindow()) {
@@ -560,11 +799,8 @@ void WindowProxy::mouseMove(const EventTask& task)
                 w->mouseMove(-1, -1, modifiers);
         }
     }
-    if (auto childWindow = box->getChildWindow()) {
-        childWindow->mouseMove(x - box->getX() - box->getBlankLeft(),
-                               y - box->getY() - box->getBlankTop(),
-                               modifiers);
-    }
+    if (hit.childWindow)
+        hit.childWindow->mouseMove(x - hit.childX, y - hit.childY, modifiers);
     if (prev != target) {
         // mouseout
         if (auto event = std::make_shared<MouseEventImp>()) {
@@ -1042,6 +1278,7 @@ void WindowProxy::navigate(std::u16string url, bool replace, WindowProxy* srcWin
     request->abort();
     history->setReplace(replace);
     request->open(u"get", url.empty() ? u"about:blank" : url);
+    request->setPriority(HttpRequest::DOCUMENT_PRIORITY);
     request->send();
 }
 
@@ -1808,13 +2045,18 @@ void WindowProxy::updateView()
 {
     if (auto parent = getParentProxy())
         parent->updateView();
+    // An event handler run while the background task is suspended needs the
+    // layout to be completed first.
+    if (!view && backgroundTask.getState() == BackgroundTask::Cascaded)
+        finishBackgroundTask();
     while (view) {
+        view->flushMutations();
         unsigned gathered = viewFlags | view->gatherFlags();
         if (!gathered || gathered == Box::NEED_REPAINT)
             return;
         viewFlags &= ~gathered;
         if (gathered & Box::NEED_SELECTOR_REMATCHING) {
-            backgroundTask.restart(BackgroundTask::Cascade);
+            backgroundTask.wakeUp(BackgroundTask::Cascade | BackgroundTask::Rematch);
             view = 0;
         } else if (gathered & Box::NEED_SELECTOR_MATCHING) {
             backgroundTask.wakeUp(BackgroundTask::Cascade);
@@ -1823,23 +2065,27 @@ void WindowProxy::updateView()
             backgroundTask.wakeUp(BackgroundTask::Layout);
             view = 0;
         }
-        while (backgroundTask.isRestarting() ||
-               backgroundTask.getState() != BackgroundTask::Done && backgroundTask.getState() != BackgroundTask::Init)
-        {
-            backgroundTask.wait();
-            if (backgroundTask.getState() == BackgroundTask::Cascaded) {
-                if (auto document = window->getDocument()) {
-                    if (HTMLElementImp::xblEnteredDocument(document)) {
-                        backgroundTask.wakeUp(BackgroundTask::Cascade);
-                        continue;
-                    }
-                }
+        finishBackgroundTask();
+    }
+}
+
+void WindowProxy::finishBackgroundTask()
+{
+    for (;;) {
+        if (backgroundTask.getState() == BackgroundTask::Cascaded && !backgroundTask.isPending()) {
+            auto document = window->getDocument();
+            if (document && HTMLElementImp::xblEnteredDocument(document))
+                backgroundTask.wakeUp(BackgroundTask::Cascade);
+            else
                 backgroundTask.wakeUp(BackgroundTask::Layout);
-            }
         }
-        ViewCSSImp* next = backgroundTask.getView();
-        updateView(next);
+        if (!backgroundTask.isPending() &&
+            (backgroundTask.getState() == BackgroundTask::Done || backgroundTask.getState() == BackgroundTask::Init))
+            break;
+        backgroundTask.wait();
     }
+    ViewCSSImp* next = backgroundTask.getView();
+    updateView(next);
 }
 
 css::CSSStyleDeclaration WindowProxy::getComputedStyle(Element elt)
@@ -1909,8 +2155,9 @@ void WindowProxy::scroll(int x, int y)
     overflow = getScrollHeight() - height;
     y = std::max(0, std::min(y, static_cast<int>(overflow)));
 
+    // Note render() repaints the canvas only if the new viewport is not in it.
     window->scroll(x, y);
-    view->setFlags(Box::NEED_REPAINT);
+    redisplay = true;
 }
 
 void WindowProxy::scrollTo(int x, int y)
@@ -1980,60 +2227,70 @@ std::u16string WindowProxy::atob(const std::u16string& atob)
 
 int WindowProxy::setTimeout(events::EventHandlerNonNull handler)
 {
-    // TODO: implement me!
-    return 0;
+    return addTimer(handler, u"", 0, Variadic<Any>(), false);
 }
 
 int WindowProxy::setTimeout(events::EventHandlerNonNull handler, int timeout, Variadic<Any> arguments)
 {
-    // TODO: implement me!
-    return 0;
+    return addTimer(handler, u"", timeout, arguments, false);
 }
 
 int WindowProxy::setTimeout(const std::u16string& handler)
 {
-    // TODO: implement me!
-    return 0;
+    return addTimer(nullptr, handler, 0, Variadic<Any>(), false);
 }
 
 int WindowProxy::setTimeout(const std::u16string& handler, int timeout, Variadic<Any> arguments)
 {
-    // TODO: implement me!
-    return 0;
+    return addTimer(nullptr, handler, timeout, arguments, false);
 }
 
 void WindowProxy::clearTimeout(int handle)
 {
-    // TODO: implement me!
+    removeTimer(handle);
 }
 
 int WindowProxy::setInterval(events::EventHandlerNonNull handler)
 {
-    // TODO: implement me!
-    return 0;
+    return addTimer(handler, u"", 0, Variadic<Any>(), true);
 }
 
 int WindowProxy::setInterval(events::EventHandlerNonNull handler, int timeout, Variadic<Any> arguments)
 {
-    // TODO: implement me!
-    return 0;
+    return addTimer(handler, u"", timeout, arguments, true);
 }
 
 int WindowProxy::setInterval(const std::u16string& handler)
 {
-    // TODO: implement me!
-    return 0;
+    return addTimer(nullptr, handler, 0, Variadic<Any>(), true);
 }
 
 int WindowProxy::setInterval(const std::u16string& handler, int timeout, Variadic<Any> arguments)
 {
-    // TODO: implement me!
-    return 0;
+    return addTimer(nullptr, handler, timeout, arguments, true);
 }
 
 void WindowProxy::clearInterval(int handle)
 {
-    // TODO: implement me!
+    removeTimer(handle);
+}
+
+int WindowProxy::requestAnimationFrame(html::FrameRequestCallback callback)
+{
+    if (!callback)
+        return 0;
+    animationFrameCallbacks.emplace_back(++lastHandle, callback);
+    return lastHandle;
+}
+
+void WindowProxy::cancelAnimationFrame(int handle)
+{
+    for (auto i = animationFrameCallbacks.begin(); i != animationFrameCallbacks.end(); ++i) {
+        if (i->first == handle) {
+            animationFrameCallbacks.erase(i);
+            break;
+        }
+    }
 }
 
 void WindowProxy::postMessage(Any message, const std::u16string& targetOrigin)
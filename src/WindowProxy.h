@@ -36,6 +36,7 @@
 #include <org/w3c/dom/html/History.h>
 #include <org/w3c/dom/html/Location.h>
 #include <org/w3c/dom/html/ApplicationCache.h>
+#include <org/w3c/dom/html/FrameRequestCallback.h>
 #include <org/w3c/dom/html/Navigator.h>
 #include <org/w3c/dom/html/External.h>
 #include <org/w3c/dom/html/Transferable.h>
@@ -45,11 +46,12 @@
 #include <condition_variable>
 #include <cstdio>
 #include <deque>
+#include <istream>
+#include <list>
+#include <memory>
 #include <mutex>
 #include <thread>
-
-#include <boost/iostreams/stream.hpp>
-#include <boost/iostreams/device/file_descriptor.hpp>
+#include <vector>
 
 #include <org/w3c/dom/css/CSSStyleSheet.h>
 
@@ -60,6 +62,7 @@
 #include "HistoryImp.h"
 #include "LocationImp.h"
 #include "NavigatorImp.h"
+#include "css/HitTestSnapshot.h"
 #include "html/HTMLIFrameElementImp.h"
 #include "html/HTMLInputStream.h"
 #include "html/HTMLParser.h"
@@ -98,6 +101,7 @@ private:
         };
         int type;
         int modifiers;
+        unsigned timeStamp;     // in ticks, to report the input latency
         union {
             struct {
                 int x;
@@ -112,6 +116,7 @@ private:
         EventTask(int mouseType, int modifiers, int x, int y, int button = 0) :
             type(mouseType),
             modifiers(modifiers),
+            timeStamp(0),
             x(x),
             y(y),
             button(button)
@@ -119,6 +124,7 @@ private:
         EventTask(int keyType, int modifiers, unsigned charCode, unsigned keyCode) :
             type(keyType),
             modifiers(modifiers),
+            timeStamp(0),
             charCode(charCode),
             keyCode(keyCode)
         {}
@@ -138,7 +144,8 @@ private:
             Abort = 1,
             Cascade = 4,
             Layout = 8,
-            Restart = 16
+            Restart = 16,
+            Rematch = 32    // with Cascade, rematch the selectors of the existing view
         };
 
     private:
@@ -149,8 +156,12 @@ private:
         volatile unsigned flags;
         ViewCSSImp* view;
         volatile bool xfered;
+        volatile bool interrupted;
+        double styleTime;   // in milliseconds, since the last takeTimes()
+        double layoutTime;
 
         void deleteView();
+        void addTime(double& time, double start);
 
     public:
         BackgroundTask(WindowProxy* window);
@@ -161,26 +172,43 @@ private:
         void abort();
         void restart(unsigned flags = 0);
         ViewCSSImp* getView();
+        ViewCSSImp* getSuspendedView();
+        // Gets and resets the time spent on the style and layout work.
+        void takeTimes(double& style, double& layout);
         int getState() const {
             return state;
         }
+        // Asks the task to return to the main thread at the next safe point
+        // so that pending input events can be dispatched.
+        void interrupt() {
+            if (state == Cascading || state == Layouting)
+                interrupted = true;
+        }
+        // Returns true if the task is waiting for the main thread, i.e., it
+        // is done, or suspended between the cascade and the layout. The
+        // document can be accessed from the main thread in either state.
+        bool isWaiting();
         bool isIdle() const {
             return state == Done && !flags && xfered;
         }
         bool isRestarting() const {
             return flags & Restart;
         }
+        // Returns true if a command has been given but not taken up yet.
+        bool isPending() const {
+            return flags & (Cascade | Layout | Restart);
+        }
         bool wait();
     };
 
     class Parser
     {
-        boost::iostreams::stream<boost::iostreams::file_descriptor_source> stream;
+        std::unique_ptr<std::istream> stream;
         HTMLInputStream htmlInputStream;
         HTMLTokenizer tokenizer;
         HTMLParser parser;
     public:
-        Parser(const DocumentPtr& document, int fd, const std::string& optionalEncoding);
+        Parser(const DocumentPtr& document, std::unique_ptr<std::istream> stream, const std::string& optionalEncoding);
 
         Token getToken() {
             return tokenizer.getToken();
@@ -215,6 +243,23 @@ private:
     std::weak_ptr<ElementImp> frameElement;
 
     std::deque<EventTask> eventQueue;
+    HitTestSnapshot hitTestSnapshot;    // of the view being laid out in the background
+
+    // for WindowTimers and animation frames
+    struct Timer
+    {
+        int handle;
+        bool repeat;
+        double due;         // in milliseconds
+        double interval;
+        Object handler;     // the script is evaluated if handler is null
+        std::u16string script;
+        std::vector<Any> arguments;
+    };
+    std::list<Timer> timers;
+    std::list<std::pair<int, Object>> animationFrameCallbacks;
+    int lastHandle;
+    double timeOrigin;  // when the window was set, in FrameScheduler::now()
 
     std::unique_ptr<Parser> parser;
 
@@ -229,6 +274,9 @@ private:
     float scrollHeight;
     unsigned width;
     unsigned height;
+    int layerOffsetX;  // the viewport position in the canvas
+    int layerOffsetY;
+    bool scrollBars;
     bool redisplay;  // set true to force redisplay
     bool zoomable;
     float zoom;
@@ -238,6 +286,8 @@ private:
     // for report
     unsigned windowDepth;
 
+    void queueEvent(const EventTask& task);
+    bool hitTest(int x, int y, HitTestSnapshot::Entry& hit);
     void mouse(const EventTask& task);
     void mouseMove(const EventTask& task);
     void keydown(const EventTask& task);
@@ -247,7 +297,16 @@ private:
     WindowProxyPtr selectBrowsingContext(std::u16string target, bool& replace);
     void navigate(std::u16string url, bool replace, WindowProxy* srcWindow);
 
+    int addTimer(Object handler, const std::u16string& script, int timeout, Variadic<Any> arguments, bool repeat);
+    void removeTimer(int handle);
+    void runTimers();
+    void runAnimationFrameCallbacks();
+
     void updateView(ViewCSSImp* next);
+    void releaseView();
+    void finishBackgroundTask();
+    bool isLayerStale();
+    void updateLayer();
 
 public:
     WindowProxy(unsigned short flags);
@@ -255,6 +314,8 @@ public:
 
     static css::CSSStyleSheet defaultStyleSheet;
 
+    static const int MaxLayerSize = 4096;
+
     void setBase(const std::u16string& base) {
         request->setBase(base);
     }
@@ -283,10 +344,17 @@ public:
     bool isBindingDocumentWindow();
 
     bool poll();
+    // Returns the time in FrameScheduler::now() by which poll() needs to be
+    // called again; 0 for the next frame, and HUGE_VAL if there is nothing to
+    // do until an input event arrives.
+    double getWakeUpTime();
 
     void beginTranslucent() {
         canvas.beginTranslucent();
     }
+    void beginTranslucent(int left, int top, int w, int h) {
+        canvas.beginTranslucent(left, top, w, h);
+    }
     void endTranslucent(float alpha) {
         canvas.endTranslucent(alpha);
     }
@@ -628,6 +696,9 @@ public:
     int setInterval(const std::u16string& handler);
     int setInterval(const std::u16string& handler, int timeout, Variadic<Any> arguments = Variadic<Any>());
     void clearInterval(int handle);
+    // Window
+    int requestAnimationFrame(html::FrameRequestCallback callback);
+    void cancelAnimationFrame(int handle);
     // Window-35
     void postMessage(Any message, const std::u16string& targetOrigin);
     void postMessage(Any message, const std::u16string& targetOrigin, Sequence<html::Transferable> transfer);
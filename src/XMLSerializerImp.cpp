@@ -5,6 +5,9 @@
 
 #include "XMLSerializerImp.h"
 
+#include "DOMSerializer.h"
+#include "NodeImp.h"
+
 namespace org
 {
 namespace w3c
@@ -16,8 +19,10 @@ namespace bootstrap
 
 std::u16string XMLSerializerImp::serializeToString(Node root)
 {
-    // TODO: implement me!
-    return u"";
+    auto node = std::dynamic_pointer_cast<NodeImp>(root.self());
+    if (!node)
+        return u"";
+    return DOMSerializer::serializeXML(node.get());
 }
 
 }
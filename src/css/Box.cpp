@@ -66,6 +66,7 @@ ContainingBlock::~ContainingBlock()
 
 Box::Box(Node node) :
     node(node),
+    parentBox(0),
     childCount(0),
     clearance(NAN),
     marginTop(0.0f),
@@ -106,7 +107,7 @@ Box::~Box()
 bool Box::isSane() const
 {
     unsigned count = 0;
-    for (auto child = getFirstChild(); child; child = child->getNextSibling())
+    for (const Box* child = firstChild.get(); child; child = child->nextSibling.get())
         ++count;
     if (count != childCount)
         return false;
@@ -137,11 +138,11 @@ BoxPtr Box::removeChild(const BoxPtr& item)
 
 BoxPtr Box::insertBefore(const BoxPtr& item, const BoxPtr& after)
 {
-    assert(item != getParentBox());
-    assert(!item->getParentBox());
+    assert(item.get() != parentBox);
+    assert(!item->parentBox);
     if (!after)
         return appendChild(item);
-    assert(after->getParentBox().get() == this);
+    assert(after->parentBox == this);
     item->previousSibling = after->previousSibling;
     item->nextSibling = after;
     after->previousSibling = item;
@@ -149,15 +150,15 @@ BoxPtr Box::insertBefore(const BoxPtr& item, const BoxPtr& after)
         firstChild = item;
     else
         item->previousSibling->nextSibling = item;
-    item->setParentBox(self());
+    item->setParentBox(this);
     ++childCount;
     return item;
 }
 
 BoxPtr Box::appendChild(const BoxPtr& item)
 {
-    assert(item != getParentBox());
-    assert(!item->getParentBox());
+    assert(item.get() != parentBox);
+    assert(!item->parentBox);
     BoxPtr prev = lastChild;
     if (!prev)
         firstChild = item;
@@ -166,7 +167,7 @@ BoxPtr Box::appendChild(const BoxPtr& item)
     item->previousSibling = prev;
     item->nextSibling = 0;
     lastChild = item;
-    item->setParentBox(self());
+    item->setParentBox(this);
     ++childCount;
     return item;
 }
@@ -194,11 +195,11 @@ void Box::removeDescendants()
 
 void Box::setContainingBox(const BoxPtr& box)
 {
-    if (parentBox.expired()) {
+    if (!parentBox) {
         containingBox = box;
         return;
     }
-    assert(box == getParentBox());
+    assert(box.get() == parentBox);
 }
 
 void Box::setStyle(const CSSStyleDeclarationPtr& style)
@@ -224,7 +225,7 @@ void Box::unresolveStyle()
 float Box::getOutlineWidth() const
 {
     if (auto style = getStyle())
-        return style->outlineWidth.getPx();
+        return style->outlineValues->outlineWidth.getPx();
     return 0.0f;
 }
 
@@ -250,10 +251,10 @@ void Box::updatePadding()
 
 void Box::updateBorderWidth()
 {
-    borderTop = style->borderTopWidth.getPx();
-    borderRight = style->borderRightWidth.getPx();
-    borderBottom = style->borderBottomWidth.getPx();
-    borderLeft = style->borderLeftWidth.getPx();
+    borderTop = style->borderValues->borderTopWidth.getPx();
+    borderRight = style->borderValues->borderRightWidth.getPx();
+    borderBottom = style->borderValues->borderBottomWidth.getPx();
+    borderLeft = style->borderValues->borderLeftWidth.getPx();
 }
 
 ContainingBlockPtr Box::getContainingBlock(ViewCSSImp* view) const
@@ -270,6 +271,38 @@ ContainingBlockPtr Box::getContainingBlock(ViewCSSImp* view) const
     return box;
 }
 
+void Box::snapshotHitTargets(HitTestSnapshot& snapshot, float dx, float dy, const HitTestSnapshot::Rect& clip, StackingContext* context)
+{
+    if (context && stackingContext && stackingContext != context)
+        return;
+    float l = x + marginLeft - dx;
+    float t = y + marginTop - dy;
+    HitTestSnapshot::Rect rect(l, t, l + getBorderWidth(), t + getBorderHeight());
+    HitTestSnapshot::Rect childClip(isClipped() ? clip.intersect(rect) : clip);
+    if (!childClip.isEmpty()) {
+        float xx(dx);
+        float yy(dy);
+        if (!isAnonymous() && Element::hasInstance(node)) {
+            Element element = interface_cast<Element>(node);
+            xx += element.getScrollLeft();
+            yy += element.getScrollTop();
+        }
+        for (BoxPtr box = getFirstChild(); box; box = box->getNextSibling())
+            box->snapshotHitTargets(snapshot, xx, yy, childClip, context);
+    }
+    snapshot.add(this, clip.intersect(rect));
+}
+
+HitTestSnapshot::Entry::Entry(const Box* box, const Rect& rect) :
+    rect(rect),
+    node(box->getTargetNode()),
+    childWindow(box->getChildWindow()),
+    childX(box->getX() + box->getBlankLeft()),
+    childY(box->getY() + box->getBlankTop()),
+    box(box)
+{
+}
+
 Element Box::getContainingElement(Node node)
 {
     for (; node; node = node.getParentNode()) {
@@ -527,7 +560,7 @@ bool Block::hasAnonymousBox(const BoxPtr& prev) const
     return prev && prev->isAnonymous() && !std::dynamic_pointer_cast<TableWrapperBox>(prev);
 }
 
-BlockPtr Block::getAnonymousBox(const BoxPtr& prev)
+BlockPtr Block::getAnonymousBox(ViewCSSImp* view, const BoxPtr& prev)
 {
     BlockPtr anonymousBox;
     if (hasAnonymousBox(prev)) {
@@ -535,7 +568,7 @@ BlockPtr Block::getAnonymousBox(const BoxPtr& prev)
         if (anonymousBox)
             return anonymousBox;
     }
-    anonymousBox = std::make_shared<Block>();
+    anonymousBox = view->createBox<Block>();
     if (anonymousBox) {
         anonymousBox->flags &= ~NEED_EXPANSION;
         anonymousBox->spliceInline(self());
@@ -551,25 +584,26 @@ BlockPtr Block::getAnonymousBox(const BoxPtr& prev)
 void Block::resolveBackground(ViewCSSImp* view)
 {
     assert(style);
-    backgroundColor = style->backgroundColor.getARGB();
-    if (style->backgroundImage.isNone()) {
+    backgroundColor = style->backgroundValues->backgroundColor.getARGB();
+    if (style->backgroundValues->backgroundImage.isNone()) {
         backgroundImage = 0;
         return;
     }
     auto document = view->getDocument();
-    if (backgroundRequest && backgroundRequest->getURL() != URL(document->getDocumentURI(), style->backgroundImage.getValue()))
+    if (backgroundRequest && backgroundRequest->getURL() != URL(document->getDocumentURI(), style->backgroundValues->backgroundImage.getValue()))
         backgroundRequest.reset();   // TODO: check notifyBackground has been called
     if (!backgroundRequest) {
         backgroundRequest = std::make_shared<HttpRequest>(document->getDocumentURI());
         if (backgroundRequest) {
-            backgroundRequest->open(u"GET", style->backgroundImage.getValue());
+            backgroundRequest->open(u"GET", style->backgroundValues->backgroundImage.getValue());
+            backgroundRequest->setPriority(HttpRequest::IMAGE_PRIORITY);
             backgroundRequest->setHandler(std::bind(&Block::notifyBackground, self(), view->getDocument()));
             document->incrementLoadEventDelayCount(backgroundRequest->getURL());
             backgroundRequest->send();
         }
     }
     if (backgroundRequest)
-        backgroundImage = backgroundRequest->getBoxImage(style->backgroundRepeat.getValue());
+        backgroundImage = backgroundRequest->getBoxImage(style->backgroundValues->backgroundRepeat.getValue());
 }
 
 void Block::notifyBackground(Document document)
@@ -585,12 +619,10 @@ void Block::resolveBackgroundPosition(ViewCSSImp* view, const ContainingBlockPtr
     assert(style);
     if (!backgroundImage || backgroundImage->getState() != BoxImage::CompletelyAvailable)
         return;
-    if (getParentBox() || !style->backgroundAttachment.isFixed())
-        style->backgroundPosition.resolve(view, backgroundImage, style.get(), getPaddingWidth(), getPaddingHeight());
+    if (parentBox || !style->backgroundValues->backgroundAttachment.isFixed())
+        style->backgroundValues->backgroundPosition.resolve(view, backgroundImage, style.get(), getPaddingWidth(), getPaddingHeight(), backgroundLeft, backgroundTop);
     else
-        style->backgroundPosition.resolve(view, backgroundImage, style.get(), containingBlock->width, containingBlock->height);
-    backgroundLeft = style->backgroundPosition.getLeftPx();
-    backgroundTop = style->backgroundPosition.getTopPx();
+        style->backgroundValues->backgroundPosition.resolve(view, backgroundImage, style.get(), containingBlock->width, containingBlock->height, backgroundLeft, backgroundTop);
 }
 
 float Block::setWidth(float w, float maxWidth, float minWidth)
@@ -761,7 +793,7 @@ void Block::resolveHeight()
 
 void Block::layOutInlineBlock(ViewCSSImp* view, Node node, const BlockPtr& inlineBlock, FormattingContext* context)
 {
-    InlineBoxPtr inlineBox = std::make_shared<InlineBox>(nullptr, inlineBlock->style); // Treat this box as an anonymous box
+    InlineBoxPtr inlineBox = view->createBox<InlineBox>(nullptr, inlineBlock->style); // Treat this box as an anonymous box
     if (!inlineBox)
         return;  // TODO error
 
@@ -783,7 +815,7 @@ void Block::layOutInlineBlock(ViewCSSImp* view, Node node, const BlockPtr& inlin
         else
             inlineBox->baseline = inlineBlock->getBaseline();
     }
-    while (context->leftover < inlineBox->getTotalWidth() && (style && style->whiteSpace.isBreakingLines())) {  // TODO: Check wrapControl as well.
+    while (context->leftover < inlineBox->getTotalWidth() && (style && style->textValues->whiteSpace.isBreakingLines())) {  // TODO: Check wrapControl as well.
         if (context->lineBox->hasChildBoxes() || context->hasNewFloats()) {
             context->nextLine(view, self(), false);
             if (!context->addLineBox(view, self()))
@@ -961,7 +993,7 @@ float Block::shrinkTo()
         --autoCount;
         min = style->width.getPx();
     } else {
-        for (BoxPtr child = getFirstChild(); child; child = child->getNextSibling())
+        for (Box* child = firstChild.get(); child; child = child->nextSibling.get())
             min = std::max(min, child->shrinkTo());
     }
     min += borderLeft + paddingLeft + paddingRight + borderRight;
@@ -987,7 +1019,7 @@ void Block::fit(float w, FormattingContext* context)
     resolveWidth(w, context);
     if (!isAnonymous() && !style->width.isAuto())
         return;
-    for (BoxPtr child = getFirstChild(); child; child = child->getNextSibling())
+    for (Box* child = firstChild.get(); child; child = child->nextSibling.get())
         child->fit(width, context);
 }
 
@@ -1441,7 +1473,7 @@ bool Block::layOut(ViewCSSImp* view, FormattingContext* context)
          flags |= NEED_REFLOW;
 
     visibility = style->visibility.getValue();
-    textAlign = style->textAlign.getValue();
+    textAlign = style->textValues->textAlign.getValue();
 
     float before = NAN;
     if (context) {
@@ -1541,7 +1573,7 @@ bool Block::layOut(ViewCSSImp* view, FormattingContext* context)
     if ((style->height.isAuto() && !intrinsic) || isAnonymous() || cell) {
         float totalClearance = 0.0f;
         height = 0.0f;
-        for (BoxPtr child = getFirstChild(); child; child = child->getNextSibling()) {
+        for (Box* child = firstChild.get(); child; child = child->nextSibling.get()) {
             height += child->getTotalHeight();
             totalClearance += child->getClearance();
         }
@@ -1559,7 +1591,7 @@ bool Block::layOut(ViewCSSImp* view, FormattingContext* context)
         context->updateRemainingHeight(height);
 
     // Now that 'height' is fixed, calculate 'left', 'right', 'top', and 'bottom'.
-    for (BoxPtr child = getFirstChild(); child; child = child->getNextSibling())
+    for (Box* child = firstChild.get(); child; child = child->nextSibling.get())
         child->fit(width, parentContext);
 
     resolveBackgroundPosition(view, containingBlock);
@@ -1807,7 +1839,7 @@ void Block::layOutAbsolute(ViewCSSImp* view)
     ContainingBlockPtr containingBlock{absoluteBlock};
     flags |= style->resolve(view, containingBlock);
     visibility = style->visibility.getValue();
-    textAlign = style->textAlign.getValue();
+    textAlign = style->textValues->textAlign.getValue();
 
     resolveBackground(view);
     updatePadding();
@@ -1896,7 +1928,7 @@ void Block::layOutAbsolute(ViewCSSImp* view)
         float before = height;
         float totalClearance = 0.0f;
         height = 0;
-        for (BoxPtr child = getFirstChild(); child; child = child->getNextSibling()) {
+        for (Box* child = firstChild.get(); child; child = child->nextSibling.get()) {
             height += child->getTotalHeight();
             totalClearance += child->getClearance();
         }
@@ -1911,7 +1943,7 @@ void Block::layOutAbsolute(ViewCSSImp* view)
     maskV = applyAbsoluteMinMaxHeight(containingBlock, top, bottom, maskV);
 
     // Now that 'height' is fixed, calculate 'left', 'right', 'top', and 'bottom'.
-    for (BoxPtr child = getFirstChild(); child; child = child->getNextSibling())
+    for (Box* child = firstChild.get(); child; child = child->nextSibling.get())
         child->fit(width, 0);
 
     resolveBackgroundPosition(view, containingBlock);
@@ -1930,7 +1962,7 @@ void Block::layOutAbsoluteEnd(float left, float top)
         BoxPtr list = getParentBox()->getParentBox();
         if (list->isAnonymous())
             list = list->getParentBox();
-        if (list->getParentBox() && list->getParentBox()->style->counterReset.hasCounter()) {
+        if (list->getParentBox() && list->getParentBox()->style->counterValues->counterReset.hasCounter()) {
             // cf. http://www.w3.org/TR/css3-lists/#list-style-position-property
             //   The horizontal static position of the marker is such that the
             //   marker's "end" edge is placed against the "start" edge of the
@@ -1970,8 +2002,9 @@ void Block::resolveXY(ViewCSSImp* view, float left, float top, const BlockPtr& c
     }
 
     if (!childWindow) {
-        for (auto child = getFirstChild(); child; child = child->getNextSibling()) {
-            child->resolveXY(view, left, top, isClipped() ? self() : clip);
+        BlockPtr childClip(isClipped() ? self() : clip);
+        for (Box* child = firstChild.get(); child; child = child->nextSibling.get()) {
+            child->resolveXY(view, left, top, childClip);
             top += child->getTotalHeight() + child->getClearance();
         }
     }
@@ -1995,7 +2028,7 @@ void Block::dump(std::string indent)
     std::cout << " (" << x + relativeX << ", " << y + relativeY << ") " <<
         "w:" << width << " h:" << height << ' ' <<
         "(" << relativeX << ", " << relativeY <<") ";
-    if ((width < scrollWidth || height < scrollHeight) && (getParentBox() || scrollWidth != 816 || scrollHeight != 1056)) // TODO: Use some constants
+    if ((width < scrollWidth || height < scrollHeight) && (parentBox || scrollWidth != 816 || scrollHeight != 1056)) // TODO: Use some constants
         std::cout << "sw:" << scrollWidth << " sh:" << scrollHeight << ' ';
     if (hasClearance())
         std::cout << "c:" << clearance << ' ';
@@ -2006,7 +2039,7 @@ void Block::dump(std::string indent)
         "b:" << borderTop << ':' <<  borderRight << ':' << borderBottom<< ':' << borderLeft << ' ' <<
         std::hex << CSSSerializeRGB(backgroundColor) << std::dec << '\n';
     indent += "  ";
-    for (BoxPtr child = getFirstChild(); child; child = child->getNextSibling())
+    for (Box* child = firstChild.get(); child; child = child->nextSibling.get())
         child->dump(indent);
 
     dumpPrevChar = u'\u00A0';   // NBSP
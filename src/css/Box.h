@@ -32,6 +32,7 @@
 #include "http/HTTPRequest.h"
 #include "CSSStyleDeclarationImp.h"
 #include "FormattingContext.h"
+#include "HitTestSnapshot.h"
 #include "StackingContext.h"
 
 struct FontGlyph;
@@ -123,7 +124,9 @@ public:
 
 protected:
     Node node;
-    std::weak_ptr<Box> parentBox;
+    // The parent is kept as a plain pointer; a box always unlinks its
+    // children in removeChild() and ~Box(), so it cannot dangle.
+    Box* parentBox;
     BoxPtr firstChild;
     BoxPtr lastChild;
     BoxPtr previousSibling;
@@ -175,7 +178,7 @@ protected:
 
     WindowProxyPtr childWindow;
 
-    void setParentBox(const BoxPtr& box) {
+    void setParentBox(Box* box) {
         parentBox = box;
         containingBox.reset();
     }
@@ -206,11 +209,11 @@ public:
     }
 
     Node getTargetNode() const {
-        BoxPtr box = self();
+        const Box* box = this;
         do {
             if (box->node)
                 return box->node;
-        } while ((box = box->getParentBox()));
+        } while ((box = box->parentBox));
         return nullptr;
     }
 
@@ -227,7 +230,10 @@ public:
     void setContainingBox(const BoxPtr& box);
 
     BoxPtr getParentBox() const {
-        return parentBox.lock();
+        return parentBox ? parentBox->self() : nullptr;
+    }
+    bool hasParentBox() const {
+        return parentBox;
     }
     bool hasChildBoxes() const {
         return childCount;
@@ -384,8 +390,8 @@ public:
     const Box* towardViewPort(float& x, float& y) const {
         x += offsetH + getBlankLeft();
         y += offsetV + getBlankTop();
-        if (BoxPtr box = getParentBox())
-            return box->towardViewPort(this, x, y);
+        if (parentBox)
+            return parentBox->towardViewPort(this, x, y);
         return 0;
     }
     virtual const Box* towardViewPort(const Box* child, float& x, float& y) const {
@@ -426,7 +432,7 @@ public:
 
     bool isInFlow() const {
         // cf. 9.3 Positioning schemes
-        return !isFloat() && !isAbsolutelyPositioned() && getParentBox();
+        return !isFloat() && !isAbsolutelyPositioned() && parentBox;
     }
 
     virtual bool isFloat() const {
@@ -510,6 +516,10 @@ public:
         }
         return isInside(x, y) ? self() : nullptr;
     }
+    // Appends the areas that boxFromPoint() would find in this box and its
+    // descendants to snapshot in the same order. (dx, dy) is subtracted from
+    // the box coordinates, and every area is clipped by clip.
+    void snapshotHitTargets(HitTestSnapshot& snapshot, float dx, float dy, const HitTestSnapshot::Rect& clip, StackingContext* context = 0);
 
     void updateScrollSize();
     void resetScrollSize();
@@ -709,7 +719,7 @@ public:
     }
     bool canScroll() const {
         // Note the root box is scrolled by the viewport.
-        return getParentBox() && !isAnonymous() && style && style->overflow.canScroll();
+        return parentBox && !isAnonymous() && style && style->overflow.canScroll();
     }
 
     bool isCollapsedThrough() const;
@@ -727,7 +737,7 @@ public:
     // Gets the anonymous child box. Creates one if there's none even
     // if there's no children; if so, the existing texts are moved to the
     // new anonymous box.
-    BlockPtr getAnonymousBox(const BoxPtr& prev);
+    BlockPtr getAnonymousBox(ViewCSSImp* view, const BoxPtr& prev);
 
     bool isCollapsableInside() const;
     bool isCollapsableOutside() const;
@@ -141,6 +141,8 @@ unsigned BoxImage::render(ViewCSSImp* view, float x, float y, float width, float
 
     if (width < 0.0f || height < 0.0f)
         return start;
+    if (1 < frameCount)
+        view->recordAnimatedRect(x, y, width, height);
 
     GLuint texname = getTexname(pixels + frame * (naturalWidth * naturalHeight * 4),
                                 naturalWidth, naturalHeight, repeat, format);
@@ -348,9 +350,10 @@ void Box::renderBorder(ViewCSSImp* view, float left, float top,
         glPushMatrix();
         if (getParentBox()) {
             glTranslatef(lr, tb, 0.0f);
-            if (!style->backgroundAttachment.isFixed())
+            if (!style->backgroundValues->backgroundAttachment.isFixed())
                 backgroundStart = backgroundImage->render(view, -borderLeft, -borderTop, rr - ll, bb - tt, backgroundLeft, backgroundTop, backgroundStart);
             else {
+                view->setScrollDependent();
                 float fixedX = left + lr - view->getWindow()->getScrollX();
                 float fixedY = top + tb - view->getWindow()->getScrollY();
                 for (Element element = interface_cast<Element>(getNode()); element; element = element.getParentElement()) {
@@ -360,17 +363,17 @@ void Box::renderBorder(ViewCSSImp* view, float left, float top,
                 backgroundStart = backgroundImage->render(view, -borderLeft, -borderTop, rr - ll, bb - tt, backgroundLeft - fixedX, backgroundTop - fixedY, backgroundStart);
             }
         } else {
-            ContainingBlockPtr containingBlock = getContainingBlock(view);
             glTranslatef(lr, tb, 0.0f);
-            float l = -lr + view->getWindow()->getScrollX();
-            float t = -tb + view->getWindow()->getScrollY();
-            float r = containingBlock->width + view->getWindow()->getScrollX();
-            float b = containingBlock->height + view->getWindow()->getScrollY();
-            if (!style->backgroundAttachment.isFixed())
+            float l = -lr + view->getLayerLeft();
+            float t = -tb + view->getLayerTop();
+            float r = view->getLayerWidth() + view->getLayerLeft();
+            float b = view->getLayerHeight() + view->getLayerTop();
+            if (!style->backgroundValues->backgroundAttachment.isFixed())
                 backgroundStart = backgroundImage->render(view, l, t, r, b, backgroundLeft, backgroundTop, backgroundStart);
             else {
-                float fixedX = left - l;
-                float fixedY = top - t;
+                view->setScrollDependent();
+                float fixedX = left + lr - view->getWindow()->getScrollX();
+                float fixedY = top + tb - view->getWindow()->getScrollY();
                 backgroundStart = backgroundImage->render(view, l, t, r, b, backgroundLeft - fixedX, backgroundTop - fixedY, backgroundStart);
             }
         }
@@ -379,23 +382,23 @@ void Box::renderBorder(ViewCSSImp* view, float left, float top,
 
     if (borderTop)
         renderBorderEdge(view, TOP,
-                         style->borderTopStyle.getValue(),
-                         style->borderTopColor.getARGB(),
+                         style->borderValues->borderTopStyle.getValue(),
+                         style->borderValues->borderTopColor.getARGB(style->color.getARGB()),
                          ll, tt, rr, tt, rl, tb, lr, tb);
     if (rightEdge && rightEdge->borderRight)
         renderBorderEdge(view, RIGHT,
-                         rightEdge->style->borderRightStyle.getValue(),
-                         rightEdge->style->borderRightColor.getARGB(),
+                         rightEdge->style->borderValues->borderRightStyle.getValue(),
+                         rightEdge->style->borderValues->borderRightColor.getARGB(rightEdge->style->color.getARGB()),
                          rl, bt, rl, tb, rr, tt, rr, bb);
     if (borderBottom)
         renderBorderEdge(view, BOTTOM,
-                         style->borderBottomStyle.getValue(),
-                         style->borderBottomColor.getARGB(),
+                         style->borderValues->borderBottomStyle.getValue(),
+                         style->borderValues->borderBottomColor.getARGB(style->color.getARGB()),
                          lr, bt, rl, bt, rr, bb, ll, bb);
     if (leftEdge && leftEdge->borderLeft)
         renderBorderEdge(view, LEFT,
-                         leftEdge->style->borderLeftStyle.getValue(),
-                         leftEdge->style->borderLeftColor.getARGB(),
+                         leftEdge->style->borderValues->borderLeftStyle.getValue(),
+                         leftEdge->style->borderValues->borderLeftColor.getARGB(leftEdge->style->color.getARGB()),
                          ll, bb, ll, tt, lr, tb, lr, bt);
 
     glEnable(GL_TEXTURE_2D);
@@ -451,7 +454,7 @@ void Box::renderOutline(ViewCSSImp* view, float left, float top)
     top += marginTop + borderTop;
     float right = left + getPaddingWidth();
     float bottom = top + getPaddingHeight();
-    renderOutline(view, left, top, right, bottom, outlineWidth, style->outlineStyle.getValue(), style->outlineColor.getARGB());
+    renderOutline(view, left, top, right, bottom, outlineWidth, style->outlineValues->outlineStyle.getValue(), style->outlineValues->outlineColor.getARGB());
 }
 
 void Box::renderVerticalScrollBar(float w, float h, float pos, float total)
@@ -544,16 +547,22 @@ unsigned Block::renderBegin(ViewCSSImp* view, bool noBorder)
         float scrollX = 0.0f;
         float scrollY = 0.0f;
         if (isFixed() && style->getParentStyle()) {
+            view->setScrollDependent();
             glPushMatrix();
             scrollX = view->getWindow()->getScrollX();
             scrollY = view->getWindow()->getScrollY();
             glTranslatef(scrollX, scrollY, 0.0f);
         }
-        if (!noBorder && isVisible())
+        float outline = getOutlineWidth();
+        view->beginInk(x + marginLeft - outline, y + marginTop - outline, getBorderWidth() + 2.0f * outline, getBorderHeight() + 2.0f * outline);
+        if (!noBorder && isVisible()) {
             renderBorder(view, x, y);
+            view->countPaintedBox();
+        }
         if (style->getParentStyle()) {
             overflow = style->overflow.getValue();
             if (overflow != CSSOverflowValueImp::Visible) {
+                view->recordBoxRect(this, x + marginLeft, y + marginTop, getBorderWidth(), getBorderHeight());
                 float left = x + marginLeft + borderLeft + scrollX;
                 float top = y + marginTop + borderTop + scrollY;
                 float w = getPaddingWidth();
@@ -567,7 +576,8 @@ unsigned Block::renderBegin(ViewCSSImp* view, bool noBorder)
         }
         if (!noBorder && isVisible() && isTableBox())
             std::dynamic_pointer_cast<TableWrapperBox>(getParentBox())->renderTableBorders(view);
-    }
+    } else
+        view->beginInk(x + marginLeft, y + marginTop, getBorderWidth(), getBorderHeight());
     return overflow;
 }
 
@@ -603,6 +613,7 @@ void Block::renderEnd(ViewCSSImp* view, unsigned overflow, bool scrollBar)
         if (isFixed() && style->getParentStyle())
             glPopMatrix();
     }
+    view->endInk(this);
 }
 
 void Block::renderNonInline(ViewCSSImp* view, StackingContext* stackingContext)
@@ -614,18 +625,18 @@ void Block::renderNonInline(ViewCSSImp* view, StackingContext* stackingContext)
     if (isClipped())
         last = stackingContext->getLastFloat();
 
-    for (auto child = getFirstChild(); child; child = child->getNextSibling()) {
+    for (Box* child = firstChild.get(); child; child = child->nextSibling.get()) {
         if (child->style && child->style->getStackingContext() != stackingContext)
             continue;
-        if (auto block = std::dynamic_pointer_cast<Block>(child)) {
+        if (auto block = dynamic_cast<Block*>(child)) {
             unsigned overflow = block->renderBegin(view);
             block->renderNonInline(view, stackingContext);
             block->renderEnd(view, overflow, false);
-        } else if (auto lineBox = std::dynamic_pointer_cast<LineBox>(child)) {
-            for (auto box = lineBox->getFirstChild(); box; box = box->getNextSibling()) {
+        } else if (auto lineBox = dynamic_cast<LineBox*>(child)) {
+            for (Box* box = lineBox->firstChild.get(); box; box = box->nextSibling.get()) {
                 if (!box->isAnonymous() && box->style->isFloat() && !box->isPositioned())
-                    stackingContext->addFloat(box);
-                else if (auto cellBox = std::dynamic_pointer_cast<CellBox>(box))
+                    stackingContext->addFloat(box->self());
+                else if (auto cellBox = dynamic_cast<CellBox*>(box))
                     cellBox->renderNonInline(view, stackingContext);
             }
         }
@@ -638,6 +649,7 @@ void Block::renderNonInline(ViewCSSImp* view, StackingContext* stackingContext)
 void Block::renderInline(ViewCSSImp* view, StackingContext* stackingContext)
 {
     if (childWindow) {
+        view->recordBoxRect(this, x + marginLeft, y + marginTop, getBorderWidth(), getBorderHeight());
         glPushMatrix();
         glTranslatef(x + getBlankLeft(), y + getBlankTop(), 0.0f);
         childWindow->render(view);
@@ -650,6 +662,7 @@ void Block::renderInline(ViewCSSImp* view, StackingContext* stackingContext)
             if (!intrinsic && image->getState() == BoxImage::CompletelyAvailable)
                 setFlags(NEED_REFLOW);
             if (isVisible()) {
+                view->recordBoxRect(this, x + marginLeft, y + marginTop, getBorderWidth(), getBorderHeight());
                 glPushMatrix();
                 glTranslatef(x + getBlankLeft(), y + getBlankTop(), 0.0f);
                 replaced->setImageStart(image->render(view, 0, 0, width, height, 0, 0, replaced->getImageStart()));
@@ -661,10 +674,10 @@ void Block::renderInline(ViewCSSImp* view, StackingContext* stackingContext)
     }
 
     bool hasOutline = false;
-    for (auto child = getFirstChild(); child; child = child->getNextSibling()) {
+    for (Box* child = firstChild.get(); child; child = child->nextSibling.get()) {
         if (child->style && child->style->getStackingContext() != stackingContext)
             continue;
-        if (auto block = std::dynamic_pointer_cast<Block>(child)) {
+        if (auto block = dynamic_cast<Block*>(child)) {
             unsigned overflow = block->renderBegin(view, true);
             block->renderInline(view, stackingContext);
             block->renderEnd(view, overflow);
@@ -674,10 +687,10 @@ void Block::renderInline(ViewCSSImp* view, StackingContext* stackingContext)
     }
 
     if (hasOutline) {
-        for (auto child = getFirstChild(); child; child = child->getNextSibling()) {
+        for (Box* child = firstChild.get(); child; child = child->nextSibling.get()) {
             if (child->style && child->style->getStackingContext() != stackingContext)
                 continue;
-            if (auto block = std::dynamic_pointer_cast<Block>(child)) {
+            if (auto block = dynamic_cast<Block*>(child)) {
                 if (!block->isAnonymous() && 0.0f < block->getOutlineWidth()) {
                     unsigned overflow = block->renderBegin(view, true);
                     block->renderOutline(view, block->x, block->y + block->getTopBorderEdge());
@@ -712,7 +725,7 @@ void Block::render(ViewCSSImp* view, StackingContext* stackingContext)
 
 void LineBox::render(ViewCSSImp* view, StackingContext* stackingContext)
 {
-    for (auto child = getFirstChild(); child; child = child->getNextSibling()) {
+    for (Box* child = firstChild.get(); child; child = child->nextSibling.get()) {
         if (!child->isAnonymous() && (child->style->isFloat() || child->style->getStackingContext() != stackingContext))
             continue;
         child->render(view, stackingContext);
@@ -806,12 +819,12 @@ void InlineBox::renderEmptyBox(ViewCSSImp* view, const CSSStyleDeclarationPtr& p
     float top = lineBox->getY();
     float leading = 0.0f;
     if (FontTexture* font = parentStyle->getFontTexture()) {
-        float point = view->getPointFromPx(parentStyle->fontSize.getPx());
+        float point = view->getPointFromPx(parentStyle->fontValues->fontSize.getPx());
         paddingHeight += font->getLineHeight(point);
-        leading = std::max(lineBox->getStyle()->lineHeight.getPx(), parentStyle->lineHeight.getPx()) - font->getLineHeight(point);
+        leading = std::max(lineBox->getStyle()->textValues->lineHeight.getPx(), parentStyle->textValues->lineHeight.getPx()) - font->getLineHeight(point);
         top += parentStyle->verticalAlign.getOffset(view, parentStyle.get(), lineBox, font, point, leading);
     }
-    top -= parentStyle->marginTop.getPx() + parentStyle->paddingTop.getPx() + parentStyle->borderTopWidth.getPx();
+    top -= parentStyle->marginTop.getPx() + parentStyle->paddingTop.getPx() + parentStyle->borderValues->borderTopWidth.getPx();
 
     BoxPtr box;
     InlineBoxPtr head;
@@ -828,20 +841,20 @@ void InlineBox::renderEmptyBox(ViewCSSImp* view, const CSSStyleDeclarationPtr& p
     float rl;
     float rr;
     float tt = parentStyle->marginTop.getPx();
-    float tb = tt + parentStyle->borderTopWidth.getPx();
+    float tb = tt + parentStyle->borderValues->borderTopWidth.getPx();
     float bt = tb + paddingHeight;
-    float bb = bt + parentStyle->borderBottomWidth.getPx();
+    float bb = bt + parentStyle->borderValues->borderBottomWidth.getPx();
 
     if (box) {
         rr = (lastBox->x + lastBox->getTotalWidth() - lastBox->marginRight) - x;
         rl = rr - lastBox->borderRight;
         renderBorder(view, x, top,
-                     parentStyle, parentStyle->backgroundColor.getARGB(), 0,
+                     parentStyle, parentStyle->backgroundValues->backgroundColor.getARGB(), 0,
                      ll, lr, rl, rr, tt, tb, bt, bb, self(), lastBox);
     } else {
         rr = rl = (tail->getX() + tail->getTotalWidth()) - x;
         renderBorder(view, x, top,
-                     parentStyle, parentStyle->backgroundColor.getARGB(), 0,
+                     parentStyle, parentStyle->backgroundValues->backgroundColor.getARGB(), 0,
                      ll, lr, rl, rr, tt, tb, bt, bb, self(), nullptr);
         float baseline = lineBox->getY() + lineBox->getBaseline();
         for (;;) {
@@ -879,7 +892,7 @@ void InlineBox::renderEmptyBox(ViewCSSImp* view, const CSSStyleDeclarationPtr& p
                 rr = (lastBox->x + lastBox->getTotalWidth() - lastBox->marginRight) - head->x;
                 rl = rr - lastBox->borderRight;
                 renderBorder(view, head->x, lastBox->y - lastBox->getBlankTop(),
-                             parentStyle, parentStyle->backgroundColor.getARGB(), 0,
+                             parentStyle, parentStyle->backgroundValues->backgroundColor.getARGB(), 0,
                              ll, lr, rl, rr, tt, tb, bt, bb, 0, lastBox);
                 break;
             }
@@ -888,7 +901,7 @@ void InlineBox::renderEmptyBox(ViewCSSImp* view, const CSSStyleDeclarationPtr& p
                 rr = rl = (tail->getX() + tail->getTotalWidth()) - head->x;
                 // TODO: Calculate 'top' accurately.
                 renderBorder(view, head->x, top + (lineBox->getY() + lineBox->getBaseline() - baseline),
-                             parentStyle, parentStyle->backgroundColor.getARGB(), 0,
+                             parentStyle, parentStyle->backgroundValues->backgroundColor.getARGB(), 0,
                              ll, lr, rl, rr, tt, tb, bt, bb, 0, 0);
             }
         }
@@ -900,6 +913,20 @@ void InlineBox::render(ViewCSSImp* view, StackingContext* stackingContext)
     assert(stackingContext);
     updateScrollSize();
 
+    // The margin covers glyph overhangs and outlines.
+    float margin = point + getOutlineWidth();
+    float inkLeft = x - margin;
+    float inkTop = y - getBlankTop() - margin;
+    float inkWidth = getTotalWidth() + 2.0f * margin;
+    float inkHeight = getBlankTop() + getTotalHeight() + 2.0f * margin;
+    view->addInk(inkLeft, inkTop, inkWidth, inkHeight);
+    // Skip the text runs outside the damaged area.
+    if (!childWindow && !getFirstChild() && !style->hasMultipleBoxes()) {
+        if (!view->isDamaged(inkLeft, inkTop, inkWidth, inkHeight))
+            return;
+    }
+    view->countPaintedBox();
+
     glPushMatrix();
 
     if (!isAnonymous()) {
@@ -926,6 +953,7 @@ void InlineBox::render(ViewCSSImp* view, StackingContext* stackingContext)
             renderMultipleBackground(view);
     }
     if (childWindow) {
+        view->recordBoxRect(this, x + marginLeft, y + marginTop, getBorderWidth(), getBorderHeight());
         glPushMatrix();
         glTranslatef(x + getBlankLeft(), y + getBlankTop(), 0.0f);
         childWindow->render(view);
@@ -991,10 +1019,10 @@ void InlineBox::renderText(ViewCSSImp* view)
     const CSSStyleDeclarationPtr& activeStyle = getStyle();
     FontTexture* font = activeStyle->getFontTexture();
     float letterSpacing = 0.0f;
-    if (!activeStyle->letterSpacing.isNormal())
-        letterSpacing = activeStyle->letterSpacing.getPx() * font->getPoint() / point;
-    float wordSpacing = activeStyle->wordSpacing.getPx() * font->getPoint() / point;
-    unsigned variant = activeStyle->fontVariant.getValue();
+    if (!activeStyle->textValues->letterSpacing.isNormal())
+        letterSpacing = activeStyle->textValues->letterSpacing.getPx() * font->getPoint() / point;
+    float wordSpacing = activeStyle->textValues->wordSpacing.getPx() * font->getPoint() / point;
+    unsigned variant = activeStyle->fontValues->fontVariant.getValue();
     font->beginRender();
 
     std::u16string data;
@@ -1079,12 +1107,12 @@ void InlineBox::renderOutline(ViewCSSImp* view)
     float top = y - paddingTop;
     if (box)
         Box::renderOutline(view, left, top, left + getPaddingWidth(), top + getPaddingHeight(),
-                           outlineWidth, style->outlineStyle.getValue(), style->outlineColor.getARGB());
+                           outlineWidth, style->outlineValues->outlineStyle.getValue(), style->outlineValues->outlineColor.getARGB());
     else {
         float right = tail->getX() + tail->getBlankLeft() + tail->width + tail->paddingRight;
         float bottom = top + getPaddingHeight() - outlineWidth;
         Box::renderOutline(view, left, top, right, bottom,
-                           outlineWidth, style->outlineStyle.getValue(), style->outlineColor.getARGB());
+                           outlineWidth, style->outlineValues->outlineStyle.getValue(), style->outlineValues->outlineColor.getARGB());
         auto lineBox = std::dynamic_pointer_cast<LineBox>(getParentBox());
         assert(lineBox);
         float baseline = lineBox->getY() + lineBox->getBaseline();
@@ -1123,7 +1151,7 @@ void InlineBox::renderOutline(ViewCSSImp* view)
                 right = lastBox->x + lastBox->getBlankLeft() + lastBox->width + lastBox->paddingRight;
                 bottom = top + lastBox->getPaddingHeight() - outlineWidth;
                 Box::renderOutline(view, left, top, right, bottom,
-                                   outlineWidth, style->outlineStyle.getValue(), style->outlineColor.getARGB());
+                                   outlineWidth, style->outlineValues->outlineStyle.getValue(), style->outlineValues->outlineColor.getARGB());
                 break;
             }
             if (head) {
@@ -1133,7 +1161,7 @@ void InlineBox::renderOutline(ViewCSSImp* view)
                 right = tail->x + tail->getBlankLeft() + tail->width + tail->paddingRight;
                 bottom = top + getPaddingHeight() - outlineWidth;
                 Box::renderOutline(view, left, top, right, bottom,
-                                   outlineWidth, style->outlineStyle.getValue(), style->outlineColor.getARGB());
+                                   outlineWidth, style->outlineValues->outlineStyle.getValue(), style->outlineValues->outlineColor.getARGB());
             }
         }
     }
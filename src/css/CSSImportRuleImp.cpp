@@ -18,8 +18,6 @@
 
 #include <boost/bind.hpp>
 #include <boost/version.hpp>
-#include <boost/iostreams/stream.hpp>
-#include <boost/iostreams/device/file_descriptor.hpp>
 
 #include "DocumentImp.h"
 #include "WindowProxy.h"
@@ -96,6 +94,7 @@ css::CSSStyleSheet CSSImportRuleImp::getStyleSheet()
         request = std::make_shared<HttpRequest>(doc->getDocumentURI());
         if (request) {
             request->open(u"GET", href);
+            request->setPriority(HttpRequest::BLOCKING_PRIORITY);
             request->setHandler(boost::bind(&CSSImportRuleImp::notify, this));
             doc->incrementLoadEventDelayCount(request->getURL());
             request->send();
@@ -111,9 +110,9 @@ void CSSImportRuleImp::notify()
         return;
 
     if (request->getStatus() == 200) {
-        boost::iostreams::stream<boost::iostreams::file_descriptor_source> stream(request->getContentDescriptor(), boost::iostreams::close_handle);
+        std::unique_ptr<std::istream> stream(request->openContent());
         CSSParser parser(request->getURL());
-        CSSInputStream cssStream(stream, request->getResponseMessage().getContentCharset(), utfconv(doc->getCharacterSet()));
+        CSSInputStream cssStream(*stream, request->getResponseMessage().getContentCharset(), utfconv(doc->getCharacterSet()));
         styleSheet = parser.parse(doc, cssStream);
         if (auto imp = std::dynamic_pointer_cast<CSSStyleSheetImp>(styleSheet.self())) {
             imp->setParentStyleSheet(getParentStyleSheet());
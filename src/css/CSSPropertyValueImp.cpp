@@ -370,13 +370,13 @@ void CSSNumericValue::compute(ViewCSSImp* view, CSSStyleDeclarationImp* self)
     }
     switch (unit) {
     case css::CSSPrimitiveValue::CSS_EMS:
-        resolved = view->getPx(*this, self->fontSize.getPx());
+        resolved = view->getPx(*this, self->fontValues->fontSize.getPx());
         break;
     case css::CSSPrimitiveValue::CSS_EXS:
         if (FontTexture* font = self->getFontTexture())
-            resolved = view->getPx(*this, font->getXHeight(view->getPointFromPx(self->fontSize.getPx())));
+            resolved = view->getPx(*this, font->getXHeight(view->getPointFromPx(self->fontValues->fontSize.getPx())));
         else
-            resolved = view->getPx(*this, self->fontSize.getPx() * 0.5f);
+            resolved = view->getPx(*this, self->fontValues->fontSize.getPx() * 0.5f);
         break;
     default:
         resolved = view->getPx(*this);
@@ -396,14 +396,14 @@ void CSSNumericValue::resolve(ViewCSSImp* view, CSSStyleDeclarationImp* self, fl
         break;
     case css::CSSPrimitiveValue::CSS_EMS:
         if (isnan(resolved))
-            resolved = view->getPx(*this, self->fontSize.getPx());
+            resolved = view->getPx(*this, self->fontValues->fontSize.getPx());
         break;
     case css::CSSPrimitiveValue::CSS_EXS:
         if (isnan(resolved)) {
             if (FontTexture* font = self->getFontTexture())
-                resolved = view->getPx(*this, font->getXHeight(view->getPointFromPx(self->fontSize.getPx())));
+                resolved = view->getPx(*this, font->getXHeight(view->getPointFromPx(self->fontValues->fontSize.getPx())));
             else
-                resolved = view->getPx(*this, self->fontSize.getPx() * 0.5f);
+                resolved = view->getPx(*this, self->fontValues->fontSize.getPx() * 0.5f);
         }
         break;
     default:
@@ -536,7 +536,7 @@ std::u16string CSSAutoNumberingValueImp::getCssText(CSSStyleDeclarationImp* self
     return cssText;
 }
 
-void CSSAutoNumberingValueImp::incrementCounter(ViewCSSImp* view, CounterContext* context)
+void CSSAutoNumberingValueImp::incrementCounter(ViewCSSImp* view, CounterContext* context) const
 {
     for (auto i = contents.begin(); i != contents.end(); ++i) {
         if (CounterImpPtr counter = view->getCounter((*i)->name)) {
@@ -549,7 +549,7 @@ void CSSAutoNumberingValueImp::incrementCounter(ViewCSSImp* view, CounterContext
     }
 }
 
-void CSSAutoNumberingValueImp::resetCounter(ViewCSSImp* view, CounterContext* context)
+void CSSAutoNumberingValueImp::resetCounter(ViewCSSImp* view, CounterContext* context) const
 {
     for (auto i = contents.begin(); i != contents.end(); ++i) {
         if (CounterImpPtr counter = view->getCounter((*i)->name)) {
@@ -563,7 +563,7 @@ void CSSAutoNumberingValueImp::resetCounter(ViewCSSImp* view, CounterContext* co
     }
 }
 
-void CSSBackgroundImageValueImp::compute(ViewCSSImp* view)
+void CSSBackgroundImageValueImp::compute(ViewCSSImp* view) const
 {
     if (isNone())
         return;
@@ -637,15 +637,21 @@ void CSSBackgroundPositionValueImp::compute(ViewCSSImp* view, CSSStyleDeclaratio
     vertical.compute(view, self);
 }
 
-void CSSBackgroundPositionValueImp::resolve(ViewCSSImp* view, BoxImage* image, CSSStyleDeclarationImp* self, float width, float height)
+void CSSBackgroundPositionValueImp::resolve(ViewCSSImp* view, BoxImage* image, CSSStyleDeclarationImp* self, float width, float height, float& left, float& top) const
 {
     assert(image);
-    horizontal.resolve(view, self, width - image->getNaturalWidth());  // TODO: negative width case
-    vertical.resolve(view, self, height - image->getNaturalHeight());  // TODO: negative height case
+    // Resolve copies so that the value can be shared among the boxes of different sizes.
+    CSSNumericValue h(horizontal);
+    CSSNumericValue v(vertical);
+    h.resolve(view, self, width - image->getNaturalWidth());  // TODO: negative width case
+    v.resolve(view, self, height - image->getNaturalHeight());  // TODO: negative height case
+    left = h.getPx();
+    top = v.getPx();
 }
 
 bool CSSBackgroundShorthandImp::setValue(CSSStyleDeclarationImp* self, CSSValueParser* parser)
 {
+    CSSBackgroundValues& backgroundValues = self->backgroundValues.mutate();
     bool color = false;
     bool attachment = false;
     bool repeat = false;
@@ -656,68 +662,62 @@ bool CSSBackgroundShorthandImp::setValue(CSSStyleDeclarationImp* self, CSSValueP
         CSSParserTerm* term = *i;
         if (term->unit == CSSPrimitiveValue::CSS_RGBCOLOR) {
             color = true;
-            self->backgroundColor.setValue(term);
+            backgroundValues.backgroundColor.setValue(term);
         } else if (term->propertyID == CSSStyleDeclarationImp::BackgroundAttachment) {
             attachment = true;
-            self->backgroundAttachment.setValue(term);
+            backgroundValues.backgroundAttachment.setValue(term);
         } else if (term->propertyID == CSSStyleDeclarationImp::BackgroundRepeat) {
             repeat = true;
-            self->backgroundRepeat.setValue(term);
+            backgroundValues.backgroundRepeat.setValue(term);
         } else if (term->propertyID == CSSStyleDeclarationImp::BackgroundImage) {
             image = true;
-            self->backgroundImage.setValue(term);
+            backgroundValues.backgroundImage.setValue(term);
         } else if (term->propertyID == CSSStyleDeclarationImp::BackgroundPosition) {
             position = true;
-            i = self->backgroundPosition.setValue(stack, i);
+            i = backgroundValues.backgroundPosition.setValue(stack, i);
         }
     }
     if (!color)
-        self->backgroundColor.setValue(CSSColorValueImp::Transparent);
+        backgroundValues.backgroundColor.setValue(CSSColorValueImp::Transparent);
     if (!attachment)
-        self->backgroundAttachment.setValue();
+        backgroundValues.backgroundAttachment.setValue();
     if (!repeat)
-        self->backgroundRepeat.setValue();
+        backgroundValues.backgroundRepeat.setValue();
     if (!image)
-        self->backgroundImage.setValue();
+        backgroundValues.backgroundImage.setValue();
     if (!position)
-        self->backgroundPosition.setValue();
+        backgroundValues.backgroundPosition.setValue();
     return true;
 }
 
 std::u16string CSSBackgroundShorthandImp::getCssText(CSSStyleDeclarationImp* self) const
 {
-    return self->backgroundColor.getCssText(self) + u' ' +
-           self->backgroundImage.getCssText(self) + u' ' +
-           self->backgroundRepeat.getCssText(self) + u' ' +
-           self->backgroundAttachment.getCssText(self) + u' ' +
-           self->backgroundPosition.getCssText(self);
+    const CSSBackgroundValues& backgroundValues = self->backgroundValues.get();
+    return backgroundValues.backgroundColor.getCssText(self) + u' ' +
+           backgroundValues.backgroundImage.getCssText(self) + u' ' +
+           backgroundValues.backgroundRepeat.getCssText(self) + u' ' +
+           backgroundValues.backgroundAttachment.getCssText(self) + u' ' +
+           backgroundValues.backgroundPosition.getCssText(self);
 }
 
 void CSSBackgroundShorthandImp::specify(CSSStyleDeclarationImp* self, const CSSStyleDeclarationPtr& decl)
 {
-    self->backgroundColor.specify(decl->backgroundColor);
-    self->backgroundImage.specify(decl->backgroundImage);
-    self->backgroundRepeat.specify(decl->backgroundRepeat);
-    self->backgroundAttachment.specify(decl->backgroundAttachment);
-    self->backgroundPosition.specify(decl->backgroundPosition);
+    CSSBackgroundValues& backgroundValues = self->backgroundValues.mutate();
+    backgroundValues.backgroundColor.specify(decl->backgroundValues->backgroundColor);
+    backgroundValues.backgroundImage.specify(decl->backgroundValues->backgroundImage);
+    backgroundValues.backgroundRepeat.specify(decl->backgroundValues->backgroundRepeat);
+    backgroundValues.backgroundAttachment.specify(decl->backgroundValues->backgroundAttachment);
+    backgroundValues.backgroundPosition.specify(decl->backgroundValues->backgroundPosition);
 }
 
 void CSSBackgroundShorthandImp::reset(CSSStyleDeclarationImp* self)
 {
-    self->backgroundColor.setValue(CSSColorValueImp::Transparent);
-    self->backgroundImage.setValue();
-    self->backgroundRepeat.setValue();
-    self->backgroundAttachment.setValue();
-    self->backgroundPosition.setValue();
-}
-
-void CSSBorderColorValueImp::compute(CSSStyleDeclarationImp* self)
-{
-    assert(self);
-    if (!hasValue)
-        resolved = self->color.getARGB();
-    else
-        resolved = value;
+    CSSBackgroundValues& backgroundValues = self->backgroundValues.mutate();
+    backgroundValues.backgroundColor.setValue(CSSColorValueImp::Transparent);
+    backgroundValues.backgroundImage.setValue();
+    backgroundValues.backgroundRepeat.setValue();
+    backgroundValues.backgroundAttachment.setValue();
+    backgroundValues.backgroundPosition.setValue();
 }
 
 void CSSBorderSpacingValueImp::compute(ViewCSSImp* view, CSSStyleDeclarationImp* self)
@@ -728,25 +728,26 @@ void CSSBorderSpacingValueImp::compute(ViewCSSImp* view, CSSStyleDeclarationImp*
 
 bool CSSBorderColorShorthandImp::setValue(CSSStyleDeclarationImp* self, CSSValueParser* parser)
 {
+    CSSBorderValues& borderValues = self->borderValues.mutate();
     std::deque<CSSParserTerm*>& stack = parser->getStack();
     switch (stack.size()) {
     case 1:
-        self->borderBottomColor = self->borderLeftColor = self->borderRightColor = self->borderTopColor.setValue(stack[0]);
+        borderValues.borderBottomColor = borderValues.borderLeftColor = borderValues.borderRightColor = borderValues.borderTopColor.setValue(stack[0]);
         break;
     case 2:
-        self->borderBottomColor = self->borderTopColor.setValue(stack[0]);
-        self->borderLeftColor = self->borderRightColor.setValue(stack[1]);
+        borderValues.borderBottomColor = borderValues.borderTopColor.setValue(stack[0]);
+        borderValues.borderLeftColor = borderValues.borderRightColor.setValue(stack[1]);
         break;
     case 3:
-        self->borderTopColor.setValue(stack[0]);
-        self->borderLeftColor = self->borderRightColor.setValue(stack[1]);
-        self->borderBottomColor.setValue(stack[2]);
+        borderValues.borderTopColor.setValue(stack[0]);
+        borderValues.borderLeftColor = borderValues.borderRightColor.setValue(stack[1]);
+        borderValues.borderBottomColor.setValue(stack[2]);
         break;
     case 4:
-        self->borderTopColor.setValue(stack[0]);
-        self->borderRightColor.setValue(stack[1]);
-        self->borderBottomColor.setValue(stack[2]);
-        self->borderLeftColor.setValue(stack[3]);
+        borderValues.borderTopColor.setValue(stack[0]);
+        borderValues.borderRightColor.setValue(stack[1]);
+        borderValues.borderBottomColor.setValue(stack[2]);
+        borderValues.borderLeftColor.setValue(stack[3]);
         break;
     }
     return true;
@@ -754,51 +755,54 @@ bool CSSBorderColorShorthandImp::setValue(CSSStyleDeclarationImp* self, CSSValue
 
 std::u16string CSSBorderColorShorthandImp::getCssText(CSSStyleDeclarationImp* self) const
 {
+    const CSSBorderValues& borderValues = self->borderValues.get();
     std::u16string cssText;
-    if (self->borderLeftColor != self->borderRightColor)
-        return self->borderTopColor.getCssText(self) + u' ' +
-               self->borderRightColor.getCssText(self) + u' ' +
-               self->borderBottomColor.getCssText(self) + u' ' +
-               self->borderLeftColor.getCssText(self);
-    if (self->borderTopColor != self->borderBottomColor)
-        return self->borderTopColor.getCssText(self) + u' ' +
-               self->borderRightColor.getCssText(self) + u' ' +
-               self->borderBottomColor.getCssText(self);
-    if (self->borderTopColor != self->borderRightColor)
-        return self->borderTopColor.getCssText(self) + u' ' +
-               self->borderRightColor.getCssText(self);
-    return self->borderTopColor.getCssText(self);
+    if (borderValues.borderLeftColor != borderValues.borderRightColor)
+        return borderValues.borderTopColor.getCssText(self) + u' ' +
+               borderValues.borderRightColor.getCssText(self) + u' ' +
+               borderValues.borderBottomColor.getCssText(self) + u' ' +
+               borderValues.borderLeftColor.getCssText(self);
+    if (borderValues.borderTopColor != borderValues.borderBottomColor)
+        return borderValues.borderTopColor.getCssText(self) + u' ' +
+               borderValues.borderRightColor.getCssText(self) + u' ' +
+               borderValues.borderBottomColor.getCssText(self);
+    if (borderValues.borderTopColor != borderValues.borderRightColor)
+        return borderValues.borderTopColor.getCssText(self) + u' ' +
+               borderValues.borderRightColor.getCssText(self);
+    return borderValues.borderTopColor.getCssText(self);
 }
 
 void CSSBorderColorShorthandImp::specify(CSSStyleDeclarationImp* self, const CSSStyleDeclarationPtr& decl)
 {
-    self->borderTopColor.specify(decl->borderTopColor);
-    self->borderRightColor.specify(decl->borderRightColor);
-    self->borderBottomColor.specify(decl->borderBottomColor);
-    self->borderLeftColor.specify(decl->borderLeftColor);
+    CSSBorderValues& borderValues = self->borderValues.mutate();
+    borderValues.borderTopColor.specify(decl->borderValues->borderTopColor);
+    borderValues.borderRightColor.specify(decl->borderValues->borderRightColor);
+    borderValues.borderBottomColor.specify(decl->borderValues->borderBottomColor);
+    borderValues.borderLeftColor.specify(decl->borderValues->borderLeftColor);
 }
 
 bool CSSBorderStyleShorthandImp::setValue(CSSStyleDeclarationImp* self, CSSValueParser* parser)
 {
+    CSSBorderValues& borderValues = self->borderValues.mutate();
     std::deque<CSSParserTerm*>& stack = parser->getStack();
     switch (stack.size()) {
     case 1:
-        self->borderBottomStyle = self->borderLeftStyle = self->borderRightStyle = self->borderTopStyle.setValue(stack[0]);
+        borderValues.borderBottomStyle = borderValues.borderLeftStyle = borderValues.borderRightStyle = borderValues.borderTopStyle.setValue(stack[0]);
         break;
     case 2:
-        self->borderBottomStyle = self->borderTopStyle.setValue(stack[0]);
-        self->borderLeftStyle = self->borderRightStyle.setValue(stack[1]);
+        borderValues.borderBottomStyle = borderValues.borderTopStyle.setValue(stack[0]);
+        borderValues.borderLeftStyle = borderValues.borderRightStyle.setValue(stack[1]);
         break;
     case 3:
-        self->borderTopStyle.setValue(stack[0]);
-        self->borderLeftStyle = self->borderRightStyle.setValue(stack[1]);
-        self->borderBottomStyle.setValue(stack[2]);
+        borderValues.borderTopStyle.setValue(stack[0]);
+        borderValues.borderLeftStyle = borderValues.borderRightStyle.setValue(stack[1]);
+        borderValues.borderBottomStyle.setValue(stack[2]);
         break;
     case 4:
-        self->borderTopStyle.setValue(stack[0]);
-        self->borderRightStyle.setValue(stack[1]);
-        self->borderBottomStyle.setValue(stack[2]);
-        self->borderLeftStyle.setValue(stack[3]);
+        borderValues.borderTopStyle.setValue(stack[0]);
+        borderValues.borderRightStyle.setValue(stack[1]);
+        borderValues.borderBottomStyle.setValue(stack[2]);
+        borderValues.borderLeftStyle.setValue(stack[3]);
         break;
     }
     return true;
@@ -806,28 +810,30 @@ bool CSSBorderStyleShorthandImp::setValue(CSSStyleDeclarationImp* self, CSSValue
 
 std::u16string CSSBorderStyleShorthandImp::getCssText(CSSStyleDeclarationImp* self) const
 {
+    const CSSBorderValues& borderValues = self->borderValues.get();
     std::u16string cssText;
-    if (self->borderLeftStyle != self->borderRightStyle)
-        return self->borderTopStyle.getCssText(self) + u' ' +
-               self->borderRightStyle.getCssText(self) + u' ' +
-               self->borderBottomStyle.getCssText(self) + u' ' +
-               self->borderLeftStyle.getCssText(self);
-    if (self->borderTopStyle != self->borderBottomStyle)
-        return self->borderTopStyle.getCssText(self) + u' ' +
-               self->borderRightStyle.getCssText(self) + u' ' +
-               self->borderBottomStyle.getCssText(self);
-    if (self->borderTopStyle != self->borderRightStyle)
-        return self->borderTopStyle.getCssText(self) + u' ' +
-               self->borderRightStyle.getCssText(self);
-    return self->borderTopStyle.getCssText(self);
+    if (borderValues.borderLeftStyle != borderValues.borderRightStyle)
+        return borderValues.borderTopStyle.getCssText(self) + u' ' +
+               borderValues.borderRightStyle.getCssText(self) + u' ' +
+               borderValues.borderBottomStyle.getCssText(self) + u' ' +
+               borderValues.borderLeftStyle.getCssText(self);
+    if (borderValues.borderTopStyle != borderValues.borderBottomStyle)
+        return borderValues.borderTopStyle.getCssText(self) + u' ' +
+               borderValues.borderRightStyle.getCssText(self) + u' ' +
+               borderValues.borderBottomStyle.getCssText(self);
+    if (borderValues.borderTopStyle != borderValues.borderRightStyle)
+        return borderValues.borderTopStyle.getCssText(self) + u' ' +
+               borderValues.borderRightStyle.getCssText(self);
+    return borderValues.borderTopStyle.getCssText(self);
 }
 
 void CSSBorderStyleShorthandImp::specify(CSSStyleDeclarationImp* self, const CSSStyleDeclarationPtr& decl)
 {
-    self->borderTopStyle.specify(decl->borderTopStyle);
-    self->borderRightStyle.specify(decl->borderRightStyle);
-    self->borderBottomStyle.specify(decl->borderBottomStyle);
-    self->borderLeftStyle.specify(decl->borderLeftStyle);
+    CSSBorderValues& borderValues = self->borderValues.mutate();
+    borderValues.borderTopStyle.specify(decl->borderValues->borderTopStyle);
+    borderValues.borderRightStyle.specify(decl->borderValues->borderRightStyle);
+    borderValues.borderBottomStyle.specify(decl->borderValues->borderBottomStyle);
+    borderValues.borderLeftStyle.specify(decl->borderValues->borderLeftStyle);
 }
 
 void CSSBorderWidthValueImp::compute(ViewCSSImp* view, const CSSBorderStyleValueImp& borderStyle, CSSStyleDeclarationImp* self)
@@ -867,25 +873,26 @@ void CSSBorderWidthValueImp::compute(ViewCSSImp* view, const CSSBorderStyleValue
 
 bool CSSBorderWidthShorthandImp::setValue(CSSStyleDeclarationImp* self, CSSValueParser* parser)
 {
+    CSSBorderValues& borderValues = self->borderValues.mutate();
     std::deque<CSSParserTerm*>& stack = parser->getStack();
     switch (stack.size()) {
     case 1:
-        self->borderBottomWidth = self->borderLeftWidth = self->borderRightWidth = self->borderTopWidth.setValue(stack[0]);
+        borderValues.borderBottomWidth = borderValues.borderLeftWidth = borderValues.borderRightWidth = borderValues.borderTopWidth.setValue(stack[0]);
         break;
     case 2:
-        self->borderBottomWidth = self->borderTopWidth.setValue(stack[0]);
-        self->borderLeftWidth = self->borderRightWidth.setValue(stack[1]);
+        borderValues.borderBottomWidth = borderValues.borderTopWidth.setValue(stack[0]);
+        borderValues.borderLeftWidth = borderValues.borderRightWidth.setValue(stack[1]);
         break;
     case 3:
-        self->borderTopWidth.setValue(stack[0]);
-        self->borderLeftWidth = self->borderRightWidth.setValue(stack[1]);
-        self->borderBottomWidth.setValue(stack[2]);
+        borderValues.borderTopWidth.setValue(stack[0]);
+        borderValues.borderLeftWidth = borderValues.borderRightWidth.setValue(stack[1]);
+        borderValues.borderBottomWidth.setValue(stack[2]);
         break;
     case 4:
-        self->borderTopWidth.setValue(stack[0]);
-        self->borderRightWidth.setValue(stack[1]);
-        self->borderBottomWidth.setValue(stack[2]);
-        self->borderLeftWidth.setValue(stack[3]);
+        borderValues.borderTopWidth.setValue(stack[0]);
+        borderValues.borderRightWidth.setValue(stack[1]);
+        borderValues.borderBottomWidth.setValue(stack[2]);
+        borderValues.borderLeftWidth.setValue(stack[3]);
         break;
     }
     return true;
@@ -893,32 +900,35 @@ bool CSSBorderWidthShorthandImp::setValue(CSSStyleDeclarationImp* self, CSSValue
 
 std::u16string CSSBorderWidthShorthandImp::getCssText(CSSStyleDeclarationImp* self) const
 {
+    const CSSBorderValues& borderValues = self->borderValues.get();
     std::u16string cssText;
-    if (self->borderLeftWidth != self->borderRightWidth)
-        return self->borderTopWidth.getCssText(self) + u' ' +
-               self->borderRightWidth.getCssText(self) + u' ' +
-               self->borderBottomWidth.getCssText(self) + u' ' +
-               self->borderLeftWidth.getCssText(self);
-    if (self->borderTopWidth != self->borderBottomWidth)
-        return self->borderTopWidth.getCssText(self) + u' ' +
-               self->borderRightWidth.getCssText(self) + u' ' +
-               self->borderBottomWidth.getCssText(self);
-    if (self->borderTopWidth != self->borderRightWidth)
-        return self->borderTopWidth.getCssText(self) + u' ' +
-               self->borderRightWidth.getCssText(self);
-    return self->borderTopWidth.getCssText(self);
+    if (borderValues.borderLeftWidth != borderValues.borderRightWidth)
+        return borderValues.borderTopWidth.getCssText(self) + u' ' +
+               borderValues.borderRightWidth.getCssText(self) + u' ' +
+               borderValues.borderBottomWidth.getCssText(self) + u' ' +
+               borderValues.borderLeftWidth.getCssText(self);
+    if (borderValues.borderTopWidth != borderValues.borderBottomWidth)
+        return borderValues.borderTopWidth.getCssText(self) + u' ' +
+               borderValues.borderRightWidth.getCssText(self) + u' ' +
+               borderValues.borderBottomWidth.getCssText(self);
+    if (borderValues.borderTopWidth != borderValues.borderRightWidth)
+        return borderValues.borderTopWidth.getCssText(self) + u' ' +
+               borderValues.borderRightWidth.getCssText(self);
+    return borderValues.borderTopWidth.getCssText(self);
 }
 
 void CSSBorderWidthShorthandImp::specify(CSSStyleDeclarationImp* self, const CSSStyleDeclarationPtr& decl)
 {
-    self->borderTopWidth.specify(decl->borderTopWidth);
-    self->borderRightWidth.specify(decl->borderRightWidth);
-    self->borderBottomWidth.specify(decl->borderBottomWidth);
-    self->borderLeftWidth.specify(decl->borderLeftWidth);
+    CSSBorderValues& borderValues = self->borderValues.mutate();
+    borderValues.borderTopWidth.specify(decl->borderValues->borderTopWidth);
+    borderValues.borderRightWidth.specify(decl->borderValues->borderRightWidth);
+    borderValues.borderBottomWidth.specify(decl->borderValues->borderBottomWidth);
+    borderValues.borderLeftWidth.specify(decl->borderValues->borderLeftWidth);
 }
 
 bool CSSBorderValueImp::setValue(CSSStyleDeclarationImp* self, CSSValueParser* parser)
 {
+    CSSBorderValues& borderValues = self->borderValues.mutate();
     bool style = false;
     bool width = false;
     bool color = false;
@@ -929,16 +939,16 @@ bool CSSBorderValueImp::setValue(CSSStyleDeclarationImp* self, CSSValueParser* p
             style = true;
             switch (index) {
             case 0:
-                self->borderTopStyle.setValue(term);
+                borderValues.borderTopStyle.setValue(term);
                 break;
             case 1:
-                self->borderRightStyle.setValue(term);
+                borderValues.borderRightStyle.setValue(term);
                 break;
             case 2:
-                self->borderBottomStyle.setValue(term);
+                borderValues.borderBottomStyle.setValue(term);
                 break;
             case 3:
-                self->borderLeftStyle.setValue(term);
+                borderValues.borderLeftStyle.setValue(term);
                 break;
             default:
                 break;
@@ -947,16 +957,16 @@ bool CSSBorderValueImp::setValue(CSSStyleDeclarationImp* self, CSSValueParser* p
             width = true;
             switch (index) {
             case 0:
-                self->borderTopWidth.setValue(term);
+                borderValues.borderTopWidth.setValue(term);
                 break;
             case 1:
-                self->borderRightWidth.setValue(term);
+                borderValues.borderRightWidth.setValue(term);
                 break;
             case 2:
-                self->borderBottomWidth.setValue(term);
+                borderValues.borderBottomWidth.setValue(term);
                 break;
             case 3:
-                self->borderLeftWidth.setValue(term);
+                borderValues.borderLeftWidth.setValue(term);
                 break;
             default:
                 break;
@@ -965,16 +975,16 @@ bool CSSBorderValueImp::setValue(CSSStyleDeclarationImp* self, CSSValueParser* p
             color = true;
             switch (index) {
             case 0:
-                self->borderTopColor.setValue(term);
+                borderValues.borderTopColor.setValue(term);
                 break;
             case 1:
-                self->borderRightColor.setValue(term);
+                borderValues.borderRightColor.setValue(term);
                 break;
             case 2:
-                self->borderBottomColor.setValue(term);
+                borderValues.borderBottomColor.setValue(term);
                 break;
             case 3:
-                self->borderLeftColor.setValue(term);
+                borderValues.borderLeftColor.setValue(term);
                 break;
             default:
                 break;
@@ -984,16 +994,16 @@ bool CSSBorderValueImp::setValue(CSSStyleDeclarationImp* self, CSSValueParser* p
     if (!style) {
         switch (index) {
         case 0:
-            self->borderTopStyle.setValue();
+            borderValues.borderTopStyle.setValue();
             break;
         case 1:
-            self->borderRightStyle.setValue();
+            borderValues.borderRightStyle.setValue();
             break;
         case 2:
-            self->borderBottomStyle.setValue();
+            borderValues.borderBottomStyle.setValue();
             break;
         case 3:
-            self->borderLeftStyle.setValue();
+            borderValues.borderLeftStyle.setValue();
             break;
         default:
             break;
@@ -1002,16 +1012,16 @@ bool CSSBorderValueImp::setValue(CSSStyleDeclarationImp* self, CSSValueParser* p
     if (!width) {
         switch (index) {
         case 0:
-            self->borderTopWidth.setValue();
+            borderValues.borderTopWidth.setValue();
             break;
         case 1:
-            self->borderRightWidth.setValue();
+            borderValues.borderRightWidth.setValue();
             break;
         case 2:
-            self->borderBottomWidth.setValue();
+            borderValues.borderBottomWidth.setValue();
             break;
         case 3:
-            self->borderLeftWidth.setValue();
+            borderValues.borderLeftWidth.setValue();
             break;
         default:
             break;
@@ -1020,16 +1030,16 @@ bool CSSBorderValueImp::setValue(CSSStyleDeclarationImp* self, CSSValueParser* p
     if (!color) {
         switch (index) {
         case 0:
-            self->borderTopColor.reset();
+            borderValues.borderTopColor.reset();
             break;
         case 1:
-            self->borderRightColor.reset();
+            borderValues.borderRightColor.reset();
             break;
         case 2:
-            self->borderBottomColor.reset();
+            borderValues.borderBottomColor.reset();
             break;
         case 3:
-            self->borderLeftColor.reset();
+            borderValues.borderLeftColor.reset();
             break;
         default:
             break;
@@ -1040,15 +1050,16 @@ bool CSSBorderValueImp::setValue(CSSStyleDeclarationImp* self, CSSValueParser* p
 
 std::u16string CSSBorderValueImp::getCssText(CSSStyleDeclarationImp* self) const
 {
+    const CSSBorderValues& borderValues = self->borderValues.get();
     switch (index) {
     case 0:
-        return self->borderTopWidth.getCssText(self) + u' ' + self->borderTopStyle.getCssText(self) + u' ' + self->borderTopColor.getCssText(self);
+        return borderValues.borderTopWidth.getCssText(self) + u' ' + borderValues.borderTopStyle.getCssText(self) + u' ' + borderValues.borderTopColor.getCssText(self);
     case 1:
-        return self->borderRightWidth.getCssText(self) + u' ' + self->borderRightStyle.getCssText(self) + u' ' + self->borderRightColor.getCssText(self);
+        return borderValues.borderRightWidth.getCssText(self) + u' ' + borderValues.borderRightStyle.getCssText(self) + u' ' + borderValues.borderRightColor.getCssText(self);
     case 2:
-        return self->borderBottomWidth.getCssText(self) + u' ' + self->borderBottomStyle.getCssText(self) + u' ' + self->borderBottomColor.getCssText(self);
+        return borderValues.borderBottomWidth.getCssText(self) + u' ' + borderValues.borderBottomStyle.getCssText(self) + u' ' + borderValues.borderBottomColor.getCssText(self);
     case 3:
-        return self->borderLeftWidth.getCssText(self) + u' ' + self->borderLeftStyle.getCssText(self) + u' ' + self->borderLeftColor.getCssText(self);
+        return borderValues.borderLeftWidth.getCssText(self) + u' ' + borderValues.borderLeftStyle.getCssText(self) + u' ' + borderValues.borderLeftColor.getCssText(self);
     default:
         return u"";
     }
@@ -1056,26 +1067,27 @@ std::u16string CSSBorderValueImp::getCssText(CSSStyleDeclarationImp* self) const
 
 void CSSBorderValueImp::specify(CSSStyleDeclarationImp* self, const CSSStyleDeclarationPtr& decl)
 {
+    CSSBorderValues& borderValues = self->borderValues.mutate();
     switch (index) {
     case 0:
-        self->borderTopWidth.specify(decl->borderTopWidth);
-        self->borderTopStyle.specify(decl->borderTopStyle);
-        self->borderTopColor.specify(decl->borderTopColor);
+        borderValues.borderTopWidth.specify(decl->borderValues->borderTopWidth);
+        borderValues.borderTopStyle.specify(decl->borderValues->borderTopStyle);
+        borderValues.borderTopColor.specify(decl->borderValues->borderTopColor);
         break;
     case 1:
-        self->borderRightWidth.specify(decl->borderRightWidth);
-        self->borderRightStyle.specify(decl->borderRightStyle);
-        self->borderRightColor.specify(decl->borderRightColor);
+        borderValues.borderRightWidth.specify(decl->borderValues->borderRightWidth);
+        borderValues.borderRightStyle.specify(decl->borderValues->borderRightStyle);
+        borderValues.borderRightColor.specify(decl->borderValues->borderRightColor);
         break;
     case 2:
-        self->borderBottomWidth.specify(decl->borderBottomWidth);
-        self->borderBottomStyle.specify(decl->borderBottomStyle);
-        self->borderBottomColor.specify(decl->borderBottomColor);
+        borderValues.borderBottomWidth.specify(decl->borderValues->borderBottomWidth);
+        borderValues.borderBottomStyle.specify(decl->borderValues->borderBottomStyle);
+        borderValues.borderBottomColor.specify(decl->borderValues->borderBottomColor);
         break;
     case 3:
-        self->borderLeftWidth.specify(decl->borderLeftWidth);
-        self->borderLeftStyle.specify(decl->borderLeftStyle);
-        self->borderLeftColor.specify(decl->borderLeftColor);
+        borderValues.borderLeftWidth.specify(decl->borderValues->borderLeftWidth);
+        borderValues.borderLeftStyle.specify(decl->borderValues->borderLeftStyle);
+        borderValues.borderLeftColor.specify(decl->borderValues->borderLeftColor);
         break;
     default:
         break;
@@ -1084,6 +1096,7 @@ void CSSBorderValueImp::specify(CSSStyleDeclarationImp* self, const CSSStyleDecl
 
 bool CSSBorderShorthandImp::setValue(CSSStyleDeclarationImp* self, CSSValueParser* parser)
 {
+    CSSBorderValues& borderValues = self->borderValues.mutate();
     bool style = false;
     bool width = false;
     bool color = false;
@@ -1092,21 +1105,21 @@ bool CSSBorderShorthandImp::setValue(CSSStyleDeclarationImp* self, CSSValueParse
         CSSParserTerm* term = *i;
         if (term->propertyID == CSSStyleDeclarationImp::BorderStyle) {
             style = true;
-            self->borderBottomStyle = self->borderLeftStyle = self->borderRightStyle = self->borderTopStyle.setValue(term);
+            borderValues.borderBottomStyle = borderValues.borderLeftStyle = borderValues.borderRightStyle = borderValues.borderTopStyle.setValue(term);
         } else if (term->propertyID == CSSStyleDeclarationImp::BorderWidth) {
             width = true;
-            self->borderBottomWidth = self->borderLeftWidth = self->borderRightWidth = self->borderTopWidth.setValue(term);
+            borderValues.borderBottomWidth = borderValues.borderLeftWidth = borderValues.borderRightWidth = borderValues.borderTopWidth.setValue(term);
         } else {
             color = true;
-            self->borderBottomColor = self->borderLeftColor = self->borderRightColor = self->borderTopColor.setValue(term);
+            borderValues.borderBottomColor = borderValues.borderLeftColor = borderValues.borderRightColor = borderValues.borderTopColor.setValue(term);
         }
     }
     if (!style)
-        self->borderBottomStyle = self->borderLeftStyle = self->borderRightStyle = self->borderTopStyle.setValue();
+        borderValues.borderBottomStyle = borderValues.borderLeftStyle = borderValues.borderRightStyle = borderValues.borderTopStyle.setValue();
     if (!width)
-        self->borderBottomWidth = self->borderLeftWidth = self->borderRightWidth = self->borderTopWidth.setValue();
+        borderValues.borderBottomWidth = borderValues.borderLeftWidth = borderValues.borderRightWidth = borderValues.borderTopWidth.setValue();
     if (!color)
-        self->borderBottomColor = self->borderLeftColor = self->borderRightColor = self->borderTopColor.reset();
+        borderValues.borderBottomColor = borderValues.borderLeftColor = borderValues.borderRightColor = borderValues.borderTopColor.reset();
     return true;
 }
 
@@ -1518,7 +1531,7 @@ std::u16string CSSFontFamilyValueImp::getCssText(CSSStyleDeclarationImp* self) c
 void CSSFontSizeValueImp::compute(ViewCSSImp* view, const CSSStyleDeclarationPtr& parentStyle)
 {
     float w;
-    float parentSize = parentStyle ? parentStyle->fontSize.getPx() : view->getMediumFontSize();
+    float parentSize = parentStyle ? parentStyle->fontValues->fontSize.getPx() : view->getMediumFontSize();
     unsigned i;
     switch (size.unit) {
     case CSSParserTerm::CSS_TERM_INDEX:
@@ -1564,7 +1577,7 @@ void CSSFontSizeValueImp::compute(ViewCSSImp* view, const CSSStyleDeclarationPtr
 
 void CSSFontWeightValueImp::compute(ViewCSSImp* view, const CSSStyleDeclarationPtr& parentStyle)
 {
-    unsigned inherited = parentStyle ? parentStyle->fontWeight.getWeight() : 400;
+    unsigned inherited = parentStyle ? parentStyle->fontValues->fontWeight.getWeight() : 400;
     unsigned w;
     switch (value.unit) {
     case CSSParserTerm::CSS_TERM_INDEX:
@@ -1605,28 +1618,30 @@ void CSSFontWeightValueImp::compute(ViewCSSImp* view, const CSSStyleDeclarationP
 
 bool CSSFontShorthandImp::setValue(CSSStyleDeclarationImp* self, CSSValueParser* parser)
 {
+    CSSFontValues& fontValues = self->fontValues.mutate();
+    CSSTextValues& textValues = self->textValues.mutate();
     reset(self);
     std::deque<CSSParserTerm*>& stack = parser->getStack();
     for (auto i = stack.begin(); i != stack.end(); ++i) {
         CSSParserTerm* term = *i;
         switch (term->propertyID) {
         case CSSStyleDeclarationImp::FontStyle:
-            self->fontStyle.setValue(term);
+            fontValues.fontStyle.setValue(term);
             break;
         case CSSStyleDeclarationImp::FontVariant:
-            self->fontVariant.setValue(term);
+            fontValues.fontVariant.setValue(term);
             break;
         case CSSStyleDeclarationImp::FontWeight:
-            self->fontWeight.setValue(term);
+            fontValues.fontWeight.setValue(term);
             break;
         case CSSStyleDeclarationImp::FontSize:
-            self->fontSize.setValue(term);
+            fontValues.fontSize.setValue(term);
             break;
         case CSSStyleDeclarationImp::LineHeight:
-            self->lineHeight.setValue(term);
+            textValues.lineHeight.setValue(term);
             break;
         case CSSStyleDeclarationImp::FontFamily:
-            i = self->fontFamily.setValue(stack, i);
+            i = fontValues.fontFamily.setValue(stack, i);
             break;
         default:
             if (term->unit == CSSParserTerm::CSS_TERM_INDEX)
@@ -1639,56 +1654,62 @@ bool CSSFontShorthandImp::setValue(CSSStyleDeclarationImp* self, CSSValueParser*
 
 std::u16string CSSFontShorthandImp::getCssText(CSSStyleDeclarationImp* self) const
 {
+    const CSSFontValues& fontValues = self->fontValues.get();
+    const CSSTextValues& textValues = self->textValues.get();
     if (index != Normal)
         return Options[index];
 
     std::u16string text;
-    if (!self->fontStyle.isNormal())
-        text += self->fontStyle.getCssText(self);
-    if (!self->fontVariant.isNormal()) {
+    if (!fontValues.fontStyle.isNormal())
+        text += fontValues.fontStyle.getCssText(self);
+    if (!fontValues.fontVariant.isNormal()) {
         if (!text.empty())
             text += u" ";
-        text += self->fontVariant.getCssText(self);
+        text += fontValues.fontVariant.getCssText(self);
     }
-    if (!self->fontWeight.isNormal()) {
+    if (!fontValues.fontWeight.isNormal()) {
         if (!text.empty())
             text += u" ";
-        text += self->fontWeight.getCssText(self);
+        text += fontValues.fontWeight.getCssText(self);
     }
     if (!text.empty())
         text += u" ";
-    text += self->fontSize.getCssText(self);
-    if (!self->lineHeight.isNormal())
-        text += u"/" + self->lineHeight.getCssText(self);
-    text += u" " + self->fontFamily.getCssText(self);
+    text += fontValues.fontSize.getCssText(self);
+    if (!textValues.lineHeight.isNormal())
+        text += u"/" + textValues.lineHeight.getCssText(self);
+    text += u" " + fontValues.fontFamily.getCssText(self);
     return text;
 }
 
 void CSSFontShorthandImp::specify(CSSStyleDeclarationImp* self, const CSSStyleDeclarationPtr& decl)
 {
+    CSSFontValues& fontValues = self->fontValues.mutate();
+    CSSTextValues& textValues = self->textValues.mutate();
     if (decl->font.index != Normal) {
         reset(self);
         index = decl->font.index;
     } else {
         index = Normal;
-        self->fontStyle.specify(decl->fontStyle);
-        self->fontVariant.specify(decl->fontVariant);
-        self->fontWeight.specify(decl->fontWeight);
-        self->fontSize.specify(decl->fontSize);
-        self->lineHeight.specify(decl->lineHeight);
-        self->fontFamily.specify(decl->fontFamily);
+        fontValues.fontStyle.specify(decl->fontValues->fontStyle);
+        fontValues.fontVariant.specify(decl->fontValues->fontVariant);
+        fontValues.fontWeight.specify(decl->fontValues->fontWeight);
+        fontValues.fontSize.specify(decl->fontValues->fontSize);
+        textValues.lineHeight.specify(decl->textValues->lineHeight);
+        fontValues.fontFamily.specify(decl->fontValues->fontFamily);
     }
 }
 
 void CSSFontShorthandImp::reset(CSSStyleDeclarationImp* self)
 {
+    CSSFontValues& fontValues = self->fontValues.mutate();
+    CSSTextValues& textValues = self->textValues.mutate();
     index = Normal;
-    self->fontStyle.setValue();
-    self->fontVariant.setValue();
-    self->fontWeight.setValue();
-    self->fontSize.setValue();
-    self->lineHeight.setValue();
-    self->fontFamily.reset();
+    fontValues.fontStyle.setValue();
+    fontValues.fontVariant.setValue();
+    fontValues.fontWeight.setValue();
+    fontValues.fontSize.setValue();
+    textValues.lineHeight.setValue();
+    fontValues.fontFamily.reset();
 }
 
 void CSSLineHeightValueImp::inherit(const CSSLineHeightValueImp& parent)
@@ -1712,7 +1733,7 @@ void CSSLineHeightValueImp::compute(ViewCSSImp* view, CSSStyleDeclarationImp* se
         value.resolved = NAN;
         break;
     default:
-        value.resolve(view, self, self->fontSize.getPx());
+        value.resolve(view, self, self->fontValues->fontSize.getPx());
         break;
     }
 }
@@ -1723,12 +1744,12 @@ void CSSLineHeightValueImp::resolve(ViewCSSImp* view, CSSStyleDeclarationImp* se
     switch (value.isNegative() ? CSSParserTerm::CSS_TERM_INDEX : value.unit) {
     case CSSParserTerm::CSS_TERM_INDEX:
         if (FontTexture* font = self->getFontTexture())
-            w = font->getLineHeight(view->getPointFromPx(self->fontSize.getPx()));
+            w = font->getLineHeight(view->getPointFromPx(self->fontValues->fontSize.getPx()));
         else
-            w = self->fontSize.getPx() * 1.2;
+            w = self->fontValues->fontSize.getPx() * 1.2;
         break;
     case css::CSSPrimitiveValue::CSS_NUMBER:
-        w = self->fontSize.getPx() * value.number;
+        w = self->fontValues->fontSize.getPx() * value.number;
         break;
     default:
         return;
@@ -1894,6 +1915,7 @@ void CSSMarginShorthandImp::specify(CSSStyleDeclarationImp* self, const CSSStyle
 
 bool CSSOutlineShorthandImp::setValue(CSSStyleDeclarationImp* self, CSSValueParser* parser)
 {
+    CSSOutlineValues& outlineValues = self->outlineValues.mutate();
     bool style = false;
     bool width = false;
     bool color = false;
@@ -1902,34 +1924,36 @@ bool CSSOutlineShorthandImp::setValue(CSSStyleDeclarationImp* self, CSSValuePars
         CSSParserTerm* term = *i;
         if (term->propertyID == CSSStyleDeclarationImp::BorderStyle) {
             style = true;
-            self->outlineStyle.setValue(term);
+            outlineValues.outlineStyle.setValue(term);
         } else if (term->propertyID == CSSStyleDeclarationImp::BorderWidth) {
             width = true;
-            self->outlineWidth.setValue(term);
+            outlineValues.outlineWidth.setValue(term);
         } else {
             color = true;
-            self->outlineColor.setValue(term);
+            outlineValues.outlineColor.setValue(term);
         }
     }
     if (!style)
-        self->outlineStyle.setValue();
+        outlineValues.outlineStyle.setValue();
     if (!width)
-        self->outlineWidth.setValue();
+        outlineValues.outlineWidth.setValue();
     if (!color)
-        self->outlineColor.setValue();
+        outlineValues.outlineColor.setValue();
     return true;
 }
 
 std::u16string CSSOutlineShorthandImp::getCssText(CSSStyleDeclarationImp* self) const
 {
-    return self->outlineWidth.getCssText(self) + u' ' + self->outlineStyle.getCssText(self) + u' ' + self->outlineColor.getCssText(self);
+    const CSSOutlineValues& outlineValues = self->outlineValues.get();
+    return outlineValues.outlineWidth.getCssText(self) + u' ' + outlineValues.outlineStyle.getCssText(self) + u' ' + outlineValues.outlineColor.getCssText(self);
 }
 
 void CSSOutlineShorthandImp::specify(CSSStyleDeclarationImp* self, const CSSStyleDeclarationPtr& decl)
 {
-    self->outlineColor.specify(decl->outlineColor);
-    self->outlineStyle.specify(decl->outlineStyle);
-    self->outlineWidth.specify(decl->outlineWidth);
+    CSSOutlineValues& outlineValues = self->outlineValues.mutate();
+    outlineValues.outlineColor.specify(decl->outlineValues->outlineColor);
+    outlineValues.outlineStyle.specify(decl->outlineValues->outlineStyle);
+    outlineValues.outlineWidth.specify(decl->outlineValues->outlineWidth);
 }
 
 bool CSSPaddingShorthandImp::setValue(CSSStyleDeclarationImp* self, CSSValueParser* parser)
@@ -2037,7 +2061,7 @@ void CSSVerticalAlignValueImp::resolve(ViewCSSImp* view, CSSStyleDeclarationImp*
 {
     if (value.isIndex())
         return;
-    value.resolve(view, self, self->lineHeight.getPx());
+    value.resolve(view, self, self->textValues->lineHeight.getPx());
 }
 
 float CSSVerticalAlignValueImp::getOffset(ViewCSSImp* view, CSSStyleDeclarationImp* self, const LineBoxPtr& line, FontTexture* font, float point, float leading) const
@@ -2057,7 +2081,7 @@ float CSSVerticalAlignValueImp::getOffset(ViewCSSImp* view, CSSStyleDeclarationI
             if (!font)
                 font = view->selectFont(parent);
             if (font)
-                offset -= font->getXHeight(view->getPointFromPx(parent->fontSize.getPx())) / 2.0f;
+                offset -= font->getXHeight(view->getPointFromPx(parent->fontValues->fontSize.getPx())) / 2.0f;
         }
         return offset;
     }
@@ -2074,7 +2098,7 @@ float CSSVerticalAlignValueImp::getOffset(ViewCSSImp* view, CSSStyleDeclarationI
             if (!font)
                 font = view->selectFont(parent);
             if (font)
-                offset = line->getBaseline() - font->getAscender(view->getPointFromPx(parent->fontSize.getPx()));
+                offset = line->getBaseline() - font->getAscender(view->getPointFromPx(parent->fontValues->fontSize.getPx()));
         }
         return offset;
     }
@@ -2085,7 +2109,7 @@ float CSSVerticalAlignValueImp::getOffset(ViewCSSImp* view, CSSStyleDeclarationI
             if (!font)
                 font = view->selectFont(parent);
             if (font) {
-                float point = view->getPointFromPx(parent->fontSize.getPx());
+                float point = view->getPointFromPx(parent->fontValues->fontSize.getPx());
                 offset = line->getBaseline() - font->getAscender(point) + font->getLineHeight(point);
             }
         }
@@ -2115,7 +2139,7 @@ float CSSVerticalAlignValueImp::getOffset(ViewCSSImp* view, CSSStyleDeclarationI
             if (!font)
                 font = view->selectFont(parent);
             if (font)
-                offset -= font->getXHeight(view->getPointFromPx(parent->fontSize.getPx())) / 2.0f;
+                offset -= font->getXHeight(view->getPointFromPx(parent->fontValues->fontSize.getPx())) / 2.0f;
         }
         return offset;
     }
@@ -2132,7 +2156,7 @@ float CSSVerticalAlignValueImp::getOffset(ViewCSSImp* view, CSSStyleDeclarationI
             if (!font)
                 font = view->selectFont(parent);
             if (font)
-                offset = line->getBaseline() - font->getAscender(view->getPointFromPx(parent->fontSize.getPx()));
+                offset = line->getBaseline() - font->getAscender(view->getPointFromPx(parent->fontValues->fontSize.getPx()));
         }
         return offset;
     }
@@ -2143,7 +2167,7 @@ float CSSVerticalAlignValueImp::getOffset(ViewCSSImp* view, CSSStyleDeclarationI
             if (!font)
                 font = view->selectFont(parent);
             if (font) {
-                float point = view->getPointFromPx(parent->fontSize.getPx());
+                float point = view->getPointFromPx(parent->fontValues->fontSize.getPx());
                 offset = line->getBaseline() - font->getAscender(point) + font->getLineHeight(point);
             }
         }
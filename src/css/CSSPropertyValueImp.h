@@ -691,8 +691,8 @@ public:
     bool hasCounter() const {
         return !contents.empty();
     }
-    void incrementCounter(ViewCSSImp* view, CounterContext* context);
-    void resetCounter(ViewCSSImp* view, CounterContext* context);
+    void incrementCounter(ViewCSSImp* view, CounterContext* context) const;
+    void resetCounter(ViewCSSImp* view, CounterContext* context) const;
 
     CSSAutoNumberingValueImp(int defaultNumber) :
         defaultNumber(defaultNumber) {
@@ -760,7 +760,7 @@ public:
     void specify(const CSSBackgroundImageValueImp& specified) {
         uri = specified.uri;
     }
-    void compute(ViewCSSImp* view);
+    void compute(ViewCSSImp* view) const;
     CSSBackgroundImageValueImp() {
     }
 };
@@ -797,13 +797,7 @@ public:
         vertical.inheritLength(parent.vertical);
     }
     void compute(ViewCSSImp* view, CSSStyleDeclarationImp* self);
-    void resolve(ViewCSSImp* view, BoxImage* image, CSSStyleDeclarationImp* self, float width, float height);
-    float getLeftPx() const {
-        return horizontal.getPx();
-    }
-    float getTopPx() const {
-        return vertical.getPx();
-    }
+    void resolve(ViewCSSImp* view, BoxImage* image, CSSStyleDeclarationImp* self, float width, float height, float& left, float& top) const;
     CSSBackgroundPositionValueImp() :
         horizontal(0.0, css::CSSPrimitiveValue::CSS_PERCENTAGE),
         vertical(0.0, css::CSSPrimitiveValue::CSS_PERCENTAGE) {
@@ -855,10 +849,9 @@ class CSSBorderColorValueImp : public CSSPropertyValueImp
 {
     unsigned value;
     bool hasValue;
-    unsigned resolved;
 public:
     CSSBorderColorValueImp& setValue(unsigned color = 0xff000000) {
-        resolved = value = color;
+        value = color;
         hasValue = true;
         return *this;
     }
@@ -883,20 +876,17 @@ public:
     void specify(const CSSBorderColorValueImp& specified) {
         value = specified.value;
         hasValue = specified.hasValue;
-        resolved = specified.resolved;
     }
     CSSBorderColorValueImp& reset() {
-        resolved = value = 0xff000000;
+        value = 0xff000000;
         hasValue = false;
         return *this;
     }
-    unsigned getARGB() const {
-        return resolved;
-    }
-    void setARGB(unsigned argb) {
-        resolved = argb;
+    // Note the border color defaults to 'color', which is given by the caller
+    // so that the value can be shared among the styles of different colors.
+    unsigned getARGB(unsigned currentColor) const {
+        return hasValue ? value : currentColor;
     }
-    void compute(CSSStyleDeclarationImp* self);
     CSSBorderColorValueImp(unsigned argb = 0xff000000) :
         value(0xff000000),
         hasValue(false)
@@ -2346,7 +2336,7 @@ public:
     bool isInvert() const {
         return resolvedInvert == Invert;
     }
-    unsigned getARGB() {
+    unsigned getARGB() const {
         return resolvedColor;
     }
     CSSOutlineColorValueImp() :
@@ -19,6 +19,8 @@
 #include <org/w3c/dom/Element.h>
 #include <org/w3c/dom/html/HTMLBodyElement.h>
 
+#include <initializer_list>
+
 #include "CSSPropertyValueImp.h"
 #include "CSSValueParser.h"
 #include "DocumentImp.h"
@@ -155,34 +157,93 @@ const char16_t* CSSStyleDeclarationImp::PropertyNames[MaxProperties] = {
     u"opacity",
 };
 
+namespace {
+
+typedef std::bitset<CSSStyleDeclarationImp::MaxProperties> PropertySet;
+
+PropertySet makePropertySet(std::initializer_list<unsigned> ids)
+{
+    PropertySet set;
+    for (auto i = ids.begin(); i != ids.end(); ++i)
+        set.set(*i);
+    return set;
+}
+
+// The properties held in each CSSPropertyGroup
+const PropertySet TableProperties = makePropertySet({
+    CSSStyleDeclarationImp::BorderCollapse,
+    CSSStyleDeclarationImp::BorderSpacing,
+    CSSStyleDeclarationImp::CaptionSide,
+    CSSStyleDeclarationImp::EmptyCells
+});
+const PropertySet CounterProperties = makePropertySet({
+    CSSStyleDeclarationImp::CounterIncrement,
+    CSSStyleDeclarationImp::CounterReset
+});
+const PropertySet PageBreakProperties = makePropertySet({
+    CSSStyleDeclarationImp::PageBreakAfter,
+    CSSStyleDeclarationImp::PageBreakBefore,
+    CSSStyleDeclarationImp::PageBreakInside
+});
+const PropertySet BackgroundProperties = makePropertySet({
+    CSSStyleDeclarationImp::BackgroundAttachment,
+    CSSStyleDeclarationImp::BackgroundColor,
+    CSSStyleDeclarationImp::BackgroundImage,
+    CSSStyleDeclarationImp::BackgroundPosition,
+    CSSStyleDeclarationImp::BackgroundRepeat
+});
+const PropertySet BorderProperties = makePropertySet({
+    CSSStyleDeclarationImp::BorderTopColor,
+    CSSStyleDeclarationImp::BorderRightColor,
+    CSSStyleDeclarationImp::BorderBottomColor,
+    CSSStyleDeclarationImp::BorderLeftColor,
+    CSSStyleDeclarationImp::BorderTopStyle,
+    CSSStyleDeclarationImp::BorderRightStyle,
+    CSSStyleDeclarationImp::BorderBottomStyle,
+    CSSStyleDeclarationImp::BorderLeftStyle,
+    CSSStyleDeclarationImp::BorderTopWidth,
+    CSSStyleDeclarationImp::BorderRightWidth,
+    CSSStyleDeclarationImp::BorderBottomWidth,
+    CSSStyleDeclarationImp::BorderLeftWidth
+});
+const PropertySet OutlineProperties = makePropertySet({
+    CSSStyleDeclarationImp::OutlineColor,
+    CSSStyleDeclarationImp::OutlineStyle,
+    CSSStyleDeclarationImp::OutlineWidth
+});
+const PropertySet FontProperties = makePropertySet({
+    CSSStyleDeclarationImp::FontFamily,
+    CSSStyleDeclarationImp::FontSize,
+    CSSStyleDeclarationImp::FontStyle,
+    CSSStyleDeclarationImp::FontVariant,
+    CSSStyleDeclarationImp::FontWeight
+});
+const PropertySet TextProperties = makePropertySet({
+    CSSStyleDeclarationImp::LetterSpacing,
+    CSSStyleDeclarationImp::LineHeight,
+    CSSStyleDeclarationImp::TextAlign,
+    CSSStyleDeclarationImp::TextTransform,
+    CSSStyleDeclarationImp::WhiteSpace,
+    CSSStyleDeclarationImp::WordSpacing
+});
+
+}  // namespace
+
 CSSStyleDeclarationBoard::CSSStyleDeclarationBoard(const CSSStyleDeclarationPtr& style) :
-    counterIncrement(1),
-    counterReset(0)
-{
-    borderCollapse.specify(style->borderCollapse);
-    borderSpacing.specify(style->borderSpacing);
-    borderTopWidth.specify(style->borderTopWidth);
-    borderRightWidth.specify(style->borderRightWidth);
-    borderBottomWidth.specify(style->borderBottomWidth);
-    borderLeftWidth.specify(style->borderLeftWidth);
+    tableValues(style->tableValues),
+    counterValues(style->counterValues),
+    borderValues(style->borderValues),
+    fontValues(style->fontValues),
+    textValues(style->textValues)
+{
     bottom.specify(style->bottom);
-    captionSide.specify(style->captionSide);
     clear.specify(style->clear);
     content.specify(style->content);
-    counterIncrement.specify(style->counterIncrement);
-    counterReset.specify(style->counterReset);
     direction.specify(style->direction);
     display.specify(style->display);
     float_.specify(style->float_);
-    fontFamily.specify(style->fontFamily);
-    fontSize.specify(style->fontSize);
-    fontStyle.specify(style->fontStyle);
-    fontVariant.specify(style->fontVariant);
-    fontWeight.specify(style->fontWeight);
     height.specify(style->height);
     left.specify(style->left);
-    letterSpacing.specify(style->letterSpacing);
-    lineHeight.specify(style->lineHeight);
     listStyleImage.specify(style->listStyleImage);
     listStylePosition.specify(style->listStylePosition);
     listStyleType.specify(style->listStyleType);
@@ -203,15 +264,11 @@ CSSStyleDeclarationBoard::CSSStyleDeclarationBoard(const CSSStyleDeclarationPtr&
     quotes.specify(style->quotes);
     right.specify(style->right);
     tableLayout.specify(style->tableLayout);
-    textAlign.specify(style->textAlign);
     textDecoration.specify(style->textDecoration);
     textIndent.specify(style->textIndent);
-    textTransform.specify(style->textTransform);
     top.specify(style->top);
     unicodeBidi.specify(style->unicodeBidi);
     verticalAlign.specify(style->verticalAlign);
-    whiteSpace.specify(style->whiteSpace);
-    wordSpacing.specify(style->wordSpacing);
     width.specify(style->width);
     zIndex.specify(style->zIndex);
     binding.specify(style);
@@ -220,30 +277,19 @@ CSSStyleDeclarationBoard::CSSStyleDeclarationBoard(const CSSStyleDeclarationPtr&
 
 void CSSStyleDeclarationImp::restoreComputedValues(CSSStyleDeclarationBoard& board)
 {
-    borderCollapse.specify(board.borderCollapse);
-    borderSpacing.specify(board.borderSpacing);
-    borderTopWidth.specify(board.borderTopWidth);
-    borderRightWidth.specify(board.borderRightWidth);
-    borderBottomWidth.specify(board.borderBottomWidth);
-    borderLeftWidth.specify(board.borderLeftWidth);
+    tableValues.share(board.tableValues);
+    counterValues.share(board.counterValues);
+    borderValues.share(board.borderValues);
+    fontValues.share(board.fontValues);
+    textValues.share(board.textValues);
     bottom.specify(board.bottom);
-    captionSide.specify(board.captionSide);
     clear.specify(board.clear);
     content.specify(board.content);
-    counterIncrement.specify(board.counterIncrement);
-    counterReset.specify(board.counterReset);
     direction.specify(board.direction);
     display.specify(board.display);
     float_.specify(board.float_);
-    fontFamily.specify(board.fontFamily);
-    fontSize.specify(board.fontSize);
-    fontStyle.specify(board.fontStyle);
-    fontVariant.specify(board.fontVariant);
-    fontWeight.specify(board.fontWeight);
     height.specify(board.height);
     left.specify(board.left);
-    letterSpacing.specify(board.letterSpacing);
-    lineHeight.specify(board.lineHeight);
     listStyleImage.specify(board.listStyleImage);
     listStylePosition.specify(board.listStylePosition);
     listStyleType.specify(board.listStyleType);
@@ -264,15 +310,11 @@ void CSSStyleDeclarationImp::restoreComputedValues(CSSStyleDeclarationBoard& boa
     quotes.specify(board.quotes);
     right.specify(board.right);
     tableLayout.specify(board.tableLayout);
-    textAlign.specify(board.textAlign);
     textDecoration.specify(board.textDecoration);
     textIndent.specify(board.textIndent);
-    textTransform.specify(board.textTransform);
     top.specify(board.top);
     unicodeBidi.specify(board.unicodeBidi);
     verticalAlign.specify(board.verticalAlign);
-    whiteSpace.specify(board.whiteSpace);
-    wordSpacing.specify(board.wordSpacing);
     width.specify(board.width);
     zIndex.specify(board.zIndex);
     if (board.binding.getValue() ==CSSBindingValueImp::None)
@@ -320,14 +362,16 @@ unsigned CSSStyleDeclarationBoard::compare(const CSSStyleDeclarationPtr& style)
     // Note: in the following comparisons, the order of left and right sides do matter, which is not good design, though.
     //
     // Firstly, check properties that require style resolutions.
-    if (!style->borderTopWidth.compare(borderTopWidth))
-        flags |= Box::NEED_REFLOW;
-    if (!style->borderRightWidth.compare(borderRightWidth))
-        flags |= Box::NEED_REFLOW;
-    if (!style->borderBottomWidth.compare(borderBottomWidth))
-        flags |= Box::NEED_REFLOW;
-    if (!style->borderLeftWidth.compare(borderLeftWidth))
-        flags |= Box::NEED_REFLOW;
+    if (!style->borderValues.isSharedWith(borderValues)) {
+        if (!style->borderValues->borderTopWidth.compare(borderValues->borderTopWidth))
+            flags |= Box::NEED_REFLOW;
+        if (!style->borderValues->borderRightWidth.compare(borderValues->borderRightWidth))
+            flags |= Box::NEED_REFLOW;
+        if (!style->borderValues->borderBottomWidth.compare(borderValues->borderBottomWidth))
+            flags |= Box::NEED_REFLOW;
+        if (!style->borderValues->borderLeftWidth.compare(borderValues->borderLeftWidth))
+            flags |= Box::NEED_REFLOW;
+    }
     if ((flags & Box::NEED_REFLOW) && style->display.isTableParts())  // cf. html4/border-collapse-dynamic-cell-003.htm
         flags |= Box::NEED_TABLE_REFLOW;
 
@@ -375,7 +419,7 @@ unsigned CSSStyleDeclarationBoard::compare(const CSSStyleDeclarationPtr& style)
     if (!style->paddingLeft.compare(paddingLeft))
         flags |= Box::NEED_REFLOW;
 
-    if (!style->lineHeight.compare(lineHeight))
+    if (!style->textValues.isSharedWith(textValues) && !style->textValues->lineHeight.compare(textValues->lineHeight))
         flags |= Box::NEED_REFLOW;
     if (!style->textIndent.compare(textIndent))
         flags |= Box::NEED_REFLOW;
@@ -391,50 +435,56 @@ unsigned CSSStyleDeclarationBoard::compare(const CSSStyleDeclarationPtr& style)
     // Secondly, check properties that do not require style resolutions.
     if (style->clear != clear)
         flags |= Box::NEED_REFLOW;
-    if (style->counterIncrement != counterIncrement)
-        flags |= Box::NEED_REFLOW;
-    if (style->counterReset != counterReset)
-        flags |= Box::NEED_REFLOW;
+    if (!style->counterValues.isSharedWith(counterValues)) {
+        if (style->counterValues->counterIncrement != counterValues->counterIncrement)
+            flags |= Box::NEED_REFLOW;
+        if (style->counterValues->counterReset != counterValues->counterReset)
+            flags |= Box::NEED_REFLOW;
+    }
     if (style->direction != direction)
         flags |= Box::NEED_REFLOW;
-    if (style->fontFamily != fontFamily)
-        flags |= Box::NEED_REFLOW;
-    if (!style->fontSize.compare(fontSize))
-        flags |= Box::NEED_REFLOW;
-    if (style->fontStyle != fontStyle)
-        flags |= Box::NEED_REFLOW;
-    if (style->fontVariant != fontVariant)
-        flags |= Box::NEED_REFLOW;
-    if (!style->fontWeight.compare(fontWeight))
-        flags |= Box::NEED_REFLOW;
-    if (!style->letterSpacing.compare(letterSpacing))
-        flags |= Box::NEED_REFLOW;
+    if (!style->fontValues.isSharedWith(fontValues)) {
+        if (style->fontValues->fontFamily != fontValues->fontFamily)
+            flags |= Box::NEED_REFLOW;
+        if (!style->fontValues->fontSize.compare(fontValues->fontSize))
+            flags |= Box::NEED_REFLOW;
+        if (style->fontValues->fontStyle != fontValues->fontStyle)
+            flags |= Box::NEED_REFLOW;
+        if (style->fontValues->fontVariant != fontValues->fontVariant)
+            flags |= Box::NEED_REFLOW;
+        if (!style->fontValues->fontWeight.compare(fontValues->fontWeight))
+            flags |= Box::NEED_REFLOW;
+    }
+    if (!style->textValues.isSharedWith(textValues)) {
+        if (!style->textValues->letterSpacing.compare(textValues->letterSpacing))
+            flags |= Box::NEED_REFLOW;
+        if (style->textValues->textAlign != textValues->textAlign)
+            flags |= Box::NEED_REFLOW;
+        if (style->textValues->textTransform != textValues->textTransform)
+            flags |= Box::NEED_REFLOW;
+        if (style->textValues->whiteSpace != textValues->whiteSpace)
+            flags |= Box::NEED_REFLOW;
+        if (!style->textValues->wordSpacing.compare(textValues->wordSpacing))
+            flags |= Box::NEED_REFLOW;
+    }
     if (style->quotes != quotes)
         flags |= Box::NEED_REFLOW;
-    if (style->textAlign != textAlign)
-        flags |= Box::NEED_REFLOW;
     if (style->textDecoration != textDecoration)
         flags |= Box::NEED_REFLOW;
-    if (style->textTransform != textTransform)
-        flags |= Box::NEED_REFLOW;
     if (style->unicodeBidi != unicodeBidi)
         flags |= Box::NEED_REFLOW;
-    if (style->whiteSpace != whiteSpace)
-        flags |= Box::NEED_REFLOW;
-    if (!style->wordSpacing.compare(wordSpacing))
-        flags |= Box::NEED_REFLOW;
 
     // Table related properties
     if (style->display.getValue() == CSSDisplayValueImp::Table || style->display.getValue() == CSSDisplayValueImp::InlineTable) {
-        if (style->borderCollapse != borderCollapse)
+        if (style->tableValues->borderCollapse != tableValues->borderCollapse)
             flags |= Box::NEED_TABLE_REFLOW;
-        if (style->borderSpacing != borderSpacing)
+        if (style->tableValues->borderSpacing != tableValues->borderSpacing)
             flags |= Box::NEED_TABLE_REFLOW;
         if (style->tableLayout != tableLayout)
             flags |= Box::NEED_TABLE_REFLOW;
     }
     if (style->display.getValue() == CSSDisplayValueImp::TableCaption) {
-        if (style->captionSide != captionSide)
+        if (style->tableValues->captionSide != tableValues->captionSide)
             flags |= Box::NEED_TABLE_REFLOW;
     }
 
@@ -457,49 +507,49 @@ CSSPropertyValueImp* CSSStyleDeclarationImp::getProperty(unsigned id)
     case Height:
         return &height;
     case BackgroundAttachment:
-        return &backgroundAttachment;
+        return &backgroundValues.mutate().backgroundAttachment;
     case BackgroundColor:
-        return &backgroundColor;
+        return &backgroundValues.mutate().backgroundColor;
     case BackgroundImage:
-        return &backgroundImage;
+        return &backgroundValues.mutate().backgroundImage;
     case BackgroundPosition:
-        return &backgroundPosition;
+        return &backgroundValues.mutate().backgroundPosition;
     case BackgroundRepeat:
-        return &backgroundRepeat;
+        return &backgroundValues.mutate().backgroundRepeat;
     case Background:
         return &background;
     case BorderCollapse:
-        return &borderCollapse;
+        return &tableValues.mutate().borderCollapse;
     case BorderSpacing:
-        return &borderSpacing;
+        return &tableValues.mutate().borderSpacing;
     case BorderTopColor:
-        return &borderTopColor;
+        return &borderValues.mutate().borderTopColor;
     case BorderRightColor:
-        return &borderRightColor;
+        return &borderValues.mutate().borderRightColor;
     case BorderBottomColor:
-        return &borderBottomColor;
+        return &borderValues.mutate().borderBottomColor;
     case BorderLeftColor:
-        return &borderLeftColor;
+        return &borderValues.mutate().borderLeftColor;
     case BorderColor:
         return &borderColor;
     case BorderTopStyle:
-        return &borderTopStyle;
+        return &borderValues.mutate().borderTopStyle;
     case BorderRightStyle:
-        return &borderRightStyle;
+        return &borderValues.mutate().borderRightStyle;
     case BorderBottomStyle:
-        return &borderBottomStyle;
+        return &borderValues.mutate().borderBottomStyle;
     case BorderLeftStyle:
-        return &borderLeftStyle;
+        return &borderValues.mutate().borderLeftStyle;
     case BorderStyle:
         return &borderStyle;
     case BorderTopWidth:
-        return &borderTopWidth;
+        return &borderValues.mutate().borderTopWidth;
     case BorderRightWidth:
-        return &borderRightWidth;
+        return &borderValues.mutate().borderRightWidth;
     case BorderBottomWidth:
-        return &borderBottomWidth;
+        return &borderValues.mutate().borderBottomWidth;
     case BorderLeftWidth:
-        return &borderLeftWidth;
+        return &borderValues.mutate().borderLeftWidth;
     case BorderWidth:
         return &borderWidth;
     case BorderTop:
@@ -513,7 +563,7 @@ CSSPropertyValueImp* CSSStyleDeclarationImp::getProperty(unsigned id)
     case Border:
         return &border;
     case CaptionSide:
-        return &captionSide;
+        return &tableValues.mutate().captionSide;
     case Clear:
         return &clear;
     case Color:
@@ -521,9 +571,9 @@ CSSPropertyValueImp* CSSStyleDeclarationImp::getProperty(unsigned id)
     case Content:
         return &content;
     case CounterIncrement:
-        return &counterIncrement;
+        return &counterValues.mutate().counterIncrement;
     case CounterReset:
-        return &counterReset;
+        return &counterValues.mutate().counterReset;
     case Cursor:
         return &cursor;
     case Direction:
@@ -531,25 +581,25 @@ CSSPropertyValueImp* CSSStyleDeclarationImp::getProperty(unsigned id)
     case Display:
         return &display;
     case EmptyCells:
-        return &emptyCells;
+        return &tableValues.mutate().emptyCells;
     case Float:
         return &float_;
     case FontFamily:
-        return &fontFamily;
+        return &fontValues.mutate().fontFamily;
     case FontSize:
-        return &fontSize;
+        return &fontValues.mutate().fontSize;
     case FontStyle:
-        return &fontStyle;
+        return &fontValues.mutate().fontStyle;
     case FontVariant:
-        return &fontVariant;
+        return &fontValues.mutate().fontVariant;
     case FontWeight:
-        return &fontWeight;
+        return &fontValues.mutate().fontWeight;
     case Font:
         return &font;
     case LetterSpacing:
-        return &letterSpacing;
+        return &textValues.mutate().letterSpacing;
     case LineHeight:
-        return &lineHeight;
+        return &textValues.mutate().lineHeight;
     case ListStyleImage:
         return &listStyleImage;
     case ListStylePosition:
@@ -577,11 +627,11 @@ CSSPropertyValueImp* CSSStyleDeclarationImp::getProperty(unsigned id)
     case MinWidth:
         return &minWidth;
     case OutlineColor:
-        return &outlineColor;
+        return &outlineValues.mutate().outlineColor;
     case OutlineStyle:
-        return &outlineStyle;
+        return &outlineValues.mutate().outlineStyle;
     case OutlineWidth:
-        return &outlineWidth;
+        return &outlineValues.mutate().outlineWidth;
     case Outline:
         return &outline;
     case Overflow:
@@ -597,11 +647,11 @@ CSSPropertyValueImp* CSSStyleDeclarationImp::getProperty(unsigned id)
     case Padding:
         return &padding;
     case PageBreakAfter:
-        return &pageBreakAfter;
+        return &pageBreakValues.mutate().pageBreakAfter;
     case PageBreakBefore:
-        return &pageBreakBefore;
+        return &pageBreakValues.mutate().pageBreakBefore;
     case PageBreakInside:
-        return &pageBreakInside;
+        return &pageBreakValues.mutate().pageBreakInside;
     case Position:
         return &position;
     case Quotes:
@@ -609,13 +659,13 @@ CSSPropertyValueImp* CSSStyleDeclarationImp::getProperty(unsigned id)
     case TableLayout:
         return &tableLayout;
     case TextAlign:
-        return &textAlign;
+        return &textValues.mutate().textAlign;
     case TextDecoration:
         return &textDecoration;
     case TextIndent:
         return &textIndent;
     case TextTransform:
-        return &textTransform;
+        return &textValues.mutate().textTransform;
     case UnicodeBidi:
         return &unicodeBidi;
     case VerticalAlign:
@@ -623,9 +673,9 @@ CSSPropertyValueImp* CSSStyleDeclarationImp::getProperty(unsigned id)
     case Visibility:
         return &visibility;
     case WhiteSpace:
-        return &whiteSpace;
+        return &textValues.mutate().whiteSpace;
     case WordSpacing:
-        return &wordSpacing;
+        return &textValues.mutate().wordSpacing;
     case ZIndex:
         return &zIndex;
     case Binding:
@@ -639,6 +689,96 @@ CSSPropertyValueImp* CSSStyleDeclarationImp::getProperty(unsigned id)
     }
 }
 
+// Unlike getProperty(), this does not make a private copy of a shared
+// property group.
+const CSSPropertyValueImp* CSSStyleDeclarationImp::getConstProperty(unsigned id) const
+{
+    switch (id) {
+    case BorderCollapse:
+        return &tableValues->borderCollapse;
+    case BorderSpacing:
+        return &tableValues->borderSpacing;
+    case CaptionSide:
+        return &tableValues->captionSide;
+    case EmptyCells:
+        return &tableValues->emptyCells;
+    case CounterIncrement:
+        return &counterValues->counterIncrement;
+    case CounterReset:
+        return &counterValues->counterReset;
+    case PageBreakAfter:
+        return &pageBreakValues->pageBreakAfter;
+    case PageBreakBefore:
+        return &pageBreakValues->pageBreakBefore;
+    case PageBreakInside:
+        return &pageBreakValues->pageBreakInside;
+    case BackgroundAttachment:
+        return &backgroundValues->backgroundAttachment;
+    case BackgroundColor:
+        return &backgroundValues->backgroundColor;
+    case BackgroundImage:
+        return &backgroundValues->backgroundImage;
+    case BackgroundPosition:
+        return &backgroundValues->backgroundPosition;
+    case BackgroundRepeat:
+        return &backgroundValues->backgroundRepeat;
+    case BorderTopColor:
+        return &borderValues->borderTopColor;
+    case BorderTopStyle:
+        return &borderValues->borderTopStyle;
+    case BorderTopWidth:
+        return &borderValues->borderTopWidth;
+    case BorderRightColor:
+        return &borderValues->borderRightColor;
+    case BorderRightStyle:
+        return &borderValues->borderRightStyle;
+    case BorderRightWidth:
+        return &borderValues->borderRightWidth;
+    case BorderBottomColor:
+        return &borderValues->borderBottomColor;
+    case BorderBottomStyle:
+        return &borderValues->borderBottomStyle;
+    case BorderBottomWidth:
+        return &borderValues->borderBottomWidth;
+    case BorderLeftColor:
+        return &borderValues->borderLeftColor;
+    case BorderLeftStyle:
+        return &borderValues->borderLeftStyle;
+    case BorderLeftWidth:
+        return &borderValues->borderLeftWidth;
+    case OutlineColor:
+        return &outlineValues->outlineColor;
+    case OutlineStyle:
+        return &outlineValues->outlineStyle;
+    case OutlineWidth:
+        return &outlineValues->outlineWidth;
+    case FontFamily:
+        return &fontValues->fontFamily;
+    case FontSize:
+        return &fontValues->fontSize;
+    case FontStyle:
+        return &fontValues->fontStyle;
+    case FontVariant:
+        return &fontValues->fontVariant;
+    case FontWeight:
+        return &fontValues->fontWeight;
+    case LetterSpacing:
+        return &textValues->letterSpacing;
+    case LineHeight:
+        return &textValues->lineHeight;
+    case TextAlign:
+        return &textValues->textAlign;
+    case TextTransform:
+        return &textValues->textTransform;
+    case WhiteSpace:
+        return &textValues->whiteSpace;
+    case WordSpacing:
+        return &textValues->wordSpacing;
+    default:
+        return const_cast<CSSStyleDeclarationImp*>(this)->getProperty(id);
+    }
+}
+
 void CSSStyleDeclarationImp::setInherit(unsigned id)
 {
     inheritSet.set(id);
@@ -923,70 +1063,70 @@ void CSSStyleDeclarationImp::specify(const CSSStyleDeclarationPtr& decl, unsigne
         height.specify(decl->height);
         break;
     case BackgroundAttachment:
-        backgroundAttachment.specify(decl->backgroundAttachment);
+        backgroundValues.mutate().backgroundAttachment.specify(decl->backgroundValues->backgroundAttachment);
         break;
     case BackgroundColor:
-        backgroundColor.specify(decl->backgroundColor);
+        backgroundValues.mutate().backgroundColor.specify(decl->backgroundValues->backgroundColor);
         break;
     case BackgroundImage:
-        backgroundImage.specify(decl->backgroundImage);
+        backgroundValues.mutate().backgroundImage.specify(decl->backgroundValues->backgroundImage);
         break;
     case BackgroundPosition:
-        backgroundPosition.specify(decl->backgroundPosition);
+        backgroundValues.mutate().backgroundPosition.specify(decl->backgroundValues->backgroundPosition);
         break;
     case BackgroundRepeat:
-        backgroundRepeat.specify(decl->backgroundRepeat);
+        backgroundValues.mutate().backgroundRepeat.specify(decl->backgroundValues->backgroundRepeat);
         break;
     case Background:
         background.specify(this, decl);
         break;
     case BorderCollapse:
-        borderCollapse.specify(decl->borderCollapse);
+        tableValues.mutate().borderCollapse.specify(decl->tableValues->borderCollapse);
         break;
     case BorderSpacing:
-        borderSpacing.specify(decl->borderSpacing);
+        tableValues.mutate().borderSpacing.specify(decl->tableValues->borderSpacing);
         break;
     case BorderTopColor:
-        borderTopColor.specify(decl->borderTopColor);
+        borderValues.mutate().borderTopColor.specify(decl->borderValues->borderTopColor);
         break;
     case BorderRightColor:
-        borderRightColor.specify(decl->borderRightColor);
+        borderValues.mutate().borderRightColor.specify(decl->borderValues->borderRightColor);
         break;
     case BorderBottomColor:
-        borderBottomColor.specify(decl->borderBottomColor);
+        borderValues.mutate().borderBottomColor.specify(decl->borderValues->borderBottomColor);
         break;
     case BorderLeftColor:
-        borderLeftColor.specify(decl->borderLeftColor);
+        borderValues.mutate().borderLeftColor.specify(decl->borderValues->borderLeftColor);
         break;
     case BorderColor:
         borderColor.specify(this, decl);
         break;
     case BorderTopStyle:
-        borderTopStyle.specify(decl->borderTopStyle);
+        borderValues.mutate().borderTopStyle.specify(decl->borderValues->borderTopStyle);
         break;
     case BorderRightStyle:
-        borderRightStyle.specify(decl->borderRightStyle);
+        borderValues.mutate().borderRightStyle.specify(decl->borderValues->borderRightStyle);
         break;
     case BorderBottomStyle:
-        borderBottomStyle.specify(decl->borderBottomStyle);
+        borderValues.mutate().borderBottomStyle.specify(decl->borderValues->borderBottomStyle);
         break;
     case BorderLeftStyle:
-        borderLeftStyle.specify(decl->borderLeftStyle);
+        borderValues.mutate().borderLeftStyle.specify(decl->borderValues->borderLeftStyle);
         break;
     case BorderStyle:
         borderStyle.specify(this, decl);
         break;
     case BorderTopWidth:
-        borderTopWidth.specify(decl->borderTopWidth);
+        borderValues.mutate().borderTopWidth.specify(decl->borderValues->borderTopWidth);
         break;
     case BorderRightWidth:
-        borderRightWidth.specify(decl->borderRightWidth);
+        borderValues.mutate().borderRightWidth.specify(decl->borderValues->borderRightWidth);
         break;
     case BorderBottomWidth:
-        borderBottomWidth.specify(decl->borderBottomWidth);
+        borderValues.mutate().borderBottomWidth.specify(decl->borderValues->borderBottomWidth);
         break;
     case BorderLeftWidth:
-        borderLeftWidth.specify(decl->borderLeftWidth);
+        borderValues.mutate().borderLeftWidth.specify(decl->borderValues->borderLeftWidth);
         break;
     case BorderWidth:
         borderWidth.specify(this, decl);
@@ -1007,7 +1147,7 @@ void CSSStyleDeclarationImp::specify(const CSSStyleDeclarationPtr& decl, unsigne
         border.specify(this, decl);
         break;
     case CaptionSide:
-        captionSide.specify(decl->captionSide);
+        tableValues.mutate().captionSide.specify(decl->tableValues->captionSide);
         break;
     case Clear:
         clear.specify(decl->clear);
@@ -1019,10 +1159,10 @@ void CSSStyleDeclarationImp::specify(const CSSStyleDeclarationPtr& decl, unsigne
         content.specify(decl->content);
         break;
     case CounterIncrement:
-        counterIncrement.specify(decl->counterIncrement);
+        counterValues.mutate().counterIncrement.specify(decl->counterValues->counterIncrement);
         break;
     case CounterReset:
-        counterReset.specify(decl->counterReset);
+        counterValues.mutate().counterReset.specify(decl->counterValues->counterReset);
         break;
     case Cursor:
         cursor.specify(decl->cursor);
@@ -1034,34 +1174,34 @@ void CSSStyleDeclarationImp::specify(const CSSStyleDeclarationPtr& decl, unsigne
         display.specify(decl->display);
         break;
     case EmptyCells:
-        emptyCells.specify(decl->emptyCells);
+        tableValues.mutate().emptyCells.specify(decl->tableValues->emptyCells);
         break;
     case Float:
         float_.specify(decl->float_);
         break;
     case FontFamily:
-        fontFamily.specify(decl->fontFamily);
+        fontValues.mutate().fontFamily.specify(decl->fontValues->fontFamily);
         break;
     case FontSize:
-        fontSize.specify(decl->fontSize);
+        fontValues.mutate().fontSize.specify(decl->fontValues->fontSize);
         break;
     case FontStyle:
-        fontStyle.specify(decl->fontStyle);
+        fontValues.mutate().fontStyle.specify(decl->fontValues->fontStyle);
         break;
     case FontVariant:
-        fontVariant.specify(decl->fontVariant);
+        fontValues.mutate().fontVariant.specify(decl->fontValues->fontVariant);
         break;
     case FontWeight:
-        fontWeight.specify(decl->fontWeight);
+        fontValues.mutate().fontWeight.specify(decl->fontValues->fontWeight);
         break;
     case Font:
         font.specify(this, decl);
         break;
     case LetterSpacing:
-        letterSpacing.specify(decl->letterSpacing);
+        textValues.mutate().letterSpacing.specify(decl->textValues->letterSpacing);
         break;
     case LineHeight:
-        lineHeight.specify(decl->lineHeight);
+        textValues.mutate().lineHeight.specify(decl->textValues->lineHeight);
         break;
     case ListStyleImage:
         listStyleImage.specify(decl->listStyleImage);
@@ -1103,13 +1243,13 @@ void CSSStyleDeclarationImp::specify(const CSSStyleDeclarationPtr& decl, unsigne
         minWidth.specify(decl->minWidth);
         break;
     case OutlineColor:
-        outlineColor.specify(decl->outlineColor);
+        outlineValues.mutate().outlineColor.specify(decl->outlineValues->outlineColor);
         break;
     case OutlineStyle:
-        outlineStyle.specify(decl->outlineStyle);
+        outlineValues.mutate().outlineStyle.specify(decl->outlineValues->outlineStyle);
         break;
     case OutlineWidth:
-        outlineWidth.specify(decl->outlineWidth);
+        outlineValues.mutate().outlineWidth.specify(decl->outlineValues->outlineWidth);
         break;
     case Outline:
         outline.specify(this, decl);
@@ -1133,13 +1273,13 @@ void CSSStyleDeclarationImp::specify(const CSSStyleDeclarationPtr& decl, unsigne
         padding.specify(this, decl);
         break;
     case PageBreakAfter:
-        pageBreakAfter.specify(decl->pageBreakAfter);
+        pageBreakValues.mutate().pageBreakAfter.specify(decl->pageBreakValues->pageBreakAfter);
         break;
     case PageBreakBefore:
-        pageBreakBefore.specify(decl->pageBreakBefore);
+        pageBreakValues.mutate().pageBreakBefore.specify(decl->pageBreakValues->pageBreakBefore);
         break;
     case PageBreakInside:
-        pageBreakInside.specify(decl->pageBreakInside);
+        pageBreakValues.mutate().pageBreakInside.specify(decl->pageBreakValues->pageBreakInside);
         break;
     case Position:
         position.specify(decl->position);
@@ -1151,7 +1291,7 @@ void CSSStyleDeclarationImp::specify(const CSSStyleDeclarationPtr& decl, unsigne
         tableLayout.specify(decl->tableLayout);
         break;
     case TextAlign:
-        textAlign.specify(decl->textAlign);
+        textValues.mutate().textAlign.specify(decl->textValues->textAlign);
         break;
     case TextDecoration:
         textDecoration.specify(decl->textDecoration);
@@ -1160,7 +1300,7 @@ void CSSStyleDeclarationImp::specify(const CSSStyleDeclarationPtr& decl, unsigne
         textIndent.specify(decl->textIndent);
         break;
     case TextTransform:
-        textTransform.specify(decl->textTransform);
+        textValues.mutate().textTransform.specify(decl->textValues->textTransform);
         break;
     case UnicodeBidi:
         unicodeBidi.specify(decl->unicodeBidi);
@@ -1172,10 +1312,10 @@ void CSSStyleDeclarationImp::specify(const CSSStyleDeclarationPtr& decl, unsigne
         visibility.specify(decl->visibility);
         break;
     case WhiteSpace:
-        whiteSpace.specify(decl->whiteSpace);
+        textValues.mutate().whiteSpace.specify(decl->textValues->whiteSpace);
         break;
     case WordSpacing:
-        wordSpacing.specify(decl->wordSpacing);
+        textValues.mutate().wordSpacing.specify(decl->textValues->wordSpacing);
         break;
     case ZIndex:
         zIndex.specify(decl->zIndex);
@@ -1258,19 +1398,24 @@ void CSSStyleDeclarationImp::reset(unsigned id)
         height.setValue();
         break;
     case BackgroundAttachment:
-        backgroundAttachment.setValue();
+        if (!backgroundValues.isInitial())
+            backgroundValues.mutate().backgroundAttachment.setValue();
         break;
     case BackgroundColor:
-        backgroundColor.setValue(static_cast<unsigned int>(0x00000000));  // TODO
+        if (!backgroundValues.isInitial())
+            backgroundValues.mutate().backgroundColor.setValue(static_cast<unsigned int>(0x00000000));  // TODO
         break;
     case BackgroundImage:
-        backgroundImage.setValue();
+        if (!backgroundValues.isInitial())
+            backgroundValues.mutate().backgroundImage.setValue();
         break;
     case BackgroundPosition:
-        backgroundPosition.setValue();
+        if (!backgroundValues.isInitial())
+            backgroundValues.mutate().backgroundPosition.setValue();
         break;
     case BackgroundRepeat:
-        backgroundRepeat.setValue();
+        if (!backgroundValues.isInitial())
+            backgroundValues.mutate().backgroundRepeat.setValue();
         break;
     case Background:
         reset(BackgroundAttachment);
@@ -1280,22 +1425,28 @@ void CSSStyleDeclarationImp::reset(unsigned id)
         reset(BackgroundRepeat);
         break;
     case BorderCollapse:
-        borderCollapse.setValue();
+        if (!tableValues.isInitial())
+            tableValues.mutate().borderCollapse.setValue();
         break;
     case BorderSpacing:
-        borderSpacing.setValue();
+        if (!tableValues.isInitial())
+            tableValues.mutate().borderSpacing.setValue();
         break;
     case BorderTopColor:
-        borderTopColor.reset();
+        if (!borderValues.isInitial())
+            borderValues.mutate().borderTopColor.reset();
         break;
     case BorderRightColor:
-        borderRightColor.reset();
+        if (!borderValues.isInitial())
+            borderValues.mutate().borderRightColor.reset();
         break;
     case BorderBottomColor:
-        borderBottomColor.reset();
+        if (!borderValues.isInitial())
+            borderValues.mutate().borderBottomColor.reset();
         break;
     case BorderLeftColor:
-        borderLeftColor.reset();
+        if (!borderValues.isInitial())
+            borderValues.mutate().borderLeftColor.reset();
         break;
     case BorderColor:
         reset(BorderTopColor);
@@ -1304,16 +1455,20 @@ void CSSStyleDeclarationImp::reset(unsigned id)
         reset(BorderLeftColor);
         break;
     case BorderTopStyle:
-        borderTopStyle.setValue();
+        if (!borderValues.isInitial())
+            borderValues.mutate().borderTopStyle.setValue();
         break;
     case BorderRightStyle:
-        borderRightStyle.setValue();
+        if (!borderValues.isInitial())
+            borderValues.mutate().borderRightStyle.setValue();
         break;
     case BorderBottomStyle:
-        borderBottomStyle.setValue();
+        if (!borderValues.isInitial())
+            borderValues.mutate().borderBottomStyle.setValue();
         break;
     case BorderLeftStyle:
-        borderLeftStyle.setValue();
+        if (!borderValues.isInitial())
+            borderValues.mutate().borderLeftStyle.setValue();
         break;
     case BorderStyle:
         reset(BorderTopStyle);
@@ -1322,16 +1477,20 @@ void CSSStyleDeclarationImp::reset(unsigned id)
         reset(BorderLeftStyle);
         break;
     case BorderTopWidth:
-        borderTopWidth.setValue();
+        if (!borderValues.isInitial())
+            borderValues.mutate().borderTopWidth.setValue();
         break;
     case BorderRightWidth:
-        borderRightWidth.setValue();
+        if (!borderValues.isInitial())
+            borderValues.mutate().borderRightWidth.setValue();
         break;
     case BorderBottomWidth:
-        borderBottomWidth.setValue();
+        if (!borderValues.isInitial())
+            borderValues.mutate().borderBottomWidth.setValue();
         break;
     case BorderLeftWidth:
-        borderLeftWidth.setValue();
+        if (!borderValues.isInitial())
+            borderValues.mutate().borderLeftWidth.setValue();
         break;
     case BorderWidth:
         reset(BorderTopWidth);
@@ -1365,7 +1524,8 @@ void CSSStyleDeclarationImp::reset(unsigned id)
         reset(BorderWidth);
         break;
     case CaptionSide:
-        captionSide.setValue();
+        if (!tableValues.isInitial())
+            tableValues.mutate().captionSide.setValue();
         break;
     case Clear:
         clear.setValue();
@@ -1377,10 +1537,12 @@ void CSSStyleDeclarationImp::reset(unsigned id)
         content.reset();
         break;
     case CounterIncrement:
-        counterIncrement.reset();
+        if (!counterValues.isInitial())
+            counterValues.mutate().counterIncrement.reset();
         break;
     case CounterReset:
-        counterReset.reset();
+        if (!counterValues.isInitial())
+            counterValues.mutate().counterReset.reset();
         break;
     case Cursor:
         cursor.reset();
@@ -1392,34 +1554,42 @@ void CSSStyleDeclarationImp::reset(unsigned id)
         display.setValue();
         break;
     case EmptyCells:
-        emptyCells.setValue();
+        if (!tableValues.isInitial())
+            tableValues.mutate().emptyCells.setValue();
         break;
     case Float:
         float_.setValue();
         break;
     case FontFamily:
-        fontFamily.reset();
+        if (!fontValues.isInitial())
+            fontValues.mutate().fontFamily.reset();
         break;
     case FontSize:
-        fontSize.setValue();
+        if (!fontValues.isInitial())
+            fontValues.mutate().fontSize.setValue();
         break;
     case FontStyle:
-        fontStyle.setValue();
+        if (!fontValues.isInitial())
+            fontValues.mutate().fontStyle.setValue();
         break;
     case FontVariant:
-        fontVariant.setValue();
+        if (!fontValues.isInitial())
+            fontValues.mutate().fontVariant.setValue();
         break;
     case FontWeight:
-        fontWeight.setValue();
+        if (!fontValues.isInitial())
+            fontValues.mutate().fontWeight.setValue();
         break;
     case Font:
         font.reset(this);
         break;
     case LetterSpacing:
-        letterSpacing.setValue();
+        if (!textValues.isInitial())
+            textValues.mutate().letterSpacing.setValue();
         break;
     case LineHeight:
-        lineHeight.setValue();
+        if (!textValues.isInitial())
+            textValues.mutate().lineHeight.setValue();
         break;
     case ListStyleImage:
         listStyleImage.setValue();
@@ -1466,18 +1636,21 @@ void CSSStyleDeclarationImp::reset(unsigned id)
         minWidth.setValue(0.0f, css::CSSPrimitiveValue::CSS_PX);
         break;
     case OutlineColor:
-        outlineColor.setValue();
+        if (!outlineValues.isInitial())
+            outlineValues.mutate().outlineColor.setValue();
         break;
     case OutlineStyle:
-        outlineStyle.setValue();
+        if (!outlineValues.isInitial())
+            outlineValues.mutate().outlineStyle.setValue();
         break;
     case OutlineWidth:
-        outlineWidth.setValue();
+        if (!outlineValues.isInitial())
+            outlineValues.mutate().outlineWidth.setValue();
         break;
     case Outline:
-        outlineColor.setValue();
-        outlineStyle.setValue();
-        outlineWidth.setValue();
+        reset(OutlineColor);
+        reset(OutlineStyle);
+        reset(OutlineWidth);
         break;
     case Overflow:
         overflow.setValue();
@@ -1501,13 +1674,16 @@ void CSSStyleDeclarationImp::reset(unsigned id)
         reset(PaddingLeft);
         break;
     case PageBreakAfter:
-        pageBreakAfter.setValue();
+        if (!pageBreakValues.isInitial())
+            pageBreakValues.mutate().pageBreakAfter.setValue();
         break;
     case PageBreakBefore:
-        pageBreakBefore.setValue();
+        if (!pageBreakValues.isInitial())
+            pageBreakValues.mutate().pageBreakBefore.setValue();
         break;
     case PageBreakInside:
-        pageBreakInside.setValue();
+        if (!pageBreakValues.isInitial())
+            pageBreakValues.mutate().pageBreakInside.setValue();
         break;
     case Position:
         position.setValue();
@@ -1519,7 +1695,8 @@ void CSSStyleDeclarationImp::reset(unsigned id)
         tableLayout.setValue();
         break;
     case TextAlign:
-        textAlign.setValue();
+        if (!textValues.isInitial())
+            textValues.mutate().textAlign.setValue();
         break;
     case TextDecoration:
         textDecoration.setValue();
@@ -1528,7 +1705,8 @@ void CSSStyleDeclarationImp::reset(unsigned id)
         textIndent.setValue(0.0f, css::CSSPrimitiveValue::CSS_PX);
         break;
     case TextTransform:
-        textTransform.setValue();
+        if (!textValues.isInitial())
+            textValues.mutate().textTransform.setValue();
         break;
     case UnicodeBidi:
         unicodeBidi.setValue();
@@ -1540,10 +1718,12 @@ void CSSStyleDeclarationImp::reset(unsigned id)
         visibility.setValue();
         break;
     case WhiteSpace:
-        whiteSpace.setValue();
+        if (!textValues.isInitial())
+            textValues.mutate().whiteSpace.setValue();
         break;
     case WordSpacing:
-        wordSpacing.setValue();
+        if (!textValues.isInitial())
+            textValues.mutate().wordSpacing.setValue();
         break;
     case ZIndex:
         zIndex.setValue();
@@ -1631,31 +1811,31 @@ void CSSStyleDeclarationImp::inherit(const CSSStyleDeclarationPtr& parentStyle,
         height.inherit(parentStyle->height);
         break;
     case BackgroundPosition:
-        backgroundPosition.inherit(parentStyle->backgroundPosition);
+        backgroundValues.mutate().backgroundPosition.inherit(parentStyle->backgroundValues->backgroundPosition);
         break;
     case BorderTopWidth:
-        borderTopWidth.inherit(parentStyle->borderTopWidth);
+        borderValues.mutate().borderTopWidth.inherit(parentStyle->borderValues->borderTopWidth);
         break;
     case BorderRightWidth:
-        borderRightWidth.inherit(parentStyle->borderRightWidth);
+        borderValues.mutate().borderRightWidth.inherit(parentStyle->borderValues->borderRightWidth);
         break;
     case BorderBottomWidth:
-        borderBottomWidth.inherit(parentStyle->borderBottomWidth);
+        borderValues.mutate().borderBottomWidth.inherit(parentStyle->borderValues->borderBottomWidth);
         break;
     case BorderLeftWidth:
-        borderLeftWidth.inherit(parentStyle->borderLeftWidth);
+        borderValues.mutate().borderLeftWidth.inherit(parentStyle->borderValues->borderLeftWidth);
         break;
     case BorderSpacing:
-        borderSpacing.inherit(parentStyle->borderSpacing);
+        tableValues.mutate().borderSpacing.inherit(parentStyle->tableValues->borderSpacing);
         break;
     case FontSize:
-        fontSize.inherit(parentStyle->fontSize);
+        fontValues.mutate().fontSize.inherit(parentStyle->fontValues->fontSize);
         break;
     case LetterSpacing:
-        letterSpacing.inherit(parentStyle->letterSpacing);
+        textValues.mutate().letterSpacing.inherit(parentStyle->textValues->letterSpacing);
         break;
     case LineHeight:
-        lineHeight.inherit(parentStyle->lineHeight);
+        textValues.mutate().lineHeight.inherit(parentStyle->textValues->lineHeight);
         break;
     case MarginTop:
         marginTop.inherit(parentStyle->marginTop);
@@ -1682,7 +1862,7 @@ void CSSStyleDeclarationImp::inherit(const CSSStyleDeclarationPtr& parentStyle,
         minWidth.inherit(parentStyle->minWidth);
         break;
     case OutlineWidth:
-        outlineWidth.inherit(parentStyle->outlineWidth);
+        outlineValues.mutate().outlineWidth.inherit(parentStyle->outlineValues->outlineWidth);
         break;
     case PaddingTop:
         paddingTop.inherit(parentStyle->paddingTop);
@@ -1703,7 +1883,7 @@ void CSSStyleDeclarationImp::inherit(const CSSStyleDeclarationPtr& parentStyle,
         verticalAlign.inherit(parentStyle->verticalAlign);
         break;
     case WordSpacing:
-        wordSpacing.inherit(parentStyle->wordSpacing);
+        textValues.mutate().wordSpacing.inherit(parentStyle->textValues->wordSpacing);
         break;
     default:
         specify(parentStyle, id);
@@ -1714,8 +1894,49 @@ void CSSStyleDeclarationImp::inherit(const CSSStyleDeclarationPtr& parentStyle,
 void CSSStyleDeclarationImp::inheritProperties(const CSSStyleDeclarationPtr& parentStyle)
 {
     assert(parentStyle);
-    for (unsigned id = 1; id < MaxProperties; ++id)
-        inherit(parentStyle, id);
+    std::bitset<MaxProperties> set(inheritSet);
+    // Share a property group with the parent style as a whole if every
+    // property in the group is inherited.
+    if ((set & TableProperties) == TableProperties) {
+        tableValues.share(parentStyle->tableValues);
+        set &= ~TableProperties;
+    }
+    if ((set & CounterProperties) == CounterProperties) {
+        counterValues.share(parentStyle->counterValues);
+        set &= ~CounterProperties;
+    }
+    if ((set & PageBreakProperties) == PageBreakProperties) {
+        pageBreakValues.share(parentStyle->pageBreakValues);
+        set &= ~PageBreakProperties;
+    }
+    if ((set & BackgroundProperties) == BackgroundProperties) {
+        backgroundValues.share(parentStyle->backgroundValues);
+        set &= ~BackgroundProperties;
+    }
+    if ((set & BorderProperties) == BorderProperties) {
+        borderValues.share(parentStyle->borderValues);
+        set &= ~BorderProperties;
+    }
+    if ((set & OutlineProperties) == OutlineProperties) {
+        outlineValues.share(parentStyle->outlineValues);
+        set &= ~OutlineProperties;
+    }
+    if ((set & FontProperties) == FontProperties) {
+        fontValues.share(parentStyle->fontValues);
+        set &= ~FontProperties;
+        // 'line-height' is resolved against the font, and the text values
+        // can be shared only with the same font.
+        if ((set & TextProperties) == TextProperties) {
+            textValues.share(parentStyle->textValues);
+            set &= ~TextProperties;
+        }
+    }
+    if (set.none())
+        return;
+    for (unsigned id = 1; id < MaxProperties; ++id) {
+        if (set.test(id))
+            inherit(parentStyle, id);
+    }
 }
 
 void CSSStyleDeclarationImp::dump(const std::string& indent)
@@ -1749,6 +1970,14 @@ void CSSStyleDeclarationImp::compute(ViewCSSImp* view, const CSSStyleDeclaration
     if (getPseudoElementSelectorType() == CSSPseudoElementSelector::NonPseudo) {
         initialize();
         // TODO: Do the same for pseudo elements:
+        tableValues.reset();
+        counterValues.reset();
+        pageBreakValues.reset();
+        backgroundValues.reset();
+        borderValues.reset();
+        outlineValues.reset();
+        fontValues.reset();
+        textValues.reset();
         for (unsigned i = 1; i < MaxProperties; ++i)
             reset(i);
         CSSStyleDeclarationPtr elementDecl;
@@ -1793,24 +2022,34 @@ void CSSStyleDeclarationImp::compute(ViewCSSImp* view, const CSSStyleDeclaration
     else
         inheritProperties(parentStyle);
 
-    backgroundColor.compute();
-    borderTopStyle.compute();
-    borderRightStyle.compute();
-    borderBottomStyle.compute();
-    borderLeftStyle.compute();
+    // A group shared with the parent style has been computed already, and
+    // the initial background, border and outline values need no computation.
+    if (!backgroundValues.isInitial() && (!parentStyle || !backgroundValues.isSharedWith(parentStyle->backgroundValues))) {
+        CSSBackgroundValues& values = backgroundValues.mutate();
+        values.backgroundColor.compute();
+        values.backgroundImage.compute(view);
+        values.backgroundPosition.compute(view, this);
+    }
     color.compute();
-    outlineColor.compute();
-    outlineStyle.compute();
 
     visibility.compute();
     opacity.compute(view, this);
     opacity.clip(0.0f, 1.0f);
 
     display.compute(this, element);
-    fontSize.compute(view, parentStyle);
-    fontWeight.compute(view, parentStyle);
+    if (!parentStyle || !fontValues.isSharedWith(parentStyle->fontValues)) {
+        CSSFontValues& values = fontValues.mutate();
+        values.fontSize.compute(view, parentStyle);
+        values.fontWeight.compute(view, parentStyle);
+    }
     fontTexture = view->selectFont(getCSSStyleDeclarationPtr());
-    lineHeight.compute(view, this);
+    if (!parentStyle || !textValues.isSharedWith(parentStyle->textValues)) {
+        CSSTextValues& values = textValues.mutate();
+        values.lineHeight.compute(view, this);
+        values.lineHeight.resolve(view, this);
+        values.letterSpacing.compute(view, this);
+        values.wordSpacing.compute(view, this);
+    }
     verticalAlign.compute(view, this);
 
     width.compute(view, this);
@@ -1832,34 +2071,38 @@ void CSSStyleDeclarationImp::compute(ViewCSSImp* view, const CSSStyleDeclaration
     marginLeft.compute(view, this);
 
     // CSS3 would allow percentages in border width, the resolved values of these should be the used values, too.
-    borderTopWidth.compute(view, borderTopStyle, this);
-    borderRightWidth.compute(view, borderRightStyle, this);
-    borderBottomWidth.compute(view, borderBottomStyle, this);
-    borderLeftWidth.compute(view, borderLeftStyle, this);
-    outlineWidth.compute(view, outlineStyle, this);
+    if (!borderValues.isInitial() && (!parentStyle || !borderValues.isSharedWith(parentStyle->borderValues))) {
+        CSSBorderValues& values = borderValues.mutate();
+        values.borderTopStyle.compute();
+        values.borderRightStyle.compute();
+        values.borderBottomStyle.compute();
+        values.borderLeftStyle.compute();
+        values.borderTopWidth.compute(view, values.borderTopStyle, this);
+        values.borderRightWidth.compute(view, values.borderRightStyle, this);
+        values.borderBottomWidth.compute(view, values.borderBottomStyle, this);
+        values.borderLeftWidth.compute(view, values.borderLeftStyle, this);
+    }
+    if (!outlineValues.isInitial() && (!parentStyle || !outlineValues.isSharedWith(parentStyle->outlineValues))) {
+        CSSOutlineValues& values = outlineValues.mutate();
+        values.outlineColor.compute();
+        values.outlineStyle.compute();
+        values.outlineWidth.compute(view, values.outlineStyle, this);
+    }
 
     paddingTop.compute(view, this);
     paddingRight.compute(view, this);
     paddingBottom.compute(view, this);
     paddingLeft.compute(view, this);
 
-    borderTopColor.compute(this);
-    borderRightColor.compute(this);
-    borderBottomColor.compute(this);
-    borderLeftColor.compute(this);
-
-    backgroundImage.compute(view);
-    backgroundPosition.compute(view, this);
-
-    borderSpacing.compute(view, this);
+    // 'border-spacing' has been computed already unless it is specified for this style.
+    if (!tableValues.isInitial() && (!parentStyle || !tableValues.isSharedWith(parentStyle->tableValues)))
+        tableValues.mutate().borderSpacing.compute(view, this);
 
     listStyleImage.compute(view, this);
     listStylePosition.compute(view, this);
     content.compute(view, this);
 
     textIndent.compute(view, this);
-    letterSpacing.compute(view, this);
-    wordSpacing.compute(view, this);
 
     if (isFloat() || isAbsolutelyPositioned() || !parentStyle || isInlineBlock())
         textDecorationContext.update(this);
@@ -1878,15 +2121,11 @@ void CSSStyleDeclarationImp::compute(ViewCSSImp* view, const CSSStyleDeclaration
         body->compute(view, getCSSStyleDeclarationPtr(), view->getDocument()->getBody());
         if (overflow.getValue() == CSSOverflowValueImp::Visible)
             overflow.useBodyValue(body->overflow);
-        if (backgroundColor.getARGB() == 0 && backgroundImage.isNone()) {
-            background.specify(this, body);
-            body->fontSize.compute(view, getCSSStyleDeclarationPtr());
-            backgroundImage.compute(view);
-            // Note if the lengths are given by 'em' or 'ex', the referred font size is
-            // the one of the 'body' style.
-            backgroundPosition.compute(view, body.get());
-            body->backgroundColor.setValue(CSSColorValueImp::Transparent);
-            body->backgroundImage.setValue();
+        if (backgroundValues->backgroundColor.getARGB() == 0 && backgroundValues->backgroundImage.isNone()) {
+            // Note the body background values have been computed with the
+            // 'body' style, which is also the one referred to by 'em' and 'ex'.
+            backgroundValues.share(body->backgroundValues);
+            body->backgroundValues.reset();
         }
     }
 
@@ -1933,12 +2172,12 @@ bool CSSStyleDeclarationImp::updateCounters(ViewCSSImp* view, CSSAutoNumberingVa
             updated = true;
         }
     }
-    if (counterReset.hasCounter()) {
-        counterReset.resetCounter(view, context);
+    if (counterValues->counterReset.hasCounter()) {
+        counterValues->counterReset.resetCounter(view, context);
         updated = true;
     }
-    if (counterIncrement.hasCounter()) {
-        counterIncrement.incrementCounter(view, context);
+    if (counterValues->counterIncrement.hasCounter()) {
+        counterValues->counterIncrement.incrementCounter(view, context);
         updated = true;
     }
     return updated;
@@ -1978,19 +2217,18 @@ unsigned CSSStyleDeclarationImp::resolve(ViewCSSImp* view, const ContainingBlock
         if (!propertySet.test(TextAlign) && !inheritSet.test(TextAlign)) {
             switch (htmlAlign.getValue()) {
             case HTMLAlignValueImp::Left:
-                textAlign.setValue(CSSTextAlignValueImp::Left);
+                textValues.mutate().textAlign.setValue(CSSTextAlignValueImp::Left);
                 break;
             case HTMLAlignValueImp::Center:
-                textAlign.setValue(CSSTextAlignValueImp::Center);
+                textValues.mutate().textAlign.setValue(CSSTextAlignValueImp::Center);
                 break;
             case HTMLAlignValueImp::Right:
-                textAlign.setValue(CSSTextAlignValueImp::Right);
+                textValues.mutate().textAlign.setValue(CSSTextAlignValueImp::Right);
                 break;
             }
         }
     }
 
-    lineHeight.resolve(view, this);
     verticalAlign.resolve(view, this);
 
     bool nonExplicitWidth = false;
@@ -2090,7 +2328,7 @@ bool CSSStyleDeclarationImp::resolveRelativeOffset(float& x, float &y)
 
 size_t CSSStyleDeclarationImp::processWhiteSpace(std::u16string& data, char16_t& prevChar)
 {
-    unsigned prop = whiteSpace.getValue();
+    unsigned prop = textValues->whiteSpace.getValue();
     switch (prop) {
     case CSSWhiteSpaceValueImp::Normal:
     case CSSWhiteSpaceValueImp::Nowrap:
@@ -2163,7 +2401,7 @@ size_t CSSStyleDeclarationImp::processWhiteSpace(std::u16string& data, char16_t&
 
 size_t CSSStyleDeclarationImp::skipWhiteSpace(const std::u16string& data, size_t position)
 {
-    if (!whiteSpace.isCollapsingSpace())
+    if (!textValues->whiteSpace.isCollapsingSpace())
         return position;
 
     size_t offset(position);
@@ -2177,7 +2415,7 @@ size_t CSSStyleDeclarationImp::skipWhiteSpace(const std::u16string& data, size_t
             u = '\n';
             // FALL THROUGH
         case '\n':
-            if (whiteSpace.getValue() != CSSWhiteSpaceValueImp::PreLine)
+            if (textValues->whiteSpace.getValue() != CSSWhiteSpaceValueImp::PreLine)
                 u = ' ';
             break;
         default:
@@ -2387,6 +2625,43 @@ void CSSStyleDeclarationImp::requestReconstruct(unsigned short flags)
     }
 }
 
+void CSSStyleDeclarationImp::requestRepaint()
+{
+    for (auto i = boxList.begin(); i != boxList.end(); i->expired() ? (i = boxList.erase(i)) : ++i) {
+        BoxPtr box = i->lock();
+        while (box && !std::dynamic_pointer_cast<Block>(box))
+            box = box->getParentBox();
+        if (box)
+            box->setFlags(Box::NEED_REPAINT);
+    }
+}
+
+size_t CSSStyleDeclarationImp::getMemoryUsage(std::set<const void*>& groups) const
+{
+    return sizeof *this +
+           tableValues.getMemoryUsage(groups) +
+           counterValues.getMemoryUsage(groups) +
+           pageBreakValues.getMemoryUsage(groups) +
+           backgroundValues.getMemoryUsage(groups) +
+           borderValues.getMemoryUsage(groups) +
+           outlineValues.getMemoryUsage(groups) +
+           fontValues.getMemoryUsage(groups) +
+           textValues.getMemoryUsage(groups);
+}
+
+size_t CSSStyleDeclarationImp::getUnsharedMemoryUsage()
+{
+    return sizeof(CSSStyleDeclarationImp) +
+           sizeof(CSSTableValues) +
+           sizeof(CSSCounterValues) +
+           sizeof(CSSPageBreakValues) +
+           sizeof(CSSBackgroundValues) +
+           sizeof(CSSBorderValues) +
+           sizeof(CSSOutlineValues) +
+           sizeof(CSSFontValues) +
+           sizeof(CSSTextValues);
+}
+
 void CSSStyleDeclarationImp::clearFlags(unsigned f)
 {
     flags &= ~f;
@@ -2486,7 +2761,7 @@ char32_t CSSStyleDeclarationImp::nextChar(const std::u16string& s, size_t& offse
     for (;;) {
         position = offset;
         u = ::nextChar(s, offset);
-        switch (textTransform.getValue()) {
+        switch (textValues->textTransform.getValue()) {
         case CSSTextTransformValueImp::Capitalize:
             if (isFirstLetter && !u_ispunct(u))
                 u = u_totitle(u);
@@ -2500,7 +2775,7 @@ char32_t CSSStyleDeclarationImp::nextChar(const std::u16string& s, size_t& offse
         default:  // None
             break;
         }
-        if (whiteSpace.isCollapsingSpace()) {
+        if (textValues->whiteSpace.isCollapsingSpace()) {
             switch (u) {
             case '\t':
                 u = ' ';
@@ -2509,7 +2784,7 @@ char32_t CSSStyleDeclarationImp::nextChar(const std::u16string& s, size_t& offse
                 u = '\n';
                 // FALL THROUGH
             case '\n':
-                if (whiteSpace.getValue() != CSSWhiteSpaceValueImp::PreLine)
+                if (textValues->whiteSpace.getValue() != CSSWhiteSpaceValueImp::PreLine)
                     u = ' ';
                 break;
             default:
@@ -2519,7 +2794,7 @@ char32_t CSSStyleDeclarationImp::nextChar(const std::u16string& s, size_t& offse
                 ++spaceCount;
                 continue;
             }
-        } else if (u == ' ' && !whiteSpace.isBreakingLines())
+        } else if (u == ' ' && !textValues->whiteSpace.isBreakingLines())
             u = u'\u00A0';  // NBSP; cf. html4/white-space-mixed-002.htm
         break;
     }
@@ -2612,7 +2887,7 @@ float CSSStyleDeclarationImp::measureText(ViewCSSImp* view,
         if (u == '\n' || u == u'\u200B')
             continue;
         char32_t caps = u;
-        if (fontVariant.getValue() == CSSFontVariantValueImp::SmallCaps)
+        if (fontValues->fontVariant.getValue() == CSSFontVariantValueImp::SmallCaps)
             caps = u_toupper(u);
         FontTexture* currentFont = font;
         glyph = font->getGlyph(caps);
@@ -2632,9 +2907,9 @@ float CSSStyleDeclarationImp::measureText(ViewCSSImp* view,
         else
             width += glyph->advance * currentFont->getScale(point) * currentFont->getSmallCapsScale();
         if (u == ' ' || u == u'\u00A0')  // SP or NBSP
-            width += wordSpacing.getPx();
-        if (!letterSpacing.isNormal())
-            width += letterSpacing.getPx();
+            width += textValues->wordSpacing.getPx();
+        if (!textValues->letterSpacing.isNormal())
+            width += textValues->letterSpacing.getPx();
     }
     return width;
 }
@@ -2651,7 +2926,7 @@ std::u16string CSSStyleDeclarationImp::getCssText()
         if (propertySet.test(i) || importantSet.test(i)) {
             if (inheritSet.test(i))
                 text += separator + getPropertyName(i) + u": inherit";
-            else if (CSSPropertyValueImp* property = getProperty(i)) {
+            else if (const CSSPropertyValueImp* property = getConstProperty(i)) {
                 text += separator + getPropertyName(i) + u": ";
                 text += property->getCssText(this);
             } else {
@@ -2685,13 +2960,13 @@ std::u16string CSSStyleDeclarationImp::item(unsigned int index)
             if (WindowProxyPtr window = document->getDefaultWindow())
                 window->updateView();
         }
-        return getProperty(index)->getCssText(this);
+        return getConstProperty(index)->getCssText(this);
     }
 
     if (inheritSet.test(index))
         return u"inherit";
     if (propertySet.test(index))
-        return getProperty(index)->getCssText(this);
+        return getConstProperty(index)->getCssText(this);
     return u"";
 }
 
@@ -4187,13 +4462,10 @@ CSSStyleDeclarationImp::CSSStyleDeclarationImp(int pseudoElementSelectorType) :
     pseudoElementSelectorType(pseudoElementSelectorType),
     containingBlockWidth(0.0f),
     containingBlockHeight(0.0f),
-    backgroundColor(CSSColorValueImp::Transparent),
     borderTop(0),
     borderRight(1),
     borderBottom(2),
     borderLeft(3),
-    counterIncrement(1),
-    counterReset(0),
     marginTop(0.0f, css::CSSPrimitiveValue::CSS_PX),
     marginRight(0.0f, css::CSSPrimitiveValue::CSS_PX),
     marginBottom(0.0f, css::CSSPrimitiveValue::CSS_PX),
@@ -4220,13 +4492,10 @@ CSSStyleDeclarationImp::CSSStyleDeclarationImp(const CSSStyleDeclarationPtr& org
     pseudoElementSelectorType(org->pseudoElementSelectorType),
     containingBlockWidth(0.0f),
     containingBlockHeight(0.0f),
-    backgroundColor(CSSColorValueImp::Transparent),
     borderTop(0),
     borderRight(1),
     borderBottom(2),
     borderLeft(3),
-    counterIncrement(1),
-    counterReset(0),
     marginTop(0.0f, css::CSSPrimitiveValue::CSS_PX),
     marginRight(0.0f, css::CSSPrimitiveValue::CSS_PX),
     marginBottom(0.0f, css::CSSPrimitiveValue::CSS_PX),
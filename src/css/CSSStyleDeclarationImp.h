@@ -28,6 +28,8 @@
 #include <bitset>
 #include <list>
 #include <map>
+#include <memory>
+#include <set>
 
 #include "CSSParser.h"
 #include "CSSPropertyValueImp.h"
@@ -49,35 +51,248 @@ class CSSStyleDeclarationImp;
 typedef std::shared_ptr<CSSStyleDeclarationImp> CSSStyleDeclarationPtr;
 typedef std::shared_ptr<ContainingBlock> ContainingBlockPtr;
 
+// CSSPropertyGroup holds a group of property values that can be shared among
+// styles, e.g., between a style and its parent style if every property in the
+// group is inherited, or among the styles in which the properties have their
+// initial values. A shared group is never modified; mutate() makes a private
+// copy of the group first if it is shared (copy-on-write).
+//
+// The values kept in a group must not depend on anything but the group
+// itself and the parent style: the border colors defaulting to 'color' are
+// resolved when they are used, and the background position is resolved into
+// the box. The text values are shared only together with the font values as
+// 'line-height' is resolved against the font. The box values (margins,
+// paddings, widths and heights) and 'text-indent' are resolved against the
+// containing block of each style, and are kept in the style itself.
+template <typename T>
+class CSSPropertyGroup
+{
+    std::shared_ptr<T> group;
+
+    static const std::shared_ptr<T>& getInitial() {
+        static const std::shared_ptr<T> initial(std::make_shared<T>());
+        return initial;
+    }
+
+public:
+    CSSPropertyGroup() :
+        group(getInitial())
+    {
+    }
+
+    const T* operator->() const {
+        return group.get();
+    }
+    const T& get() const {
+        return *group;
+    }
+    T& mutate() {
+        if (!group.unique())
+            group = std::make_shared<T>(*group);
+        return *group;
+    }
+
+    void share(const CSSPropertyGroup& other) {
+        group = other.group;
+    }
+    void reset() {
+        group = getInitial();
+    }
+    bool isInitial() const {
+        return group == getInitial();
+    }
+    bool isSharedWith(const CSSPropertyGroup& other) const {
+        return group == other.group;
+    }
+
+    // Returns the size of the group unless it is already in groups.
+    size_t getMemoryUsage(std::set<const void*>& groups) const {
+        return groups.insert(group.get()).second ? sizeof(T) : 0;
+    }
+};
+
+// 'border-collapse', 'border-spacing', 'caption-side' and 'empty-cells', which
+// are all inherited.
+struct CSSTableValues
+{
+    CSSBorderCollapseValueImp borderCollapse;
+    CSSBorderSpacingValueImp borderSpacing;
+    CSSCaptionSideValueImp captionSide;
+    CSSEmptyCellsValueImp emptyCells;
+
+    CSSTableValues() {}
+    CSSTableValues(const CSSTableValues& other) {
+        borderCollapse.specify(other.borderCollapse);
+        borderSpacing.specify(other.borderSpacing);
+        captionSide.specify(other.captionSide);
+        emptyCells.specify(other.emptyCells);
+    }
+};
+
+// 'counter-increment' and 'counter-reset'
+struct CSSCounterValues
+{
+    CSSAutoNumberingValueImp counterIncrement;
+    CSSAutoNumberingValueImp counterReset;
+
+    CSSCounterValues() :
+        counterIncrement(1),
+        counterReset(0)
+    {}
+    CSSCounterValues(const CSSCounterValues& other) :
+        counterIncrement(1),
+        counterReset(0)
+    {
+        counterIncrement.specify(other.counterIncrement);
+        counterReset.specify(other.counterReset);
+    }
+};
+
+// 'page-break-after', 'page-break-before' and 'page-break-inside'
+struct CSSPageBreakValues
+{
+    CSSPageBreakValueImp pageBreakAfter;
+    CSSPageBreakValueImp pageBreakBefore;
+    CSSPageBreakValueImp pageBreakInside;
+
+    CSSPageBreakValues() {}
+    CSSPageBreakValues(const CSSPageBreakValues& other) {
+        pageBreakAfter.specify(other.pageBreakAfter);
+        pageBreakBefore.specify(other.pageBreakBefore);
+        pageBreakInside.specify(other.pageBreakInside);
+    }
+};
+
+// 'background-attachment', 'background-color', 'background-image',
+// 'background-position' and 'background-repeat'
+struct CSSBackgroundValues
+{
+    CSSBackgroundAttachmentValueImp backgroundAttachment;
+    CSSColorValueImp backgroundColor;
+    CSSBackgroundImageValueImp backgroundImage;
+    CSSBackgroundPositionValueImp backgroundPosition;
+    CSSBackgroundRepeatValueImp backgroundRepeat;
+
+    CSSBackgroundValues() :
+        backgroundColor(CSSColorValueImp::Transparent)
+    {}
+    CSSBackgroundValues(const CSSBackgroundValues& other) {
+        backgroundAttachment.specify(other.backgroundAttachment);
+        backgroundColor.specify(other.backgroundColor);
+        backgroundImage.specify(other.backgroundImage);
+        backgroundPosition.specify(other.backgroundPosition);
+        backgroundRepeat.specify(other.backgroundRepeat);
+    }
+};
+
+// 'border-*-color', 'border-*-style' and 'border-*-width'
+struct CSSBorderValues
+{
+    CSSBorderColorValueImp borderTopColor;
+    CSSBorderColorValueImp borderRightColor;
+    CSSBorderColorValueImp borderBottomColor;
+    CSSBorderColorValueImp borderLeftColor;
+    CSSBorderStyleValueImp borderTopStyle;
+    CSSBorderStyleValueImp borderRightStyle;
+    CSSBorderStyleValueImp borderBottomStyle;
+    CSSBorderStyleValueImp borderLeftStyle;
+    CSSBorderWidthValueImp borderTopWidth;
+    CSSBorderWidthValueImp borderRightWidth;
+    CSSBorderWidthValueImp borderBottomWidth;
+    CSSBorderWidthValueImp borderLeftWidth;
+
+    CSSBorderValues() {}
+    CSSBorderValues(const CSSBorderValues& other) {
+        borderTopColor.specify(other.borderTopColor);
+        borderRightColor.specify(other.borderRightColor);
+        borderBottomColor.specify(other.borderBottomColor);
+        borderLeftColor.specify(other.borderLeftColor);
+        borderTopStyle.specify(other.borderTopStyle);
+        borderRightStyle.specify(other.borderRightStyle);
+        borderBottomStyle.specify(other.borderBottomStyle);
+        borderLeftStyle.specify(other.borderLeftStyle);
+        borderTopWidth.specify(other.borderTopWidth);
+        borderRightWidth.specify(other.borderRightWidth);
+        borderBottomWidth.specify(other.borderBottomWidth);
+        borderLeftWidth.specify(other.borderLeftWidth);
+    }
+};
+
+// 'outline-color', 'outline-style' and 'outline-width'
+struct CSSOutlineValues
+{
+    CSSOutlineColorValueImp outlineColor;
+    CSSBorderStyleValueImp outlineStyle;
+    CSSBorderWidthValueImp outlineWidth;
+
+    CSSOutlineValues() {}
+    CSSOutlineValues(const CSSOutlineValues& other) {
+        outlineColor.specify(other.outlineColor);
+        outlineStyle.specify(other.outlineStyle);
+        outlineWidth.specify(other.outlineWidth);
+    }
+};
+
+// 'font-family', 'font-size', 'font-style', 'font-variant' and 'font-weight',
+// which are all inherited.
+struct CSSFontValues
+{
+    CSSFontFamilyValueImp fontFamily;
+    CSSFontSizeValueImp fontSize;
+    CSSFontStyleValueImp fontStyle;
+    CSSFontVariantValueImp fontVariant;
+    CSSFontWeightValueImp fontWeight;
+
+    CSSFontValues() {}
+    CSSFontValues(const CSSFontValues& other) {
+        fontFamily.specify(other.fontFamily);
+        fontSize.specify(other.fontSize);
+        fontStyle.specify(other.fontStyle);
+        fontVariant.specify(other.fontVariant);
+        fontWeight.specify(other.fontWeight);
+    }
+};
+
+// 'letter-spacing', 'line-height', 'text-align', 'text-transform',
+// 'white-space' and 'word-spacing', which are all inherited.
+struct CSSTextValues
+{
+    CSSLetterSpacingValueImp letterSpacing;
+    CSSLineHeightValueImp lineHeight;
+    CSSTextAlignValueImp textAlign;
+    CSSTextTransformValueImp textTransform;
+    CSSWhiteSpaceValueImp whiteSpace;
+    CSSWordSpacingValueImp wordSpacing;
+
+    CSSTextValues() {}
+    CSSTextValues(const CSSTextValues& other) {
+        letterSpacing.specify(other.letterSpacing);
+        lineHeight.specify(other.lineHeight);
+        textAlign.specify(other.textAlign);
+        textTransform.specify(other.textTransform);
+        whiteSpace.specify(other.whiteSpace);
+        wordSpacing.specify(other.wordSpacing);
+    }
+};
+
 struct CSSStyleDeclarationBoard
 {
     // property values                                         Block/  | need
     //                                                         reFlow/ | Resolve
     //                                                         rePaint |
-    CSSBorderCollapseValueImp borderCollapse;               // F
-    CSSBorderSpacingValueImp borderSpacing;                 // F
-    CSSBorderWidthValueImp borderTopWidth;                  // F
-    CSSBorderWidthValueImp borderRightWidth;                // F
-    CSSBorderWidthValueImp borderBottomWidth;               // F
-    CSSBorderWidthValueImp borderLeftWidth;                 // F
+    CSSPropertyGroup<CSSTableValues> tableValues;           // F
+    CSSPropertyGroup<CSSCounterValues> counterValues;       // F
+    CSSPropertyGroup<CSSBorderValues> borderValues;         // F
+    CSSPropertyGroup<CSSFontValues> fontValues;             // F
+    CSSPropertyGroup<CSSTextValues> textValues;             // F
     CSSAutoLengthValueImp bottom;                           // TBD       R
-    CSSCaptionSideValueImp captionSide;                     // B
     CSSClearValueImp clear;                                 // F
     CSSContentValueImp content;                             // B
-    CSSAutoNumberingValueImp counterIncrement;              // F
-    CSSAutoNumberingValueImp counterReset;                  // F
     CSSDirectionValueImp direction;                         // F
     CSSDisplayValueImp display;                             // B
     CSSFloatValueImp float_;                                // B
-    CSSFontFamilyValueImp fontFamily;                       // F
-    CSSFontSizeValueImp fontSize;                           // F
-    CSSFontStyleValueImp fontStyle;                         // F
-    CSSFontVariantValueImp fontVariant;                     // F
-    CSSFontWeightValueImp fontWeight;                       // F
     CSSAutoLengthValueImp height;                           // F         R
     CSSAutoLengthValueImp left;                             // TBD       R
-    CSSLetterSpacingValueImp letterSpacing;                 // F
-    CSSLineHeightValueImp lineHeight;                       // F         R
     CSSListStyleImageValueImp listStyleImage;               // B
     CSSListStylePositionValueImp listStylePosition;         // B
     CSSListStyleTypeValueImp listStyleType;                 // B
@@ -98,15 +313,11 @@ struct CSSStyleDeclarationBoard
     CSSQuotesValueImp quotes;                               // F
     CSSAutoLengthValueImp right;                            // TBD       R
     CSSTableLayoutValueImp tableLayout;                     // F
-    CSSTextAlignValueImp textAlign;                         // F
     CSSTextDecorationValueImp textDecoration;               // F
     CSSNumericValueImp textIndent;                          // F         R
-    CSSTextTransformValueImp textTransform;                 // F
     CSSAutoLengthValueImp top;                              // TBD       R
     CSSUnicodeBidiValueImp unicodeBidi;                     // F
     CSSVerticalAlignValueImp verticalAlign;                 // F         R
-    CSSWhiteSpaceValueImp whiteSpace;                       // F
-    CSSWordSpacingValueImp wordSpacing;                     // F
     CSSAutoLengthValueImp width;                            // F         R
     CSSZIndexValueImp zIndex;                               // B
     CSSBindingValueImp binding;                             // B
@@ -350,59 +561,29 @@ private:
 
 public:
     // property values                                         Block/reFlow/rePaint
-    CSSBackgroundAttachmentValueImp backgroundAttachment;   // P
-    CSSColorValueImp backgroundColor;                       // P
-    CSSBackgroundImageValueImp backgroundImage;             // P
-    CSSBackgroundPositionValueImp backgroundPosition;       // P
-    CSSBackgroundRepeatValueImp backgroundRepeat;           // P
     CSSBackgroundShorthandImp background;                   //
-    CSSBorderCollapseValueImp borderCollapse;               // F
     CSSBorderColorShorthandImp borderColor;                 // P
-    CSSBorderSpacingValueImp borderSpacing;                 // F
     CSSBorderStyleShorthandImp borderStyle;                 //
     CSSBorderValueImp borderTop;                            //
     CSSBorderValueImp borderRight;                          //
     CSSBorderValueImp borderBottom;                         //
     CSSBorderValueImp borderLeft;                           //
-    CSSBorderColorValueImp borderTopColor;                  // P
-    CSSBorderColorValueImp borderRightColor;                // P
-    CSSBorderColorValueImp borderBottomColor;               // P
-    CSSBorderColorValueImp borderLeftColor;                 // P
-    CSSBorderStyleValueImp borderTopStyle;                  // P
-    CSSBorderStyleValueImp borderRightStyle;                // P
-    CSSBorderStyleValueImp borderBottomStyle;               // P
-    CSSBorderStyleValueImp borderLeftStyle;                 // P
-    CSSBorderWidthValueImp borderTopWidth;                  // F
-    CSSBorderWidthValueImp borderRightWidth;                // F
-    CSSBorderWidthValueImp borderBottomWidth;               // F
-    CSSBorderWidthValueImp borderLeftWidth;                 // F
     CSSBorderWidthShorthandImp borderWidth;                 //
     CSSBorderShorthandImp border;                           //
     CSSAutoLengthValueImp bottom;                           // TBD
-    CSSCaptionSideValueImp captionSide;                     // B
     CSSClearValueImp clear;                                 // F
 
     CSSColorValueImp color;                                 // P
     CSSContentValueImp content;                             // B
-    CSSAutoNumberingValueImp counterIncrement;              // F
-    CSSAutoNumberingValueImp counterReset;                  // F
 
     CSSCursorValueImp cursor;                               // P
     CSSDirectionValueImp direction;                         // F
     CSSDisplayValueImp display;                             // B
 
-    CSSEmptyCellsValueImp emptyCells;                       // P
     CSSFloatValueImp float_;                                // B
-    CSSFontFamilyValueImp fontFamily;                       // F
-    CSSFontSizeValueImp fontSize;                           // F
-    CSSFontStyleValueImp fontStyle;                         // F
-    CSSFontVariantValueImp fontVariant;                     // F
-    CSSFontWeightValueImp fontWeight;                       // F
     CSSFontShorthandImp font;                               //
     CSSAutoLengthValueImp height;                           // F
     CSSAutoLengthValueImp left;                             // TBD
-    CSSLetterSpacingValueImp letterSpacing;                 // F
-    CSSLineHeightValueImp lineHeight;                       // F
     CSSListStyleImageValueImp listStyleImage;               // B
     CSSListStylePositionValueImp listStylePosition;         // B
     CSSListStyleTypeValueImp listStyleType;                 // B
@@ -417,9 +598,6 @@ public:
     CSSNonNegativeLengthImp minHeight;                      // F
     CSSNonNegativeLengthImp minWidth;                       // F
 
-    CSSOutlineColorValueImp outlineColor;                   // P
-    CSSBorderStyleValueImp outlineStyle;                    // P
-    CSSBorderWidthValueImp outlineWidth;                    // P
     CSSOutlineShorthandImp outline;                         //
     CSSOverflowValueImp overflow;                           // F
     CSSPaddingWidthValueImp paddingTop;                     // F
@@ -427,9 +605,6 @@ public:
     CSSPaddingWidthValueImp paddingBottom;                  // F
     CSSPaddingWidthValueImp paddingLeft;                    // F
     CSSPaddingShorthandImp padding;                         //
-    CSSPageBreakValueImp pageBreakAfter;                    // TBD
-    CSSPageBreakValueImp pageBreakBefore;                   // TBD
-    CSSPageBreakValueImp pageBreakInside;                   // TBD
 
     CSSPositionValueImp position;                           // B
     CSSQuotesValueImp quotes;                               // F
@@ -437,17 +612,13 @@ public:
     CSSAutoLengthValueImp right;                            // TBD
 
     CSSTableLayoutValueImp tableLayout;                     // F
-    CSSTextAlignValueImp textAlign;                         // F
     CSSTextDecorationValueImp textDecoration;               // F
     CSSNumericValueImp textIndent;                          // F
-    CSSTextTransformValueImp textTransform;                 // F
     CSSAutoLengthValueImp top;                              // TBD
     CSSUnicodeBidiValueImp unicodeBidi;                     // F
     CSSVerticalAlignValueImp verticalAlign;                 // F
     CSSVisibilityValueImp visibility;                       // P
 
-    CSSWhiteSpaceValueImp whiteSpace;                       // F
-    CSSWordSpacingValueImp wordSpacing;                     // F
     CSSAutoLengthValueImp width;                            // F
 
     CSSZIndexValueImp zIndex;                               // B
@@ -457,6 +628,16 @@ public:
 
     HTMLAlignValueImp htmlAlign;                            // F
 
+    // grouped property values
+    CSSPropertyGroup<CSSTableValues> tableValues;           // F (P for 'empty-cells')
+    CSSPropertyGroup<CSSCounterValues> counterValues;       // F
+    CSSPropertyGroup<CSSPageBreakValues> pageBreakValues;   // TBD
+    CSSPropertyGroup<CSSBackgroundValues> backgroundValues; // P
+    CSSPropertyGroup<CSSBorderValues> borderValues;         // F (P for colors and styles)
+    CSSPropertyGroup<CSSOutlineValues> outlineValues;       // P
+    CSSPropertyGroup<CSSFontValues> fontValues;             // F
+    CSSPropertyGroup<CSSTextValues> textValues;             // F
+
     TextDecorationContext textDecorationContext;
 
     CSSStyleDeclarationImp(const CSSStyleDeclarationImp&);
@@ -513,6 +694,7 @@ public:
     }
 
     CSSPropertyValueImp* getProperty(unsigned id);
+    const CSSPropertyValueImp* getConstProperty(unsigned id) const;
 
     int getPseudoElementSelectorType() const {
         return pseudoElementSelectorType;
@@ -608,6 +790,14 @@ public:
     BlockPtr updateInlines(Element element);
     BlockPtr revert(Element element);
     void requestReconstruct(unsigned short flags);
+    // Flags the blocks that paint the boxes of this style for repainting.
+    void requestRepaint();
+
+    // Returns the size of this style, counting each shared property group
+    // only if it is not in groups yet.
+    size_t getMemoryUsage(std::set<const void*>& groups) const;
+    // Returns the size a style would take if no property group were shared.
+    static size_t getUnsharedMemoryUsage();
 
     StackingContextPtr getStackingContext() const {
         return stackingContext;
@@ -253,7 +253,7 @@ LineBoxPtr FormattingContext::addLineBox(ViewCSSImp* view, const BlockPtr& paren
     assert(parentBox);
     baseline = lineHeight = 0.0f;
     isFirstLine = false;
-    lineBox = std::make_shared<LineBox>(parentBox->getStyle());
+    lineBox = view->createBox<LineBox>(parentBox->getStyle());
     if (lineBox) {
         parentBox->appendChild(lineBox);
 
@@ -495,8 +495,8 @@ void FormattingContext::appendInlineBox(ViewCSSImp* view, const InlineBoxPtr& in
             assert(parentStyle);
             FontTexture* font = view->selectFont(parentStyle);
             assert(font);
-            float point = view->getPointFromPx(parentStyle->fontSize.getPx());
-            parentBox->defaultLineHeight = parentStyle->lineHeight.getPx();
+            float point = view->getPointFromPx(parentStyle->fontValues->fontSize.getPx());
+            parentBox->defaultLineHeight = parentStyle->textValues->lineHeight.getPx();
             float leading = parentBox->defaultLineHeight - font->getLineHeight(point);
             parentBox->defaultBaseline = (leading / 2.0f) + font->getAscender(point);
         }
@@ -522,8 +522,8 @@ void FormattingContext::appendInlineBox(ViewCSSImp* view, const InlineBoxPtr& in
 
     if (0.0f < inlineBox->getLeading() + inlineBox->height)
         lineBox->height = std::max(lineBox->baseline + descender, offset + inlineBox->getLeading() + inlineBox->height);
-    lineBox->height = std::max(lineBox->height, activeStyle->lineHeight.getPx());
-    lineBox->height = std::max(lineBox->height, lineBox->getStyle()->lineHeight.getPx());
+    lineBox->height = std::max(lineBox->height, activeStyle->textValues->lineHeight.getPx());
+    lineBox->height = std::max(lineBox->height, lineBox->getStyle()->textValues->lineHeight.getPx());
 
     lineBox->width += inlineBox->getTotalWidth();
 
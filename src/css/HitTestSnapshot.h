@@ -0,0 +1,118 @@
+/*
+ * Copyright 2015 Esrille Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ES_HITTESTSNAPSHOT_H
+#define ES_HITTESTSNAPSHOT_H
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <org/w3c/dom/Node.h>
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <vector>
+
+namespace org { namespace w3c { namespace dom { namespace bootstrap {
+
+class Box;
+class WindowProxy;
+
+typedef std::shared_ptr<WindowProxy> WindowProxyPtr;
+
+// HitTestSnapshot keeps the areas that Box::boxFromPoint() would find in a
+// laid out box tree, so that input events can still be targeted at what is on
+// the screen while the background task lays the tree out again. The snapshot
+// refers to no box; the box pointer of an entry is only compared for identity.
+class HitTestSnapshot
+{
+public:
+    struct Rect
+    {
+        float left;
+        float top;
+        float right;
+        float bottom;
+
+        Rect(float left = -HUGE_VALF, float top = -HUGE_VALF, float right = HUGE_VALF, float bottom = HUGE_VALF) :
+            left(left),
+            top(top),
+            right(right),
+            bottom(bottom)
+        {}
+        bool isEmpty() const {
+            return right <= left || bottom <= top;
+        }
+        bool contains(int x, int y) const {
+            return left <= x && x < right && top <= y && y < bottom;
+        }
+        Rect intersect(const Rect& r) const {
+            return Rect(std::max(left, r.left), std::max(top, r.top),
+                        std::min(right, r.right), std::min(bottom, r.bottom));
+        }
+    };
+
+    struct Entry
+    {
+        Rect rect;              // in the document coordinates
+        Node node;              // the target node of the box
+        WindowProxyPtr childWindow;
+        float childX;           // the origin of the child window
+        float childY;
+        const Box* box;
+
+        Entry() :
+            childX(0.0f),
+            childY(0.0f),
+            box(0)
+        {}
+        Entry(const Box* box, const Rect& rect = Rect());
+    };
+
+private:
+    std::vector<Entry> entries;
+
+public:
+    void clear() {
+        entries.clear();
+    }
+    bool empty() const {
+        return entries.empty();
+    }
+    size_t size() const {
+        return entries.size();
+    }
+    void add(const Box* box, const Rect& rect) {
+        if (!rect.isEmpty())
+            entries.emplace_back(box, rect);
+    }
+
+    // Returns the first entry that contains (x, y) in the document
+    // coordinates, or nullptr.
+    const Entry* find(int x, int y) const {
+        for (auto i = entries.begin(); i != entries.end(); ++i) {
+            if (i->rect.contains(x, y))
+                return &*i;
+        }
+        return nullptr;
+    }
+};
+
+}}}}  // org::w3c::dom::bootstrap
+
+#endif  // ES_HITTESTSNAPSHOT_H
@@ -48,7 +48,7 @@ namespace {
 CSSStyleDeclarationPtr setActiveStyle(ViewCSSImp* view, const CSSStyleDeclarationPtr& style, FontTexture*& font, float& point)
 {
     font = style->getFontTexture();
-    point = view->getPointFromPx(style->fontSize.getPx());
+    point = view->getPointFromPx(style->fontValues->fontSize.getPx());
     return style;
 }
 
@@ -182,8 +182,8 @@ bool Block::layOutText(ViewCSSImp* view, Node text, FormattingContext* context,
     bool discardable = !data.empty();
     if (discardable && style->display.isInline()) {
         // TODO: Check emptyInline
-        if (element.getFirstChild() == text && (style->marginLeft.getPx() || style->borderLeftWidth.getPx() || style->paddingLeft.getPx()) ||
-            element.getLastChild() == text && (style->marginRight.getPx() || style->borderRightWidth.getPx() || style->paddingRight.getPx()))
+        if (element.getFirstChild() == text && (style->marginLeft.getPx() || style->borderValues->borderLeftWidth.getPx() || style->paddingLeft.getPx()) ||
+            element.getLastChild() == text && (style->marginRight.getPx() || style->borderValues->borderRightWidth.getPx() || style->paddingRight.getPx()))
             discardable = false;
     }
 
@@ -231,7 +231,7 @@ bool Block::layOutText(ViewCSSImp* view, Node text, FormattingContext* context,
                 if (position == 0)
                     base = skipped;
                 position = skipped;
-                if (!context->atLineHead && activeStyle->whiteSpace.isBreakingLines())
+                if (!context->atLineHead && activeStyle->textValues->whiteSpace.isBreakingLines())
                     wrapControl.markBreakable();
             }
         }
@@ -249,14 +249,14 @@ bool Block::layOutText(ViewCSSImp* view, Node text, FormattingContext* context,
                 length = activeStyle->getNextWord(data, position, context->isFirstLetter, context->prevChar, word);
             else
                 length = activeStyle->getFirstLetter(data, position, context->isFirstLetter, context->prevChar, word);
-            breakable = (position < data.length() && activeStyle->whiteSpace.isBreakingLines());
+            breakable = (position < data.length() && activeStyle->textValues->whiteSpace.isBreakingLines());
             if (word.empty()) {
-                if (!context->atLineHead && activeStyle->whiteSpace.isBreakingLines() && offset < data.length())
+                if (!context->atLineHead && activeStyle->textValues->whiteSpace.isBreakingLines() && offset < data.length())
                     wrapControl.markBreakable();    // cf. html4/white-space-007.htm
                 if (discardable)
                     return !isAnonymous();
             } else {
-                if (offset == 0 && activeStyle->whiteSpace.isBreakingLines() && !context->atLineHead && prevChar) {
+                if (offset == 0 && activeStyle->textValues->whiteSpace.isBreakingLines() && !context->atLineHead && prevChar) {
                     TextIterator ti;
                     std::u16string test;
                     append(test, prevChar);
@@ -294,7 +294,7 @@ bool Block::layOutText(ViewCSSImp* view, Node text, FormattingContext* context,
 
             if (!inlineBox) {
                 try {
-                    inlineBox = std::make_shared<InlineBox>(text, activeStyle);
+                    inlineBox = view->createBox<InlineBox>(text, activeStyle);
                 } catch (...) {
                     return false;
                 }
@@ -311,16 +311,16 @@ bool Block::layOutText(ViewCSSImp* view, Node text, FormattingContext* context,
             if (firstLetterStyle || data.length() <= position && inlineBox->isEmptyInlineAtLast(style, element, text))
                 w += blankRight;    // BWBAL: blankRight will be adjusted later
 
-            while (context->leftover < w && (wrapControl.isBreakable() || activeStyle->whiteSpace.isBreakingLines())) {
-                if (activeStyle->whiteSpace.isCollapsingSpace() && !word.empty() && word.back() == u' ') {
-                    float lineEnd = w - glyph->advance * font->getScale(point) - activeStyle->wordSpacing.getPx();
-                    if (!activeStyle->letterSpacing.isNormal())
-                        lineEnd -= activeStyle->letterSpacing.getPx();
+            while (context->leftover < w && (wrapControl.isBreakable() || activeStyle->textValues->whiteSpace.isBreakingLines())) {
+                if (activeStyle->textValues->whiteSpace.isCollapsingSpace() && !word.empty() && word.back() == u' ') {
+                    float lineEnd = w - glyph->advance * font->getScale(point) - activeStyle->textValues->wordSpacing.getPx();
+                    if (!activeStyle->textValues->letterSpacing.isNormal())
+                        lineEnd -= activeStyle->textValues->letterSpacing.getPx();
                     if (lineEnd <= context->leftover || lineEnd <= 0.0f) {
                         breakable = true;
                         context->dontWrap();
                         w = lineEnd;
-                        length = trimSpacesAtBack(data, offset, length, activeStyle->whiteSpace.getValue() == CSSWhiteSpaceValueImp::PreLine);
+                        length = trimSpacesAtBack(data, offset, length, activeStyle->textValues->whiteSpace.getValue() == CSSWhiteSpaceValueImp::PreLine);
                         linefeed = true;
                         break;
                     }
@@ -363,8 +363,8 @@ bool Block::layOutText(ViewCSSImp* view, Node text, FormattingContext* context,
             }
 
             // cf. html4/white-space-normal-001.htm
-            if (activeStyle->whiteSpace.isCollapsingSpace() && !word.empty() && word.back() == u' ')
-                w -= glyph->advance * font->getScale(point) + activeStyle->wordSpacing.getPx();
+            if (activeStyle->textValues->whiteSpace.isCollapsingSpace() && !word.empty() && word.back() == u' ')
+                w -= glyph->advance * font->getScale(point) + activeStyle->textValues->wordSpacing.getPx();
 
             wrapControl.extendMCW(w);
             updateMCW(wrapControl.getMCW());
@@ -386,7 +386,7 @@ bool Block::layOutText(ViewCSSImp* view, Node text, FormattingContext* context,
             if (inlineBox->hasHeight()) {   // TODO: This can be done in LineBox::layOut().
                 // Switch height from 'line-height' to the content height.
                 inlineBox->height = font->getLineHeight(point);
-                inlineBox->leading = activeStyle->lineHeight.getPx() - inlineBox->height;
+                inlineBox->leading = activeStyle->textValues->lineHeight.getPx() - inlineBox->height;
                 lineBox->underlinePosition = std::max(lineBox->underlinePosition, font->getUnderlinePosition(point));
                 lineBox->underlineThickness = std::max(lineBox->underlineThickness, font->getUnderlineThickness(point));
                 lineBox->lineThroughPosition = std::max(lineBox->lineThroughPosition, font->getLineThroughPosition(point));
@@ -463,7 +463,7 @@ float LineBox::shrinkTo()
 
     float wl = 0.0f;
     float l = 0.0f;
-    for (auto child = getFirstChild(); child; child = child->getNextSibling()) {
+    for (Box* child = firstChild.get(); child; child = child->nextSibling.get()) {
         if (child->isAnonymous() || !child->style)
             break;
         if (child->style->float_.getValue() == CSSFloatValueImp::Left) {
@@ -576,7 +576,7 @@ void LineBox::dump(std::string indent)
         std::cout << "c:" << clearance << ' ';
     std::cout << "m:" << marginTop << ':' << marginRight << ':' << marginBottom << ':' << marginLeft << '\n';
     indent += "  ";
-    for (BoxPtr child = getFirstChild(); child; child = child->getNextSibling())
+    for (Box* child = firstChild.get(); child; child = child->nextSibling.get())
         child->dump(indent);
 }
 
@@ -650,18 +650,18 @@ float InlineBox::atEndOfLine()
 {
     if (length == 0)
         return 0.0f;
-    if (style->whiteSpace.isCollapsingSpace()) {
+    if (style->textValues->whiteSpace.isCollapsingSpace()) {
         std::u16string data;
         if (node.getNodeType() == Node::TEXT_NODE) {
             Text text = interface_cast<Text>(node);
             data = text.substringData(offset, length);
-            size_t len = trimSpacesAtBack(data, 0, length, getStyle()->whiteSpace.getValue() == CSSWhiteSpaceValueImp::PreLine);
+            size_t len = trimSpacesAtBack(data, 0, length, getStyle()->textValues->whiteSpace.getValue() == CSSWhiteSpaceValueImp::PreLine);
             if (len < length) {
                 length = len;
                 // TODO: Deal with the errors in floating point operations.
-                float w = -font->measureText(u" ", point) - getStyle()->wordSpacing.getPx();
-                if (!getStyle()->letterSpacing.isNormal())
-                    w -= getStyle()->letterSpacing.getPx();
+                float w = -font->measureText(u" ", point) - getStyle()->textValues->wordSpacing.getPx();
+                if (!getStyle()->textValues->letterSpacing.isNormal())
+                    w -= getStyle()->textValues->letterSpacing.getPx();
                 width += w;
                 return w;
             }
@@ -688,7 +688,7 @@ void InlineBox::resolveWidth()
 {
     // The ‘width’ and ‘height’ properties do not apply.
     if (isInline()) {
-        backgroundColor = style->backgroundColor.getARGB();
+        backgroundColor = style->backgroundValues->backgroundColor.getARGB();
         updatePadding();
         updateBorderWidth();
         marginTop = style->marginTop.isAuto() ? 0 : style->marginTop.getPx();
@@ -752,7 +752,7 @@ void InlineBox::dump(std::string indent)
         std::cout << std::hex << CSSSerializeRGB(activeStyle->color.getARGB()) << std::dec;
     std::cout << '\n';
     indent += "  ";
-    for (BoxPtr child = getFirstChild(); child; child = child->getNextSibling())
+    for (Box* child = firstChild.get(); child; child = child->nextSibling.get())
         child->dump(indent);
 }
 
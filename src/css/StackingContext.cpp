@@ -272,6 +272,79 @@ bool StackingContext::hasClipBox()
     return clipWidth != HUGE_VALF && clipHeight != HUGE_VALF;
 }
 
+bool StackingContext::hasScrolledClipBox()
+{
+    // cf. updateClipBox()
+    for (StackingContext* s = this; s != parent; s = s->positioned) {
+        for (BlockPtr clip = s->getClipBox(); clip && (!s->positioned || clip != s->positioned->getClipBox()); clip = clip->getClipBox()) {
+            if (clip->stackingContext != s && clip->getParentBox())
+                return true;
+        }
+    }
+    return false;
+}
+
+bool StackingContext::addInkBounds(Box* box, float dx, float dy, float& left, float& top, float& right, float& bottom)
+{
+    if (box->isFixed())
+        return false;
+    float l, t, r, b;
+    if (box->getBoxType() == Box::INLINE_LEVEL_BOX) {
+        // Leave room for glyph overhangs.
+        float m = box->getTotalHeight() + box->getOutlineWidth();
+        l = box->x - m;
+        t = box->y - box->getBlankTop() - m;
+        r = box->x + box->getTotalWidth() + m;
+        b = box->y + box->getTotalHeight() + m;
+    } else {
+        float m = box->getOutlineWidth();
+        l = box->x + box->marginLeft - m;
+        t = box->y + box->marginTop - m;
+        r = l + box->getBorderWidth() + 2.0f * m;
+        b = t + box->getBorderHeight() + 2.0f * m;
+    }
+    left = std::min(left, l + dx);
+    top = std::min(top, t + dy);
+    right = std::max(right, r + dx);
+    bottom = std::max(bottom, b + dy);
+    if (!box->isAnonymous() && box->getBoxType() == Box::BLOCK_LEVEL_BOX && box->style && box->style->getParentStyle() &&
+        box->style->overflow.getValue() != CSSOverflowValueImp::Visible)
+        return true;    // the descendants are clipped by box
+    for (Box* child = box->firstChild.get(); child; child = child->nextSibling.get()) {
+        if (!addInkBounds(child, dx, dy, left, top, right, bottom))
+            return false;
+    }
+    return true;
+}
+
+bool StackingContext::addInkBounds(float dx, float dy, float& left, float& top, float& right, float& bottom)
+{
+    for (auto i = baseList.begin(); i != baseList.end(); ++i) {
+        if (BoxPtr base = i->lock()) {
+            if (!addInkBounds(base.get(), dx, dy, left, top, right, bottom))
+                return false;
+        }
+    }
+    for (StackingContext* childContext = getFirstChild(); childContext; childContext = childContext->getNextSibling()) {
+        if (childContext->hasScrolledClipBox())
+            return false;
+        if (!childContext->addInkBounds(dx + childContext->relativeX - relativeX, dy + childContext->relativeY - relativeY, left, top, right, bottom))
+            return false;
+    }
+    return true;
+}
+
+bool StackingContext::getInkBounds(float& left, float& top, float& right, float& bottom)
+{
+    left = top = HUGE_VALF;
+    right = bottom = -HUGE_VALF;
+    if (!addInkBounds(0.0f, 0.0f, left, top, right, bottom))
+        return false;
+    if (right < left || bottom < top)
+        left = top = right = bottom = 0.0f;
+    return true;
+}
+
 void StackingContext::render(ViewCSSImp* view)
 {
     auto style = getStyle();
@@ -283,8 +356,13 @@ void StackingContext::render(ViewCSSImp* view)
         glTranslatef(relativeX - parent->relativeX, relativeY - parent->relativeY, 0.0f);
     else
         glTranslatef(relativeX, relativeY, 0.0f);
-    if (style->opacity.getValue() < 1.0f)
-        view->beginTranslucent();
+    if (style->opacity.getValue() < 1.0f) {
+        float left, top, right, bottom;
+        if (getInkBounds(left, top, right, bottom))
+            view->beginTranslucent(left, top, right - left, bottom - top);
+        else
+            view->beginTranslucent();
+    }
 
     if (getFirstBase()) {
         firstFloat = lastFloat = currentFloat = nullptr;
@@ -497,6 +575,20 @@ BoxPtr StackingContext::boxFromPoint(int x, int y)
     return nullptr;
 }
 
+void StackingContext::snapshotHitTargets(HitTestSnapshot& snapshot)
+{
+    // Follow the order of boxFromPoint().
+    StackingContext* childContext;
+    for (childContext = getLastChild(); childContext && 0 <= childContext->zIndex; childContext = childContext->getPreviousSibling())
+        childContext->snapshotHitTargets(snapshot);
+    for (auto i = baseList.begin(); i != baseList.end(); i->expired() ? (i = baseList.erase(i)) : ++i) {
+        if (auto base = i->lock())
+            base->snapshotHitTargets(snapshot, -relativeX, -relativeY, HitTestSnapshot::Rect(), this);
+    }
+    for (; childContext; childContext = childContext->getPreviousSibling())
+        childContext->snapshotHitTargets(snapshot);
+}
+
 void StackingContext::dump(std::string indent)
 {
     std::cout << indent << "z-index: ";
@@ -30,6 +30,7 @@ namespace org { namespace w3c { namespace dom { namespace bootstrap {
 
 class Box;
 class Block;
+class HitTestSnapshot;
 class ViewCSSImp;
 class CSSStyleDeclarationImp;
 
@@ -109,6 +110,10 @@ class StackingContext
     void reparent(StackingContext* target);
 
     void updateClipBox(StackingContext* s);
+    bool hasScrolledClipBox();
+
+    static bool addInkBounds(Box* box, float dx, float dy, float& left, float& top, float& right, float& bottom);
+    bool addInkBounds(float dx, float dy, float& left, float& top, float& right, float& bottom);
 
 public:
     StackingContext(bool auto_, int zIndex, const CSSStyleDeclarationPtr& style);
@@ -185,6 +190,10 @@ public:
     void resolveScrollSize(ViewCSSImp* view);
 
     bool hasClipBox();
+    // Gets the area painted by this stacking context, including its child
+    // contexts, before the opacity is applied. Returns false if the area
+    // cannot be determined, e.g., for fixed boxes.
+    bool getInkBounds(float& left, float& top, float& right, float& bottom);
     void render(ViewCSSImp* view);
 
     float getRelativeX() const {
@@ -195,6 +204,7 @@ public:
     }
 
     BoxPtr boxFromPoint(int x, int y);
+    void snapshotHitTargets(HitTestSnapshot& snapshot);
 
     void dump(std::string indent = "");
 };
@@ -23,13 +23,26 @@
 #include <org/w3c/dom/html/HTMLTableRowElement.h>
 #include <org/w3c/dom/html/HTMLTableSectionElement.h>
 
+#include <map>
+#include <mutex>
+#include <thread>
+
 #include "CSSPropertyValueImp.h"
 #include "DocumentImp.h"
 #include "FormattingContext.h"
 #include "ViewCSSImp.h"
 
+#include "font/FontManager.h"
+
 namespace org { namespace w3c { namespace dom { namespace bootstrap {
 
+namespace {
+
+// The minimum length of the cell texts to load their glyphs in parallel
+const size_t MinParallelGlyphText = 4096;
+
+}
+
 CellBox::CellBox(Element element, const CSSStyleDeclarationPtr& style):
     Block(element, style),
     fixedLayout(false),
@@ -39,7 +52,13 @@ CellBox::CellBox(Element element, const CSSStyleDeclarationPtr& style):
     rowSpan(1),
     verticalAlign(CSSVerticalAlignValueImp::Baseline),  // see TableWrapperBox::processCell
     intrinsicHeight(0.0f),
-    columnWidth(NAN)
+    columnWidth(NAN),
+    minContribution(0.0f),
+    maxContribution(0.0f),
+    contributionWidth(NAN),
+    layoutColumnWidth(NAN),
+    layoutPaddingTop(0.0f),
+    layoutHeight(0.0f)
 {
     if (style)
         verticalAlign = style->verticalAlign.getValueForCell();
@@ -56,8 +75,8 @@ void CellBox::fit(float w, FormattingContext* context)
 
 void CellBox::separateBorders(const CSSStyleDeclarationPtr& style, unsigned xWidth, unsigned yHeight)
 {
-    float hs = style->borderSpacing.getHorizontalSpacing();
-    float vs = style->borderSpacing.getVerticalSpacing();
+    float hs = style->tableValues->borderSpacing.getHorizontalSpacing();
+    float vs = style->tableValues->borderSpacing.getVerticalSpacing();
     marginTop = (row == 0) ? vs : (vs / 2.0f);
     marginRight = (col + colSpan == xWidth) ? hs : (hs / 2.0f);
     marginBottom = (row + rowSpan == yHeight) ? vs : (vs / 2.0f);
@@ -100,14 +119,19 @@ float CellBox::getBaseline() const
     return !isnan(x) ? x : (getBlankTop() + height);
 }
 
-float CellBox::adjustWidth()
+void CellBox::resolveMargins()
 {
     auto wrapper(std::dynamic_pointer_cast<TableWrapperBox>(getParentBox()->getParentBox()->getParentBox()));
     assert(wrapper);
-    if (wrapper->getStyle()->borderCollapse.getValue() == CSSBorderCollapseValueImp::Collapse)
+    if (wrapper->getStyle()->tableValues->borderCollapse.getValue() == CSSBorderCollapseValueImp::Collapse)
         collapseBorder(wrapper);
     else
         separateBorders(wrapper->getStyle(), wrapper->getColumnCount(), wrapper->getRowCount());
+}
+
+float CellBox::adjustWidth()
+{
+    resolveMargins();
     float w = isnan(columnWidth) ? getTotalWidth() : columnWidth;
     width = w - getBlankLeft() - getBlankRight();
     if (fixedLayout || isnan(columnWidth))
@@ -119,6 +143,19 @@ float CellBox::adjustWidth()
     return width;
 }
 
+bool CellBox::reuseLayout()
+{
+    if (!isClean() || isnan(columnWidth) || layoutColumnWidth != columnWidth)
+        return false;
+    resolveMargins();
+    if (width != columnWidth - getBlankLeft() - getBlankRight())
+        return false;
+    // Undo the vertical alignment applied by the table.
+    paddingTop = layoutPaddingTop;
+    height = layoutHeight;
+    return true;
+}
+
 float CellBox::shrinkTo()
 {
     if (fixedLayout)
@@ -146,9 +183,9 @@ bool CellBox::isEmptyCell() const
 {
     if (hasChildBoxes() || !style)
         return false;
-    if (style->emptyCells.getValue() == CSSEmptyCellsValueImp::Show)
+    if (style->tableValues->emptyCells.getValue() == CSSEmptyCellsValueImp::Show)
         return false;
-    return style->borderCollapse.getValue();
+    return style->tableValues->borderCollapse.getValue();
 }
 
 void CellBox::render(ViewCSSImp* view, StackingContext* stackingContext)
@@ -199,8 +236,7 @@ TableWrapperBox::~TableWrapperBox()
 unsigned TableWrapperBox::appendRow()
 {
     ++yHeight;
-    grid.resize(yHeight);
-    grid.back().resize(xWidth);
+    grid.resize(xWidth * yHeight);
     rows.resize(yHeight);
     rowGroups.resize(yHeight);
     return yHeight;
@@ -209,8 +245,15 @@ unsigned TableWrapperBox::appendRow()
 unsigned TableWrapperBox::appendColumn()
 {
     ++xWidth;
-    for (auto r = grid.begin(); r != grid.end(); ++r)
-        r->resize(xWidth);
+    if (0 < yHeight) {
+        // Widen each row by one cell, moving the rows from the bottom up.
+        // Note the moved-from cells are left empty.
+        grid.resize(xWidth * yHeight);
+        for (unsigned y = yHeight - 1; 0 < y; --y) {
+            auto row = grid.begin() + (xWidth - 1) * y;
+            std::move_backward(row, row + (xWidth - 1), grid.begin() + xWidth * y + (xWidth - 1));
+        }
+    }
     columns.resize(xWidth);
     columnGroups.resize(xWidth);
     return xWidth;
@@ -226,15 +269,15 @@ void TableWrapperBox::constructBlocks()
         appendChild(*i);
 
     // Table box
-    tableBox = std::make_shared<Block>(getNode(), getStyle());
+    tableBox = view->createBox<Block>(getNode(), getStyle());
     if (auto box = getTableBox()) {
         for (unsigned y = 0; y < yHeight; ++y) {
-            LineBoxPtr lineBox = std::make_shared<LineBox>(nullptr);
+            LineBoxPtr lineBox = view->createBox<LineBox>(nullptr);
             if (!lineBox)
                 continue;
             box->appendChild(lineBox);
             for (unsigned x = 0; x < xWidth; ++x) {
-                CellBoxPtr cellBox = grid[y][x];
+                const CellBoxPtr& cellBox = getCell(x, y);
                 if (!cellBox || cellBox->isSpanned(x, y))
                     continue;
                 cellBox->resetWidth();
@@ -355,7 +398,7 @@ void TableWrapperBox::reconstructBlocks()
             } else {
                 for (unsigned y = 0; y < yHeight; ++y) {
                     for (unsigned x = 0; x < xWidth; ++x) {
-                        CellBoxPtr cellBox = grid[y][x];
+                        const CellBoxPtr& cellBox = getCell(x, y);
                         if (!cellBox || cellBox->isSpanned(x, y))
                             continue;
                         if (cellBox->flags & (Box::NEED_EXPANSION | Box::NEED_CHILD_EXPANSION)) {
@@ -423,7 +466,7 @@ bool TableWrapperBox::processTableChild(Node node, const CSSStyleDeclarationPtr&
         // 'table-caption' doesn't seem to end the current row:
         // cf. table-caption-003.
         if (BlockPtr caption = constructTablePart(child)) {
-            if (childStyle->captionSide.getValue() == CSSCaptionSideValueImp::Top)
+            if (childStyle->tableValues->captionSide.getValue() == CSSCaptionSideValueImp::Top)
                 topCaptions.push_back(caption);
             else
                 bottomCaptions.push_back(caption);
@@ -711,7 +754,7 @@ CellBoxPtr TableWrapperBox::processCell(Element current, const BlockPtr& parentB
         xCurrent = 0;
     }
     rows[yCurrent] = rowStyle;
-    while (xCurrent < xWidth && grid[yCurrent][xCurrent])
+    while (xCurrent < xWidth && getCell(xCurrent, yCurrent))
         ++xCurrent;
     if (xCurrent == xWidth)
         appendColumn();
@@ -732,7 +775,7 @@ CellBoxPtr TableWrapperBox::processCell(Element current, const BlockPtr& parentB
     if (current)
         cellBox = std::static_pointer_cast<CellBox>(constructTablePart(current));
     else {
-        cellBox = std::make_shared<CellBox>();  // TODO: use parentStyle? -- For verticalAlign, yes.
+        cellBox = view->createBox<CellBox>();  // TODO: use parentStyle? -- For verticalAlign, yes.
         if (cellBox) {
             cellBox->stackingContext = stackingContext;
             cellBox->establishFormattingContext();
@@ -744,7 +787,7 @@ CellBoxPtr TableWrapperBox::processCell(Element current, const BlockPtr& parentB
         cellBox->setRowSpan(rowspan);
         for (unsigned x = xCurrent; x < xCurrent + colspan; ++x) {
             for (unsigned y = yCurrent; y < yCurrent + rowspan; ++y)
-                grid[y][x] = cellBox;
+                getCell(x, y) = cellBox;
         }
         // TODO: 13
         if (cellGrowsDownward)
@@ -804,12 +847,12 @@ void TableWrapperBox::processHeader()
     if (headerCount == 0)
         return;
 
-    std::rotate(grid.begin(), grid.begin() + yTheadBegin, grid.begin() + yTheadEnd);
+    std::rotate(grid.begin(), grid.begin() + xWidth * yTheadBegin, grid.begin() + xWidth * yTheadEnd);
     std::rotate(rows.begin(), rows.begin() + yTheadBegin, rows.begin() + yTheadEnd);
     std::rotate(rowGroups.begin(), rowGroups.begin() + yTheadBegin, rowGroups.begin() + yTheadEnd);
     for (unsigned y = 0; y < headerCount; ++y) {
         for (unsigned x = 0; x < xWidth; ++x) {
-            CellBoxPtr cellBox = grid[y][x];
+            const CellBoxPtr& cellBox = getCell(x, y);
             if (!cellBox || cellBox->isSpanned(x, y + yTheadBegin))
                 continue;
             cellBox->row -= yTheadBegin;
@@ -817,7 +860,7 @@ void TableWrapperBox::processHeader()
     }
     for (unsigned y = headerCount; y < yTheadEnd; ++y) {
         for (unsigned x = 0; x < xWidth; ++x) {
-            CellBoxPtr cellBox = grid[y][x];
+            const CellBoxPtr& cellBox = getCell(x, y);
             if (!cellBox || cellBox->isSpanned(x, y - headerCount))
                 continue;
             cellBox->row += headerCount;
@@ -841,7 +884,7 @@ void TableWrapperBox::processFooter()
     unsigned offset = yHeight - yTfootEnd;
     for (unsigned y = yTfootBegin; y < yTfootEnd; ++y) {
         for (unsigned x = 0; x < xWidth; ++x) {
-            CellBoxPtr cellBox = grid[y][x];
+            const CellBoxPtr& cellBox = getCell(x, y);
             if (!cellBox || cellBox->isSpanned(x, y))
                 continue;
             cellBox->row += offset;
@@ -849,13 +892,13 @@ void TableWrapperBox::processFooter()
     }
     for (unsigned y = yTfootEnd; y < yHeight; ++y) {
         for (unsigned x = 0; x < xWidth; ++x) {
-            CellBoxPtr cellBox = grid[y][x];
+            const CellBoxPtr& cellBox = getCell(x, y);
             if (!cellBox || cellBox->isSpanned(x, y))
                 continue;
             cellBox->row -= headerCount;
         }
     }
-    std::rotate(grid.begin() + yTfootBegin, grid.begin() + yTfootEnd, grid.end());
+    std::rotate(grid.begin() + xWidth * yTfootBegin, grid.begin() + xWidth * yTfootEnd, grid.end());
     std::rotate(rows.begin() + yTfootBegin, rows.begin() + yTfootEnd, rows.end());
     std::rotate(rowGroups.begin() + yTfootBegin, rowGroups.begin() + yTfootEnd, rowGroups.end());
 }
@@ -894,7 +937,7 @@ void TableWrapperBox::fit(float w, FormattingContext* context)
 }
 
 bool TableWrapperBox::
-BorderValue::resolveBorderConflict(CSSBorderColorValueImp& c, CSSBorderStyleValueImp& s, CSSBorderWidthValueImp& w)
+BorderValue::resolveBorderConflict(unsigned c, const CSSBorderStyleValueImp& s, const CSSBorderWidthValueImp& w)
 {
     if (s.getValue() == CSSBorderStyleValueImp::None || style.getValue() == CSSBorderStyleValueImp::Hidden)
         return false;
@@ -905,7 +948,7 @@ BorderValue::resolveBorderConflict(CSSBorderColorValueImp& c, CSSBorderStyleValu
     }
     float px = w.getPx();
     if (width < px || width == px && style < s) {
-        color.specify(c);
+        color = c;
         style.specify(s);
         width = px;
         return true;
@@ -918,14 +961,16 @@ BorderValue::resolveBorderConflict(CSSStyleDeclarationPtr style, unsigned trbl)
 {
     if (!style)
         return;
+    const CSSBorderValues& values = style->borderValues.get();
+    unsigned currentColor = style->color.getARGB();
     if (trbl & 0x1)
-        resolveBorderConflict(style->borderTopColor, style->borderTopStyle, style->borderTopWidth);
+        resolveBorderConflict(values.borderTopColor.getARGB(currentColor), values.borderTopStyle, values.borderTopWidth);
     if (trbl & 0x2)
-        resolveBorderConflict(style->borderRightColor, style->borderRightStyle, style->borderRightWidth);
+        resolveBorderConflict(values.borderRightColor.getARGB(currentColor), values.borderRightStyle, values.borderRightWidth);
     if (trbl & 0x4)
-        resolveBorderConflict(style->borderBottomColor, style->borderBottomStyle, style->borderBottomWidth);
+        resolveBorderConflict(values.borderBottomColor.getARGB(currentColor), values.borderBottomStyle, values.borderBottomWidth);
     if (trbl & 0x8)
-        resolveBorderConflict(style->borderLeftColor, style->borderLeftStyle, style->borderLeftWidth);
+        resolveBorderConflict(values.borderLeftColor.getARGB(currentColor), values.borderLeftStyle, values.borderLeftWidth);
 }
 
 void TableWrapperBox::resolveHorizontalBorderConflict(unsigned x, unsigned y, BorderValue* b, const CellBoxPtr& top, const CellBoxPtr& bottom)
@@ -1010,7 +1055,7 @@ bool TableWrapperBox::resolveBorderConflict()
     assert(style);
     borderRows.clear();
     borderColumns.clear();
-    if (style->borderCollapse.getValue() != CSSBorderCollapseValueImp::Collapse)
+    if (style->tableValues->borderCollapse.getValue() != CSSBorderCollapseValueImp::Collapse)
         return false;
     if (!getTableBox())
         return false;
@@ -1020,14 +1065,14 @@ bool TableWrapperBox::resolveBorderConflict()
         for (unsigned x = 0; x < xWidth + 1; ++x) {
             if (x < xWidth) {
                 BorderValue* br = getRowBorderValue(x, y);
-                CellBoxPtr top = (y < yHeight) ? grid[y][x] : 0;
-                CellBoxPtr bottom = (0 < y) ? grid[y - 1][x] : 0;
+                CellBoxPtr top = (y < yHeight) ? getCell(x, y) : 0;
+                CellBoxPtr bottom = (0 < y) ? getCell(x, y - 1) : 0;
                 resolveHorizontalBorderConflict(x, y, br, top, bottom);
             }
             if (y < yHeight) {
                 BorderValue* bc = getColumnBorderValue(x, y);
-                CellBoxPtr left = (x < xWidth) ? grid[y][x] : 0;
-                CellBoxPtr right = (0 < x) ? grid[y][x - 1] : 0;
+                CellBoxPtr left = (x < xWidth) ? getCell(x, y) : 0;
+                CellBoxPtr right = (0 < x) ? getCell(x - 1, y) : 0;
                 resolveVerticalBorderConflict(x, y, bc, left, right);
             }
         }
@@ -1072,7 +1117,7 @@ void TableWrapperBox::layOutFixed(ViewCSSImp* view, const ContainingBlockPtr& co
         return;
     float hs = 0.0f;
     if (!collapsingModel) {
-        hs = style->borderSpacing.getHorizontalSpacing();
+        hs = style->tableValues->borderSpacing.getHorizontalSpacing();
         BlockPtr tableBox(getTableBox());
         assert(tableBox);
         tableBox->width -= tableBox->getBorderWidth() - tableBox->width;  // TODO: HTML, XHTML only
@@ -1085,18 +1130,18 @@ void TableWrapperBox::layOutFixed(ViewCSSImp* view, const ContainingBlockPtr& co
         if (CSSStyleDeclarationPtr colStyle = columns[x]) {
             if (!colStyle->width.isAuto()) {
                 colStyle->resolve(view, containingBlock);
-                widths[x] = colStyle->borderLeftWidth.getPx() +
+                widths[x] = colStyle->borderValues->borderLeftWidth.getPx() +
                             colStyle->paddingLeft.getPx() +
                             colStyle->width.getPx() +
                             colStyle->paddingRight.getPx() +
-                            colStyle->borderRightWidth.getPx() +
+                            colStyle->borderValues->borderRightWidth.getPx() +
                             hs;
                 sum += widths[x];
                 --remainingColumns;
                 continue;
             }
         }
-        CellBoxPtr cellBox = grid[0][x];
+        const CellBoxPtr& cellBox = getCell(x, 0);
         if (!cellBox || cellBox->isSpanned(x, 0))
             continue;
         CSSStyleDeclarationPtr cellStyle = cellBox->getStyle();
@@ -1104,11 +1149,11 @@ void TableWrapperBox::layOutFixed(ViewCSSImp* view, const ContainingBlockPtr& co
             continue;
         cellStyle->resolve(view, containingBlock);
         unsigned span = cellBox->getColSpan();
-        float w = cellStyle->borderLeftWidth.getPx() +
+        float w = cellStyle->borderValues->borderLeftWidth.getPx() +
                   cellStyle->paddingLeft.getPx() +
                   cellStyle->width.getPx() +
                   cellStyle->paddingRight.getPx() +
-                  cellStyle->borderRightWidth.getPx() +
+                  cellStyle->borderValues->borderRightWidth.getPx() +
                   hs * span;
         w /= span;
         for (unsigned i = x; i < x + span; ++i) {
@@ -1145,10 +1190,10 @@ void TableWrapperBox::layOutAuto(ViewCSSImp* view, const ContainingBlockPtr& con
         if (CSSStyleDeclarationPtr colStyle = columns[x]) {
             if (!colStyle->width.isAuto()) {
                 colStyle->resolve(view, containingBlock);
-                widths[x] = colStyle->borderLeftWidth.getPx() +
+                widths[x] = colStyle->borderValues->borderLeftWidth.getPx() +
                             colStyle->paddingLeft.getPx() +
                             colStyle->paddingRight.getPx() +
-                            colStyle->borderRightWidth.getPx();
+                            colStyle->borderValues->borderRightWidth.getPx();
                 if (!colStyle->width.isPercentage())
                     widths[x] += colStyle->width.getPx();
                 else
@@ -1174,10 +1219,10 @@ void TableWrapperBox::layOutAutoColgroup(ViewCSSImp* view, const ContainingBlock
         }
         if (!columnGroupStyle->width.isAuto()) {
             columnGroupStyle->resolve(view, containingBlock);
-            float w = columnGroupStyle->borderLeftWidth.getPx() +
+            float w = columnGroupStyle->borderValues->borderLeftWidth.getPx() +
                       columnGroupStyle->paddingLeft.getPx() +
                       columnGroupStyle->paddingRight.getPx() +
-                      columnGroupStyle->borderRightWidth.getPx();
+                      columnGroupStyle->borderValues->borderRightWidth.getPx();
             if (!columnGroupStyle->width.isPercentage())
                 w += columnGroupStyle->width.getPx();
             if (sum < w) {
@@ -1209,7 +1254,7 @@ void TableWrapperBox::layOutTableBox(ViewCSSImp* view, FormattingContext* contex
         if (!collapsingModel) {
             tableBox->updatePadding();
             tableBox->updateBorderWidth();
-            hs = style->borderSpacing.getHorizontalSpacing();
+            hs = style->tableValues->borderSpacing.getHorizontalSpacing();
         }
     }
     // Note 'width' needs to be preserved since it is used as the width of
@@ -1233,10 +1278,10 @@ void TableWrapperBox::layOutTableBox(ViewCSSImp* view, FormattingContext* contex
     for (unsigned y = 0; y < yHeight; ++y) {
         rowImages[y] = 0;
         CSSStyleDeclarationPtr rowStyle = rows[y];
-        if (rowStyle && !rowStyle->backgroundImage.isNone()) {
-            HttpRequestPtr request = view->preload(view->getDocument()->getDocumentURI(), rowStyle->backgroundImage.getValue());
+        if (rowStyle && !rowStyle->backgroundValues->backgroundImage.isNone()) {
+            HttpRequestPtr request = view->preload(view->getDocument()->getDocumentURI(), rowStyle->backgroundValues->backgroundImage.getValue());
             if (request)
-                rowImages[y] = request->getBoxImage(rowStyle->backgroundRepeat.getValue());
+                rowImages[y] = request->getBoxImage(rowStyle->backgroundValues->backgroundRepeat.getValue());
         }
     }
     rowGroupImages.resize(yHeight);
@@ -1244,10 +1289,10 @@ void TableWrapperBox::layOutTableBox(ViewCSSImp* view, FormattingContext* contex
         rowGroupImages[y] = 0;
         CSSStyleDeclarationPtr rowGroupStyle = rowGroups[y];
         if (rowGroupStyle) {
-            if (!rowGroupStyle->backgroundImage.isNone()) {
-                HttpRequestPtr request = view->preload(view->getDocument()->getDocumentURI(), rowGroupStyle->backgroundImage.getValue());
+            if (!rowGroupStyle->backgroundValues->backgroundImage.isNone()) {
+                HttpRequestPtr request = view->preload(view->getDocument()->getDocumentURI(), rowGroupStyle->backgroundValues->backgroundImage.getValue());
                 if (request)
-                    rowGroupImages[y] = request->getBoxImage(rowGroupStyle->backgroundRepeat.getValue());
+                    rowGroupImages[y] = request->getBoxImage(rowGroupStyle->backgroundValues->backgroundRepeat.getValue());
             }
             while (rowGroupStyle == rowGroups[++y])
                 ;
@@ -1259,10 +1304,10 @@ void TableWrapperBox::layOutTableBox(ViewCSSImp* view, FormattingContext* contex
     for (unsigned x = 0; x < xWidth; ++x) {
         columnImages[x] = 0;
         CSSStyleDeclarationPtr columnStyle = columns[x];
-        if (columnStyle && !columnStyle->backgroundImage.isNone()) {
-            HttpRequestPtr request = view->preload(view->getDocument()->getDocumentURI(), columnStyle->backgroundImage.getValue());
+        if (columnStyle && !columnStyle->backgroundValues->backgroundImage.isNone()) {
+            HttpRequestPtr request = view->preload(view->getDocument()->getDocumentURI(), columnStyle->backgroundValues->backgroundImage.getValue());
             if (request)
-                columnImages[x] = request->getBoxImage(columnStyle->backgroundRepeat.getValue());
+                columnImages[x] = request->getBoxImage(columnStyle->backgroundValues->backgroundRepeat.getValue());
         }
     }
     columnGroupImages.resize(xWidth);
@@ -1270,10 +1315,10 @@ void TableWrapperBox::layOutTableBox(ViewCSSImp* view, FormattingContext* contex
         columnGroupImages[x] = 0;
         CSSStyleDeclarationPtr columnGroupStyle = columnGroups[x];
         if (columnGroupStyle) {
-            if (!columnGroupStyle->backgroundImage.isNone()) {
-                HttpRequestPtr request = view->preload(view->getDocument()->getDocumentURI(), columnGroupStyle->backgroundImage.getValue());
+            if (!columnGroupStyle->backgroundValues->backgroundImage.isNone()) {
+                HttpRequestPtr request = view->preload(view->getDocument()->getDocumentURI(), columnGroupStyle->backgroundValues->backgroundImage.getValue());
                 if (request)
-                    columnGroupImages[x] = request->getBoxImage(columnGroupStyle->backgroundRepeat.getValue());
+                    columnGroupImages[x] = request->getBoxImage(columnGroupStyle->backgroundValues->backgroundRepeat.getValue());
             }
             while (columnGroupStyle == columnGroups[++x])
                 ;
@@ -1290,6 +1335,9 @@ void TableWrapperBox::layOutTableBox(ViewCSSImp* view, FormattingContext* contex
     else
         layOutAuto(view, containingBlock);
     float tableWidth = width;
+    float contributionWidth = tableBox->width;
+    if (!fixedLayout)
+        loadCellGlyphs(contributionWidth);
     int pass = 0;
 Reflow:
     for (unsigned y = 0; y < yHeight; ++y) {
@@ -1298,7 +1346,7 @@ Reflow:
             heights[y] = rows[y]->height.getPx();
         bool noBaseline = true;
         for (unsigned x = 0; x < xWidth; ++x) {
-            CellBoxPtr cellBox = grid[y][x];
+            const CellBoxPtr& cellBox = getCell(x, y);
             if (!cellBox || cellBox->isSpanned(x, y))
                 continue;
             if (fixedLayout) {
@@ -1313,8 +1361,24 @@ Reflow:
                     tableBox->width -= hs / 2.0f;
                 cellBox->fixedLayout = true;
             }
-            cellBox->layOut(view, 0);
-            cellBox->intrinsicHeight = cellBox->getTotalHeight();
+            if (!fixedLayout && pass == 0 && cellBox->hasContributions(contributionWidth)) {
+                // The cell has not been changed since it was measured; it is
+                // laid out in the next pass only if its column width changes.
+                cellBox->resolveMargins();
+            } else if (fixedLayout || !cellBox->reuseLayout()) {
+                cellBox->layOut(view, 0);
+                cellBox->intrinsicHeight = cellBox->getTotalHeight();
+                cellBox->layoutColumnWidth = cellBox->columnWidth;
+                cellBox->layoutPaddingTop = cellBox->paddingTop;
+                cellBox->layoutHeight = cellBox->height;
+                if (!fixedLayout && pass == 0) {
+                    cellBox->minContribution = cellBox->getMCW() - cellBox->marginLeft - cellBox->marginRight;
+                    cellBox->maxContribution = cellBox->getTotalWidth() - cellBox->marginLeft - cellBox->marginRight;
+                    cellBox->contributionWidth = contributionWidth;
+                }
+            }
+            float minWidth = (pass == 0) ? cellBox->getMinContribution() : cellBox->getMCW();
+            float maxWidth = (pass == 0) ? cellBox->getMaxContribution() : cellBox->getTotalWidth();
             // Process 'height' as the minimum height.
             CSSStyleDeclarationPtr cellStyle = cellBox->isAnonymous() ? nullptr : cellBox->getStyle();
             if (cellBox->getRowSpan() == 1) {
@@ -1326,14 +1390,14 @@ Reflow:
                 if (cellStyle) {
                     if (cellStyle->width.isPercentage()) {
                         percentages[x] = std::max(percentages[x], cellStyle->width.getPercentage());
-                        fixedWidths[x] = std::max(fixedWidths[x], ceilf(cellBox->getTotalWidth()));
+                        fixedWidths[x] = std::max(fixedWidths[x], ceilf(maxWidth));
                     } else if (!cellStyle->width.isAuto())
-                        fixedWidths[x] = std::max(fixedWidths[x], cellBox->getMCW());
+                        fixedWidths[x] = std::max(fixedWidths[x], minWidth);
                     else
-                        fixedWidths[x] = std::max(fixedWidths[x], ceilf(cellBox->getTotalWidth()));
+                        fixedWidths[x] = std::max(fixedWidths[x], ceilf(maxWidth));
                 } else
-                    fixedWidths[x] = std::max(fixedWidths[x], ceilf(cellBox->getTotalWidth()));
-                widths[x] = std::max(widths[x], cellBox->getMCW());
+                    fixedWidths[x] = std::max(fixedWidths[x], ceilf(maxWidth));
+                widths[x] = std::max(widths[x], minWidth);
             }
             if (cellBox->getVerticalAlign() == CSSVerticalAlignValueImp::Baseline) {
                 baselines[y] = std::max(baselines[y], cellBox->getBaseline());
@@ -1342,7 +1406,7 @@ Reflow:
         }
         // Process baseline
         for (unsigned x = 0; x < xWidth; ++x) {
-            CellBoxPtr cellBox = grid[y][x];
+            const CellBoxPtr& cellBox = getCell(x, y);
             if (!cellBox || cellBox->isSpanned(x, y) || cellBox->getRowSpan() != 1)
                 continue;
             if (cellBox->getVerticalAlign() == CSSVerticalAlignValueImp::Baseline)
@@ -1368,25 +1432,27 @@ Reflow:
         tableBox->width = tableWidth;
     for (unsigned x = 0; x < xWidth; ++x) {
         for (unsigned y = 0; y < yHeight; ++y) {
-            CellBoxPtr cellBox = grid[y][x];
+            const CellBoxPtr& cellBox = getCell(x, y);
             if (!cellBox || cellBox->isSpanned(x, y))
                 continue;
             if (!fixedLayout) {
                 unsigned span = cellBox->getColSpan();
                 if (1 < span) {
+                    float minWidth = (pass == 0) ? cellBox->getMinContribution() : cellBox->getMCW();
+                    float maxWidth = (pass == 0) ? cellBox->getMaxContribution() : cellBox->getTotalWidth();
                     float sum = 0.0f;
                     for (unsigned c = 0; c < span; ++c)
                         sum += widths[x + c];
-                    if (sum < cellBox->getMCW()) {
-                        float diff = (cellBox->getMCW() - sum) / span;
+                    if (sum < minWidth) {
+                        float diff = (minWidth - sum) / span;
                         for (unsigned c = 0; c < span; ++c)
                             widths[x + c] += diff;
                     }
                     sum = 0.0f;
                     for (unsigned c = 0; c < span; ++c)
                         sum += fixedWidths[x + c];
-                    if (sum < cellBox->getTotalWidth()) {
-                        float diff = (cellBox->getTotalWidth() - sum) / span;
+                    if (sum < maxWidth) {
+                        float diff = (maxWidth - sum) / span;
                         for (unsigned c = 0; c < span; ++c)
                             fixedWidths[x + c] += diff;
                     }
@@ -1499,7 +1565,7 @@ Reflow:
             // At this point, column widths have been determined.
             for (unsigned x = 0; x < xWidth; ++x) {
                 for (unsigned y = 0; y < yHeight; ++y) {
-                    CellBoxPtr cellBox = grid[y][x];
+                    const CellBoxPtr& cellBox = getCell(x, y);
                     if (!cellBox || cellBox->isSpanned(x, y))
                         continue;
                     unsigned span = cellBox->getColSpan();
@@ -1529,7 +1595,7 @@ Reflow:
 
     for (unsigned x = 0; x < xWidth; ++x) {
         for (unsigned y = 0; y < yHeight; ++y) {
-            CellBoxPtr cellBox = grid[y][x];
+            const CellBoxPtr& cellBox = getCell(x, y);
             if (!cellBox || cellBox->isSpanned(x, y))
                 continue;
             if (!fixedLayout) {
@@ -1573,7 +1639,7 @@ Reflow:
 
         float xOffset = 0.0f;
         for (unsigned x = 0; x < xWidth; ++x) {
-            CellBoxPtr cellBox = grid[y][x];
+            const CellBoxPtr& cellBox = getCell(x, y);
             if (!cellBox || cellBox->isSpanned(x, y) && cellBox->row != y) {
                 xOffset += widths[x];
                 continue;
@@ -1614,6 +1680,74 @@ Reflow:
     tableBox->flags &= ~(NEED_EXPANSION | NEED_REFLOW | NEED_CHILD_REFLOW);
 }
 
+// Loads the glyphs used in the cells that are going to be measured. The cells
+// themselves are laid out one by one since they share the styles and the
+// stacking contexts with the rest of the box tree, but rendering the glyphs
+// on their first use, which dominates the measurement of a large table, can
+// be done concurrently for each font face.
+void TableWrapperBox::loadCellGlyphs(float contributionWidth)
+{
+    if (std::thread::hardware_concurrency() < 2)
+        return;
+
+    // Measure the text first so that a small table costs no more than a walk
+    // over its cells.
+    std::vector<Node> nodes;
+    size_t length = 0;
+    for (unsigned y = 0; y < yHeight; ++y) {
+        for (unsigned x = 0; x < xWidth; ++x) {
+            const CellBoxPtr& cellBox = getCell(x, y);
+            if (!cellBox || cellBox->isSpanned(x, y) || cellBox->hasContributions(contributionWidth))
+                continue;
+            for (auto i = cellBox->inlines.begin(); i != cellBox->inlines.end(); ++i) {
+                if (i->getNodeType() != Node::TEXT_NODE)
+                    continue;
+                length += interface_cast<Text>(*i).getLength();
+                nodes.push_back(*i);
+            }
+        }
+    }
+    if (length < MinParallelGlyphText)
+        return;  // The glyphs are loaded on demand.
+
+    std::map<FontFace*, std::map<FontTexture*, std::u16string>> texts;
+    for (auto i = nodes.begin(); i != nodes.end(); ++i) {
+        Element element = getContainingElement(*i);
+        CSSStyleDeclarationPtr style = element ? view->getStyle(element) : nullptr;
+        if (FontTexture* font = style ? style->getFontTexture() : 0)
+            texts[font->getFace()][font] += interface_cast<Text>(*i).getData();
+    }
+    unsigned threadCount = std::min<unsigned>(texts.size(), std::thread::hardware_concurrency());
+    if (threadCount < 2)
+        return;
+
+    std::mutex mutex;
+    auto next = texts.begin();
+    auto worker = [&texts, &next, &mutex]() {
+        for (;;) {
+            std::map<FontTexture*, std::u16string>* job;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (next == texts.end())
+                    return;
+                job = &(next++)->second;
+            }
+            for (auto i = job->begin(); i != job->end(); ++i)
+                i->first->loadGlyphs(i->second);
+        }
+    };
+    std::vector<std::thread> threads;
+    try {
+        while (threads.size() < threadCount - 1)
+            threads.emplace_back(worker);
+    } catch (...) {
+        // Process the rest in this thread.
+    }
+    worker();
+    for (auto i = threads.begin(); i != threads.end(); ++i)
+        i->join();
+}
+
 void TableWrapperBox::layOutTableParts()
 {
     for (auto i = blockMap.begin(); i != blockMap.end(); ++i) {
@@ -1621,6 +1755,7 @@ void TableWrapperBox::layOutTableParts()
         if (!block->needLayout())
             continue;
         if (auto cellBox = std::dynamic_pointer_cast<CellBox>(block)) {
+            cellBox->discardLayout();
             float savedMCW = cellBox->getMCW();
             float savedWidth = cellBox->getTotalWidth();
             float savedIntrinsicHeight = cellBox->intrinsicHeight;
@@ -1653,7 +1788,7 @@ void TableWrapperBox::resetCellBoxWidths()
 {
     for (unsigned y = 0; y < yHeight; ++y) {
         for (unsigned x = 0; x < xWidth; ++x) {
-            CellBoxPtr cellBox = grid[y][x];
+            const CellBoxPtr& cellBox = getCell(x, y);
             if (!cellBox || cellBox->isSpanned(x, y))
                 continue;
             cellBox->resetWidth();
@@ -1677,14 +1812,14 @@ bool TableWrapperBox::layOut(ViewCSSImp* view, FormattingContext* context)
 
     // The computed values of properties 'position', 'float', 'margin-*', 'top', 'right', 'bottom',
     // and 'left' on the table element are used on the table wrapper box and not the table box;
-    backgroundColor = getParentBox() ? 0x00000000 : style->backgroundColor.getARGB();
+    backgroundColor = getParentBox() ? 0x00000000 : style->backgroundValues->backgroundColor.getARGB();
     paddingTop = paddingRight = paddingBottom = paddingLeft = 0.0f;
     borderTop = borderRight = borderBottom = borderLeft = 0.0f;
     float leftover = resolveWidth(containingBlock->width, context);
     resolveHeight();
 
     visibility = style->visibility.getValue();
-    textAlign = style->textAlign.getValue();
+    textAlign = style->textValues->textAlign.getValue();
 
     if (context) {
         collapseMarginTop(context);
@@ -1783,7 +1918,7 @@ void TableWrapperBox::layOutAbsolute(ViewCSSImp* view)
 
     // The computed values of properties 'position', 'float', 'margin-*', 'top', 'right', 'bottom',
     // and 'left' on the table element are used on the table wrapper box and not the table box;
-    backgroundColor = getParentBox() ? 0x00000000 : style->backgroundColor.getARGB();
+    backgroundColor = getParentBox() ? 0x00000000 : style->backgroundValues->backgroundColor.getARGB();
     paddingTop = paddingRight = paddingBottom = paddingLeft = 0.0f;
     borderTop = borderRight = borderBottom = borderLeft = 0.0f;
 
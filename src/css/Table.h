@@ -43,7 +43,21 @@ class CellBox : public Block
     float intrinsicHeight;
     float columnWidth;
 
+    // The min/max width contributions to the column(s) measured by the
+    // first pass of the automatic table layout, cached so that the cell
+    // does not need to be laid out again while it is clean. The horizontal
+    // margins are excluded as they depend on the position of the cell.
+    float minContribution;
+    float maxContribution;
+    float contributionWidth;    // the table width used for the measurement
+    // The results of the last layout at a given column width, before the
+    // vertical alignment has been applied.
+    float layoutColumnWidth;
+    float layoutPaddingTop;
+    float layoutHeight;
+
     float getBaseline(const BoxPtr& box) const;
+    void resolveMargins();
 
 public:
     CellBox(Element element = nullptr, const CSSStyleDeclarationPtr& style = nullptr);
@@ -97,6 +111,22 @@ public:
         return columnWidth;
     }
     float adjustWidth();
+    bool isClean() const {
+        return !(flags & (NEED_EXPANSION | NEED_CHILD_EXPANSION | NEED_REFLOW | NEED_CHILD_REFLOW | NEED_TABLE_REFLOW));
+    }
+    bool hasContributions(float tableWidth) const {
+        return contributionWidth == tableWidth && isClean();
+    }
+    float getMinContribution() const {
+        return minContribution + marginLeft + marginRight;
+    }
+    float getMaxContribution() const {
+        return maxContribution + marginLeft + marginRight;
+    }
+    void discardLayout() {
+        contributionWidth = layoutColumnWidth = NAN;
+    }
+    bool reuseLayout();
     void resetWidth() {
         columnWidth = NAN;
         fixedLayout = false;
@@ -114,20 +144,20 @@ class TableWrapperBox : public Block
 {
     typedef BlockPtr Caption;
 
-    typedef std::deque<CellBoxPtr> Row;
-    typedef std::deque<Row> Grid;
+    typedef std::vector<CellBoxPtr> Grid;    // row-major
 
     struct BorderValue
     {
-        CSSBorderColorValueImp color;
+        unsigned color;
         CSSBorderStyleValueImp style;
         float width;
     public:
         BorderValue() :
+            color(0xff000000),
             width(0.0f)
         {}
 
-        bool resolveBorderConflict(CSSBorderColorValueImp& c, CSSBorderStyleValueImp& s, CSSBorderWidthValueImp& w);
+        bool resolveBorderConflict(unsigned c, const CSSBorderStyleValueImp& s, const CSSBorderWidthValueImp& w);
         void resolveBorderConflict(CSSStyleDeclarationPtr s, unsigned trbl);
         float getWidth() const {
             return width;
@@ -159,7 +189,7 @@ class TableWrapperBox : public Block
     std::deque<CSSStyleDeclarationPtr> columns;
     std::deque<CSSStyleDeclarationPtr> columnGroups;
 
-    Grid grid;
+    Grid grid;  // xWidth * yHeight cells
     unsigned xWidth;
     unsigned yHeight;
 
@@ -222,6 +252,7 @@ class TableWrapperBox : public Block
     void layOutAuto(ViewCSSImp* view, const ContainingBlockPtr& containingBlock);
     void layOutAutoColgroup(ViewCSSImp* view, const ContainingBlockPtr& containingBlock);
     void layOutTableBox(ViewCSSImp* view, FormattingContext* context, const ContainingBlockPtr& containingBlock, bool collapsingModel, bool fixedLayout);
+    void loadCellGlyphs(float contributionWidth);
     void layOutTableParts();
     void resetCellBoxWidths();
 
@@ -237,6 +268,15 @@ public:
     void revertTablePart(Node node);
     void reconstructBlocks();
 
+    CellBoxPtr& getCell(unsigned x, unsigned y) {
+        assert(x < xWidth && y < yHeight);
+        return grid[xWidth * y + x];
+    }
+    const CellBoxPtr& getCell(unsigned x, unsigned y) const {
+        assert(x < xWidth && y < yHeight);
+        return grid[xWidth * y + x];
+    }
+
     BorderValue* getRowBorderValue(unsigned x, unsigned y) {
         assert(x < xWidth);
         return &borderRows[xWidth * y + x];
@@ -51,10 +51,8 @@ void TableWrapperBox::renderBackground(ViewCSSImp* view, const CSSStyleDeclarati
     }
 
     if (backgroundImage && backgroundImage->getState() == BoxImage::CompletelyAvailable) {
-        // TODO: Check style->backgroundAttachment.isFixed()
-        style->backgroundPosition.resolve(view, backgroundImage, style.get(), width, height);
-        backgroundLeft = style->backgroundPosition.getLeftPx();
-        backgroundTop = style->backgroundPosition.getTopPx();
+        // TODO: Check style->backgroundValues->backgroundAttachment.isFixed()
+        style->backgroundValues->backgroundPosition.resolve(view, backgroundImage, style.get(), width, height, backgroundLeft, backgroundTop);
         GLfloat border[] = { ((backgroundColor >> 16) & 0xff) / 255.0f,
                              ((backgroundColor >> 8) & 0xff) / 255.0f,
                              ((backgroundColor) & 0xff) / 255.0f,
@@ -84,7 +82,7 @@ void TableWrapperBox::renderLayers(ViewCSSImp* view)
     w = tableBox->getX() + tableBox->getMarginLeft();
     for (unsigned x = 0; x < xWidth;) {
         CSSStyleDeclarationPtr columnGroupStyle = columnGroups[x];
-        if (columnGroupStyle && (columnGroupImages[x] || columnGroupStyle->backgroundColor.getARGB())) {
+        if (columnGroupStyle && (columnGroupImages[x] || columnGroupStyle->backgroundValues->backgroundColor.getARGB())) {
             BoxImage* image = columnGroupImages[x];
             h = tableBox->getY() + tableBox->getMarginTop();
             float w0 = w;
@@ -96,12 +94,12 @@ void TableWrapperBox::renderLayers(ViewCSSImp* view)
                 wN += widths[x + elements];
                 ++elements;
             }
-            if (CellBoxPtr cellBox = grid[0][x]) {
+            if (const CellBoxPtr& cellBox = getCell(x, 0)) {
                 h0 = cellBox->y + cellBox->getMarginTop();
                 if (!cellBox->isLeftSpanned(x)) // TODO: else look up for a single column spanning cell.
                     w0 = cellBox->x + cellBox->getMarginLeft();
             }
-            if (CellBoxPtr cellBox = grid[yHeight - 1][x + elements - 1]) {
+            if (const CellBoxPtr& cellBox = getCell(x + elements - 1, yHeight - 1)) {
                 hN = cellBox->y + cellBox->getTotalHeight() - cellBox->getMarginBottom();
                 if (!cellBox->isRightSpanned(x + elements)) // TODO: else look up for a single column spanning cell.
                     wN = cellBox->x + cellBox->getTotalWidth() - cellBox->getMarginRight();
@@ -109,14 +107,14 @@ void TableWrapperBox::renderLayers(ViewCSSImp* view)
             unsigned x0 = x;
             for (unsigned end = x + elements; x < end; w += widths[x], ++x) {
                 for (unsigned y = 0; y < yHeight; h += heights[y], ++y) {
-                    CellBoxPtr cellBox = grid[y][x];
+                    const CellBoxPtr& cellBox = getCell(x, y);
                     if (!cellBox || cellBox->isEmptyCell() || cellBox->isSpanned(x, y))
                         continue;
                     left = cellBox->x;
                     top = cellBox->y;
                     right = left + cellBox->getTotalWidth();
                     bottom = top + cellBox->getTotalHeight();
-                    if (style->borderCollapse.getValue() == CSSBorderCollapseValueImp::Separate) {
+                    if (style->tableValues->borderCollapse.getValue() == CSSBorderCollapseValueImp::Separate) {
                         left += cellBox->getMarginLeft();
                         right -= cellBox->getMarginRight();
                         top += cellBox->getMarginTop();
@@ -131,7 +129,7 @@ void TableWrapperBox::renderLayers(ViewCSSImp* view)
                         if (y + 1 == yHeight)
                             bottom -= cellBox->getMarginBottom();
                     }
-                    renderBackground(view, columnGroupStyle, w0, h0, left, top, right, bottom, wN - w0, hN - h0, columnGroupStyle->backgroundColor.getARGB(), image);
+                    renderBackground(view, columnGroupStyle, w0, h0, left, top, right, bottom, wN - w0, hN - h0, columnGroupStyle->backgroundValues->backgroundColor.getARGB(), image);
                 }
             }
         } else {
@@ -144,31 +142,31 @@ void TableWrapperBox::renderLayers(ViewCSSImp* view)
     w = tableBox->getX() + tableBox->getMarginLeft();
     for (unsigned x = 0; x < xWidth; w += widths[x], ++x) {
         CSSStyleDeclarationPtr columnStyle = columns[x];
-        if (columnStyle && (columnImages[x] || columnStyle->backgroundColor.getARGB())) {
+        if (columnStyle && (columnImages[x] || columnStyle->backgroundValues->backgroundColor.getARGB())) {
             h = tableBox->getY() + tableBox->getMarginTop();
             float w0 = w;
             float h0 = h;
             float wN = w0 + widths[x];
             float hN = h0 + tableBox->height;
-            if (CellBoxPtr cellBox = grid[0][x]) {
+            if (const CellBoxPtr& cellBox = getCell(x, 0)) {
                 h0 = cellBox->y + cellBox->getMarginTop();
                 if (!cellBox->isLeftSpanned(x)) // TODO: else look up for a single column spanning cell.
                     w0 = cellBox->x + cellBox->getMarginLeft();
             }
-            if (CellBoxPtr cellBox = grid[yHeight - 1][x]) {
+            if (const CellBoxPtr& cellBox = getCell(x, yHeight - 1)) {
                 hN = cellBox->y + cellBox->getTotalHeight() - cellBox->getMarginBottom();
                 if (!cellBox->isRightSpanned(x + 1)) // TODO: else look up for a single column spanning cell.
                     wN = cellBox->x + cellBox->getTotalWidth() - cellBox->getMarginRight();
             }
             for (unsigned y = 0; y < yHeight; h += heights[y], ++y) {
-                CellBoxPtr cellBox = grid[y][x];
+                const CellBoxPtr& cellBox = getCell(x, y);
                 if (!cellBox || cellBox->isEmptyCell() || cellBox->isSpanned(x, y))
                     continue;
                 left = cellBox->x;
                 top = cellBox->y;
                 right = left + cellBox->getTotalWidth();
                 bottom = top + cellBox->getTotalHeight();
-                if (style->borderCollapse.getValue() == CSSBorderCollapseValueImp::Separate) {
+                if (style->tableValues->borderCollapse.getValue() == CSSBorderCollapseValueImp::Separate) {
                     left += cellBox->getMarginLeft();
                     right -= cellBox->getMarginRight();
                     top += cellBox->getMarginTop();
@@ -181,7 +179,7 @@ void TableWrapperBox::renderLayers(ViewCSSImp* view)
                     if (y + 1 == yHeight)
                         bottom -= cellBox->getMarginBottom();
                 }
-                renderBackground(view, columnStyle, w0, h0, left, top, right, bottom, wN - w0, hN - h0, columnStyle->backgroundColor.getARGB(), columnImages[x]);
+                renderBackground(view, columnStyle, w0, h0, left, top, right, bottom, wN - w0, hN - h0, columnStyle->backgroundValues->backgroundColor.getARGB(), columnImages[x]);
             }
         }
     }
@@ -190,7 +188,7 @@ void TableWrapperBox::renderLayers(ViewCSSImp* view)
     h = tableBox->getY() + tableBox->getMarginTop();
     for (unsigned y = 0; y < yHeight;) {
         CSSStyleDeclarationPtr rowGroupStyle = rowGroups[y];
-        if (rowGroupStyle && (rowGroupImages[y] || rowGroupStyle->backgroundColor.getARGB())) {
+        if (rowGroupStyle && (rowGroupImages[y] || rowGroupStyle->backgroundValues->backgroundColor.getARGB())) {
             BoxImage* image = rowGroupImages[y];
             w = tableBox->getX() + tableBox->getMarginLeft();
             float w0 = w;
@@ -202,12 +200,12 @@ void TableWrapperBox::renderLayers(ViewCSSImp* view)
                 hN += heights[y + elements];
                 ++elements;
             }
-            if (CellBoxPtr cellBox = grid[y][0]) {
+            if (const CellBoxPtr& cellBox = getCell(0, y)) {
                 w0 = cellBox->x + cellBox->getMarginLeft();
                 if (!cellBox->isTopSpanned(y)) // TODO: else look up for a single row spanning cell.
                     h0 = cellBox->y + cellBox->getMarginTop();
             }
-            if (CellBoxPtr cellBox = grid[y + elements - 1][xWidth - 1]) {
+            if (const CellBoxPtr& cellBox = getCell(xWidth - 1, y + elements - 1)) {
                 wN = cellBox->x + cellBox->getTotalWidth() - cellBox->getMarginRight();
                 if (!cellBox->isBottomSpanned(y + elements)) // TODO: else look up for a single row spanning cell.
                     hN = cellBox->y + cellBox->getTotalHeight() - cellBox->getMarginBottom();
@@ -215,14 +213,14 @@ void TableWrapperBox::renderLayers(ViewCSSImp* view)
             unsigned y0 = y;
             for (unsigned end = y + elements; y < end; h += heights[y], ++y) {
                 for (unsigned x = 0; x < xWidth; w += widths[x], ++x) {
-                    CellBoxPtr cellBox = grid[y][x];
+                    const CellBoxPtr& cellBox = getCell(x, y);
                     if (!cellBox || cellBox->isEmptyCell() || cellBox->isSpanned(x, y))
                         continue;
                     left = cellBox->x;
                     top = cellBox->y;
                     right = left + cellBox->getTotalWidth();
                     bottom = top + cellBox->getTotalHeight();
-                    if (style->borderCollapse.getValue() == CSSBorderCollapseValueImp::Separate) {
+                    if (style->tableValues->borderCollapse.getValue() == CSSBorderCollapseValueImp::Separate) {
                         left += cellBox->getMarginLeft();
                         right -= cellBox->getMarginRight();
                         top += cellBox->getMarginTop();
@@ -237,7 +235,7 @@ void TableWrapperBox::renderLayers(ViewCSSImp* view)
                         if (y + 1 == end)
                             bottom -= cellBox->getMarginBottom();
                     }
-                    renderBackground(view, rowGroupStyle, w0, h0, left, top, right, bottom, wN - w0, hN - h0, rowGroupStyle->backgroundColor.getARGB(), image);
+                    renderBackground(view, rowGroupStyle, w0, h0, left, top, right, bottom, wN - w0, hN - h0, rowGroupStyle->backgroundValues->backgroundColor.getARGB(), image);
                 }
             }
         } else {
@@ -250,31 +248,31 @@ void TableWrapperBox::renderLayers(ViewCSSImp* view)
     h = tableBox->getY() + tableBox->getMarginTop();
     for (unsigned y = 0; y < yHeight; h += heights[y], ++y) {
         CSSStyleDeclarationPtr rowStyle = rows[y];
-        if (rowStyle && (rowImages[y] || rowStyle->backgroundColor.getARGB())) {
+        if (rowStyle && (rowImages[y] || rowStyle->backgroundValues->backgroundColor.getARGB())) {
             w = tableBox->getX() + tableBox->getMarginLeft();
             float w0 = w;
             float h0 = h;
             float wN = w0 + tableBox->width;
             float hN = h0 + heights[y];
-            if (CellBoxPtr cellBox = grid[y][0]) {
+            if (const CellBoxPtr& cellBox = getCell(0, y)) {
                 w0 = cellBox->x + cellBox->getMarginLeft();
                 if (!cellBox->isTopSpanned(y)) // TODO: else look up for a single row spanning cell.
                     h0 = cellBox->y + cellBox->getMarginTop();
             }
-            if (CellBoxPtr cellBox = grid[y][xWidth - 1]) {
+            if (const CellBoxPtr& cellBox = getCell(xWidth - 1, y)) {
                 wN = cellBox->x + cellBox->getTotalWidth() - cellBox->getMarginRight();
                 if (!cellBox->isBottomSpanned(y + 1)) // TODO: else look up for a single row spanning cell.
                     hN = cellBox->y + cellBox->getTotalHeight() - cellBox->getMarginBottom();
             }
             for (unsigned x = 0; x < xWidth; w += widths[x], ++x) {
-                CellBoxPtr cellBox = grid[y][x];
+                const CellBoxPtr& cellBox = getCell(x, y);
                 if (!cellBox || cellBox->isEmptyCell() || cellBox->isSpanned(x, y))
                     continue;
                 left = cellBox->x;
                 top = cellBox->y;
                 right = left + cellBox->getTotalWidth();
                 bottom = top + cellBox->getTotalHeight();
-                if (style->borderCollapse.getValue() == CSSBorderCollapseValueImp::Separate) {
+                if (style->tableValues->borderCollapse.getValue() == CSSBorderCollapseValueImp::Separate) {
                     left += cellBox->getMarginLeft();
                     right -= cellBox->getMarginRight();
                     top += cellBox->getMarginTop();
@@ -287,7 +285,7 @@ void TableWrapperBox::renderLayers(ViewCSSImp* view)
                     top += cellBox->getMarginTop();
                     bottom -= cellBox->getMarginBottom();
                 }
-                renderBackground(view, rowStyle, w0, h0, left, top, right, bottom, wN - w0, hN - h0, rowStyle->backgroundColor.getARGB(), rowImages[y]);
+                renderBackground(view, rowStyle, w0, h0, left, top, right, bottom, wN - w0, hN - h0, rowStyle->backgroundValues->backgroundColor.getARGB(), rowImages[y]);
             }
         }
     }
@@ -329,7 +327,7 @@ void TableWrapperBox::renderTableBorders(ViewCSSImp* view)
                         if (x == xWidth - 1)
                             rr = -getColumnBorderValue(xWidth, yHeight - 1)->getWidth() / 2.0f;
                     }
-                    renderBorderEdge(view, TOP, br->getStyle(), br->color.getARGB(),
+                    renderBorderEdge(view, TOP, br->getStyle(), br->color,
                                      l - ll, t, r + rr, t, r - rr, b, l + ll, b);
                 }
             }
@@ -354,7 +352,7 @@ void TableWrapperBox::renderTableBorders(ViewCSSImp* view)
                         if (y == yHeight - 1)
                             bb = -getRowBorderValue(xWidth - 1, yHeight)->getWidth() / 2.0f;
                     }
-                    renderBorderEdge(view, LEFT, bc->getStyle(), bc->color.getARGB(),
+                    renderBorderEdge(view, LEFT, bc->getStyle(), bc->color,
                                      l, b + bb, l, t - tt, r, t + tt, r, b - bb);
                 }
             }
@@ -379,9 +377,9 @@ void TableWrapperBox::renderTableOutlines(ViewCSSImp* view)
             h += heights[y];
             for (++y; rowGroupStyle == rowGroups[y]; ++y)
                 h += heights[y];
-            if (0.0f < rowGroupStyle->outlineWidth.getPx())
+            if (0.0f < rowGroupStyle->outlineValues->outlineWidth.getPx())
                 renderOutline(view, tableBox->getX(), h0, tableBox->getX() + tableBox->width, h,
-                              rowGroupStyle->outlineWidth.getPx(), rowGroupStyle->outlineStyle.getValue(), rowGroupStyle->outlineColor.getARGB());
+                              rowGroupStyle->outlineValues->outlineWidth.getPx(), rowGroupStyle->outlineValues->outlineStyle.getValue(), rowGroupStyle->outlineValues->outlineColor.getARGB());
         } else {
             h += heights[y];
             ++y;
@@ -392,15 +390,15 @@ void TableWrapperBox::renderTableOutlines(ViewCSSImp* view)
     h = tableBox->getY() + tableBox->getMarginTop();
     for (unsigned y = 0; y < yHeight; h += heights[y], ++y) {
         CSSStyleDeclarationPtr rowStyle = rows[y];
-        if (rowStyle && 0.0f < rowStyle->outlineWidth.getPx())
+        if (rowStyle && 0.0f < rowStyle->outlineValues->outlineWidth.getPx())
             renderOutline(view, tableBox->getX(), h, tableBox->getX() + tableBox->width, h + heights[y],
-                          rowStyle->outlineWidth.getPx(), rowStyle->outlineStyle.getValue(), rowStyle->outlineColor.getARGB());
+                          rowStyle->outlineValues->outlineWidth.getPx(), rowStyle->outlineValues->outlineStyle.getValue(), rowStyle->outlineValues->outlineColor.getARGB());
     }
 
     // cells
     for (unsigned y = 0; y < yHeight; ++y) {
         for (unsigned x = 0; x < xWidth; ++x) {
-            CellBoxPtr cellBox = grid[y][x];
+            const CellBoxPtr& cellBox = getCell(x, y);
             if (!cellBox || cellBox->isEmptyCell() || cellBox->isSpanned(x, y))
                 continue;
             cellBox->renderOutline(view, cellBox->x, cellBox->y);
@@ -25,6 +25,7 @@
 #include <org/w3c/dom/html/HTMLStyleElement.h>
 
 #include <new>
+#include <set>
 #include <boost/bind.hpp>
 
 #include "CSSImportRuleImp.h"
@@ -70,10 +71,11 @@ ViewCSSImp::ViewCSSImp(WindowPtr window) :
     window(window),
     dpi(96),
     zoom(1.0f),
-    mutationListener(boost::bind(&ViewCSSImp::handleMutation, this, _1, _2)),
+    mutationObserver(std::make_shared<MutationObserverImp>(MutationObserverImp::Handler(boost::bind(&ViewCSSImp::handleMutations, this, _1)))),
     mediaCheck(false),
     overflow(CSSOverflowValueImp::Auto),
     stackingContexts(0),
+    boxArena(std::make_shared<NodeArena>()),
     quotingDepth(0),
     scrollWidth(0.0f),
     scrollHeight(0.0f),
@@ -81,22 +83,13 @@ ViewCSSImp::ViewCSSImp(WindowPtr window) :
     delay(0)
 {
     setMediumFontSize(16);
-    if (DocumentPtr document = getDocument()) {
-        document->addEventListener(u"DOMAttrModified", mutationListener, false, EventTargetImp::UseDefault);
-        document->addEventListener(u"DOMCharacterDataModified", mutationListener, false, EventTargetImp::UseDefault);
-        document->addEventListener(u"DOMNodeInserted", mutationListener, false, EventTargetImp::UseDefault);
-        document->addEventListener(u"DOMNodeRemoved", mutationListener, false, EventTargetImp::UseDefault);
-    }
+    if (DocumentPtr document = getDocument())
+        mutationObserver->observe(document, MutationObserverImp::ChildList | MutationObserverImp::Attributes | MutationObserverImp::CharacterData | MutationObserverImp::Subtree);
 }
 
 ViewCSSImp::~ViewCSSImp()
 {
-    if (DocumentPtr document = getDocument()) {
-        document->removeEventListener(u"DOMAttrModified", mutationListener, false, EventTargetImp::UseDefault);
-        document->removeEventListener(u"DOMCharacterDataModified", mutationListener, false, EventTargetImp::UseDefault);
-        document->removeEventListener(u"DOMNodeInserted", mutationListener, false, EventTargetImp::UseDefault);
-        document->removeEventListener(u"DOMNodeRemoved", mutationListener, false, EventTargetImp::UseDefault);
-    }
+    mutationObserver->disconnect();
 }
 
 BoxPtr ViewCSSImp::boxFromPoint(int x, int y)
@@ -110,6 +103,15 @@ BoxPtr ViewCSSImp::boxFromPoint(int x, int y)
     return boxTree;
 }
 
+void ViewCSSImp::snapshotHitTargets(HitTestSnapshot& snapshot)
+{
+    snapshot.clear();
+    if (stackingContexts)
+        stackingContexts->snapshotHitTargets(snapshot);
+    if (boxTree)
+        snapshot.add(boxTree.get(), HitTestSnapshot::Rect());
+}
+
 bool ViewCSSImp::isHovered(Element node)
 {
     // TODO: Check if we need to process forefront node only or not.
@@ -135,64 +137,73 @@ void ViewCSSImp::removeComputedStyle(Element element)
     }
 }
 
-void ViewCSSImp::handleMutation(EventListenerImp* listener, events::Event event)
+void ViewCSSImp::handleMutations(const std::deque<events::MutationRecord>& records)
 {
     if (!boxTree)
         return;
 
-    events::MutationEvent mutation(interface_cast<events::MutationEvent>(event));
-    if (mutation.getType() == u"DOMCharacterDataModified") {
-        Node parentNode = interface_cast<Node>(mutation.getRelatedNode());
-        if (Element::hasInstance(parentNode)) {
-            Element element(interface_cast<Element>(parentNode));
-            if (CSSStyleDeclarationPtr style = getStyle(element))
-                style->updateInlines(element);
-        }
-        return;
-    } else if (mutation.getType() == u"DOMNodeInserted") {
-        Node parentNode = interface_cast<Node>(mutation.getRelatedNode());
-        if (!Element::hasInstance(parentNode))
-            return;
-        Node target = interface_cast<Node>(event.getTarget());
-        if (Element::hasInstance(target))
-            setFlags(Box::NEED_SELECTOR_MATCHING);
-        else if (Element::hasInstance(parentNode)) {
-            Element element(interface_cast<Element>(parentNode));
-            if (CSSStyleDeclarationPtr style = getStyle(element))
-                style->updateInlines(element);
-        }
-        return;
-    } else if (mutation.getType() == u"DOMNodeRemoved") {
-        Node parentNode = interface_cast<Node>(mutation.getRelatedNode());
-        if (!Element::hasInstance(parentNode))
-            return;
-        Node target = interface_cast<Node>(event.getTarget());
-        if (Element::hasInstance(target)) {
-            removeComputedStyle(interface_cast<Element>(target));
-            setFlags(Box::NEED_SELECTOR_MATCHING);
-        } else if (Element::hasInstance(parentNode)) {
-            Element element(interface_cast<Element>(parentNode));
-            if (CSSStyleDeclarationPtr style = getStyle(element))
-                style->updateInlines(element);
-        }
-        return;
-    } else if (mutation.getType() == u"DOMAttrModified") {
-        Node target = interface_cast<Node>(event.getTarget());
-        if (Element::hasInstance(target)) {
-            if (CSSStyleDeclarationPtr style = getStyle(interface_cast<Element>(target))) {
-                style->requestReconstruct(Box::NEED_STYLE_RECALCULATION);
-                style->clearFlags(CSSStyleDeclarationImp::Computed);
-                if (mutation.getAttrName() != u"style") {
-                    // Request a selector re-matching for the element
-                    style->setFlags(CSSStyleDeclarationImp::NeedSelectorMatching);
-                    setFlags(Box::NEED_SELECTOR_MATCHING);
+    // Coalesce the records so that each element is restyled at most once.
+    std::set<ElementPtr> inlines;
+    std::map<ElementPtr, bool> restyles;  // true to rematch selectors
+    for (auto i = records.begin(); i != records.end(); ++i) {
+        auto record = std::static_pointer_cast<MutationRecordImp>(i->self());
+        const NodePtr& target = record->getTargetPtr();
+        switch (record->getTypeBit()) {
+        case MutationObserverImp::CharacterData:
+            if (NodePtr parent = target->getParent()) {
+                if (parent->getNodeType() == Node::ELEMENT_NODE)
+                    inlines.insert(std::static_pointer_cast<ElementImp>(parent));
+            }
+            break;
+        case MutationObserverImp::ChildList: {
+            if (target->getNodeType() != Node::ELEMENT_NODE)
+                break;
+            auto parent = std::static_pointer_cast<ElementImp>(target);
+            if (NodeListPtr added = record->getAddedNodeList()) {
+                for (unsigned j = 0; j < added->getLength(); ++j) {
+                    if (added->item(j).getNodeType() == Node::ELEMENT_NODE)
+                        setFlags(Box::NEED_SELECTOR_MATCHING);
+                    else
+                        inlines.insert(parent);
                 }
             }
+            if (NodeListPtr removed = record->getRemovedNodeList()) {
+                for (unsigned j = 0; j < removed->getLength(); ++j) {
+                    Node node = removed->item(j);
+                    if (node.getNodeType() == Node::ELEMENT_NODE) {
+                        removeComputedStyle(interface_cast<Element>(node));
+                        setFlags(Box::NEED_SELECTOR_MATCHING);
+                    } else
+                        inlines.insert(parent);
+                }
+            }
+            break;
+        }
+        case MutationObserverImp::Attributes:
+            if (target->getNodeType() == Node::ELEMENT_NODE)
+                restyles[std::static_pointer_cast<ElementImp>(target)] |= (record->getAttributeNameValue().value() != u"style");
+            break;
+        default:
+            setFlags(Box::NEED_SELECTOR_REMATCHING);
+            break;
         }
-        return;
     }
 
-    setFlags(Box::NEED_SELECTOR_REMATCHING);
+    for (auto i = restyles.begin(); i != restyles.end(); ++i) {
+        if (CSSStyleDeclarationPtr style = getStyle(i->first)) {
+            style->requestReconstruct(Box::NEED_STYLE_RECALCULATION);
+            style->clearFlags(CSSStyleDeclarationImp::Computed);
+            if (i->second) {
+                // Request a selector re-matching for the element
+                style->setFlags(CSSStyleDeclarationImp::NeedSelectorMatching);
+                setFlags(Box::NEED_SELECTOR_MATCHING);
+            }
+        }
+    }
+    for (auto i = inlines.begin(); i != inlines.end(); ++i) {
+        if (CSSStyleDeclarationPtr style = getStyle(*i))
+            style->updateInlines(*i);
+    }
 }
 
 void ViewCSSImp::collectRules(CSSRuleListImp::RuleSet& set, Element element, css::CSSRuleList list, unsigned importance, MediaListPtr mediaList)
@@ -232,12 +243,22 @@ void ViewCSSImp::addStyle(const Element& element, const CSSStyleDeclarationPtr&
     map[element] = style;
 }
 
-void ViewCSSImp::constructComputedStyles()
+void ViewCSSImp::constructComputedStyles(bool rematch)
 {
-    constructComputedStyle(getDocument(), nullptr);
+    constructComputedStyle(getDocument(), nullptr, rematch ? CSSStyleDeclarationImp::NeedSelectorMatching : 0);
     clearFlags(Box::NEED_SELECTOR_MATCHING | Box::NEED_SELECTOR_REMATCHING);  // TODO: Refine
 }
 
+size_t ViewCSSImp::getComputedStyleMemoryUsage(size_t& unshared) const
+{
+    std::set<const void*> groups;
+    size_t used = 0;
+    for (auto i = map.begin(); i != map.end(); ++i)
+        used += i->second->getMemoryUsage(groups);
+    unshared = map.size() * CSSStyleDeclarationImp::getUnsharedMemoryUsage();
+    return used;
+}
+
 void ViewCSSImp::updateStyleRules(Element element, const CSSStyleDeclarationPtr& style, CSSStyleDeclarationPtr parentStyle)
 {
 #ifndef NDEBUG
@@ -428,8 +449,12 @@ void ViewCSSImp::calculateComputedStyle(Element element, const CSSStyleDeclarati
             if (BlockPtr block = getCurrentBox(style, true))
                 block->setFlags(Box::NEED_REPOSITION);
             // else 'position' is relative
-        } else if (BlockPtr block = getCurrentBox(style, true))
-            block->resolveBackground(this);
+        } else {
+            // Only the painted values may have been changed.
+            if (BlockPtr block = getCurrentBox(style, true))
+                block->resolveBackground(this);
+            style->requestRepaint();
+        }
         if (!parentStyle)
             overflow = style->overflow.getValue();
         flags |= CSSStyleDeclarationImp::Computed;  // The child styles have to be recomputed.
@@ -466,14 +491,14 @@ void ViewCSSImp::calculateComputedStyle(Element element, const CSSStyleDeclarati
         else {
             if (style->marker || style->before)
                 style->emptyInline = 1;
-            else if (style->marginLeft.getPx() || style->borderLeftWidth.getPx() || style->paddingLeft.getPx()) {
+            else if (style->marginLeft.getPx() || style->borderValues->borderLeftWidth.getPx() || style->paddingLeft.getPx()) {
                 Node child = shadow.getFirstChild();
                 if (child.getNodeType() != Node::TEXT_NODE)
                     style->emptyInline = 1;
             }
             if (style->after)
                 style->emptyInline |= 2;
-            else if (style->marginRight.getPx() || style->borderRightWidth.getPx() || style->paddingRight.getPx()) {
+            else if (style->marginRight.getPx() || style->borderValues->borderRightWidth.getPx() || style->paddingRight.getPx()) {
                 Node child = shadow.getLastChild();
                 if (child.getNodeType() != Node::TEXT_NODE)
                     style->emptyInline |= 2;
@@ -545,13 +570,13 @@ BlockPtr ViewCSSImp::constructBlock(Text text, const BlockPtr& parentBox, const
     if (style->display.isInline()) {
         Element element = interface_cast<Element>(text.getParentNode());
         assert(element);
-        if (element.getFirstChild() == text && (style->marginLeft.getPx() || style->borderLeftWidth.getPx() || style->paddingLeft.getPx()) ||
-            element.getLastChild() == text && (style->marginRight.getPx() || style->borderRightWidth.getPx() || style->paddingRight.getPx()))
+        if (element.getFirstChild() == text && (style->marginLeft.getPx() || style->borderValues->borderLeftWidth.getPx() || style->paddingLeft.getPx()) ||
+            element.getLastChild() == text && (style->marginRight.getPx() || style->borderValues->borderRightWidth.getPx() || style->paddingRight.getPx()))
             discardable = false;
     }
 
     if (!parentBox->hasChildBoxes()) {
-        if (discardable && !parentBox->hasInline() && style->whiteSpace.isCollapsingSpace()) {
+        if (discardable && !parentBox->hasInline() && style->textValues->whiteSpace.isCollapsingSpace()) {
             std::u16string data = text.getData();
             size_t offset(0);
             bool firstLetter(true);
@@ -577,7 +602,7 @@ BlockPtr ViewCSSImp::constructBlock(Text text, const BlockPtr& parentBox, const
         // White space content that would subsequently be collapsed
         // away according to the 'white-space' property does not
         // generate any anonymous inline boxes.
-        if (style->whiteSpace.isCollapsingSpace()) {
+        if (style->textValues->whiteSpace.isCollapsingSpace()) {
             std::u16string data = text.getData();
             size_t offset(0);
             bool firstLetter(true);
@@ -585,7 +610,7 @@ BlockPtr ViewCSSImp::constructBlock(Text text, const BlockPtr& parentBox, const
                 return nullptr;
         }
     }
-    if (BlockPtr anonymousBox = parentBox->getAnonymousBox(prevBox)) {
+    if (BlockPtr anonymousBox = parentBox->getAnonymousBox(this, prevBox)) {
         anonymousBox->insertInline(text);
         return anonymousBox;
     }
@@ -597,14 +622,14 @@ BlockPtr ViewCSSImp::createBlock(Element element, const BlockPtr& parentBox, con
     assert(style);
     BlockPtr block;
     if (style->display == CSSDisplayValueImp::Table || style->display == CSSDisplayValueImp::InlineTable) {
-        block = std::make_shared<TableWrapperBox>(this, element, style);
+        block = createBox<TableWrapperBox>(this, element, style);
         newContext = true;
     } else if (style->display.isTableParts()) {
         if (asTablePart) {
             if (style->display == CSSDisplayValueImp::TableCell)
-                block = std::make_shared<CellBox>(element, style);
+                block = createBox<CellBox>(element, style);
             else
-                block = std::make_shared<Block>(element, style);
+                block = createBox<Block>(element, style);
         } else {
             assert(parentBox);  // cf. http://www.w3.org/TR/CSS21/visuren.html#dis-pos-flo
             if (parentBox->anonymousTable) {
@@ -612,12 +637,12 @@ BlockPtr ViewCSSImp::createBlock(Element element, const BlockPtr& parentBox, con
                 parentBox->anonymousTable->processTableChild(element, style);
                 return 0;
             }
-            parentBox->anonymousTable = std::make_shared<TableWrapperBox>(this, element, style);
+            parentBox->anonymousTable = createBox<TableWrapperBox>(this, element, style);
             block = parentBox->anonymousTable;
         }
         newContext = true;
     } else
-        block = std::make_shared<Block>(element, style);
+        block = createBox<Block>(element, style);
     if (!block)
         return 0;
     if (newContext)
@@ -696,7 +721,7 @@ BlockPtr ViewCSSImp::constructBlock(Element element, const BlockPtr& parentBox,
                 currentBox->setContainingBox(parentBox);
                 if (!parentBox->hasChildBoxes())
                     parentBox->insertInline(element);
-                else if (prevBox = parentBox->getAnonymousBox(prevBox))
+                else if (prevBox = parentBox->getAnonymousBox(this, prevBox))
                     prevBox->insertInline(element);
             } else {
                 prevBox = std::dynamic_pointer_cast<Block>(currentBox->getParentBox()->getParentBox());
@@ -717,7 +742,7 @@ BlockPtr ViewCSSImp::constructBlock(Element element, const BlockPtr& parentBox,
         if (parentBox) {
             if (!currentBox->getParentBox()) {
                 if (parentBox->hasInline()) {
-                    prevBox = parentBox->getAnonymousBox(prevBox);
+                    prevBox = parentBox->getAnonymousBox(this, prevBox);
                     if (!prevBox)
                         return 0;
                     assert(!parentBox->hasInline());
@@ -798,7 +823,7 @@ BlockPtr ViewCSSImp::constructBlock(Element element, const BlockPtr& parentBox,
         if ((style->emptyInline & 1) || style->emptyInline == 4) {
             if (!currentBox->hasChildBoxes())
                 currentBox->insertInline(element);
-            else if (BlockPtr anonymousBox = currentBox->getAnonymousBox(prev))
+            else if (BlockPtr anonymousBox = currentBox->getAnonymousBox(this, prev))
                 anonymousBox->insertInline(element);
         }
 
@@ -810,7 +835,7 @@ BlockPtr ViewCSSImp::constructBlock(Element element, const BlockPtr& parentBox,
             if (style->height.isAuto() && !shadow.hasChildNodes() && !style->before && !style->after) {
                 if (!currentBox->hasChildBoxes())
                     currentBox->insertInline(element);
-                else if (BlockPtr anonymousBox = currentBox->getAnonymousBox(prev))
+                else if (BlockPtr anonymousBox = currentBox->getAnonymousBox(this, prev))
                     anonymousBox->insertInline(element);
             }
         }
@@ -835,7 +860,7 @@ BlockPtr ViewCSSImp::constructBlock(Element element, const BlockPtr& parentBox,
         if (style->emptyInline & 2) {
             if (!currentBox->hasChildBoxes())
                 currentBox->insertInline(element);
-            else if (BlockPtr anonymousBox = currentBox->getAnonymousBox(prev))
+            else if (BlockPtr anonymousBox = currentBox->getAnonymousBox(this, prev))
                 anonymousBox->insertInline(element);
         }
 
@@ -869,13 +894,17 @@ BlockPtr ViewCSSImp::layOut()
     scrollWidth = 0.0f;
     scrollHeight = 0.0f;
 
+    recordTime("box construction begin");
     if (!constructBlocks())
         return 0;
+    recordTime("box construction end");
 
     // Expand line boxes and inline-level boxes in each block-level box
     if (!boxTree->isAbsolutelyPositioned()) {
         boxTree->layOut(this, 0);
+        recordTime("box layout end");
         boxTree->resolveXY(this, 0.0f, 0.0f, 0);
+        recordTime("box resolveXY end");
     }
 
     if (stackingContexts) {
@@ -971,11 +1000,96 @@ unsigned ViewCSSImp::getBackgroundColor()
     // cf. http://test.csswg.org/suites/css2.1/20110323/html4/root-box-003.htm
     if (DocumentPtr document = getDocument()) {
         if (CSSStyleDeclarationPtr style = getStyle(document->getDocumentElement()))
-            return style->backgroundColor.getARGB();
+            return style->backgroundValues->backgroundColor.getARGB();
     }
     return 0;
 }
 
+void ViewCSSImp::addDamage(const Rect& rect)
+{
+    if (rect.right <= rect.left || rect.bottom <= rect.top)
+        return;
+    if (!damaged) {
+        damage = rect;
+        damaged = true;
+        return;
+    }
+    damage.left = std::min(damage.left, rect.left);
+    damage.top = std::min(damage.top, rect.top);
+    damage.right = std::max(damage.right, rect.right);
+    damage.bottom = std::max(damage.bottom, rect.bottom);
+}
+
+void ViewCSSImp::unite(Rect& rect, const Rect& other)
+{
+    if (other.right <= other.left || other.bottom <= other.top)
+        return;
+    if (rect.right <= rect.left || rect.bottom <= rect.top) {
+        rect = other;
+        return;
+    }
+    rect.left = std::min(rect.left, other.left);
+    rect.top = std::min(rect.top, other.top);
+    rect.right = std::max(rect.right, other.right);
+    rect.bottom = std::max(rect.bottom, other.bottom);
+}
+
+void ViewCSSImp::gatherDamage(const Box* box)
+{
+    for (BoxPtr child = box->getFirstChild(); child && !fullDamage; child = child->getNextSibling()) {
+        if (child->getFlags() & Box::NEED_REPAINT) {
+            auto found = boxRects.find(child.get());
+            if (found == boxRects.end()) {
+                fullDamage = true;
+                return;
+            }
+            addDamage(found->second);
+        }
+        gatherDamage(child.get());
+    }
+}
+
+void ViewCSSImp::gatherDamage(int width, int height)
+{
+    if (!boxTree || (boxTree->getFlags() & Box::NEED_REPAINT))
+        fullDamage = true;
+    else if (!fullDamage)
+        gatherDamage(boxTree.get());
+    if (fullDamage || !damaged)
+        return;
+    damage.left = std::max(damage.left, 0.0f);
+    damage.top = std::max(damage.top, 0.0f);
+    damage.right = std::min(damage.right, static_cast<float>(width));
+    damage.bottom = std::min(damage.bottom, static_cast<float>(height));
+    if (damage.right <= damage.left || damage.bottom <= damage.top)
+        damaged = false;
+    else if (damage.left <= 0.0f && damage.top <= 0.0f && width <= damage.right && height <= damage.bottom)
+        fullDamage = true;
+}
+
+void ViewCSSImp::damageAnimatedImages()
+{
+    if (animatedRects.empty()) {
+        setFlags(Box::NEED_REPAINT);
+        return;
+    }
+    for (auto i = animatedRects.begin(); i != animatedRects.end(); ++i)
+        addDamage(*i);
+    flags |= Box::NEED_REPAINT;
+}
+
+void ViewCSSImp::getDamage(int& left, int& top, int& w, int& h) const
+{
+    if (!damaged) {
+        left = top = w = h = 0;
+        return;
+    }
+    left = static_cast<int>(floorf(damage.left));
+    top = static_cast<int>(floorf(damage.top));
+    w = static_cast<int>(ceilf(damage.right)) - left;
+    h = static_cast<int>(ceilf(damage.bottom)) - top;
+}
+
 char32_t ViewCSSImp::nextChar(const CSSStyleDeclarationPtr& style, const std::u16string data, size_t& offset)
 {
     char32_t u = style->nextChar(data, offset, isFirstLetter, prevChar);
@@ -24,11 +24,16 @@
 #include <org/w3c/dom/css/CSSStyleDeclaration.h>
 #include <org/w3c/dom/html/HTMLTemplateElement.h>
 
+#include <deque>
 #include <map>
+#include <unordered_map>
+#include <vector>
 
 #include "WindowImp.h"
 #include "ElementImp.h"
 #include "EventListenerImp.h"
+#include "MutationObserverImp.h"
+#include "NodeArena.h"
 
 #include "Box.h"
 #include "CounterImp.h"
@@ -59,8 +64,7 @@ class ViewCSSImp
     unsigned mediumFontSize;  // [px]
     float fontSizeTable[MaxFontSizes];
     float zoom;
-
-    Retained<EventListenerImp> mutationListener;
+    MutationObserverPtr mutationObserver;
 
     std::map<MediaListImp*, MediaQueryListPtr> mediaListMap;
     bool mediaCheck;
@@ -75,6 +79,7 @@ class ViewCSSImp
 
     // Reflow
     Element hovered;
+    NodeArenaPtr boxArena;  // Boxes are allocated from here
     BlockPtr boxTree;       // A box tree under construction
     std::list<CounterImpPtr> counterList;
     int quotingDepth;
@@ -87,13 +92,43 @@ class ViewCSSImp
     bool isFirstLetter{true};
     char32_t prevChar{'\n'};
 
+    // Damage tracking; rectangles are in canvas pixels.
+    struct Rect {
+        float left;
+        float top;
+        float right;
+        float bottom;
+    };
+    bool fullDamage{true};
+    bool damaged{false};
+    Rect damage{0.0f, 0.0f, 0.0f, 0.0f};
+    float originX{0.0f};   // the canvas origin in the modelview space
+    float originY{0.0f};
+    std::unordered_map<const Box*, Rect> boxRects;  // scrolled, replaced, and frame boxes as last painted
+    std::vector<Rect> animatedRects;    // kept until the next full repaint
+    std::vector<Rect> inkRects;         // the areas painted by the blocks being rendered
+    unsigned paintedBoxes{0};
+
+    // Compositing; the area of the document painted into the canvas.
+    float layerLeft{0.0f};
+    float layerTop{0.0f};
+    float layerWidth{0.0f};
+    float layerHeight{0.0f};
+    bool scrollDependent{false};  // painted anything fixed to the viewport?
+
     // Animation
     unsigned last;   // in 1/100 sec for GIF
     unsigned delay;  // in 1/100 sec for GIF
 
     void removeComputedStyle(Element element);
 
-    void handleMutation(EventListenerImp* listener, events::Event event);
+    void addDamage(const Rect& rect);
+    static void unite(Rect& rect, const Rect& other);
+    void gatherDamage(const Box* box);
+    Rect toCanvas(float left, float top, float w, float h) const;
+
+    void handleMutations(const std::deque<events::MutationRecord>& records);
+
     void collectRules(CSSRuleListImp::RuleSet& set, Element element, css::CSSRuleList list, unsigned importance, MediaListPtr mediaList = nullptr);
     void updateStyleRules(Element element, const CSSStyleDeclarationPtr& style, CSSStyleDeclarationPtr parentStyle);
     bool expandBinding(Element element, const CSSStyleDeclarationPtr& style);
@@ -102,6 +137,12 @@ public:
     ViewCSSImp(WindowPtr window);
     virtual ~ViewCSSImp();
 
+    // Applies the queued DOM mutations to the computed styles. This is called
+    // at every task checkpoint, and before the view is used synchronously.
+    void flushMutations() {
+        mutationObserver->deliver();
+    }
+
     DocumentPtr getDocument() const {
         return window->getDocument();
     }
@@ -118,8 +159,17 @@ public:
 
     // Selector matching
     void addStyle(const Element& element, const CSSStyleDeclarationPtr& style);
-    void constructComputedStyles();
+    // If rematch is true, the selectors of every element are matched again in
+    // place, e.g., after a style sheet has been added; the computed styles
+    // and the boxes are kept and only the changed ones are rebuilt.
+    void constructComputedStyles(bool rematch = false);
     unsigned constructComputedStyle(Node node, CSSStyleDeclarationPtr parentStyle, unsigned propagateFlags = 0);
+    size_t getComputedStyleCount() const {
+        return map.size();
+    }
+    // Returns the memory used by the computed styles; unshared is set to the
+    // memory they would use if no property group were shared among them.
+    size_t getComputedStyleMemoryUsage(size_t& unshared) const;
 
     // Style recalculation
     void calculateComputedStyles();
@@ -132,6 +182,13 @@ public:
             return window->preload(base, url);
         return 0;
     }
+    // Allocates a box from the arena of this view so that the boxes of a tree
+    // are laid out close together in memory.
+    template <typename T, typename... Args>
+    std::shared_ptr<T> createBox(Args&&... args) {
+        return std::allocate_shared<T>(NodeAllocator<T>(boxArena), std::forward<Args>(args)...);
+    }
+
     BlockPtr createBlock(Element element, const BlockPtr& parentBox, const CSSStyleDeclarationPtr& style, bool newContext, bool asTablePart = false);
     BlockPtr constructBlock(Node node, const BlockPtr& parentBox, const CSSStyleDeclarationPtr& style, const BlockPtr& prevBox, bool asTablePart = false);
     BlockPtr constructBlock(Text text, const BlockPtr& parentBox, const CSSStyleDeclarationPtr& style, const BlockPtr& prevBox);
@@ -143,6 +200,7 @@ public:
 
     // Repaint
     void beginTranslucent();
+    void beginTranslucent(float left, float top, float w, float h);
     void endTranslucent(float alpha);
     void render(unsigned clipCount);
     void renderCanvas(unsigned color);
@@ -248,6 +306,7 @@ public:
     }
 
     BoxPtr boxFromPoint(int x, int y);
+    void snapshotHitTargets(HitTestSnapshot& snapshot);
 
     float getScrollWidth() const {
         return scrollWidth;
@@ -341,9 +400,66 @@ public:
         return false;
     }
 
+    // Damage tracking for partial repaints. gatherDamage() collects the
+    // boxes flagged with NEED_REPAINT before render(); a box whose last
+    // painted rectangle is unknown damages the whole canvas.
+    void gatherDamage(int width, int height);
+    void damageAll() {
+        fullDamage = true;
+    }
+    void damageAnimatedImages();
+    bool hasFullDamage() const {
+        return fullDamage;
+    }
+    void getDamage(int& left, int& top, int& w, int& h) const;
+    bool isDamaged(float left, float top, float w, float h) const;
+    void recordBoxRect(const Box* box, float left, float top, float w, float h);
+    void recordAnimatedRect(float left, float top, float w, float h);
+    // In full repaints, every block records the area painted by itself and
+    // its contents, so that a restyle which changes only the painted values
+    // can damage just the blocks of the restyled elements.
+    void beginInk(float left, float top, float w, float h);
+    void addInk(float left, float top, float w, float h);
+    void endInk(const Box* box);
+    void countPaintedBox() {
+        ++paintedBoxes;
+    }
+    unsigned getPaintedBoxes() const {
+        return paintedBoxes;
+    }
+
     void clip(float left, float top, float w, float h);
     void unclip(float left, float top, float w, float h);
 
+    // The canvas can be larger than the viewport so that scrolling only
+    // recomposites it. Boxes that stay still in the viewport set
+    // scrollDependent, and then the canvas must be repainted per scroll.
+    void setLayer(float left, float top, float w, float h) {
+        layerLeft = left;
+        layerTop = top;
+        layerWidth = w;
+        layerHeight = h;
+    }
+    float getLayerLeft() const {
+        return layerLeft;
+    }
+    float getLayerTop() const {
+        return layerTop;
+    }
+    float getLayerWidth() const {
+        return layerWidth;
+    }
+    float getLayerHeight() const {
+        return layerHeight;
+    }
+    void setScrollDependent() {
+        scrollDependent = true;
+    }
+    bool isScrollDependent() const {
+        return scrollDependent;
+    }
+    static void renderScrollBars(float w, float h, float scrollX, float scrollY, float scrollWidth, float scrollHeight);
+
     bool getMediaCheck() const {
         return mediaCheck;
     }
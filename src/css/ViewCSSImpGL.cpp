@@ -48,13 +48,13 @@ namespace org { namespace w3c { namespace dom { namespace bootstrap {
 FontTexture* ViewCSSImp::selectFont(const CSSStyleDeclarationPtr& style)
 {
     FontManager* manager = backend.getFontManager();
-    unsigned s = style->fontStyle.getStyle();
-    unsigned w = style->fontWeight.getWeight();
-    for (auto i = style->fontFamily.getFamilyNames().begin(); i != style->fontFamily.getFamilyNames().end(); ++i) {
+    unsigned s = style->fontValues->fontStyle.getStyle();
+    unsigned w = style->fontValues->fontWeight.getWeight();
+    for (auto i = style->fontValues->fontFamily.getFamilyNames().begin(); i != style->fontValues->fontFamily.getFamilyNames().end(); ++i) {
         if (FontFace* face = manager->getFontFace(*i, s, w))
             return face->getFontTexture(Point, s, w);
     }
-    unsigned g = style->fontFamily.getGeneric();
+    unsigned g = style->fontValues->fontFamily.getGeneric();
     if (!g)
         g = CSSFontFamilyValueImp::SansSerif;
     if (FontFace* face = manager->getFontFace(g, s, w))
@@ -66,10 +66,10 @@ FontTexture* ViewCSSImp::selectAltFont(const CSSStyleDeclarationPtr& style, Font
 {
     assert(current);
     FontManager* manager = backend.getFontManager();
-    unsigned s = style->fontStyle.getStyle();
-    unsigned w = style->fontWeight.getWeight();
+    unsigned s = style->fontValues->fontStyle.getStyle();
+    unsigned w = style->fontValues->fontWeight.getWeight();
     bool skipped = false;
-    for (auto i = style->fontFamily.getFamilyNames().begin(); i != style->fontFamily.getFamilyNames().end(); ++i) {
+    for (auto i = style->fontValues->fontFamily.getFamilyNames().begin(); i != style->fontValues->fontFamily.getFamilyNames().end(); ++i) {
         FontFace* face = manager->getFontFace(*i, s, w);
         if (!face)
             continue;
@@ -81,7 +81,7 @@ FontTexture* ViewCSSImp::selectAltFont(const CSSStyleDeclarationPtr& style, Font
         if (skipped && face->hasGlyph(u))
             return face->getFontTexture(Point, s, w);
     }
-    unsigned g = style->fontFamily.getGeneric();
+    unsigned g = style->fontValues->fontFamily.getGeneric();
     if (!g)
         g = CSSFontFamilyValueImp::SansSerif;
     if (FontFace* face = manager->getAltFontFace(g, s, w, current, u))
@@ -95,6 +95,16 @@ void ViewCSSImp::beginTranslucent()
         imp->beginTranslucent();
 }
 
+void ViewCSSImp::beginTranslucent(float left, float top, float w, float h)
+{
+    if (auto imp = window->getWindowProxy()) {
+        Rect rect = toCanvas(left, top, w, h);
+        int l = static_cast<int>(floorf(rect.left));
+        int t = static_cast<int>(floorf(rect.top));
+        imp->beginTranslucent(l, t, static_cast<int>(ceilf(rect.right)) - l, static_cast<int>(ceilf(rect.bottom)) - t);
+    }
+}
+
 void ViewCSSImp::endTranslucent(float alpha)
 {
     if (auto imp = window->getWindowProxy())
@@ -105,13 +115,27 @@ void ViewCSSImp::render(unsigned parentClipCount)
 {
     last = getTick();
 
+    GLfloat mtx[16];
+    glGetFloatv(GL_MODELVIEW_MATRIX, mtx);
+    originX = mtx[12];
+    originY = mtx[13];
+    // The animated images outside the damaged area are not painted again, so
+    // their rectangles are kept until the next full repaint.
+    if (fullDamage) {
+        boxRects.clear();
+        animatedRects.clear();
+        inkRects.clear();
+        scrollDependent = false;
+    }
+    paintedBoxes = 0;
+
     // reset clipCount
     clipCount = 0;
     glStencilFunc(GL_EQUAL, 0, 0xFF);
 
     glPushMatrix();
     glScalef(zoom, zoom, zoom);
-    glTranslatef(-window->getScrollX(), -window->getScrollY(), 0.0f);
+    glTranslatef(-layerLeft, -layerTop, 0.0f);
     if (stackingContexts) {
         stackingContexts->resetScrollSize();
         if (boxTree) {
@@ -130,14 +154,89 @@ void ViewCSSImp::render(unsigned parentClipCount)
         boxTree->scrollHeight = std::max(boxTree->scrollHeight, t + boxTree->getBlockHeight());
         updateScrollWidth(boxTree->getScrollWidth());
         updateScrollHeight(boxTree->getScrollHeight());
-        if (canScroll()) {
-            Box::renderVerticalScrollBar(initialContainingBlock->width, initialContainingBlock->height, window->getScrollY(), scrollHeight);
-            Box::renderHorizontalScrollBar(initialContainingBlock->width, initialContainingBlock->height, window->getScrollX(), scrollWidth);
-        }
     }
 
     // restore clipCount
     glStencilFunc(GL_EQUAL, parentClipCount, 0xFF);
+
+    fullDamage = damaged = false;
+}
+
+ViewCSSImp::Rect ViewCSSImp::toCanvas(float left, float top, float w, float h) const
+{
+    // The modelview matrix only ever translates and scales boxes.
+    GLfloat mtx[16];
+    glGetFloatv(GL_MODELVIEW_MATRIX, mtx);
+    Rect rect;
+    rect.left = mtx[0] * left + mtx[12] - originX;
+    rect.top = mtx[5] * top + mtx[13] - originY;
+    rect.right = rect.left + mtx[0] * w;
+    rect.bottom = rect.top + mtx[5] * h;
+    return rect;
+}
+
+bool ViewCSSImp::isDamaged(float left, float top, float w, float h) const
+{
+    if (fullDamage)
+        return true;
+    if (!damaged)
+        return false;
+    Rect rect = toCanvas(left, top, w, h);
+    return rect.left < damage.right && damage.left < rect.right &&
+           rect.top < damage.bottom && damage.top < rect.bottom;
+}
+
+void ViewCSSImp::recordBoxRect(const Box* box, float left, float top, float w, float h)
+{
+    boxRects[box] = toCanvas(left, top, w, h);
+}
+
+void ViewCSSImp::beginInk(float left, float top, float w, float h)
+{
+    if (fullDamage)
+        inkRects.push_back(toCanvas(left, top, w, h));
+}
+
+void ViewCSSImp::addInk(float left, float top, float w, float h)
+{
+    if (fullDamage && !inkRects.empty())
+        unite(inkRects.back(), toCanvas(left, top, w, h));
+}
+
+void ViewCSSImp::endInk(const Box* box)
+{
+    if (!fullDamage)
+        return;
+    assert(!inkRects.empty());
+    Rect rect = inkRects.back();
+    inkRects.pop_back();
+    auto found = boxRects.find(box);
+    if (found != boxRects.end())
+        unite(found->second, rect);
+    else
+        boxRects[box] = rect;
+    if (!inkRects.empty())
+        unite(inkRects.back(), rect);
+}
+
+void ViewCSSImp::recordAnimatedRect(float left, float top, float w, float h)
+{
+    Rect rect = toCanvas(left, top, w, h);
+    for (auto i = animatedRects.begin(); i != animatedRects.end(); ++i) {
+        if (i->left == rect.left && i->top == rect.top && i->right == rect.right && i->bottom == rect.bottom)
+            return;
+    }
+    animatedRects.push_back(rect);
+}
+
+void ViewCSSImp::renderScrollBars(float w, float h, float scrollX, float scrollY, float scrollWidth, float scrollHeight)
+{
+    // The scroll bars are drawn over the composited canvas, where texturing
+    // is disabled.
+    glEnable(GL_TEXTURE_2D);
+    Box::renderVerticalScrollBar(w, h, scrollY, scrollHeight);
+    Box::renderHorizontalScrollBar(w, h, scrollX, scrollWidth);
+    glDisable(GL_TEXTURE_2D);
 }
 
 void ViewCSSImp::renderCanvas(unsigned color)
@@ -146,10 +245,10 @@ void ViewCSSImp::renderCanvas(unsigned color)
         return;
 
     glColor4ub(color >> 16, color >> 8, color, color >> 24);
-    float l = window->getScrollX();
-    float r = l + initialContainingBlock->width;
-    float t = window->getScrollY();
-    float b = t + initialContainingBlock->height;
+    float l = layerLeft;
+    float r = l + layerWidth;
+    float t = layerTop;
+    float b = t + layerHeight;
     glBegin(GL_QUADS);
     glVertex2f(l, t);
     glVertex2f(r, t);
@@ -216,6 +315,9 @@ Element ViewCSSImp::setHovered(Element target)
     Element prev = hovered;
     hovered = target; // TODO: Fix synchronization issues with the background thread.
 
+    // Only the styles affected by the old and the new hovered elements are
+    // recomputed; if just their painted values change, only their blocks are
+    // repainted.
     if (next) {
         glutSetCursor(cursorMap[next->cursor.getValue()]);
         CSSStyleDeclarationPtr affected;
@@ -236,6 +338,7 @@ Element ViewCSSImp::setHovered(Element target)
 void initFonts(int* argc, char* argv[])
 {
     FontManager* manager = backend.getFontManager();
+    recordTime("font loading begin");
     FontDatabase::loadBaseFonts(manager);
     for (int i = 1; i < *argc; ++i) {
         if (strcmp(argv[i], "-testfonts") == 0) {
@@ -246,4 +349,5 @@ void initFonts(int* argc, char* argv[])
             break;
         }
     }
+    recordTime("font loading end");
 }
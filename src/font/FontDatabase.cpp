@@ -192,24 +192,34 @@ const char* testFontList[] =
 #endif  // TEST_FONTS
 };
 
-}
+std::string cachePath;
 
-void FontDatabase::loadBaseFonts(FontManager* manager)
+void loadFonts(FontManager* manager, const char** begin, const char** end)
 {
-    for (auto i = fontList; i < &fontList[sizeof fontList / sizeof fontList[0]]; ++i) {
+    if (!cachePath.empty())
+        manager->openCache(cachePath + "/fonts");
+    for (auto i = begin; i < end; ++i) {
         try {
             manager->loadFont(*i);
         } catch (...) {
         }
     }
+    manager->saveCache();
+}
+
+}
+
+void FontDatabase::setCachePath(const std::string& path)
+{
+    cachePath = path;
+}
+
+void FontDatabase::loadBaseFonts(FontManager* manager)
+{
+    loadFonts(manager, fontList, &fontList[sizeof fontList / sizeof fontList[0]]);
 }
 
 void FontDatabase::loadTestFonts(FontManager* manager)
 {
-    for (auto i = testFontList; i < &testFontList[sizeof testFontList / sizeof testFontList[0]]; ++i) {
-        try {
-            manager->loadFont(*i);
-        } catch (...) {
-        }
-    }
+    loadFonts(manager, testFontList, &testFontList[sizeof testFontList / sizeof testFontList[0]]);
 }
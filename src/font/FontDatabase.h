@@ -17,10 +17,15 @@
 #ifndef ES_FONT_DATABASE_H
 #define ES_FONT_DATABASE_H
 
+#include <string>
+
 class FontManager;
 
 struct FontDatabase
 {
+    // Sets the directory to keep the font metadata cache in.
+    static void setCachePath(const std::string& path);
+
     static void loadBaseFonts(FontManager* manager);
     static void loadTestFonts(FontManager* manager);
 };
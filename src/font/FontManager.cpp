@@ -17,9 +17,13 @@
 #include "FontManager.h"
 
 #include <strings.h>
+#include <sys/stat.h>
 
 #include <algorithm>
+#include <cstdio>
+#include <fstream>
 #include <iostream>
+#include <limits>
 #include <set>
 
 #include <unicode/utypes.h>
@@ -61,6 +65,8 @@ bool isCollapsingSpace(unsigned value) {
 
 const bool USE_HINTING = false;
 
+const char* const CacheSignature = "escudo font cache 1";
+
 }
 
 //
@@ -71,7 +77,8 @@ FontGlyph* const FontManagerBackEnd::Add = (FontGlyph*) 1;
 FontGlyph* const FontManagerBackEnd::Delete = (FontGlyph*) 2;
 
 FontManager::FontManager(FontManagerBackEnd* backend) :
-    backend(backend)
+    backend(backend),
+    cacheModified(false)
 {
     FT_Error error = FT_Init_FreeType(&library);
     if (error)
@@ -90,9 +97,98 @@ FontManager::~FontManager()
     FT_Done_FreeType(library);
 }
 
+void FontManager::openCache(const std::string& filename)
+{
+    if (cacheFilename == filename)
+        return;
+    cacheFilename = filename;
+    cache.clear();
+    cacheModified = false;
+
+    std::ifstream stream(filename);
+    std::string line;
+    if (!std::getline(stream, line) || line != CacheSignature) {
+        cacheModified = true;
+        return;
+    }
+    std::string path;
+    while (std::getline(stream, path)) {
+        FontFaceInfo info;
+        size_t familyCount;
+        size_t rangeCount;
+        stream >> info.size >> info.mtime >> info.generic >> info.style >> info.weight >> familyCount >> rangeCount;
+        stream.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+        std::getline(stream, info.familyName);
+        for (size_t i = 0; i < familyCount && std::getline(stream, line); ++i)
+            info.familyNames.push_back(utfconv(line));
+        for (size_t i = 0; i < rangeCount; ++i) {
+            unsigned long first;
+            unsigned long last;
+            stream >> first >> last;
+            info.coverage.push_back(std::make_pair(static_cast<char32_t>(first), static_cast<char32_t>(last)));
+        }
+        stream.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+        if (!stream || 6 <= info.generic) {
+            // Discard the broken entry and the rest; they will be rebuilt.
+            cacheModified = true;
+            break;
+        }
+        cache.insert(std::make_pair(path, info));
+    }
+}
+
+void FontManager::saveCache()
+{
+    if (cacheFilename.empty() || !cacheModified)
+        return;
+
+    // Write to a temporary file first so that a broken cache is never left behind.
+    std::string tempFilename = cacheFilename + ".tmp";
+    std::ofstream stream(tempFilename, std::ios::trunc);
+    stream << CacheSignature << '\n';
+    for (auto i = cache.begin(); i != cache.end(); ++i) {
+        const FontFaceInfo& info = i->second;
+        stream << i->first << '\n'
+               << info.size << ' ' << info.mtime << ' '
+               << info.generic << ' ' << info.style << ' ' << info.weight << ' '
+               << info.familyNames.size() << ' ' << info.coverage.size() << '\n'
+               << info.familyName << '\n';
+        for (auto j = info.familyNames.begin(); j != info.familyNames.end(); ++j)
+            stream << utfconv(*j) << '\n';
+        for (auto j = info.coverage.begin(); j != info.coverage.end(); ++j)
+            stream << static_cast<unsigned long>(j->first) << ' ' << static_cast<unsigned long>(j->second) << ' ';
+        stream << '\n';
+    }
+    stream.close();
+    if (!stream || rename(tempFilename.c_str(), cacheFilename.c_str()) == -1) {
+        remove(tempFilename.c_str());
+        return;
+    }
+    cacheModified = false;
+}
+
 FontFace* FontManager::loadFont(const char* fontFilename)
 {
-    FontFace* face = new(std::nothrow) FontFace(this, fontFilename);
+    struct stat st;
+    if (stat(fontFilename, &st) == -1) {
+        if (cache.erase(fontFilename))
+            cacheModified = true;
+        return 0;
+    }
+
+    FontFace* face;
+    auto found = cache.find(fontFilename);
+    if (found != cache.end() && found->second.size == st.st_size && found->second.mtime == st.st_mtime)
+        face = new(std::nothrow) FontFace(this, fontFilename, found->second);
+    else {
+        face = new(std::nothrow) FontFace(this, fontFilename);
+        if (face) {
+            face->info.size = st.st_size;
+            face->info.mtime = st.st_mtime;
+            cache[fontFilename] = face->info;
+            cacheModified = true;
+        }
+    }
     if (face)
         genericLists[face->getGeneric()].push_back(face);
     return face;
@@ -185,21 +281,24 @@ FontFace* FontManager::getFontFace(const std::u16string& familyName, unsigned st
 FontFace::FontFace(FontManager* manager, const char* filename, long index) try :
     manager(manager),
     filename(filename),
-    charmap(0),
-    generic(CSSFontFamilyValueImp::None),
-    style(CSSFontStyleValueImp::Normal),
-    weight(400) // normal
+    index(index),
+    face(0)
 {
-    FT_Error error = FT_New_Face(manager->library, filename, index, &face);
-    if (error) {
-        face = 0;
+    info.size = 0;
+    info.mtime = 0;
+    info.generic = CSSFontFamilyValueImp::None;
+    info.style = CSSFontStyleValueImp::Normal;
+    info.weight = 400; // normal
+
+    if (!open())
         throw std::runtime_error(__func__);
-    }
 
-    initCharmap();
+    initCoverage();
 
+    if (face->family_name)
+        info.familyName = face->family_name;
     std::set<std::u16string> familyNames;
-    familyNames.insert(toString(face->family_name));
+    familyNames.insert(toString(info.familyName.c_str()));
     if (FT_IS_SFNT(face)) {
         // cf. http://www.microsoft.com/typography/otspec/name.htm
         unsigned count = FT_Get_Sfnt_Name_Count(face);
@@ -222,14 +321,14 @@ FontFace::FontFace(FontManager* manager, const char* filename, long index) try :
         // cf. http://www.microsoft.com/typography/otspec/os2.htm
         if (TT_OS2* os2 = static_cast<TT_OS2*>(FT_Get_Sfnt_Table(face, ft_sfnt_os2))) {
             if (os2->fsSelection & 0x001)
-                style = CSSFontStyleValueImp::Italic;
+                info.style = CSSFontStyleValueImp::Italic;
             else if (os2->fsSelection & 0x200)
-                style = CSSFontStyleValueImp::Oblique;
+                info.style = CSSFontStyleValueImp::Oblique;
             if (os2->fsSelection & 0x020)
-                weight = 700;
+                info.weight = 700;
             switch (os2->panose[3]) {    // bProportion
             case 9: // Monospaced
-                generic = CSSFontFamilyValueImp::Monospace;
+                info.generic = CSSFontFamilyValueImp::Monospace;
                 break;
             default:
                 switch (os2->panose[0]) {   // bFamilyType
@@ -239,45 +338,78 @@ FontFace::FontFace(FontManager* manager, const char* filename, long index) try :
                     case 3:  // Obtuse Cove
                     case 4:  // Square Cove
                     case 5:  // Obtuse Square Cove
-                        generic = CSSFontFamilyValueImp::Serif;
+                        info.generic = CSSFontFamilyValueImp::Serif;
                         break;
                     case 11: // Normal Sans
                     case 12: // Obtuse Sans
                     case 13: // Perpendicular Sans
-                        generic = CSSFontFamilyValueImp::SansSerif;
+                        info.generic = CSSFontFamilyValueImp::SansSerif;
                         break;
                     default:
                         break;
                     }
                     break;
                 case 3: // Latin Hand Written
-                    generic = CSSFontFamilyValueImp::Cursive;
+                    info.generic = CSSFontFamilyValueImp::Cursive;
                     break;
                 case 4: // Latin Decorative
-                    generic = CSSFontFamilyValueImp::Fantasy;
+                    info.generic = CSSFontFamilyValueImp::Fantasy;
                     break;
                 default:
                     break;
                 }
                 break;
             }
-            weight = os2->usWeightClass;
+            info.weight = os2->usWeightClass;
         }
     }
-    for (auto i = familyNames.begin(); i != familyNames.end(); ++i)
-        manager->registerFont(*i, this);
-
+    info.familyNames.assign(familyNames.begin(), familyNames.end());
+    registerFamilyNames();
 } catch (...) {
-    if (face)
+    if (face) {
+        std::lock_guard<std::mutex> lock(manager->libraryMutex);
         FT_Done_Face(face);
+    }
     throw;
 }
 
+FontFace::FontFace(FontManager* manager, const char* filename, const FontFaceInfo& info) :
+    manager(manager),
+    filename(filename),
+    index(0),
+    face(0),
+    info(info)
+{
+    registerFamilyNames();
+}
+
 FontFace::~FontFace()
 {
     for (auto it = textures.begin(); it != textures.end(); ++it)
         delete it->second;
-    FT_Done_Face(face);
+    if (face) {
+        std::lock_guard<std::mutex> lock(manager->libraryMutex);
+        FT_Done_Face(face);
+    }
+}
+
+bool FontFace::open()
+{
+    if (face)
+        return true;
+    std::lock_guard<std::mutex> lock(manager->libraryMutex);
+    FT_Error error = FT_New_Face(manager->library, filename, index, &face);
+    if (error) {
+        face = 0;
+        return false;
+    }
+    return true;
+}
+
+void FontFace::registerFamilyNames()
+{
+    for (auto i = info.familyNames.begin(); i != info.familyNames.end(); ++i)
+        manager->registerFont(*i, this);
 }
 
 unsigned FontFace::getScore(unsigned style, unsigned weight) const
@@ -307,17 +439,31 @@ unsigned FontFace::getScore(unsigned style, unsigned weight) const
     return score;
 }
 
-bool FontFace::hasGlyph(char32_t ucode) const
+FT_UInt FontFace::getGlyphIndex(char32_t u)
+{
+    auto found = glyphIndices.find(u);
+    if (found != glyphIndices.end())
+        return found->second;
+    FT_UInt glyphIndex = hasGlyph(u) ? FT_Get_Char_Index(face, u) : 0;
+    glyphIndices.insert(std::make_pair(u, glyphIndex));
+    return glyphIndex;
+}
+
+bool FontFaceInfo::hasGlyph(char32_t u) const
 {
-    std::vector<char32_t>::const_iterator result;
-    result = std::lower_bound(charmap.begin(), charmap.end(), ucode);
-    return *result == ucode;
+    auto range = std::upper_bound(coverage.begin(), coverage.end(), u,
+                                  [](char32_t c, const std::pair<char32_t, char32_t>& r) {
+                                      return c < r.first;
+                                  });
+    return range != coverage.begin() && u <= (--range)->second;
 }
 
 FontTexture* FontFace::getFontTexture(unsigned int point, bool bold, bool oblique)
 {
-    std::lock_guard<std::mutex> lock(getManager()->getMutex());
+    std::lock_guard<std::mutex> lock(mutex);
 
+    if (!open())
+        return 0;
     for (auto it = textures.find(point); it != textures.end(); ++it) {
         FontTexture* font = it->second;
         if (font->getPoint() == point && font->getBold() == bold && font->getOblique() == oblique)
@@ -354,14 +500,14 @@ FontTexture* FontFace::getFontTexture(unsigned int point, unsigned style, unsign
 
 FontTexture::FontTexture(FontFace* face, unsigned int point, bool bold, bool oblique) try :
     face(face),
-    glyphs(0),
+    pages(0),
     point(point),
     bold(bold),
     oblique(oblique),
     bearingGap(0.0f)
 {
     addImage();
-    glyphs = new FontGlyph[face->glyphCount];
+    pages = new std::atomic<GlyphPage*>[PageCount]();
 
     sizes[0] = face->face->size;
     for (size_t i = 1; i < Sizes; ++i) {
@@ -416,11 +562,11 @@ FontTexture::FontTexture(FontFace* face, unsigned int point, bool bold, bool obl
         }
     }
 
-    // Store the missing glyph (0) as the 1st entry
-    if (!storeGlyph(glyphs, 0))
+    // Store the missing glyph (0)
+    if (!storeGlyph(&missingGlyph, 0))
         throw std::runtime_error(__func__);
 } catch (...) {
-    delete glyphs;
+    delete[] pages;
     throw;
 }
 
@@ -428,28 +574,54 @@ FontTexture::~FontTexture()
 {
     for (std::vector<uint8_t*>::iterator it = images.begin(); it != images.end(); ++it)
         deleteImage(*it);
-    delete[] glyphs;
+    for (unsigned i = 0; i < PageCount; ++i)
+        delete pages[i].load(std::memory_order_relaxed);
+    delete[] pages;
 }
 
 FontGlyph* FontTexture::getGlyph(char32_t ucode)
 {
-    std::vector<char32_t>::const_iterator result;
-    result = std::lower_bound(face->charmap.begin(), face->charmap.end(), ucode);
-    if (*result != ucode)
-        return glyphs;
-    FontGlyph* glyph = &glyphs[result - face->charmap.begin()];
-    if (!glyph->isInitialized()) {
-        std::lock_guard<std::mutex> lock(getFace()->getManager()->getMutex());
-        if (!glyph->isInitialized()) {
-            FT_UInt glyphIndex = FT_Get_Char_Index(face->face, ucode);
-            assert(glyphIndex);
-            if (!glyphIndex)
-                return glyphs;
-            if (!storeGlyph(glyph, glyphIndex))
-                return glyphs;
+    if (0x10FFFF < ucode)
+        return &missingGlyph;
+    std::atomic<GlyphPage*>& entry = pages[ucode >> PageBits];
+    unsigned offset = ucode & (PageSize - 1);
+    GlyphPage* page = entry.load(std::memory_order_acquire);
+    if (page) {
+        switch (page->states[offset].load(std::memory_order_acquire)) {
+        case Loaded:
+            return &page->glyphs[offset];
+        case Missing:
+            return &missingGlyph;
+        default:
+            break;
         }
     }
-    return glyph;
+
+    std::lock_guard<std::mutex> lock(face->mutex);
+    if (!page) {
+        page = entry.load(std::memory_order_relaxed);
+        if (!page) {
+            page = new(std::nothrow) GlyphPage();
+            if (!page)
+                return &missingGlyph;
+            entry.store(page, std::memory_order_release);
+        }
+    }
+    unsigned char state = page->states[offset].load(std::memory_order_relaxed);
+    if (state == Unloaded) {
+        FT_UInt glyphIndex = face->getGlyphIndex(ucode);
+        state = (glyphIndex && storeGlyph(&page->glyphs[offset], glyphIndex)) ? Loaded : Missing;
+        page->states[offset].store(state, std::memory_order_release);
+    }
+    return (state == Loaded) ? &page->glyphs[offset] : &missingGlyph;
+}
+
+void FontTexture::loadGlyphs(const std::u16string& text)
+{
+    const char16_t* p = text.c_str();
+    char32_t u;
+    while ((p = utf16to32(p, &u)) && u)
+        getGlyph(u);
 }
 
 uint8_t* FontTexture::getImage(FontGlyph* glyph)
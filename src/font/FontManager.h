@@ -20,12 +20,14 @@
 #include <assert.h>
 #include <stdint.h>
 
+#include <atomic>
 #include <list>
 #include <map>
 #include <mutex>
 #include <stdexcept>
 #include <string>
 #include <thread>
+#include <unordered_map>
 #include <vector>
 
 // FreeType 2, http://www.freetype.org/index2.html
@@ -38,6 +40,24 @@ class FontFace;
 class FontTexture;
 struct FontGlyph;
 
+// FontFaceInfo keeps what is needed to select a font face without opening
+// the font file. It is saved in the font metadata cache keyed by the file
+// path, and is reused as long as the size and mtime of the file match.
+struct FontFaceInfo
+{
+    long long size;
+    long long mtime;
+    std::string familyName;
+    std::vector<std::u16string> familyNames;
+    unsigned generic;
+    unsigned style;
+    unsigned weight;
+    // the sorted, disjoint ranges of the code points covered by the face
+    std::vector<std::pair<char32_t, char32_t>> coverage;
+
+    bool hasGlyph(char32_t u) const;
+};
+
 class FontManagerBackEnd
 {
 protected:
@@ -81,16 +101,29 @@ class FontManager
     std::mutex mutex;
     FontManagerBackEnd* backend;
     FT_Library library;
+    std::mutex libraryMutex;  // for FT_New_Face and FT_Done_Face
     // a map from font family name to FontFace
     std::multimap<std::u16string, FontFace*, CompareIgnoreCase> faces;
     std::list<FontFace*> genericLists[6];
 
+    // the font metadata cache
+    std::string cacheFilename;
+    std::map<std::string, FontFaceInfo> cache;
+    bool cacheModified;
+
     void registerFont(const std::u16string& familyName, FontFace* face);
 
 public:
     FontManager(FontManagerBackEnd* backend = 0);
     ~FontManager();
 
+    // Reads the font metadata cache from filename. The fonts loaded after
+    // this call are not opened until they are used if they are found in the
+    // cache.
+    void openCache(const std::string& filename);
+    // Writes back the font metadata cache if it has been modified.
+    void saveCache();
+
     FontFace* loadFont(const char* fontFilename);
 
     FontFace* getFontFace(unsigned generic, unsigned style, unsigned weight, int mask = 0x3f);
@@ -108,37 +141,50 @@ public:
 
 class FontFace
 {
+    friend class FontManager;
     friend class FontTexture;
 
     FontManager* manager;
 
+    // FT_Face is not thread-safe; mutex serializes the glyph loading and the
+    // texture lookup of this face only, so that the glyphs of the other faces
+    // can be loaded concurrently.
+    std::mutex mutex;
+
     const char* filename;
-    std::vector<char32_t > charmap;
-    int32_t glyphCount;
-    FT_Face face;
+    long index;
+    FT_Face face;   // 0 until the face is opened
     // a map from nominal font size in pixels to FontTexture
     std::multimap<unsigned int, FontTexture*> textures;
+    // a map from Unicode character to glyph index, shared by the textures
+    std::unordered_map<char32_t, FT_UInt> glyphIndices;
 
-    unsigned generic;
-    unsigned style;
-    unsigned weight;
+    FontFaceInfo info;
 
-    void initCharmap() throw ()
+    void initCoverage() throw ()
     {
-        glyphCount = 0;
-        charmap.push_back(0);
-        ++glyphCount;
         FT_UInt index;
         FT_ULong ucode = FT_Get_First_Char(face, &index);
         while (index) {
-            charmap.push_back(ucode);
-            ++glyphCount;
+            if (!info.coverage.empty() && info.coverage.back().second + 1 == ucode)
+                info.coverage.back().second = ucode;
+            else
+                info.coverage.push_back(std::make_pair(ucode, ucode));
             ucode = FT_Get_Next_Char(face, ucode, &index);
         }
     }
 
+    bool open();
+    void registerFamilyNames();
+
+    // Returns the glyph index of u, or 0 if u is not in the face. mutex must
+    // be held by the caller.
+    FT_UInt getGlyphIndex(char32_t u);
+
 public:
     FontFace(FontManager* manager, const char* filename, long index = 0);
+    // Creates a face from the cached info without opening the font file.
+    FontFace(FontManager* manager, const char* filename, const FontFaceInfo& info);
     ~FontFace();
 
     const char* getFilename() const {
@@ -152,32 +198,81 @@ public:
     }
 
     const char* getFamilyName() const {
-        return face->family_name;
+        return info.familyName.c_str();
     }
     unsigned getGeneric() const {
-        return generic;
+        return info.generic;
     }
     unsigned getStyle() const {
-        return style;
+        return info.style;
     }
     unsigned getWeight() const {
-        return weight;
+        return info.weight;
     }
 
     unsigned getScore(unsigned style, unsigned weight) const;
 
-    bool hasGlyph(char32_t u) const;
+    bool hasGlyph(char32_t u) const {
+        return info.hasGlyph(u);
+    }
 
     FontTexture* getFontTexture(unsigned int point, bool bold, bool oblique);
     FontTexture* getFontTexture(unsigned int point, unsigned style, unsigned weight);
 };
 
+struct FontGlyph
+{
+    short advance;
+    unsigned short x; // pos
+    unsigned y;       // pos
+    short left;
+    short top;
+    unsigned short width;
+    unsigned short height;
+
+    FontGlyph() :
+        advance(0),
+        x(0),
+        y(0),
+        left(0),
+        top(0),
+        width(0),
+        height(0)
+    {
+    }
+
+    bool isInitialized()
+    {
+        return x || y;
+    }
+};
+
 class FontTexture
 {
     static const size_t Sizes = 3;  // for 11px, 22px, 44px, etc.
 
+    // The glyphs are kept in a two-level table keyed by Unicode character so
+    // that only the pages of the characters actually used are allocated.
+    static const unsigned PageBits = 8;
+    static const unsigned PageSize = 1u << PageBits;
+    static const unsigned PageCount = 0x110000 >> PageBits;
+
+    enum {
+        Unloaded,
+        Loaded,
+        Missing
+    };
+
+    struct GlyphPage
+    {
+        FontGlyph glyphs[PageSize];
+        std::atomic<unsigned char> states[PageSize];
+    };
+
     FontFace* face;
-    FontGlyph* glyphs;
+    FontGlyph missingGlyph;
+    // Pages are allocated under face->mutex and never freed until the texture is deleted.
+    std::atomic<GlyphPage*>* pages;
     FT_Size sizes[Sizes];
     unsigned int point; // nominal font point sized
     short ascender;
@@ -239,8 +334,12 @@ public:
      */
     FontGlyph* getGlyph(char32_t ucode);
     uint8_t* getImage(FontGlyph* glyph);
+
+    // Loads the glyphs used in text in advance. This can be called from any
+    // thread.
+    void loadGlyphs(const std::u16string& text);
     bool isMissingGlyph(const FontGlyph* glyph) const {
-        return glyph == glyphs;
+        return glyph == &missingGlyph;
     }
 
     unsigned getPoint() const {
@@ -351,31 +450,4 @@ public:
     static const int Align = 1 << (Sizes - 1);
 };
 
-struct FontGlyph
-{
-    short advance;
-    unsigned short x; // pos
-    unsigned y;       // pos
-    short left;
-    short top;
-    unsigned short width;
-    unsigned short height;
-
-    FontGlyph() :
-        advance(0),
-        x(0),
-        y(0),
-        left(0),
-        top(0),
-        width(0),
-        height(0)
-    {
-    }
-
-    bool isInitialized()
-    {
-        return x || y;
-    }
-};
-
 #endif // ES_FONTMANAGER_H
@@ -15,6 +15,10 @@
  */
 
 #include "HTMLCollectionImp.h"
+
+#include <limits>
+
+#include "DocumentImp.h"
 #include "ElementImp.h"
 
 namespace org
@@ -80,6 +84,107 @@ Object HTMLCollectionImp::namedItem(const std::u16string& name)
         return it->second;
 }
 
+namespace {
+
+// Returns the node following node in tree order within the subtree rooted at root
+NodePtr getNextNodeWithin(const NodePtr& node, const NodeImp* root)
+{
+    if (NodePtr child = node->getFirstChildPtr())
+        return child;
+    for (NodePtr n = node; n && n.get() != root; n = n->getParent()) {
+        if (NodePtr next = n->getNextSiblingPtr())
+            return next;
+    }
+    return nullptr;
+}
+
+}
+
+LiveHTMLCollectionImp::LiveHTMLCollectionImp(const NodePtr& root, unsigned kind, const std::u16string& key) :
+    root(root),
+    kind(kind),
+    key(key),
+    document(0),
+    version(0),
+    complete(false)
+{
+}
+
+unsigned LiveHTMLCollectionImp::getVersion(DocumentImp* document)
+{
+    return document->getTreeVersion();
+}
+
+void LiveHTMLCollectionImp::validate()
+{
+    DocumentPtr owner = root->getTrackingDocument();
+    unsigned current = owner ? getVersion(owner.get()) : 0;
+    if (!owner || owner.get() != document || current != version) {
+        cache.clear();
+        cursor.reset();
+        complete = false;
+        document = owner.get();
+        version = current;
+    }
+}
+
+void LiveHTMLCollectionImp::fill(unsigned int count)
+{
+    while (!complete && cache.size() < count) {
+        NodePtr node = getNextNodeWithin(cursor ? cursor : root, root.get());
+        if (!node) {
+            cursor.reset();
+            complete = true;
+            break;
+        }
+        cursor = node;
+        if (node->getNodeType() == Node::ELEMENT_NODE) {
+            if (auto element = std::dynamic_pointer_cast<ElementImp>(node)) {
+                if (match(element.get()))
+                    cache.push_back(element);
+            }
+        }
+    }
+}
+
+unsigned int LiveHTMLCollectionImp::getLength()
+{
+    validate();
+    fill(std::numeric_limits<unsigned int>::max());
+    return cache.size();
+}
+
+Element LiveHTMLCollectionImp::item(unsigned int index)
+{
+    validate();
+    if (index == std::numeric_limits<unsigned int>::max())
+        return nullptr;
+    fill(index + 1);
+    if (cache.size() <= index)
+        return nullptr;
+    return cache[index];
+}
+
+Object LiveHTMLCollectionImp::namedItem(const std::u16string& name)
+{
+    if (name.empty())
+        return nullptr;
+    validate();
+    fill(std::numeric_limits<unsigned int>::max());
+    for (auto i = cache.begin(); i != cache.end(); ++i) {
+        ElementPtr e = *i;
+        if (e->getId() == name)
+            return e;
+        Nullable<std::u16string> uri = e->getNamespaceURI();
+        if (uri.hasValue() && uri.value() == u"http://www.w3.org/1999/xhtml") {
+            Nullable<std::u16string> n = e->getAttribute(u"name");
+            if (n.hasValue() && n.value() == name)
+                return e;
+        }
+    }
+    return nullptr;
+}
+
 }
 }
 }
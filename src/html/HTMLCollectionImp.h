@@ -27,6 +27,7 @@
 
 #include <deque>
 #include <map>
+#include <vector>
 
 namespace org
 {
@@ -63,6 +64,57 @@ public:
 
 typedef std::shared_ptr<HTMLCollectionImp> HTMLCollectionPtr;
 
+class DocumentImp;
+class ElementImp;
+class NodeImp;
+
+// LiveHTMLCollectionImp is the base class of the live collections of the
+// elements in the subtree rooted at a node. The matching elements are
+// collected lazily in tree order only as far as they have been asked for,
+// and the collected elements are discarded once the DOM version of the owner
+// document has changed.
+class LiveHTMLCollectionImp : public HTMLCollectionImp
+{
+    std::shared_ptr<NodeImp> root;
+    unsigned kind;
+    std::u16string key;
+
+    const DocumentImp* document;
+    unsigned version;
+    std::vector<std::shared_ptr<ElementImp>> cache;
+    std::shared_ptr<NodeImp> cursor;  // the last node examined
+    bool complete;
+
+    void validate();
+    void fill(unsigned int count);
+
+protected:
+    // Returns the version of document that invalidates this collection
+    virtual unsigned getVersion(DocumentImp* document);
+    virtual bool match(ElementImp* element) = 0;
+
+public:
+    enum Kind
+    {
+        ElementsByTagName,
+        ElementsByClassName
+    };
+
+    LiveHTMLCollectionImp(const std::shared_ptr<NodeImp>& root, unsigned kind, const std::u16string& key);
+
+    bool isFor(unsigned kind, const std::u16string& key) const {
+        return this->kind == kind && this->key == key;
+    }
+    const std::u16string& getKey() const {
+        return key;
+    }
+
+    // HTMLCollection
+    virtual unsigned int getLength();
+    virtual Element item(unsigned int index);
+    virtual Object namedItem(const std::u16string& name);
+};
+
 
 }
 }
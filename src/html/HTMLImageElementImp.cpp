@@ -46,6 +46,7 @@ void HTMLImageElementImp::handleMutation(events::MutationEvent mutation)
             current = std::make_shared<HttpRequest>(document->getDocumentURI());
             if (current) {
                 current->open(u"GET", getSrc());
+                current->setPriority(HttpRequest::IMAGE_PRIORITY);
                 current->setHandler(boost::bind(&HTMLImageElementImp::notify, this, current));
                 document->incrementLoadEventDelayCount(current->getURL());
                 current->send();
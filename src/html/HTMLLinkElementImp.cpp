@@ -18,8 +18,6 @@
 
 #include <boost/bind.hpp>
 #include <boost/version.hpp>
-#include <boost/iostreams/stream.hpp>
-#include <boost/iostreams/device/file_descriptor.hpp>
 
 #include "one_at_a_time.hpp"
 
@@ -128,6 +126,7 @@ void HTMLLinkElementImp::refresh()
                 current = std::make_shared<HttpRequest>(document->getDocumentURI());
                 if (current) {
                     current->open(u"GET", href);
+                    current->setPriority(HttpRequest::BLOCKING_PRIORITY);
                     current->setHandler(boost::bind(&HTMLLinkElementImp::linkStyleSheet, this, current));
                     document->incrementLoadEventDelayCount(current->getURL());
                     current->send();
@@ -140,6 +139,7 @@ void HTMLLinkElementImp::refresh()
             current = std::make_shared<HttpRequest>(document->getDocumentURI());
             if (current) {
                 current->open(u"GET", href);
+                current->setPriority(HttpRequest::IMAGE_PRIORITY);
                 current->setHandler(boost::bind(&HTMLLinkElementImp::linkIcon, this, current));
                 document->incrementLoadEventDelayCount(current->getURL());
                 current->send();
@@ -156,9 +156,9 @@ void HTMLLinkElementImp::linkStyleSheet(const HttpRequestPtr& request)
 
     DocumentPtr document = getOwnerDocumentImp();
     if (current->getStatus() == 200) {
-        boost::iostreams::stream<boost::iostreams::file_descriptor_source> stream(current->getContentDescriptor(), boost::iostreams::close_handle);
+        std::unique_ptr<std::istream> stream(current->openContent());
         CSSParser parser(current->getURL());
-        CSSInputStream cssStream(stream, current->getResponseMessage().getContentCharset(), utfconv(document->getCharacterSet()));
+        CSSInputStream cssStream(*stream, current->getResponseMessage().getContentCharset(), utfconv(document->getCharacterSet()));
         styleSheet = parser.parse(document, cssStream);
         if (auto imp = std::dynamic_pointer_cast<CSSStyleSheetImp>(styleSheet.self()))
             imp->setOwnerNode(self());
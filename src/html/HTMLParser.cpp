@@ -229,7 +229,7 @@ Element HTMLParser::insertHtmlElement(Element element)
 
 Element HTMLParser::insertHtmlElement(const std::u16string& name)
 {
-    Element element = document->createElement(name);
+    Element element = nodeDocument->createElement(name);
     if (element)
         insertHtmlElement(element);
     return element;
@@ -243,7 +243,7 @@ Element HTMLParser::insertHtmlElement(Token& token)
 
 Element HTMLParser::createHtmlElement(Token& token)
 {
-    Element element = document->createElement(token.getName());
+    Element element = nodeDocument->createElement(token.getName());
     if (element) {
         if (auto imp = std::static_pointer_cast<ElementImp>(element.self()))
             imp->setAttributes(token.getAttributes());
@@ -258,7 +258,7 @@ void HTMLParser::insertCharacter(Node node, const std::u16string& data)
         org::w3c::dom::Text text = interface_cast<org::w3c::dom::Text>(last);
         text.appendData(data);
     } else {
-        org::w3c::dom::Text text = document->createTextNode(data);
+        org::w3c::dom::Text text = nodeDocument->createTextNode(data);
         node.appendChild(text);
     }
 }
@@ -286,7 +286,7 @@ void HTMLParser::insertCharacter(const std::u16string& data)
                     }
                 }
             }
-            org::w3c::dom::Text text = document->createTextNode(data);
+            org::w3c::dom::Text text = nodeDocument->createTextNode(data);
             fosterParent.insertBefore(text, table);
             return;
         } else
@@ -579,7 +579,7 @@ bool HTMLParser::Initial::processEOF(HTMLParser* parser, Token& token)
 
 bool HTMLParser::Initial::processComment(HTMLParser* parser, Token& token)
 {
-    Comment comment = parser->document->createComment(token.getName());
+    Comment comment = parser->nodeDocument->createComment(token.getName());
     parser->document->appendChild(comment);
     return true;
 }
@@ -734,7 +734,7 @@ bool HTMLParser::BeforeHtml::processEOF(HTMLParser* parser, Token& token)
 
 bool HTMLParser::BeforeHtml::processComment(HTMLParser* parser, Token& token)
 {
-    Comment comment = parser->document->createComment(token.getName());
+    Comment comment = parser->nodeDocument->createComment(token.getName());
     parser->document->appendChild(comment);
     return true;
 }
@@ -791,7 +791,7 @@ bool HTMLParser::BeforeHead::processEOF(HTMLParser* parser, Token& token)
 
 bool HTMLParser::BeforeHead::processComment(HTMLParser* parser, Token& token)
 {
-    Comment comment = parser->document->createComment(token.getName());
+    Comment comment = parser->nodeDocument->createComment(token.getName());
     parser->currentNode().appendChild(comment);
     return true;
 }
@@ -848,7 +848,7 @@ bool HTMLParser::InHead::processEOF(HTMLParser* parser, Token& token)
 
 bool HTMLParser::InHead::processComment(HTMLParser* parser, Token& token)
 {
-    Comment comment = parser->document->createComment(token.getName());
+    Comment comment = parser->nodeDocument->createComment(token.getName());
     parser->currentNode().appendChild(comment);
     return true;
 }
@@ -903,7 +903,8 @@ bool HTMLParser::InHead::processStartTag(HTMLParser* parser, Token& token)
         Element script = parser->createHtmlElement(token);
         if (auto imp = std::dynamic_pointer_cast<HTMLScriptElementImp>(script.self())) {
             imp->markAsParserInserted();
-            // TODO: fragment case
+            if (parser->innerHTML)
+                imp->markAsAlreadyStarted();
         }
         parser->insertHtmlElement(script);
         parser->tokenizer->setState(&HTMLTokenizer::scriptDataState);
@@ -1027,7 +1028,7 @@ bool HTMLParser::AfterHead::processEOF(HTMLParser* parser, Token& token)
 
 bool HTMLParser::AfterHead::processComment(HTMLParser* parser, Token& token)
 {
-    Comment comment = parser->document->createComment(token.getName());
+    Comment comment = parser->nodeDocument->createComment(token.getName());
     parser->currentNode().appendChild(comment);
     return true;
 }
@@ -1101,7 +1102,7 @@ bool HTMLParser::InBody::processEOF(HTMLParser* parser, Token& token)
 
 bool HTMLParser::InBody::processComment(HTMLParser* parser, Token& token)
 {
-    Comment comment = parser->document->createComment(token.getName());
+    Comment comment = parser->nodeDocument->createComment(token.getName());
     parser->currentNode().appendChild(comment);
     return true;
 }
@@ -1288,7 +1289,7 @@ bool HTMLParser::InBody::processStartTag(HTMLParser* parser, Token& token)
         return true;
     }
     if (token.getName() == u"table") {
-        if (parser->document->getCompatMode() != u"BackCompat" && parser->elementInButtonScope(u"p"))
+        if (parser->nodeDocument->getCompatMode() != u"BackCompat" && parser->elementInButtonScope(u"p"))
             processEndTag(parser, endTagP);
         parser->insertHtmlElement(token);
         parser->framesetOkFlag = false;
@@ -1785,7 +1786,7 @@ bool HTMLParser::InTable::processEOF(HTMLParser* parser, Token& token)
 
 bool HTMLParser::InTable::processComment(HTMLParser* parser, Token& token)
 {
-    Comment comment = parser->document->createComment(token.getName());
+    Comment comment = parser->nodeDocument->createComment(token.getName());
     parser->currentNode().appendChild(comment);
     return true;
 }
@@ -2027,7 +2028,7 @@ bool HTMLParser::InColumnGroup::processEOF(HTMLParser* parser, Token& token)
 
 bool HTMLParser::InColumnGroup::processComment(HTMLParser* parser, Token& token)
 {
-    Comment comment = parser->document->createComment(token.getName());
+    Comment comment = parser->nodeDocument->createComment(token.getName());
     parser->currentNode().appendChild(comment);
     return true;
 }
@@ -2361,7 +2362,7 @@ bool HTMLParser::InSelect::processEOF(HTMLParser* parser, Token& token)
 
 bool HTMLParser::InSelect::processComment(HTMLParser* parser, Token& token)
 {
-    Comment comment = parser->document->createComment(token.getName());
+    Comment comment = parser->nodeDocument->createComment(token.getName());
     parser->currentNode().appendChild(comment);
     return true;
 }
@@ -2575,7 +2576,7 @@ bool HTMLParser::AfterBody::processEOF(HTMLParser* parser, Token& token)
 
 bool HTMLParser::AfterBody::processComment(HTMLParser* parser, Token& token)
 {
-    Comment comment = parser->document->createComment(token.getName());
+    Comment comment = parser->nodeDocument->createComment(token.getName());
     parser->openElementStack.top().appendChild(comment);
     return true;
 }
@@ -2632,7 +2633,7 @@ bool HTMLParser::InFrameset::processEOF(HTMLParser* parser, Token& token)
 
 bool HTMLParser::InFrameset::processComment(HTMLParser* parser, Token& token)
 {
-    Comment comment = parser->document->createComment(token.getName());
+    Comment comment = parser->nodeDocument->createComment(token.getName());
     parser->currentNode().appendChild(comment);
     return true;
 }
@@ -2701,7 +2702,7 @@ bool HTMLParser::AfterFrameset::processEOF(HTMLParser* parser, Token& token)
 
 bool HTMLParser::AfterFrameset::processComment(HTMLParser* parser, Token& token)
 {
-    Comment comment = parser->document->createComment(token.getName());
+    Comment comment = parser->nodeDocument->createComment(token.getName());
     parser->currentNode().appendChild(comment);
     return true;
 }
@@ -2755,7 +2756,7 @@ bool HTMLParser::AfterAfterBody::processEOF(HTMLParser* parser, Token& token)
 
 bool HTMLParser::AfterAfterBody::processComment(HTMLParser* parser, Token& token)
 {
-    Comment comment = parser->document->createComment(token.getName());
+    Comment comment = parser->nodeDocument->createComment(token.getName());
     parser->document->appendChild(comment);
     return true;
 }
@@ -2869,7 +2870,8 @@ bool HTMLParser::InBinding::processStartTag(HTMLParser* parser, Token& token)
         Element script = parser->createHtmlElement(token);
         if (auto imp = std::dynamic_pointer_cast<HTMLScriptElementImp>(script.self())) {
             imp->markAsParserInserted();
-            // TODO: fragment case
+            if (parser->innerHTML)
+                imp->markAsAlreadyStarted();
         }
         parser->insertHtmlElement(script);
         parser->tokenizer->setState(&HTMLTokenizer::scriptDataState);
@@ -2904,6 +2906,7 @@ bool HTMLParser::InBinding::processEndTag(HTMLParser* parser, Token& token)
 
 HTMLParser::HTMLParser(const DocumentPtr& document, HTMLTokenizer* tokenizer, bool enableXBL) :
     document(document),
+    nodeDocument(document),
     tokenizer(tokenizer),
     insertionMode(&initial),
     originalInsertionMode(0),
@@ -2952,19 +2955,23 @@ bool HTMLParser::processPendingParsingBlockingScript()
     return true;
 }
 
-void HTMLParser::parseFragment(const DocumentPtr& document, const std::u16string& markup, Element context)
+Element HTMLParser::parseFragment(const DocumentPtr& document, const std::u16string& markup, Element context)
 {
-    std::basic_stringstream<char16_t> sstream(markup);
-    U16TrivialInputStream stream(sstream);
+    // The parser keeps its own state, e.g., the ready state, in a scratch
+    // document, while the nodes are created by document directly so that
+    // they need not be adopted afterward.
+    DocumentPtr scratch(std::make_shared<DocumentImp>());
+    U16StringInputStream stream(markup);
     HTMLTokenizer tokenizer(&stream);
-    HTMLParser parser(document, &tokenizer);
+    HTMLParser parser(scratch, &tokenizer);
+    parser.nodeDocument = document;
+    parser.innerHTML = true;
 
     if (context) {
         parser.contextElement = context;
         tokenizer.setContext(context);
     }
     Element root = document->createElement(u"html");
-    document->appendChild(root);
     parser.openElementStack.push(root);
     parser.resetInsertionMode();
     for (auto i = context; i; i = i.getParentElement()) {
@@ -2975,4 +2982,5 @@ void HTMLParser::parseFragment(const DocumentPtr& document, const std::u16string
         }
     }
     parser.mainLoop();
+    return root;
 }
\ No newline at end of file
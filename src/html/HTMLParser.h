@@ -414,6 +414,7 @@ class HTMLParser
     static InBinding inBinding;
 
     bootstrap::DocumentPtr document;
+    bootstrap::DocumentPtr nodeDocument;  // the owner of the nodes created by the parser
     HTMLTokenizer* tokenizer;
 
     InsertionMode* insertionMode;
@@ -590,7 +591,9 @@ public:
 
     bool processPendingParsingBlockingScript();
 
-    static void parseFragment(const bootstrap::DocumentPtr&, const std::u16string& markup, Element context);
+    // Parses markup in the context of context, and returns a detached html
+    // element holding the resulting nodes. The nodes are owned by document.
+    static Element parseFragment(const bootstrap::DocumentPtr& document, const std::u16string& markup, Element context);
 };
 
 #endif  // ES_HTMLPARSER_H
@@ -20,8 +20,6 @@
 
 #include <boost/bind.hpp>
 #include <boost/version.hpp>
-#include <boost/iostreams/stream.hpp>
-#include <boost/iostreams/device/file_descriptor.hpp>
 
 #include "ECMAScript.h"
 
@@ -112,6 +110,7 @@ bool HTMLScriptElementImp::prepare()
                 document->addDeferScript(self());
             } else if (parserInserted && !hasAsync) {
                 type = Blocking;
+                request->setPriority(HttpRequest::BLOCKING_PRIORITY);
                 document->setPendingParsingBlockingScript(std::static_pointer_cast<HTMLScriptElementImp>(self()));
             } else if (!hasAsync && !forceAsync) {
                 type = Ordered;
@@ -176,8 +175,8 @@ bool HTMLScriptElementImp::execute()
     std::u16string script;
     if (request) {
         assert(request->getStatus() == 200);
-        boost::iostreams::stream<boost::iostreams::file_descriptor_source> stream(request->getContentDescriptor(), boost::iostreams::close_handle);
-        U16ConverterInputStream u16stream(stream, "utf-8");  // TODO detect encode
+        std::unique_ptr<std::istream> stream(request->openContent());
+        U16ConverterInputStream u16stream(*stream, "utf-8");  // TODO detect encode
         script = u16stream;
     } else {
         Nullable<std::u16string> content = getTextContent();
@@ -58,6 +58,11 @@ public:
         parserInserted = true;
         forceAsync = false;
     }
+    // Marks a script created by the fragment parsing algorithm so that it
+    // never runs.
+    void markAsAlreadyStarted() {
+        alreadyStarted = true;
+    }
     bool isReadyToBeParserExecuted() const {
         return readyToBeParserExecuted;
     }
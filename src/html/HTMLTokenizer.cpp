@@ -21,7 +21,6 @@
 
 #include "utf.h"
 
-#include "AttrImp.h"
 #include "css/CSSSerialize.h"
 #include "html/HTMLUtil.h"
 
@@ -2378,11 +2377,8 @@ bool Token::append(Attribute& attribute)
     if (attribute.getName().length() == 0)
         return true;
     if (attrNames.find(attribute.getName()) == attrNames.end()) {
-        Attr attr(std::make_shared<org::w3c::dom::bootstrap::AttrImp>(Nullable<std::u16string>(), Nullable<std::u16string>(), attribute.getName(), attribute.getValue()));
-        if (attr) {
-            attrNames.insert(attribute.getName());
-            attrList.push_back(attr);
-        }
+        attrNames.insert(attribute.getName());
+        attrList.push_back(attribute);
         attribute.clear();
         return true;
     }
@@ -2394,9 +2390,8 @@ Nullable<std::u16string> Token::getAttribute(const std::u16string& name) const
 {
     if (attrNames.find(name) != attrNames.end()) {
         for (auto i = attrList.begin(); i != attrList.end(); ++i) {
-            Attr attr = *i;
-            if (attr.getName() == name)
-                return attr.getValue();
+            if (i->getName() == name)
+                return i->getValue();
         }
     }
     return Nullable<std::u16string>();
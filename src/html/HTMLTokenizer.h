@@ -67,8 +67,6 @@ public:
 
 class Token
 {
-    typedef org::w3c::dom::Attr Attr;
-
 public:
     enum class Type
     {
@@ -100,9 +98,10 @@ private:
     // name or data for Comment and Doctype
     std::u16string name;
 
-    // StartTag/EndTag field
+    // StartTag/EndTag field; attributes are kept as plain name/value pairs
+    // so that no Attr object is allocated until an element is created.
     std::set<std::u16string> attrNames;
-    std::deque<Attr> attrList;
+    std::deque<Attribute> attrList;
 
     // Doctype fields
     std::u16string publicId;
@@ -133,7 +132,7 @@ public:
         this->name = name;
     }
 
-    const std::deque<Attr>& getAttributes() const
+    const std::deque<Attribute>& getAttributes() const
     {
         return attrList;
     }
@@ -0,0 +1,161 @@
+/*
+ * Copyright 2015 Esrille Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "HTTPBody.h"
+
+#include <fcntl.h>
+#include <limits.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+namespace org { namespace w3c { namespace dom { namespace bootstrap {
+
+const size_t HttpBody::ChunkSize;
+size_t HttpBody::spillThreshold = 256 * 1024;
+
+HttpBody::HttpBody(const std::string& directory) :
+    directory(directory),
+    size(0)
+{
+}
+
+HttpBody::~HttpBody()
+{
+    if (file.is_open())
+        file.close();
+    if (!filePath.empty())
+        remove(filePath.c_str());
+}
+
+bool HttpBody::write(const char* data, size_t length)
+{
+    if (!isSpilled() && spillThreshold < size + length && !spill(true))
+        return false;
+    size += length;
+    if (isSpilled()) {
+        file.write(data, length);
+        return file.good();
+    }
+    while (0 < length) {
+        if (chunks.empty() || chunks.back().length() == ChunkSize) {
+            chunks.push_back(std::string());
+            chunks.back().reserve(std::min(std::max(length, size), ChunkSize));
+        }
+        std::string& chunk = chunks.back();
+        size_t count = std::min(length, ChunkSize - chunk.length());
+        chunk.append(data, count);
+        data += count;
+        length -= count;
+    }
+    return true;
+}
+
+bool HttpBody::spill(bool release)
+{
+    if (!isSpilled()) {
+        char tempPath[PATH_MAX];
+        if (PATH_MAX <= directory.length() + 16)
+            return false;
+        strcpy(tempPath, directory.c_str());
+        strcat(tempPath, "/esrille-XXXXXX");
+        int fd = mkstemp(tempPath);
+        if (fd == -1)
+            return false;
+        file.open(tempPath, std::ios_base::trunc | std::ios_base::out | std::ios::binary);
+        close(fd);
+        for (auto i = chunks.begin(); i != chunks.end() && file; ++i)
+            file.write(i->data(), i->length());
+        file.flush();
+        if (!file) {
+            file.close();
+            remove(tempPath);
+            return false;
+        }
+        filePath = tempPath;
+    }
+    if (release)
+        std::vector<std::string>().swap(chunks);
+    return true;
+}
+
+std::streamsize HttpBody::xsputn(const char* s, std::streamsize n)
+{
+    return write(s, n) ? n : 0;
+}
+
+HttpBody::int_type HttpBody::overflow(int_type c)
+{
+    if (traits_type::eq_int_type(c, traits_type::eof()))
+        return traits_type::not_eof(c);
+    char ch = traits_type::to_char_type(c);
+    return write(&ch, 1) ? c : traits_type::eof();
+}
+
+int HttpBody::sync()
+{
+    if (!file.is_open())
+        return 0;
+    file.flush();
+    return file ? 0 : -1;
+}
+
+int HttpBody::getDescriptor()
+{
+    if (!spill() || sync() != 0)
+        return -1;
+    return ::open(filePath.c_str(), O_RDONLY, 0);
+}
+
+std::FILE* HttpBody::openFile()
+{
+    if (!spill() || sync() != 0)
+        return 0;
+    return fopen(filePath.c_str(), "rb");
+}
+
+HttpBodyStream::ChunkBuffer::ChunkBuffer(const HttpBodyPtr& body) :
+    body(body),
+    index(0)
+{
+}
+
+HttpBodyStream::ChunkBuffer::int_type HttpBodyStream::ChunkBuffer::underflow()
+{
+    const std::vector<std::string>& chunks = body->getChunks();
+    while (index < chunks.size()) {
+        const std::string& chunk = chunks[index++];
+        if (!chunk.empty()) {
+            char* p = const_cast<char*>(chunk.data());
+            setg(p, p, p + chunk.length());
+            return traits_type::to_int_type(*p);
+        }
+    }
+    return traits_type::eof();
+}
+
+HttpBodyStream::HttpBodyStream(const HttpBodyPtr& body) :
+    std::istream(0),
+    chunks(body)
+{
+    if (body->isInMemory())
+        rdbuf(&chunks);
+    else if (file.open(body->getFilePath().c_str(), std::ios::in | std::ios::binary))
+        rdbuf(&file);
+}
+
+}}}}  // org::w3c::dom::bootstrap
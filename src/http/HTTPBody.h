@@ -0,0 +1,119 @@
+/*
+ * Copyright 2015 Esrille Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ES_HTTP_BODY_H
+#define ES_HTTP_BODY_H
+
+#include <cstdio>
+#include <fstream>
+#include <istream>
+#include <memory>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+namespace org { namespace w3c { namespace dom { namespace bootstrap {
+
+class HttpBody;
+
+typedef std::shared_ptr<HttpBody> HttpBodyPtr;
+
+// HttpBody is the sink of a response body. A small body is kept in memory as
+// a chain of buffers, and it is moved to a temporary file under the cache
+// directory only once it grows past the spill threshold. A body is shared by
+// the cache entry and the requests of the same resource; the temporary file
+// is removed together with the last reference to the body.
+class HttpBody : public std::streambuf
+{
+    static const size_t ChunkSize = 16384;
+    static size_t spillThreshold;
+
+    std::string directory;
+    std::vector<std::string> chunks;
+    size_t size;
+    std::string filePath;
+    std::ofstream file;
+
+protected:
+    virtual std::streamsize xsputn(const char* s, std::streamsize n);
+    virtual int_type overflow(int_type c);
+    virtual int sync();
+
+public:
+    HttpBody(const std::string& directory);
+    ~HttpBody();
+
+    bool write(const char* data, size_t length);
+
+    // Moves the body to a temporary file. The buffers in memory are released
+    // only if release is true, since they might be being read by a stream.
+    // A body spilled without releasing its buffers must not be written any
+    // more.
+    bool spill(bool release = false);
+
+    size_t getSize() const {
+        return size;
+    }
+    bool isSpilled() const {
+        return !filePath.empty();
+    }
+    bool isInMemory() const {
+        return !isSpilled() || !chunks.empty();
+    }
+    const std::string& getFilePath() const {
+        return filePath;
+    }
+    const std::vector<std::string>& getChunks() const {
+        return chunks;
+    }
+
+    // Opens the body for the decoders that only take a file descriptor or a
+    // FILE*. The body is spilled to the file first if necessary.
+    int getDescriptor();
+    std::FILE* openFile();
+
+    static size_t getSpillThreshold() {
+        return spillThreshold;
+    }
+    static void setSpillThreshold(size_t value) {
+        spillThreshold = value;
+    }
+};
+
+// HttpBodyStream reads a complete body. The buffers kept in memory are handed
+// to the reader in place without being copied.
+class HttpBodyStream : public std::istream
+{
+    class ChunkBuffer : public std::streambuf
+    {
+        HttpBodyPtr body;
+        size_t index;
+    protected:
+        virtual int_type underflow();
+    public:
+        ChunkBuffer(const HttpBodyPtr& body);
+    };
+
+    ChunkBuffer chunks;
+    std::filebuf file;
+
+public:
+    HttpBodyStream(const HttpBodyPtr& body);
+};
+
+}}}}  // org::w3c::dom::bootstrap
+
+#endif  // ES_HTTP_BODY_H
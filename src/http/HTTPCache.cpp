@@ -31,6 +31,8 @@
 
 namespace org { namespace w3c { namespace dom { namespace bootstrap {
 
+bool HttpCacheManager::storeEncoded = false;
+
 void HttpCache::notify(HttpRequest* request, bool error)
 {
     current = 0;
@@ -41,14 +43,11 @@ void HttpCache::notify(HttpRequest* request, bool error)
         response.update(request->getResponseMessage());
         // TODO: deal with partial...
         unsigned short status = request->getResponseMessage().getStatus();
-        if (status == 304) {  // Not Modified?
-            request->removeFile();
+        if (status == 304)  // Not Modified?
             request->constructResponseFromCache(false);
-        } else {
-            if (!filePath.empty() && filePath != request->getFilePath())
-                remove(filePath.c_str());
+        else {
             response.updateStatus(request->getResponseMessage());
-            filePath = request->getFilePath();
+            body = request->getBody();
         }
     }
 
@@ -72,10 +71,7 @@ void HttpCache::invalidate()
 {
     response.clear();
     contentLength = 0;
-    if (!filePath.empty()) {
-        remove(filePath.c_str());
-        filePath.clear();
-    }
+    body.reset();
     requestTime = 0;
 }
 
@@ -152,7 +148,7 @@ HttpCache* HttpCacheManager::send(const HttpRequestPtr& request)
             if (cache->response.isCacheable() && cache->response.isFresh(cache->requestTime)) {
                 if (request->redirect(cache->response))
                     continue;
-                if (code == HttpRequestMessage::HEAD || !cache->filePath.empty())
+                if (code == HttpRequestMessage::HEAD || cache->body)
                     return cache;
             }
             return cache->send(request);
@@ -162,7 +158,6 @@ HttpCache* HttpCacheManager::send(const HttpRequestPtr& request)
 
     // No need for going through the cache
     // TODO: call cache->invlidate();
-    request->flags &= ~HttpRequest::DONT_REMOVE;
     HttpConnectionManager& manager(HttpConnectionManager::getInstance());
     manager.send(request);
     return 0;
@@ -176,7 +171,7 @@ void HttpCacheManager::remove(HttpCache* cache)
 void HttpCacheManager::dump() {
     for (auto i = lru.begin(); i != lru.end(); ++i) {
         HttpCache* cache = *i;
-        std::cout << static_cast<std::u16string>(cache->url) << ' ' << cache->response.getStatus() << ' ' << cache->filePath << '\n';
+        std::cout << static_cast<std::u16string>(cache->url) << ' ' << cache->response.getStatus() << ' ' << (cache->body ? cache->body->getSize() : 0) << '\n';
     }
 }
 
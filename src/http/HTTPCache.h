@@ -17,7 +17,6 @@
 #ifndef ES_HTTP_CACHE_H
 #define ES_HTTP_CACHE_H
 
-#include <fstream>
 #include <list>
 
 #include "http/HTTPRequest.h"
@@ -32,7 +31,7 @@ class HttpCache
     HttpResponseMessage response;
     unsigned long long contentLength;
 
-    std::string filePath;
+    HttpBodyPtr body;
 
     long long requestTime;
 
@@ -52,8 +51,8 @@ public:
         return static_cast<bool>(current);
     }
 
-    const std::string& getFilePath() const {
-        return filePath;
+    const HttpBodyPtr& getBody() const {
+        return body;
     }
 
     void notify(HttpRequest* request, bool error);
@@ -76,20 +75,28 @@ public:
         current(0)
     {
     }
-
-    ~HttpCache()
-    {
-        if (!filePath.empty())
-            remove(filePath.c_str());
-    }
 };
 
 class HttpCacheManager
 {
+    static bool storeEncoded;
+
     std::list<HttpCache*> lru;
 public:
     ~HttpCacheManager();
 
+    // By default, gzip and deflate coded responses are decoded as they are
+    // received and stored decoded. If storeEncoded is set, they are stored
+    // as received, which saves the disk space, and each request decodes its
+    // own copy upon completion instead. This must be set before any request
+    // is sent.
+    static void setStoreEncoded(bool value) {
+        storeEncoded = value;
+    }
+    static bool isStoreEncoded() {
+        return storeEncoded;
+    }
+
     HttpCache* getCache(const URL& url);
     HttpCache* send(const HttpRequestPtr& request);
     void remove(HttpCache* cache);
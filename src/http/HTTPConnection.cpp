@@ -18,6 +18,7 @@
 
 #include <algorithm>
 #include <iostream>
+#include <iterator>
 #include <boost/bind.hpp>
 
 #include "url/URI.h"
@@ -49,6 +50,7 @@ HttpConnection::HttpConnection(const std::string& protocol, const std::string& h
     protocol(protocol),
     hostname(hostname),
     port(port),
+    nextEndpoint(0),
     socket(HttpConnectionManager::getIOService()),
     context(boost::asio::ssl::context::sslv23),
     secureSocket(socket, context),
@@ -81,22 +83,8 @@ void HttpConnection::done(HttpConnectionManager* manager, bool error)
         current.reset();
         manager->complete(request, error);
     }
-    if (!error) {
+    if (!error)
         retryCount = 0;
-        if (!requests.empty()) {
-            // Note at this point, the socket might have been closed.
-            HttpRequestPtr request = requests.front();
-            requests.pop_front();
-            send(request);
-        }
-    } else {
-        while (!requests.empty()) {
-            current = requests.front();
-            requests.pop_front();
-            manager->complete(current, error);
-        }
-        current.reset();
-    }
 }
 
 void HttpConnection::close()
@@ -107,6 +95,7 @@ void HttpConnection::close()
     socket.close();
     request.consume(request.size());
     response.consume(response.size());
+    decoder.close();
 }
 
 void HttpConnection::retry()
@@ -125,21 +114,28 @@ void HttpConnection::retry()
         HttpConnectionManager::getInstance().done(this, true);
 }
 
-void HttpConnection::handleResolve(const boost::system::error_code& err, boost::asio::ip::tcp::resolver::iterator endpointIterator)
+void HttpConnection::handleResolve(const boost::system::error_code& err, const HttpResolver::Endpoints& endpoints)
 {
     if (3 <= getLogLevel())
         std::cerr << __func__ << ' ' << err << '\n';
 
     if (!err) {
         state = Resolved;
-        boost::asio::ip::tcp::endpoint endpoint = *endpointIterator;
-        socket.async_connect(endpoint, boost::bind(&HttpConnection::handleConnect, this, boost::asio::placeholders::error, ++endpointIterator));
+        this->endpoints = endpoints;
+        nextEndpoint = 0;
+        connect();
         return;
     }
     HttpConnectionManager::getInstance().done(this, true);
 }
 
-void HttpConnection::handleConnect(const boost::system::error_code& err, boost::asio::ip::tcp::resolver::iterator endpointIterator)
+void HttpConnection::connect()
+{
+    assert(nextEndpoint < endpoints.size());
+    socket.async_connect(endpoints[nextEndpoint++], boost::bind(&HttpConnection::handleConnect, this, boost::asio::placeholders::error));
+}
+
+void HttpConnection::handleConnect(const boost::system::error_code& err)
 {
     if (3 <= getLogLevel())
         std::cerr << __func__ << ' ' << err << '\n';
@@ -159,12 +155,13 @@ void HttpConnection::handleConnect(const boost::system::error_code& err, boost::
         }
         return;
     }
-    if (endpointIterator != boost::asio::ip::tcp::resolver::iterator()) {
+    if (nextEndpoint < endpoints.size()) {
         close();
-        boost::asio::ip::tcp::endpoint endpoint = *endpointIterator;
-        socket.async_connect(endpoint, boost::bind(&HttpConnection::handleConnect, this, boost::asio::placeholders::error, ++endpointIterator));
+        connect();
         return;
     }
+    // The cached addresses might be stale; look up the host again next time.
+    HttpConnectionManager::getInstance().getResolver().invalidate(hostname, port);
     HttpConnectionManager::getInstance().done(this, true);
 }
 
@@ -343,6 +340,8 @@ void HttpConnection::readHead(const boost::system::error_code& err)
         break;
     default:
         octetCount = 0;
+        if (!HttpCacheManager::isStoreEncoded() && current->getRequestMessage().getMethodCode() != HttpRequestMessage::HEAD)
+            decoder.open(responseMessage.getContentCoding());
         if (responseMessage.isChunked()) {
             chunkCRLF = 0;
             contentLength = 0;
@@ -369,22 +368,19 @@ void HttpConnection::readHead(const boost::system::error_code& err)
 void HttpConnection::readContent(const boost::system::error_code& err)
 {
     if (!err || err == boost::asio::error::eof) {
-        std::fstream& content = current->getContent();
-        if (!content.is_open()) {
-            HttpConnectionManager::getInstance().done(this, true);
-            return;
-        }
+        HttpBody* body = current->getSink();
         bool completed = false;
         if (0 < response.size()) {
-            if (!contentLength) {
-                octetCount += response.size();
-                content << &response;
-            } else {
-                unsigned long long length = std::min(static_cast<unsigned long long>(response.size()), contentLength - octetCount);
-                content.write(boost::asio::buffer_cast<const char*>(response.data()), length);
-                response.consume(length);
-                octetCount += length;
+            unsigned long long length = response.size();
+            if (contentLength)
+                length = std::min(length, contentLength - octetCount);
+            if (!writeContent(body, boost::asio::buffer_cast<const char*>(response.data()), length)) {
+                close();
+                HttpConnectionManager::getInstance().done(this, true);
+                return;
             }
+            response.consume(length);
+            octetCount += length;
             if (contentLength <= octetCount)
                 completed = true;
         }
@@ -392,7 +388,11 @@ void HttpConnection::readContent(const boost::system::error_code& err)
             asyncRead(response, boost::asio::transfer_at_least(1), boost::bind(&HttpConnection::handleRead, this, boost::asio::placeholders::error));
             return;
         }
-        content.flush();
+        if (!finishContent(body)) {
+            close();
+            HttpConnectionManager::getInstance().done(this, true);
+            return;
+        }
     }
     if (err == boost::asio::error::eof) {
         close();
@@ -411,11 +411,7 @@ void HttpConnection::readContent(const boost::system::error_code& err)
 void HttpConnection::readChunk(const boost::system::error_code& err)
 {
     if (!err || err == boost::asio::error::eof) {
-        std::fstream& content = current->getContent();
-        if (!content.is_open()) {
-            HttpConnectionManager::getInstance().done(this, true);
-            return;
-        }
+        HttpBody* body = current->getSink();
         bool completed = false;
         while (0 < response.size()) {
             if (line.empty() || line[line.length() - 1] != '\n') {
@@ -432,13 +428,12 @@ void HttpConnection::readChunk(const boost::system::error_code& err)
                     parseHexDigits(line.c_str(), line.c_str() + line.length(), chunkLength);
                     contentLength += chunkLength;
                     if (chunkLength == 0) {
-                        if (line[0] != '0') {
-                            HttpConnectionManager::getInstance().done(this, true);
+                        if (line[0] != '0' || !finishContent(body)) {
                             close();
+                            HttpConnectionManager::getInstance().done(this, true);
                             return;
                         }
                         completed = true;
-                        content.flush();
                         chunkCRLF = 1;
                     }
                 }
@@ -446,7 +441,11 @@ void HttpConnection::readChunk(const boost::system::error_code& err)
             if (!completed) {
                 if (0 < response.size() && octetCount < contentLength) {
                     unsigned long long length = std::min(static_cast<unsigned long long>(response.size()), contentLength - octetCount);
-                    content.write(boost::asio::buffer_cast<const char*>(response.data()), length);
+                    if (!writeContent(body, boost::asio::buffer_cast<const char*>(response.data()), length)) {
+                        close();
+                        HttpConnectionManager::getInstance().done(this, true);
+                        return;
+                    }
                     response.consume(length);
                     octetCount += length;
                 }
@@ -459,8 +458,8 @@ void HttpConnection::readChunk(const boost::system::error_code& err)
                     } else if (c == '\r' && chunkCRLF == 0)
                         ++chunkCRLF;
                     else {
-                        HttpConnectionManager::getInstance().done(this, true);
                         close();
+                        HttpConnectionManager::getInstance().done(this, true);
                         return;
                     }
                 }
@@ -477,8 +476,8 @@ void HttpConnection::readChunk(const boost::system::error_code& err)
         }
     }
     assert(err);
-    HttpConnectionManager::getInstance().done(this, err);
     close();
+    HttpConnectionManager::getInstance().done(this, err);
 }
 
 void HttpConnection::readTrailer(const boost::system::error_code& err)
@@ -507,17 +506,34 @@ void HttpConnection::readTrailer(const boost::system::error_code& err)
         }
     }
     assert(err);
-    HttpConnectionManager::getInstance().done(this, err);
     close();
+    HttpConnectionManager::getInstance().done(this, err);
+}
+
+// Writes a piece of the response body to the content sink, decoding it on
+// the way if it is gzip or deflate coded.
+bool HttpConnection::writeContent(HttpBody* body, const char* data, size_t length)
+{
+    if (!decoder.isOpen())
+        return body->write(data, length);
+    std::ostream content(body);
+    return decoder.write(content, data, length) && content;
+}
+
+// Flushes the body and ends the content decoding. Returns false if the coded
+// stream ended before its end mark, i.e., the body has been truncated. Note an
+// empty body is accepted as is.
+bool HttpConnection::finishContent(HttpBody* body)
+{
+    body->pubsync();
+    bool truncated = decoder.isOpen() && !decoder.isFinished() && 0 < octetCount;
+    decoder.close();
+    return !truncated;
 }
 
 void HttpConnection::send(const HttpRequestPtr& request)
 {
-    if (current) {
-        assert(current != request);
-        requests.push_back(request);
-        return;
-    }
+    assert(!current);
     current = request;
 
     if (socket.is_open()) {
@@ -526,41 +542,72 @@ void HttpConnection::send(const HttpRequestPtr& request)
     }
 
     state = Resolving;
-    boost::asio::ip::tcp::resolver::query query(hostname, port);
-    HttpConnectionManager::getInstance().resolve(query,
-                                                 boost::bind(&HttpConnection::handleResolve, this,
-                                                             boost::asio::placeholders::error,
-                                                             boost::asio::placeholders::iterator));
+    HttpConnectionManager::getInstance().getResolver().resolve(hostname, port,
+                                                               boost::bind(&HttpConnection::handleResolve, this, _1, _2));
 }
 
 void HttpConnection::abort(const HttpRequestPtr& request)
 {
-    if (current != request) {
-        requests.remove(request);
-        request->notify(true);
-        return;
-    }
+    assert(current == request);
     close();
     done(&HttpConnectionManager::getInstance(), true);
 }
 
 void HttpConnection::dump()
 {
-    std::cout << "HttpConnection: " << protocol << ' ' << hostname << ' ' << States[state] << ' ' << requests.size() << '\n';
+    std::cout << "HttpConnection: " << protocol << ' ' << hostname << ' ' << States[state] << '\n';
 }
 
-HttpConnection* HttpConnectionManager::getConnection(const std::string& protocol, const std::string& hostname, const std::string& port)
+HttpConnection* HttpConnectionManager::getConnection(const std::string& protocol, const std::string& hostname, const std::string& port, unsigned short priority)
 {
+    HttpConnection* idle = 0;
+    size_t count = 0;
+    size_t busy = 0;
     for (auto i = connections.begin(); i != connections.end(); ++i) {
-        if ((*i)->protocol == protocol && (*i)->hostname == hostname && (*i)->port == port)
-            return *i;
+        HttpConnection* c = *i;
+        if (c->protocol != protocol || c->hostname != hostname || c->port != port)
+            continue;
+        ++count;
+        if (c->isBusy())
+            ++busy;
+        else if (!idle || !idle->socket.is_open())
+            idle = c;   // Prefer a kept-alive connection.
     }
+    size_t limit = MaxConnectionsPerOrigin;
+    if (HttpRequest::BLOCKING_PRIORITY < priority)
+        --limit;
+    if (limit <= busy)
+        return 0;
+    if (idle)
+        return idle;
+    if (MaxConnectionsPerOrigin <= count)
+        return 0;
     HttpConnection* c = new(std::nothrow) HttpConnection(protocol, hostname, port);
     if (c)
         connections.push_back(c);
     return c;
 }
 
+// Sends the queued requests of the origin as long as connections are available.
+void HttpConnectionManager::dispatch(const std::string& protocol, const std::string& hostname, const std::string& port)
+{
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+
+    auto found = queues.find(getOrigin(protocol, hostname, port));
+    if (found == queues.end())
+        return;
+    std::list<HttpRequestPtr>& queue = found->second;
+    while (!queue.empty()) {
+        HttpConnection* conn = getConnection(protocol, hostname, port, queue.front()->getPriority());
+        if (!conn)
+            return;
+        HttpRequestPtr request = queue.front();
+        queue.pop_front();
+        conn->send(request);
+    }
+    queues.erase(found);
+}
+
 void HttpConnectionManager::send(const HttpRequestPtr& request)
 {
     std::lock_guard<std::recursive_mutex> lock(mutex);
@@ -569,10 +616,12 @@ void HttpConnectionManager::send(const HttpRequestPtr& request)
     std::string protocol = uri.getProtocol();
     std::string hostname = uri.getHostname();
     std::string port = uri.getPort();
-    HttpConnection* conn = getConnection(protocol, hostname, port);
-    if (!conn)
-        return;
-    conn->send(request);
+    std::list<HttpRequestPtr>& queue = queues[getOrigin(protocol, hostname, port)];
+    auto i = queue.end();
+    while (i != queue.begin() && request->getPriority() < (*std::prev(i))->getPriority())
+        --i;
+    queue.insert(i, request);
+    dispatch(protocol, hostname, port);
 }
 
 void HttpConnectionManager::abort(const HttpRequestPtr& request)
@@ -585,9 +634,27 @@ void HttpConnectionManager::abort(const HttpRequestPtr& request)
             std::string protocol = uri.getProtocol();
             std::string hostname = uri.getHostname();
             std::string port = uri.getPort();
-            HttpConnection* conn = getConnection(protocol, hostname, port);
-            if (conn)
-                conn->abort(request);
+            bool queued = false;
+            auto found = queues.find(getOrigin(protocol, hostname, port));
+            if (found != queues.end()) {
+                auto i = std::find(found->second.begin(), found->second.end(), request);
+                if (i != found->second.end()) {
+                    found->second.erase(i);
+                    queued = true;
+                }
+            }
+            if (queued)
+                request->notify(true);
+            else {
+                for (auto i = connections.begin(); i != connections.end(); ++i) {
+                    HttpConnection* conn = *i;
+                    if (conn->current == request) {
+                        conn->abort(request);
+                        dispatch(protocol, hostname, port);
+                        break;
+                    }
+                }
+            }
         }
     }
     if (request->getReadyState() == HttpRequest::COMPLETE)
@@ -600,6 +667,10 @@ void HttpConnectionManager::done(HttpConnection* conn, bool error)
     std::lock_guard<std::recursive_mutex> lock(mutex);
 
     conn->done(this, error);
+
+    // The caller is still in the middle of updating the state of conn, so
+    // hand conn over to the next request after the current handler returns.
+    ioService.post(boost::bind(&HttpConnectionManager::dispatch, this, conn->protocol, conn->hostname, conn->port));
 }
 
 void HttpConnectionManager::complete(const HttpRequestPtr& request, bool error)
@@ -626,6 +697,23 @@ void HttpConnectionManager::poll()
         request->notify();
 }
 
+bool HttpConnectionManager::isIdle()
+{
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+
+    if (!completed.empty())
+        return false;
+    for (auto i = queues.begin(); i != queues.end(); ++i) {
+        if (!i->second.empty())
+            return false;
+    }
+    for (auto i = connections.begin(); i != connections.end(); ++i) {
+        if ((*i)->isBusy())
+            return false;
+    }
+    return true;
+}
+
 void HttpConnectionManager::operator()()
 {
     ioService.run();
@@ -637,6 +725,7 @@ void HttpConnectionManager::dump()
     for (auto i = instance.connections.begin(); i != instance.connections.end(); ++i)
         (*i)->dump();
     std::cout << "completed: " << instance.completed.size() << '\n';
+    instance.resolver.dump();
 }
 
 }}}}  // org::w3c::dom::bootstrap
@@ -18,6 +18,7 @@
 #define ES_HTTP_CONNECTION_H
 
 #include <list>
+#include <map>
 #include <mutex>
 #include <thread>
 
@@ -25,6 +26,8 @@
 #include <boost/asio/ssl.hpp>
 
 #include "http/HTTPCache.h"
+#include "http/HTTPContentDecoder.h"
+#include "http/HTTPResolver.h"
 
 namespace org { namespace w3c { namespace dom { namespace bootstrap {
 
@@ -32,16 +35,30 @@ class HttpConnection;
 
 class HttpConnectionManager
 {
+    // The maximum number of the parallel connections to a single origin.
+    // Requests below BLOCKING_PRIORITY may use one less, so that a style
+    // sheet or a script is never stuck behind a full set of image transfers.
+    static const size_t MaxConnectionsPerOrigin = 6;
+
     std::recursive_mutex mutex;
     std::list<HttpConnection*> connections;
+    // a map from origin to the requests waiting for a connection, in the order of priority
+    std::map<std::string, std::list<HttpRequestPtr>> queues;
     std::list<HttpRequestPtr> completed;
 
     boost::asio::io_service ioService;
-    boost::asio::ip::tcp::resolver resolver;
+    HttpResolver resolver;
     boost::asio::io_service::work work;
 
     HttpRequestPtr getCompleted();
 
+    static std::string getOrigin(const std::string& protocol, const std::string& hostname, const std::string& port) {
+        return protocol + "//" + hostname + ':' + port;
+    }
+
+    HttpConnection* getConnection(const std::string& protocol, const std::string& hostname, const std::string& port, unsigned short priority);
+    void dispatch(const std::string& protocol, const std::string& hostname, const std::string& port);
+
 public:
     HttpConnectionManager() :
         resolver(ioService),
@@ -49,16 +66,16 @@ public:
     {
     }
 
-    HttpConnection* getConnection(const std::string& protocol, const std::string& hostname, const std::string& port);
     void send(const HttpRequestPtr& request);
     void abort(const HttpRequestPtr& request);
     void done(HttpConnection* conn, bool error);
     void complete(const HttpRequestPtr& request, bool error);
     void poll();
+    // Returns true if no request is in flight or waiting to be notified.
+    bool isIdle();
 
-    template <typename ResolveHandler>
-    void resolve(const boost::asio::ip::tcp::resolver::query& q, ResolveHandler handler) {
-        resolver.async_resolve(q,handler);
+    HttpResolver& getResolver() {
+        return resolver;
     }
 
     void operator()();
@@ -100,6 +117,7 @@ class HttpConnection
     static const char* States[];
 
     static const int MaxRetryCount = 3;
+    static const size_t ReadBufferSize = 65536;
 
     int state;
     int retryCount;
@@ -110,6 +128,8 @@ class HttpConnection
     std::string port;
 
     // Boost
+    HttpResolver::Endpoints endpoints;
+    size_t nextEndpoint;
     boost::asio::ip::tcp::socket socket;
     boost::asio::streambuf request;
     boost::asio::streambuf response;
@@ -124,13 +144,15 @@ class HttpConnection
     unsigned long long chunkLength;
     int chunkCRLF;
 
-    std::list<HttpRequestPtr> requests;
+    HttpContentDecoder decoder;
+
     HttpRequestPtr current;
 
     void sendRequest();
+    void connect();
 
-    void handleResolve(const boost::system::error_code& err, boost::asio::ip::tcp::resolver::iterator endpointIterator);
-    void handleConnect(const boost::system::error_code& err, boost::asio::ip::tcp::resolver::iterator endpointIterator);
+    void handleResolve(const boost::system::error_code& err, const HttpResolver::Endpoints& endpoints);
+    void handleConnect(const boost::system::error_code& err);
     void handleHandshake(const boost::system::error_code& err);
     void handleWriteRequest(const boost::system::error_code& err);
     void handleRead(const boost::system::error_code& err);
@@ -141,6 +163,9 @@ class HttpConnection
     void readChunk(const boost::system::error_code& err);
     void readTrailer(const boost::system::error_code& err);
 
+    bool writeContent(HttpBody* body, const char* data, size_t length);
+    bool finishContent(HttpBody* body);
+
     void close();
     void retry();
 
@@ -150,6 +175,9 @@ class HttpConnection
 
     template<typename CompletionCondition, typename ReadHandler>
     void asyncRead(boost::asio::streambuf& buffers, CompletionCondition completionCondition, ReadHandler handler) {
+        // Reserve room so that a single read can take up to ReadBufferSize
+        // bytes rather than the 512 bytes asio reads into an empty streambuf.
+        buffers.prepare(ReadBufferSize);
         if (protocol == "https:")
             boost::asio::async_read(secureSocket, buffers, completionCondition, handler);
         else
@@ -166,6 +194,11 @@ class HttpConnection
 
 public:
     HttpConnection(const std::string& protocol, const std::string& hostname, const std::string& port);
+
+    bool isBusy() const {
+        return static_cast<bool>(current);
+    }
+
     void dump();
 };
 
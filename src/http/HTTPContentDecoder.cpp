@@ -0,0 +1,121 @@
+/*
+ * Copyright 2015 Esrille Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "HTTPContentDecoder.h"
+
+#include <istream>
+#include <ostream>
+
+#include "http/HTTPResponseMessage.h"
+
+namespace org { namespace w3c { namespace dom { namespace bootstrap {
+
+HttpContentDecoder::HttpContentDecoder() :
+    coding(HttpResponseMessage::Identity),
+    raw(false),
+    finished(false)
+{
+}
+
+HttpContentDecoder::~HttpContentDecoder()
+{
+    close();
+}
+
+bool HttpContentDecoder::open(int coding)
+{
+    close();
+    if (coding != HttpResponseMessage::Gzip && coding != HttpResponseMessage::Deflate)
+        return false;
+    stream.zalloc = Z_NULL;
+    stream.zfree = Z_NULL;
+    stream.opaque = Z_NULL;
+    stream.next_in = Z_NULL;
+    stream.avail_in = 0;
+    // 32 enables the automatic detection of the zlib and gzip headers.
+    if (inflateInit2(&stream, MAX_WBITS + 32) != Z_OK)
+        return false;
+    this->coding = coding;
+    return true;
+}
+
+void HttpContentDecoder::close()
+{
+    if (!isOpen())
+        return;
+    inflateEnd(&stream);
+    coding = HttpResponseMessage::Identity;
+    raw = false;
+    finished = false;
+    head.clear();
+}
+
+bool HttpContentDecoder::write(std::ostream& out, const char* data, size_t length)
+{
+    char buffer[16384];
+    bool retriable = coding == HttpResponseMessage::Deflate && !raw && stream.total_out == 0;
+    if (retriable)
+        head.append(data, length);
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+    stream.avail_in = length;
+    while (0 < stream.avail_in && !finished) {
+        stream.next_out = reinterpret_cast<Bytef*>(buffer);
+        stream.avail_out = sizeof buffer;
+        int result = inflate(&stream, Z_NO_FLUSH);
+        if (result == Z_DATA_ERROR && retriable && stream.total_out == 0) {
+            // Some servers send a raw deflate stream without the zlib wrapper.
+            if (inflateReset2(&stream, -MAX_WBITS) != Z_OK)
+                return false;
+            raw = true;
+            retriable = false;
+            stream.next_in = reinterpret_cast<Bytef*>(&head[0]);
+            stream.avail_in = head.length();
+            continue;
+        }
+        if (retriable && stream.total_out != 0) {
+            retriable = false;
+            head.clear();
+        }
+        switch (result) {
+        case Z_STREAM_END:
+            finished = true;
+            // FALL THROUGH
+        case Z_OK:
+            out.write(buffer, sizeof buffer - stream.avail_out);
+            break;
+        case Z_BUF_ERROR:   // no progress was possible
+            return true;
+        default:
+            return false;
+        }
+    }
+    return true;
+}
+
+bool HttpContentDecoder::decode(int coding, std::istream& in, std::ostream& out)
+{
+    HttpContentDecoder decoder;
+    if (!decoder.open(coding))
+        return false;
+    char buffer[16384];
+    while (in.read(buffer, sizeof buffer) || in.gcount()) {
+        if (!decoder.write(out, buffer, in.gcount()))
+            return false;
+    }
+    return true;
+}
+
+}}}}  // org::w3c::dom::bootstrap
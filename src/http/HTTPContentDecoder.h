@@ -0,0 +1,65 @@
+/*
+ * Copyright 2015 Esrille Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ES_HTTP_CONTENT_DECODER_H
+#define ES_HTTP_CONTENT_DECODER_H
+
+#include <iosfwd>
+#include <string>
+
+#include <zlib.h>
+
+namespace org { namespace w3c { namespace dom { namespace bootstrap {
+
+// HttpContentDecoder inflates a gzip or deflate coded body incrementally as
+// it arrives, so that the decoded bytes can be written straight to the
+// content sink.
+class HttpContentDecoder
+{
+    z_stream stream;
+    int coding;
+    bool raw;       // a raw deflate stream without the zlib wrapper
+    bool finished;  // the end of the coded stream has been reached
+    std::string head;   // the deflate input kept until the first output for retrying as raw
+
+public:
+    HttpContentDecoder();
+    ~HttpContentDecoder();
+
+    // Starts decoding a body of the specified HttpResponseMessage content
+    // coding. Returns false if the coding needs no decoding or is not
+    // supported.
+    bool open(int coding);
+    void close();
+
+    bool isOpen() const {
+        return coding != 0;
+    }
+    bool isFinished() const {
+        return finished;
+    }
+
+    // Decodes the next piece of the body and writes the decoded bytes to out.
+    // Returns false if the body is corrupted.
+    bool write(std::ostream& out, const char* data, size_t length);
+
+    // Decodes the whole body read from in.
+    static bool decode(int coding, std::istream& in, std::ostream& out);
+};
+
+}}}}  // org::w3c::dom::bootstrap
+
+#endif  // ES_HTTP_CONTENT_DECODER_H
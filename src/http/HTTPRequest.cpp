@@ -21,6 +21,7 @@
 #include <unistd.h>
 
 #include <iostream>
+#include <sstream>
 #include <string>
 
 #include "utf.h"
@@ -28,6 +29,7 @@
 #include "url/URI.h"
 #include "http/HTTPCache.h"
 #include "http/HTTPConnection.h"
+#include "http/HTTPContentDecoder.h"
 
 #include "css/Box.h"
 #include "css/BoxImage.h"
@@ -41,11 +43,35 @@ const unsigned short HttpRequest::LOADING;
 const unsigned short HttpRequest::COMPLETE;
 const unsigned short HttpRequest::DONE;
 
+const unsigned short HttpRequest::DOCUMENT_PRIORITY;
+const unsigned short HttpRequest::BLOCKING_PRIORITY;
+const unsigned short HttpRequest::FONT_PRIORITY;
+const unsigned short HttpRequest::DEFAULT_PRIORITY;
+const unsigned short HttpRequest::IMAGE_PRIORITY;
+
 std::string HttpRequest::aboutPath;
 std::string HttpRequest::cachePath("/tmp");
 
+HttpBody* HttpRequest::getSink()
+{
+    if (!body)
+        body = std::make_shared<HttpBody>(cachePath);
+    return body.get();
+}
+
+std::unique_ptr<std::istream> HttpRequest::openContent()
+{
+    if (body)
+        return std::unique_ptr<std::istream>(new HttpBodyStream(body));
+    if (filePath.empty())
+        return std::unique_ptr<std::istream>(new std::istringstream);
+    return std::unique_ptr<std::istream>(new std::ifstream(filePath.c_str(), std::ios::in | std::ios::binary));
+}
+
 int HttpRequest::getContentDescriptor()
 {
+    if (body)
+        return body->getDescriptor();
     if (filePath.empty())
         return -1;
     return ::open(filePath.c_str(), O_RDONLY, 0);
@@ -53,28 +79,32 @@ int HttpRequest::getContentDescriptor()
 
 std::FILE* HttpRequest::openFile()
 {
+    if (body)
+        return body->openFile();
     if (filePath.empty())
         return 0;
     return fopen(filePath.c_str(), "rb");
 }
 
-std::fstream& HttpRequest::getContent()
+// Decodes the gzip or deflate coded body into a body of this request's own.
+// This is used only if coded responses are stored encoded.
+bool HttpRequest::decodeContent()
 {
-    if (content.is_open())
-        return content;
-
-    char tempPath[PATH_MAX];
-    if (PATH_MAX <= cachePath.length() + 9)
-        return content;
-    strcpy(tempPath, cachePath.c_str());
-    strcat(tempPath, "/esrille-XXXXXX");
-    int fd = mkstemp(tempPath);
-    if (fd == -1)
-        return content;
-    filePath = tempPath;
-    content.open(tempPath, std::ios_base::trunc | std::ios_base::in | std::ios_base::out | std::ios::binary);
-    close(fd);
-    return content;
+    int coding = response.getContentCoding();
+    if (coding != HttpResponseMessage::Gzip && coding != HttpResponseMessage::Deflate)
+        return true;
+    if (!body || body == decodedBody)
+        return true;
+
+    HttpBodyStream encoded(body);
+    if (!encoded)
+        return false;
+    HttpBodyPtr decoded = std::make_shared<HttpBody>(cachePath);
+    std::ostream out(decoded.get());
+    bool result = HttpContentDecoder::decode(coding, encoded, out);
+    out.flush();
+    body = decodedBody = decoded;
+    return result;
 }
 
 void HttpRequest::setHandler(boost::function<void (void)> f)
@@ -128,8 +158,7 @@ bool HttpRequest::redirect(const HttpResponseMessage& res)
         return false;
 
     // Redirect to location
-    if (content.is_open())
-        content.close();
+    body.reset();
     filePath.clear();
     cache = 0;
     readyState = OPENED;
@@ -157,6 +186,8 @@ void HttpRequest::notify()
         send();
         return;
     }
+    if (!errorFlag && HttpCacheManager::isStoreEncoded() && !decodeContent())
+        errorFlag = true;
 
     if (handler) {
         handler();
@@ -202,7 +233,7 @@ bool HttpRequest::constructResponseFromCache(bool sync)
     response.getLastModifiedValue(lastModified);
 
     // TODO: deal with partial...
-    filePath = cache->getFilePath();
+    body = cache->getBody();
 
     cache = 0;
     if (sync)
@@ -217,7 +248,7 @@ bool HttpRequest::constructResponseFromCache(bool sync)
 
 namespace {
 
-bool decodeBase64(std::fstream& content, const std::string& data)
+bool decodeBase64(std::ostream& content, const std::string& data)
 {
     static const char* const table = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
     char buf[4];
@@ -265,12 +296,7 @@ bool HttpRequest::constructResponseFromData()
         base64 = true;
     }
     response.parseMediaType(data.c_str() + 5, data.c_str() + end);
-    std::fstream& content = getContent();
-    if (!content.is_open()) {
-        notify(true);
-        return errorFlag;
-    }
-    flags &= ~DONT_REMOVE;
+    std::ostream content(getSink());
     if (!base64) {
         end += 1;
         std::string decoded(URI::percentDecode(URI::percentDecode(data, end, data.length() - end)));
@@ -352,9 +378,9 @@ void HttpRequest::abort(bool dtor)
     errorFlag = false;
     request.clear();
     response.clear();
-    if (content.is_open())
-        content.close();
-    filePath.clear();   // TODO: Check if we should remove file now
+    body.reset();
+    decodedBody.reset();
+    filePath.clear();
     cache = 0;
 }
 
@@ -399,6 +425,7 @@ HttpRequest::HttpRequest(const std::u16string& base) :
     base(base),
     readyState(UNSENT),
     flags(DONT_REMOVE),
+    priority(DEFAULT_PRIORITY),
     errorFlag(false),
     cache(0),
     handler(0),
@@ -20,10 +20,11 @@
 #include <atomic>
 #include <cstdio>
 #include <deque>
+#include <istream>
 #include <memory>
-#include <fstream>
 #include <boost/function.hpp>
 
+#include "http/HTTPBody.h"
 #include "http/HTTPRequestMessage.h"
 #include "http/HTTPResponseMessage.h"
 
@@ -55,6 +56,13 @@ public:
     static const unsigned short DONT_REMOVE = 1;    // Do not remove filePath upon destruction
     static const unsigned short CANCELED = 2;
 
+    // priorities; requests of a smaller value are sent first.
+    static const unsigned short DOCUMENT_PRIORITY = 0;
+    static const unsigned short BLOCKING_PRIORITY = 1;  // style sheets and parser-blocking scripts
+    static const unsigned short FONT_PRIORITY = 2;
+    static const unsigned short DEFAULT_PRIORITY = 3;
+    static const unsigned short IMAGE_PRIORITY = 4;
+
 private:
     static std::string aboutPath;
     static std::string cachePath;
@@ -62,12 +70,14 @@ private:
     std::u16string base;
     unsigned short readyState;
     std::atomic_ushort flags;
+    unsigned short priority;
     bool errorFlag;
     HttpRequestMessage request;
     HttpResponseMessage response;
 
-    std::string filePath;
-    std::fstream content;
+    std::string filePath;       // for file: and about:
+    HttpBodyPtr body;
+    HttpBodyPtr decodedBody;    // the copy decoded by decodeContent()
 
     HttpCache* cache;
     boost::function<void (void)> handler;
@@ -113,8 +123,16 @@ public:
         }
     }
 
+    const HttpBodyPtr& getBody() const {
+        return body;
+    }
+    // Returns the sink of the response body, creating it upon the first call.
+    HttpBody* getSink();
+
+    // Opens a stream to read the content. The body kept in memory is read in
+    // place without copying.
+    std::unique_ptr<std::istream> openContent();
     int getContentDescriptor();
-    std::fstream& getContent();
     std::FILE* openFile();
 
     void setHandler(boost::function<void (void)> f);
@@ -122,6 +140,8 @@ public:
     unsigned addCallback(boost::function<void (void)> f, unsigned id = static_cast<unsigned>(-1));
     void clearCallback(unsigned id);
 
+    bool decodeContent();
+
     bool redirect(const HttpResponseMessage& res);
     bool complete(bool error);
     void notify();
@@ -151,6 +171,14 @@ public:
     std::string getAllResponseHeaders() const;
     // void overrideMimeType(std::u16string mime);
 
+    unsigned short getPriority() const {
+        return priority;
+    }
+    // Sets the priority of this request. This must be called before send().
+    void setPriority(unsigned short value) {
+        priority = value;
+    }
+
     bool getError() const {
         return errorFlag;
     }
@@ -0,0 +1,185 @@
+/*
+ * Copyright 2015 Esrille Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "HTTPResolver.h"
+
+#include <iostream>
+
+#include <boost/bind.hpp>
+
+namespace org { namespace w3c { namespace dom { namespace bootstrap {
+
+const int HttpResolver::DefaultTTL;
+const int HttpResolver::DefaultNegativeTTL;
+
+HttpResolver::HttpResolver(boost::asio::io_service& ioService) :
+    ioService(ioService),
+    resolver(ioService),
+    ttl(DefaultTTL),
+    negativeTTL(DefaultNegativeTTL),
+    hitCount(0),
+    negativeHitCount(0),
+    coalescedCount(0),
+    missCount(0)
+{
+    setLookup(Lookup());
+}
+
+void HttpResolver::lookupBySystem(const std::string& hostname, const std::string& port, const Handler& handler)
+{
+    boost::asio::ip::tcp::resolver::query query(hostname, port);
+    resolver.async_resolve(query,
+                           boost::bind(&HttpResolver::handleResolve, this,
+                                       boost::asio::placeholders::error,
+                                       boost::asio::placeholders::iterator,
+                                       handler));
+}
+
+void HttpResolver::handleResolve(const boost::system::error_code& err, boost::asio::ip::tcp::resolver::iterator endpointIterator, const Handler& handler)
+{
+    Endpoints endpoints;
+    for (; endpointIterator != boost::asio::ip::tcp::resolver::iterator(); ++endpointIterator)
+        endpoints.push_back(*endpointIterator);
+    handler(err, endpoints);
+}
+
+void HttpResolver::resolve(const std::string& hostname, const std::string& port, const Handler& handler)
+{
+    std::string key(getKey(hostname, port));
+    Lookup f;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        Entry& entry = cache[key];
+        if (entry.pending) {
+            ++coalescedCount;
+            entry.handlers.push_back(handler);
+            return;
+        }
+        if (std::chrono::steady_clock::now() < entry.expires) {
+            if (entry.error)
+                ++negativeHitCount;
+            else
+                ++hitCount;
+            ioService.post(boost::bind(handler, entry.error, entry.endpoints));
+            return;
+        }
+        ++missCount;
+        entry.pending = true;
+        entry.handlers.push_back(handler);
+        f = lookup;
+    }
+    // The lock is not held here as a stub lookup may complete right away.
+    f(hostname, port, boost::bind(&HttpResolver::complete, this, key, _1, _2));
+}
+
+void HttpResolver::complete(const std::string& key, const boost::system::error_code& err, const Endpoints& endpoints)
+{
+    boost::system::error_code error(err);
+    if (!error && endpoints.empty())
+        error = boost::asio::error::host_not_found;
+    std::list<Handler> handlers;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        Entry& entry = cache[key];
+        entry.pending = false;
+        entry.error = error;
+        entry.endpoints = endpoints;
+        if (error == boost::asio::error::operation_aborted)
+            entry.expires = std::chrono::steady_clock::time_point();
+        else
+            entry.expires = std::chrono::steady_clock::now() + (error ? negativeTTL : ttl);
+        handlers.swap(entry.handlers);
+    }
+    for (auto i = handlers.begin(); i != handlers.end(); ++i)
+        ioService.post(boost::bind(*i, error, endpoints));
+}
+
+void HttpResolver::invalidate(const std::string& hostname, const std::string& port)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    auto found = cache.find(getKey(hostname, port));
+    if (found != cache.end() && !found->second.pending)
+        cache.erase(found);
+}
+
+void HttpResolver::clear()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto i = cache.begin(); i != cache.end();) {
+        if (i->second.pending)
+            ++i;
+        else
+            i = cache.erase(i);
+    }
+}
+
+void HttpResolver::setLookup(const Lookup& lookup)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (lookup)
+        this->lookup = lookup;
+    else
+        this->lookup = boost::bind(&HttpResolver::lookupBySystem, this, _1, _2, _3);
+}
+
+void HttpResolver::setTTL(int seconds, int negativeSeconds)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    ttl = std::chrono::seconds(seconds);
+    negativeTTL = std::chrono::seconds(negativeSeconds);
+}
+
+unsigned long long HttpResolver::getHitCount() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return hitCount;
+}
+
+unsigned long long HttpResolver::getNegativeHitCount() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return negativeHitCount;
+}
+
+unsigned long long HttpResolver::getCoalescedCount() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return coalescedCount;
+}
+
+unsigned long long HttpResolver::getMissCount() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return missCount;
+}
+
+double HttpResolver::getHitRate() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    unsigned long long hits = hitCount + negativeHitCount + coalescedCount;
+    unsigned long long total = hits + missCount;
+    return total ? static_cast<double>(hits) / total : 0.0;
+}
+
+void HttpResolver::dump() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    std::cout << "HttpResolver: " << cache.size() << " entries, " <<
+                 hitCount << " hits, " << negativeHitCount << " negative hits, " <<
+                 coalescedCount << " coalesced, " << missCount << " misses\n";
+}
+
+}}}}  // org::w3c::dom::bootstrap
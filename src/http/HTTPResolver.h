@@ -0,0 +1,116 @@
+/*
+ * Copyright 2015 Esrille Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ES_HTTP_RESOLVER_H
+#define ES_HTTP_RESOLVER_H
+
+#include <chrono>
+#include <list>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <boost/asio.hpp>
+#include <boost/function.hpp>
+
+namespace org { namespace w3c { namespace dom { namespace bootstrap {
+
+// HttpResolver resolves host names for the HTTP connections and keeps the
+// results for a while. A failed lookup is kept too for a shorter period,
+// and the connections asking for a host name that is being looked up wait
+// for that lookup rather than starting their own.
+class HttpResolver
+{
+public:
+    typedef std::vector<boost::asio::ip::tcp::endpoint> Endpoints;
+    typedef boost::function<void (const boost::system::error_code&, const Endpoints&)> Handler;
+    // A lookup resolves hostname and port, and calls handler when done. The
+    // default lookup uses boost::asio::ip::tcp::resolver; a test can set a
+    // stub lookup in its place.
+    typedef boost::function<void (const std::string& hostname, const std::string& port, const Handler& handler)> Lookup;
+
+    // The system resolver does not report the TTLs of the DNS records, so
+    // results are kept for fixed periods (in seconds).
+    static const int DefaultTTL = 60;
+    static const int DefaultNegativeTTL = 10;
+
+private:
+    struct Entry
+    {
+        boost::system::error_code error;
+        Endpoints endpoints;
+        std::chrono::steady_clock::time_point expires;
+        bool pending;
+        std::list<Handler> handlers;   // waiting for the pending lookup
+
+        Entry() :
+            pending(false)
+        {
+        }
+    };
+
+    boost::asio::io_service& ioService;
+    boost::asio::ip::tcp::resolver resolver;
+    Lookup lookup;
+
+    mutable std::mutex mutex;
+    std::map<std::string, Entry> cache;    // keyed by hostname:port
+    std::chrono::seconds ttl;
+    std::chrono::seconds negativeTTL;
+
+    unsigned long long hitCount;
+    unsigned long long negativeHitCount;   // hits on failed lookups
+    unsigned long long coalescedCount;     // requests that joined a pending lookup
+    unsigned long long missCount;
+
+    static std::string getKey(const std::string& hostname, const std::string& port) {
+        return hostname + ':' + port;
+    }
+
+    void lookupBySystem(const std::string& hostname, const std::string& port, const Handler& handler);
+    void handleResolve(const boost::system::error_code& err, boost::asio::ip::tcp::resolver::iterator endpointIterator, const Handler& handler);
+    void complete(const std::string& key, const boost::system::error_code& err, const Endpoints& endpoints);
+
+public:
+    HttpResolver(boost::asio::io_service& ioService);
+
+    // Resolves hostname and port, and posts handler to the io_service with
+    // the result.
+    void resolve(const std::string& hostname, const std::string& port, const Handler& handler);
+
+    // Forgets the result for hostname and port, e.g., once none of the
+    // resolved addresses could be connected.
+    void invalidate(const std::string& hostname, const std::string& port);
+    void clear();
+
+    // Replaces the lookup; an empty lookup restores the system resolver.
+    void setLookup(const Lookup& lookup);
+    void setTTL(int seconds, int negativeSeconds);
+
+    unsigned long long getHitCount() const;
+    unsigned long long getNegativeHitCount() const;
+    unsigned long long getCoalescedCount() const;
+    unsigned long long getMissCount() const;
+    // Returns the ratio of the requests answered without a lookup of their own.
+    double getHitRate() const;
+
+    void dump() const;
+};
+
+}}}}  // org::w3c::dom::bootstrap
+
+#endif  // ES_HTTP_RESOLVER_H
@@ -267,6 +267,21 @@ bool HttpResponseMessage::isChunked() const
     return hasToken(value, "chunked", 7);
 }
 
+int HttpResponseMessage::getContentCoding() const
+{
+    std::string value;
+    if (!headers.get("Content-Encoding", value))
+        return Identity;
+    trimLWS(value);
+    if (value.empty() || strcasecmp(value.c_str(), "identity") == 0)
+        return Identity;
+    if (strcasecmp(value.c_str(), "gzip") == 0 || strcasecmp(value.c_str(), "x-gzip") == 0)
+        return Gzip;
+    if (strcasecmp(value.c_str(), "deflate") == 0)
+        return Deflate;
+    return UnknownCoding;
+}
+
 bool HttpResponseMessage::getExpiresValue(long long& expiresValue) const
 {
     std::string value;
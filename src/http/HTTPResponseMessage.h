@@ -47,6 +47,14 @@ class HttpResponseMessage
     bool parseHeader(const HttpHeader& hdr);
 
 public:
+    // content codings
+    enum {
+        Identity,
+        Deflate,
+        Gzip,
+        UnknownCoding
+    };
+
     HttpResponseMessage();
 
     const char* parseMediaType(const char* start, const char* const end);
@@ -126,6 +134,7 @@ public:
     bool isFresh(long long requestTime) const;
 
     bool isChunked() const;
+    int getContentCoding() const;
 
     void clear();
     void update(const HttpResponseMessage& response);
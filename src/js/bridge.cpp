@@ -21,8 +21,11 @@
 #include <alloca.h>
 
 #include <iostream>
+#include <iterator>
 #include <memory>
 
+#include "one_at_a_time.hpp"
+
 namespace {
 
 template<typename T>
@@ -53,39 +56,6 @@ public:
     }
 };
 
-// a public domain hash function.
-// cf. http://burtleburtle.net/bob/hash/doobs.html
-inline uint32_t one_at_a_time(const char* key, size_t len)
-{
-    uint32_t hash, i;
-    for (hash = 0, i = 0; i < len; ++i) {
-        hash += key[i];
-        hash += (hash << 10);
-        hash ^= (hash >> 6);
-    }
-    hash += (hash << 3);
-    hash ^= (hash >> 11);
-    hash += (hash << 15);
-    return hash;
-}
-
-// returns zero if key contains any non-ascii character.
-inline uint32_t uc_one_at_a_time(const char16_t* key, size_t len)
-{
-    uint32_t hash, i;
-    for (hash = 0, i = 0; i < len; ++i) {
-        if (127 < key[i])
-            return 0;
-        hash += key[i];
-        hash += (hash << 10);
-        hash ^= (hash >> 6);
-    }
-    hash += (hash << 3);
-    hash ^= (hash >> 11);
-    hash += (hash << 15);
-    return hash;
-}
-
 Object convert(JSContext* cx, JSObject* obj)
 {
     JSClass* cls = JS_GET_CLASS(cx, obj);
@@ -121,17 +91,24 @@ Any convert(JSContext* cx, jsval& v)
 
 JSObject* convert(JSContext* cx, const std::shared_ptr<Imp>& pimpl)
 {
-    JSObject* jsobj = 0;
-    if (pimpl) {
-        if (auto p = std::dynamic_pointer_cast<ProxyObject>(pimpl))
-            jsobj = p->getJSObject();
-        else if (auto p = std::dynamic_pointer_cast<ObjectImp>(pimpl))
-            jsobj = static_cast<NativeClass*>(p->getStaticPrivate())->createJSObject(cx, p.get());
+    // Note raw pointers are used here to avoid touching the reference count.
+    if (Imp* imp = pimpl.get()) {
+        if (auto p = dynamic_cast<ObjectImp*>(imp)) {
+            // Use the wrapper cached in the object if any.
+            if (JSObject* jsobj = static_cast<JSObject*>(p->getPrivate()))
+                return jsobj;
+            return static_cast<NativeClass*>(p->getStaticPrivate())->createJSObject(cx, p);
+        }
+        if (auto p = dynamic_cast<ProxyObject*>(imp))
+            return p->getJSObject();
     }
-    return jsobj;
+    return 0;
 }
 
-jsval convert(JSContext* cx, Any& v)
+// If intern is true, the string is atomized so that the same JSString is
+// shared by every call; use it only for strings from a bounded vocabulary
+// such as readyState values since interned strings are never collected.
+jsval convert(JSContext* cx, Any& v, bool intern = false)
 {
     switch (v.getType()) {
     case Any::Undefined:
@@ -153,8 +130,9 @@ jsval convert(JSContext* cx, Any& v)
         break;
     }
     if (v.isString()) {
-        std::u16string s = v.toString();
-        JSString* j = JS_NewUCStringCopyN(cx, reinterpret_cast<const jschar*>(s.c_str()), s.length());
+        const std::u16string& s = v.getString();
+        JSString* j = intern ? JS_InternUCStringN(cx, reinterpret_cast<const jschar*>(s.c_str()), s.length()) :
+                               JS_NewUCStringCopyN(cx, reinterpret_cast<const jschar*>(s.c_str()), s.length());
         return STRING_TO_JSVAL(j);
     }
     if (v.isObject())
@@ -200,22 +178,19 @@ JSBool operation(JSContext* cx, uintN argc, jsval* vp)
     return JS_FALSE;
 }
 
-bool hasProperty(ObjectImp* native, const std::u16string& name)
+bool hasProperty(JSContext* cx, JSObject* obj, ObjectImp* native, const char16_t* name, size_t length)
 {
-    uint32_t hash = uc_one_at_a_time(name.c_str(), name.length());
+    uint32_t hash = one_at_a_time::computeASCII(name, length);
     if (!hash)
         return false;
     // It seems specialGetter, etc. are not called for predefined properties; so just check operatons.
-    Any result = native->message_(hash, 0, Object::HAS_OPERATION_, 0);
-    return result.toBoolean();
+    return NativeClass::getNativeClass(JS_GET_CLASS(cx, obj))->hasOperation(native, hash, name, length);
 }
 
-std::u16string toString(JSContext* cx, jsid id)
+const char16_t* getChars(JSContext* cx, jsid id, size_t* length)
 {
     JSString* jsstring = JSID_TO_STRING(id);
-    size_t length;
-    const char16_t* string = reinterpret_cast<const char16_t*>(JS_GetStringCharsAndLength(cx, jsstring, &length));
-    return std::u16string(string, length);
+    return reinterpret_cast<const char16_t*>(JS_GetStringCharsAndLength(cx, jsstring, length));
 }
 
 JSBool specialOp(JSContext* cx, JSObject* obj, jsid id, jsval* vp, int argc)
@@ -227,10 +202,11 @@ JSBool specialOp(JSContext* cx, JSObject* obj, jsid id, jsval* vp, int argc)
     if (JSID_IS_INT(id))
         argument = JSID_TO_INT(id);
     else if (JSID_IS_STRING(id)) {
-        std::u16string name = toString(cx, id);
-        if (hasProperty(native, name))
+        size_t length;
+        const char16_t* name = getChars(cx, id, &length);
+        if (hasProperty(cx, obj, native, name, length))
             return JS_PropertyStub(cx, obj, id, vp);
-        argument = name;
+        argument = std::u16string(name, length);
     } else
         return JS_PropertyStub(cx, obj, id, vp);
     Any result = native->message_(0, 0, argc, &argument);
@@ -254,10 +230,11 @@ JSBool specialResolver(JSContext* cx, JSObject* obj, jsid id)
     if (JSID_IS_INT(id))
         argument = JSID_TO_INT(id);
     else if (JSID_IS_STRING(id)) {
-        std::u16string name = toString(cx, id);
-        if (hasProperty(native, name))
+        size_t length;
+        const char16_t* name = getChars(cx, id, &length);
+        if (hasProperty(cx, obj, native, name, length))
             return JS_ResolveStub(cx, obj, id);
-        argument = name;
+        argument = std::u16string(name, length);
     } else
         return JS_ResolveStub(cx, obj, id);
     Any result = native->message_(0, 0, Object::SPECIAL_GETTER_, &argument);
@@ -289,10 +266,11 @@ JSBool specialSetter(JSContext* cx, JSObject* obj, jsid id, JSBool strict, jsval
     if (JSID_IS_INT(id))
         arguments[0] = JSID_TO_INT(id);
     else if (JSID_IS_STRING(id)) {
-        std::u16string name = toString(cx, id);
-        if (hasProperty(native, name))
+        size_t length;
+        const char16_t* name = getChars(cx, id, &length);
+        if (hasProperty(cx, obj, native, name, length))
             return JS_StrictPropertyStub(cx, obj, id, strict, vp);
-        arguments[0] = name;
+        arguments[0] = std::u16string(name, length);
     } else
         return JS_StrictPropertyStub(cx, obj, id, strict, vp);
     arguments[1] = convert(cx, *vp);
@@ -325,8 +303,35 @@ uint32_t NativeClass::getHash(JSContext* cx, jsval* vp, int n)
     assert(parent);
     JSClass* jsclass = JS_GET_CLASS(cx, parent);
     assert(jsclass);
-    NativeClass* nc = reinterpret_cast<NativeClass*>(reinterpret_cast<char*>(jsclass) - offsetof(NativeClass, jsclass));
-    return nc->getHash(n);
+    return getNativeClass(jsclass)->getHash(n);
+}
+
+NativeClass* NativeClass::getNativeClass(JSClass* jsclass)
+{
+    return reinterpret_cast<NativeClass*>(reinterpret_cast<char*>(jsclass) - offsetof(NativeClass, jsclass));
+}
+
+// Whether a name is an operation or not depends only on the interface; so
+// ask the object just once per name and interface. The cache is keyed by the
+// hash of the name, and the name is compared only to tell collisions apart;
+// a colliding name replaces the cached one. Since script can probe any
+// number of names, the cache is flushed once it has grown to
+// MAX_OPERATION_CACHE_SIZE entries.
+bool NativeClass::hasOperation(ObjectImp* native, uint32_t hash, const char16_t* name, size_t length)
+{
+    auto found = operationCache.find(hash);
+    if (found != operationCache.end() && !found->second.name.compare(0, std::u16string::npos, name, length))
+        return found->second.result;
+    bool result = native->message_(hash, 0, Object::HAS_OPERATION_, 0).toBoolean();
+    if (found != operationCache.end()) {
+        found->second.name.assign(name, length);
+        found->second.result = result;
+        return result;
+    }
+    if (MAX_OPERATION_CACHE_SIZE <= operationCache.size())
+        operationCache.clear();
+    operationCache.insert(std::make_pair(hash, Operation{std::u16string(name, length), result}));
+    return result;
 }
 
 template <int N>
@@ -340,8 +345,7 @@ JSBool NativeClass::staticOperation(JSContext* cx, uintN argc, jsval* vp)
             JSString* s = JS_GetFunctionId(f);
             size_t l;
             const jschar* b = JS_GetStringCharsAndLength(cx, s, &l);
-            std::u16string name(reinterpret_cast<const char16_t*>(b), l);
-            hash = uc_one_at_a_time(name.c_str(), name.length());
+            hash = one_at_a_time::computeASCII(reinterpret_cast<const char16_t*>(b), l);
         }
         if (!hash)
             return JS_FALSE;
@@ -383,9 +387,9 @@ JSBool NativeClass::getter(JSContext* cx, JSObject* obj, jsid id, jsval* vp)
             NativeClass* nc = static_cast<NativeClass*>(native->getStaticPrivate());
             while (nc->protoRank != R)
                 nc = nc->proto;
-            uint32_t hash = nc->getHash(JSID_TO_INT(id) & 0xff);
-            Any result = native->message_(hash, 0, Object::GETTER_, 0);
-            JS_SET_RVAL(cx, vp, convert(cx, result));
+            int n = JSID_TO_INT(id) & 0xff;
+            Any result = native->message_(nc->getHash(n), 0, Object::GETTER_, 0);
+            JS_SET_RVAL(cx, vp, convert(cx, result, nc->isInterned(n)));
             return JS_TRUE;
         }
     }
@@ -439,6 +443,25 @@ bool NativeClass::isNativeClass(JSClass* jsclass)
 
 std::list<NativeClass*> NativeClass::nativeClassList;
 
+// Attributes whose values are taken from a small, closed vocabulary. Their
+// values are returned as interned strings to save a string allocation and
+// copy per access. Names such as tagName or type are not listed here since a
+// page can make up any number of them, and interned strings are never
+// collected.
+bool NativeClass::isInternedAttribute(const std::string& name)
+{
+    static const char* const names[] = {
+        "readyState",
+        "compatMode",
+        "characterSet",
+    };
+    for (auto i = std::begin(names); i != std::end(names); ++i) {
+        if (name == *i)
+            return true;
+    }
+    return false;
+}
+
 JSNative NativeClass::operations[MAX_METHOD_COUNT] =
 {
     &operation<0>, &operation<1>, &operation<2>, &operation<3>, &operation<4>,
@@ -606,7 +629,7 @@ NativeClass::NativeClass(const char* metadata, Object (*getConstructor)()) :
         switch (prop.getType()) {
         case Reflect::kOperation:
             if (!prop.isOmittable() && 0 < prop.getName().length()) {
-                hashTable.get()[propertyNumber] = one_at_a_time(prop.getName().c_str(), prop.getName().length());
+                hashTable.get()[propertyNumber] = one_at_a_time::compute(prop.getName().c_str(), prop.getName().length());
                 if (prop.isStatic()) {
                     psfs->name = heap;
                     psfs->call = sop;
@@ -635,7 +658,7 @@ NativeClass::NativeClass(const char* metadata, Object (*getConstructor)()) :
             if (prop.isCaller())
                 jsclass.call = caller;
             if (prop.isStringifier() && prop.getName() != "toString") {
-                hashTable.get()[propertyNumber] = one_at_a_time(prop.getName().c_str(), prop.getName().length());
+                hashTable.get()[propertyNumber] = one_at_a_time::compute(prop.getName().c_str(), prop.getName().length());
                 pfs->name = "toString";
                 pfs->call = operations[propertyNumber];
                 pfs->nargs = 0;
@@ -645,7 +668,9 @@ NativeClass::NativeClass(const char* metadata, Object (*getConstructor)()) :
             }
             break;
         case Reflect::kAttribute:
-            hashTable.get()[propertyNumber] = one_at_a_time(prop.getName().c_str(), prop.getName().length());
+            hashTable.get()[propertyNumber] = one_at_a_time::compute(prop.getName().c_str(), prop.getName().length());
+            if (isInternedAttribute(prop.getName()))
+                internTable.set(propertyNumber);
             pps->name = heap;
             assert(propertyNumber < 256);
             pps->tinyid = propertyNumber++;
@@ -658,7 +683,7 @@ NativeClass::NativeClass(const char* metadata, Object (*getConstructor)()) :
             ++pps;
 
             if (prop.isStringifier()) {
-                hashTable.get()[propertyNumber] = one_at_a_time(prop.getName().c_str(), prop.getName().length());
+                hashTable.get()[propertyNumber] = one_at_a_time::compute(prop.getName().c_str(), prop.getName().length());
                 pfs->name = "toString";
                 pfs->call = operations[propertyNumber];
                 pfs->nargs = 0;
@@ -19,8 +19,11 @@
 
 #include <js/jsapi.h>
 
+#include <bitset>
 #include <list>
 #include <memory>
+#include <string>
+#include <unordered_map>
 
 #include "Object.h"
 #include "Reflect.h"
@@ -32,6 +35,7 @@ class NativeClass
     static const size_t MAX_METHOD_COUNT = 256;
     static const size_t MAX_CONSTRUCTOR_COUNT = 64;
     static const size_t MAX_RANK = 16;
+    static const size_t MAX_OPERATION_CACHE_SIZE = 256;
 
     static std::list<NativeClass*> nativeClassList;
 
@@ -49,6 +53,12 @@ class NativeClass
     char name[48];
     JSClass jsclass;
     std::unique_ptr<uint32_t[]> hashTable;
+    std::bitset<MAX_METHOD_COUNT> internTable;
+    struct Operation {
+        std::u16string name;
+        bool result;
+    };
+    std::unordered_map<uint32_t, Operation> operationCache;  // HAS_OPERATION_ results by name hash
 
     std::unique_ptr<JSPropertySpec[]> ps;
     std::unique_ptr<JSFunctionSpec[]> fs;
@@ -56,6 +66,8 @@ class NativeClass
     std::unique_ptr<char[]> stringHeap;
     JSNative ctor;
 
+    static bool isInternedAttribute(const std::string& name);
+
     char* storeName(char* heap, const Reflect::Property& prop)
     {
         std::string name = prop.getName();
@@ -74,6 +86,9 @@ public:
         uint32_t* table = hashTable.get();
         return table ? table[n] : 0;
     }
+    bool isInterned(int n) const {
+        return internTable.test(n);
+    }
 
     JSClass* getJSClass() {
         return &jsclass;
@@ -96,6 +111,10 @@ public:
 
     static uint32_t getHash(JSContext* cx, jsval* vp, int n);
 
+    bool hasOperation(ObjectImp* native, uint32_t hash, const char16_t* name, size_t length);
+
+    static NativeClass* getNativeClass(JSClass* jsclass);
+
     static NativeClass* lookupNativeClass(const char* name) {
         for (auto i = nativeClassList.begin(); i != nativeClassList.end(); ++i) {
             if (!std::strcmp((*i)->name, name))
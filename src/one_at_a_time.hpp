@@ -34,6 +34,7 @@
 #ifndef ES_ONE_AT_A_TIME_H_INCLUDED
 #define ES_ONE_AT_A_TIME_H_INCLUDED
 
+#include <cstddef>
 #include <cstdint>
 
 namespace one_at_a_time {
@@ -65,6 +66,40 @@ constexpr std::uint32_t hash(const T* s)
     return postprocess(combine(0, s));
 }
 
+// Run-time versions for the strings whose length is known, e.g., the
+// property names handed over by the script engines. These produce the same
+// values as hash() above so that a name hashed at run-time matches the
+// selector constants computed at compile-time. Note they are not overloads
+// of hash() so that &hash<T> can still be taken.
+
+template <typename T>
+inline std::uint32_t compute(const T* s, std::size_t length)
+{
+    std::uint32_t hash = 0;
+    for (const T* end = s + length; s < end; ++s) {
+        hash += *s;
+        hash += (hash << 10);
+        hash ^= (hash >> 6);
+    }
+    return postprocess(hash);
+}
+
+// Returns zero if s contains any non-ASCII character; no IDL member name
+// can match such a string.
+template <typename T>
+inline std::uint32_t computeASCII(const T* s, std::size_t length)
+{
+    std::uint32_t hash = 0;
+    for (const T* end = s + length; s < end; ++s) {
+        if (127 < static_cast<std::uint32_t>(*s))
+            return 0;
+        hash += *s;
+        hash += (hash << 10);
+        hash ^= (hash >> 6);
+    }
+    return postprocess(hash);
+}
+
 } // one_at_a_time
 
 #endif  // ES_ONE_AT_A_TIME_H_INCLUDED
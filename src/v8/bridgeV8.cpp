@@ -25,6 +25,7 @@
 
 #include "ScriptV8.h"
 #include "WindowProxy.h"
+#include "one_at_a_time.hpp"
 
 std::map<std::string, v8::Persistent<v8::FunctionTemplate>> NativeClass::interfaceMap;
 std::map<ObjectImp*, v8::Persistent<v8::Object>> NativeClass::wrapperMap;
@@ -59,39 +60,6 @@ public:
     }
 };
 
-// a public domain hash function.
-// cf. http://burtleburtle.net/bob/hash/doobs.html
-inline uint32_t one_at_a_time(const char* key, size_t len)
-{
-    uint32_t hash, i;
-    for (hash = 0, i = 0; i < len; ++i) {
-        hash += key[i];
-        hash += (hash << 10);
-        hash ^= (hash >> 6);
-    }
-    hash += (hash << 3);
-    hash ^= (hash >> 11);
-    hash += (hash << 15);
-    return hash;
-}
-
-// returns zero if key contains any non-ascii character.
-inline uint32_t uc_one_at_a_time(const char16_t* key, size_t len)
-{
-    uint32_t hash, i;
-    for (hash = 0, i = 0; i < len; ++i) {
-        if (127 < key[i])
-            return 0;
-        hash += key[i];
-        hash += (hash << 10);
-        hash ^= (hash >> 6);
-    }
-    hash += (hash << 3);
-    hash ^= (hash >> 11);
-    hash += (hash << 15);
-    return hash;
-}
-
 Object convertObject(v8::Handle<v8::Object> obj)
 {
     // TODO: We would need to check more strictly whether obj is an ObjectImp.
@@ -230,8 +198,7 @@ v8::Handle<v8::Integer> indexedPropertyQuery(uint32_t index, const v8::AccessorI
 v8::Handle<v8::Integer> namedPropertyQuery(v8::Local<v8::String> property, const v8::AccessorInfo& info)
 {
     v8::String::Value value(property);
-    std::u16string name(*value ? reinterpret_cast<const char16_t*>(*value) : u"");
-    uint32_t hash = uc_one_at_a_time(name.c_str(), name.length());
+    uint32_t hash = *value ? one_at_a_time::computeASCII(reinterpret_cast<const char16_t*>(*value), value.length()) : 0;
     if (!hash)
         return v8::Handle<v8::Integer>();
     v8::Local<v8::Object> self = info.This();
@@ -248,8 +215,7 @@ v8::Handle<v8::Integer> namedPropertyQuery(v8::Local<v8::String> property, const
 v8::Handle<v8::Value> namedPropertyGetter(v8::Local<v8::String> property, const v8::AccessorInfo& info)
 {
     v8::String::Value value(property);
-    std::u16string name(*value ? reinterpret_cast<const char16_t*>(*value) : u"");
-    uint32_t hash = uc_one_at_a_time(name.c_str(), name.length());
+    uint32_t hash = *value ? one_at_a_time::computeASCII(reinterpret_cast<const char16_t*>(*value), value.length()) : 0;
     if (!hash)
         return v8::Handle<v8::Value>();
     v8::Local<v8::Object> self = info.This();
@@ -336,23 +302,10 @@ v8::Handle<v8::Value> NativeClass::staticOperation(const v8::Arguments& args)
 {
     int argc = args.Length();
 
-    // TODO: It is better if we can get 'hash' through args.Data() and get
-    //       'getConstructor' by other means.
-
     auto data = v8::Handle<v8::External>::Cast(args.Data());
-    Object (*getConstructor)() = reinterpret_cast<Object (*)()>(data->Value());
-
-    auto function = v8::Local<v8::Function>::Cast(args.Callee());
-    if (function.IsEmpty())
-        return v8::Null();
-    v8::Handle<v8::Value> val = function->GetName();
-    if (!val->IsString())
-        return v8::Null();
-    v8::String::Value value(val);
-    if (!*value)
-        return v8::Null();
-    std::u16string name(reinterpret_cast<const char16_t*>(*value));
-    uint32_t hash = uc_one_at_a_time(name.c_str(), name.length());
+    StaticOperation* op = static_cast<StaticOperation*>(data->Value());
+    Object (*getConstructor)() = op->getConstructor;
+    uint32_t hash = op->hash;
 
     TemporaryBuffer<Any> arguments(alloca(sizeof(Any) * argc), argc);
     for (int i = 0; i < argc; ++i)
@@ -550,7 +503,7 @@ NativeClass::NativeClass(v8::Handle<v8::ObjectTemplate> global, const char* meta
 
     Reflect::Property prop(meta);
     while (prop.getType()) {
-        uint32_t hash = one_at_a_time(prop.getName().c_str(), prop.getName().length());
+        uint32_t hash = one_at_a_time::compute(prop.getName().c_str(), prop.getName().length());
 
         v8::NamedPropertyGetter namedGetter = 0;
         v8::NamedPropertySetter namedSetter = 0;
@@ -563,9 +516,10 @@ NativeClass::NativeClass(v8::Handle<v8::ObjectTemplate> global, const char* meta
         switch (prop.getType()) {
         case Reflect::kOperation:
             if (!prop.isOmittable() && 0 < prop.getName().length()) {
-                if (prop.isStatic())
-                    classTemplate->Set(v8::String::New(prop.getName().c_str()), v8::FunctionTemplate::New(staticOperation, v8::External::New(reinterpret_cast<void*>(getConstructor))));
-                else
+                if (prop.isStatic()) {
+                    staticOperations.push_back(StaticOperation{ getConstructor, hash });
+                    classTemplate->Set(v8::String::New(prop.getName().c_str()), v8::FunctionTemplate::New(staticOperation, v8::External::New(&staticOperations.back())));
+                } else
                     prototypeTemplate->Set(v8::String::New(prop.getName().c_str()), v8::FunctionTemplate::New(operation, v8::Uint32::New(hash)));
             }
 
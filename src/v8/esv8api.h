@@ -23,6 +23,7 @@
 
 #include <v8.h>
 
+#include <list>
 #include <map>
 
 #include "Reflect.h"
@@ -31,9 +32,18 @@ class ObjectImp;
 
 class NativeClass
 {
+    // The data bound to each static operation so that the selector need not
+    // be computed from the function name at every call.
+    struct StaticOperation
+    {
+        Object (*getConstructor)();
+        uint32_t hash;
+    };
+
     const char* metaData;
     Object (*getConstructor)();
     v8::Persistent<v8::FunctionTemplate> classTemplate;
+    std::list<StaticOperation> staticOperations;
 public:
     NativeClass(v8::Handle<v8::ObjectTemplate> global, const char* metadata, Object (*getConstructor)() = 0);
     ~NativeClass();
@@ -0,0 +1 @@
+document.getElementById('t').style.backgroundColor = 'red';